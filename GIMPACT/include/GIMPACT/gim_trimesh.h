@@ -37,6 +37,7 @@ email: projectileman@yahoo.com
 ///MAsk defines
 #define GIM_TRIMESH_TRANSFORMED_REPLY 1
 #define GIM_TRIMESH_NEED_UPDATE 2
+#define GIM_TRIMESH_WORK_DATA_PINNED 4
 
 /*! \addtogroup TRIMESH
 \brief
@@ -178,6 +179,17 @@ Call it after made changes to the trimesh.
 */
 void gim_trimesh_post_update(GIM_TRIMESH * trimesh);
 
+//! Keeps the work data locked until gim_trimesh_unpin_work_data is called
+/*!
+While pinned, gim_trimesh_locks_work_data and gim_trimesh_unlocks_work_data do nothing
+and the triangle planes are not cached, so the trimesh may be queried from several threads
+at once. gim_trimesh_update and gim_trimesh_destroy unpin the data as necessary.
+*/
+void gim_trimesh_pin_work_data(GIM_TRIMESH * trimesh);
+
+//! Releases the lock acquired with gim_trimesh_pin_work_data
+void gim_trimesh_unpin_work_data(GIM_TRIMESH * trimesh);
+
 //! Creates the aabb set and the triangles cache
 /*!
 
@@ -138,6 +138,8 @@ void gim_trimesh_create_from_data(GBUFFER_MANAGER_DATA buffer_managers[],
 //! Clears auxiliary data and releases buffer arrays
 void gim_trimesh_destroy(GIM_TRIMESH * trimesh)
 {
+    gim_trimesh_unpin_work_data(trimesh);
+
     gim_aabbset_destroy(&trimesh->m_aabbset);
 
     GIM_DYNARRAY_DESTROY(trimesh->m_planes_cache_buffer);
@@ -194,6 +196,8 @@ void gim_trimesh_copy(GIM_TRIMESH * source_trimesh,
 */
 void gim_trimesh_locks_work_data(GIM_TRIMESH * trimesh)
 {
+    if(trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED) return;
+
     GINT32 res;
     res=gim_buffer_array_lock(&trimesh->m_tri_index_buffer,G_MA_READ_ONLY);
     assert(res==G_BUFFER_OP_SUCCESS);
@@ -208,6 +212,8 @@ void gim_trimesh_locks_work_data(GIM_TRIMESH * trimesh)
 */
 void gim_trimesh_unlocks_work_data(GIM_TRIMESH * trimesh)
 {
+    if(trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED) return;
+
     gim_buffer_array_unlock(&trimesh->m_tri_index_buffer);
     gim_buffer_array_unlock(&trimesh->m_transformed_vertex_buffer);
 }
@@ -237,6 +243,20 @@ void gim_trimesh_post_update(GIM_TRIMESH * trimesh)
     trimesh->m_mask |= GIM_TRIMESH_NEED_UPDATE;
 }
 
+void gim_trimesh_pin_work_data(GIM_TRIMESH * trimesh)
+{
+    if(trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED) return;
+    gim_trimesh_locks_work_data(trimesh);
+    trimesh->m_mask |= GIM_TRIMESH_WORK_DATA_PINNED;
+}
+
+void gim_trimesh_unpin_work_data(GIM_TRIMESH * trimesh)
+{
+    if((trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED) == 0) return;
+    trimesh->m_mask &= ~GIM_TRIMESH_WORK_DATA_PINNED;
+    gim_trimesh_unlocks_work_data(trimesh);
+}
+
 //kernel
 #define MULT_MAT_VEC4_KERNEL(_mat,_src,_dst) MAT_DOT_VEC_3X4((_dst),(_mat),(_src))
 
@@ -296,6 +316,11 @@ void gim_trimesh_update_aabbset(GIM_TRIMESH * trimesh)
 void gim_trimesh_update(GIM_TRIMESH * trimesh)
 {
     if(gim_trimesh_needs_update(trimesh)==0) return;
+
+    //The vertices are written with a separate lock
+    char pinned = trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED;
+    gim_trimesh_unpin_work_data(trimesh);
+
     gim_trimesh_update_vertices(trimesh);
     gim_trimesh_locks_work_data(trimesh);
     gim_trimesh_update_aabbset(trimesh);
@@ -303,6 +328,8 @@ void gim_trimesh_update(GIM_TRIMESH * trimesh)
 
     //Clear update flag
      trimesh->m_mask &= ~GIM_TRIMESH_NEED_UPDATE;
+
+    if(pinned) gim_trimesh_pin_work_data(trimesh);
 }
 
 void gim_trimesh_set_tranform(GIM_TRIMESH * trimesh, mat4f transform)
@@ -336,6 +363,16 @@ void gim_trimesh_get_triangle_data(GIM_TRIMESH * trimesh, GUINT32 triangle_index
     VEC_COPY(tri_data->m_vertices[1],transformed_vertices[triangle_indices[1]]);
     VEC_COPY(tri_data->m_vertices[2],transformed_vertices[triangle_indices[2]]);
 
+    if(trimesh->m_mask&GIM_TRIMESH_WORK_DATA_PINNED)
+    {
+        //The shared cache can't be written while several threads may be querying the trimesh
+        TRIANGLE_PLANE(tri_data->m_vertices[0],tri_data->m_vertices[1],tri_data->m_vertices[2],tri_data->m_planes.m_planes[0]);
+        EDGE_PLANE(tri_data->m_vertices[0],tri_data->m_vertices[1],(tri_data->m_planes.m_planes[0]),(tri_data->m_planes.m_planes[1]));
+        EDGE_PLANE(tri_data->m_vertices[1],tri_data->m_vertices[2],(tri_data->m_planes.m_planes[0]),(tri_data->m_planes.m_planes[2]));
+        EDGE_PLANE(tri_data->m_vertices[2],tri_data->m_vertices[0],(tri_data->m_planes.m_planes[0]),(tri_data->m_planes.m_planes[3]));
+        return;
+    }
+
     //Get the planes
     GIM_TRIPLANES_CACHE * planes = GIM_DYNARRAY_POINTER(GIM_TRIPLANES_CACHE,trimesh->m_planes_cache_buffer);
     planes += triangle_index;
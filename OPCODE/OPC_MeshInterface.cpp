@@ -139,6 +139,8 @@ MeshInterface::MeshInterface() :
 	mVertexStride	(sizeof(Point)),
 	mFetchTriangle	(&MeshInterface::FetchTriangleFromSingles),
 	mFetchExTriangle	(&MeshInterface::FetchExTriangleFromSingles),
+	mQuantizationOrigin	(0.0f, 0.0f, 0.0f),
+	mQuantizationScale	(1.0f, 1.0f, 1.0f),
 	#endif
 	mTris			(null),
 	mVerts			(null)
@@ -273,6 +275,32 @@ bool MeshInterface::SetStrides(udword tri_stride, udword vertex_stride)
 	mVertexStride	= vertex_stride;
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Quantized storage control: setups pointers to packed quantized data. Replaces the pointers, strides and precision settings.
+ *	\param		tris			[in] pointer to packed triangle vertex indices
+ *	\param		verts			[in] pointer to packed quantized vertices
+ *	\param		origin			[in] dequantization origin
+ *	\param		scale			[in] dequantization scale
+ *	\param		short_indices	[in] indicates whether triangle vertex indices are stored as uwords
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool MeshInterface::SetQuantizedPointers(const void* tris, const uword* verts, const Point& origin, const Point& scale, bool short_indices)
+{
+	if(!tris || !verts)	return SetIceError("MeshInterface::SetQuantizedPointers: pointer is null", null);
+
+	mTris	= (const IndexedTriangle*)tris;
+	mVerts	= (const Point*)verts;
+	mTriStride		= 3 * (short_indices ? sizeof(uword) : sizeof(udword));
+	mVertexStride	= 3 * sizeof(uword);
+	mQuantizationOrigin	= origin;
+	mQuantizationScale	= scale;
+	mFetchTriangle		= short_indices ? &MeshInterface::FetchTriangleFromQuantized<uword> : &MeshInterface::FetchTriangleFromQuantized<udword>;
+	mFetchExTriangle	= short_indices ? &MeshInterface::FetchExTriangleFromQuantized<uword> : &MeshInterface::FetchExTriangleFromQuantized<udword>;
+	return true;
+}
 #endif
 #endif
 
@@ -344,6 +372,42 @@ void MeshInterface::FetchExTriangleFromDoubles(VertexPointersEx& vpe, udword ind
 		vpe.vp.Vertex[i] = &vc[i];
 	}
 }
+
+template<typename TIndex>
+void MeshInterface::FetchTriangleFromQuantized(VertexPointers& vp, udword index, ConversionArea vc) const
+{
+	const TIndex* T = (const TIndex*)(((ubyte*)mTris) + index * mTriStride);
+
+	const uword* Verts = (const uword*)GetVerts();
+
+	for (int i = 0; i < 3; i++){
+		const uword* v = Verts + (udword)T[i] * 3;
+
+		vc[i].x = mQuantizationOrigin.x + (float)v[0] * mQuantizationScale.x;
+		vc[i].y = mQuantizationOrigin.y + (float)v[1] * mQuantizationScale.y;
+		vc[i].z = mQuantizationOrigin.z + (float)v[2] * mQuantizationScale.z;
+		vp.Vertex[i] = &vc[i];
+	}
+}
+
+template<typename TIndex>
+void MeshInterface::FetchExTriangleFromQuantized(VertexPointersEx& vpe, udword index, ConversionArea vc) const
+{
+	const TIndex* T = (const TIndex*)(((ubyte*)mTris) + index * mTriStride);
+
+	const uword* Verts = (const uword*)GetVerts();
+
+	for (int i = 0; i < 3; i++){
+		dTriIndex VertIndex = (dTriIndex)T[i];
+		vpe.Index[i] = VertIndex;
+
+		const uword* v = Verts + (udword)VertIndex * 3;
+		vc[i].x = mQuantizationOrigin.x + (float)v[0] * mQuantizationScale.x;
+		vc[i].y = mQuantizationOrigin.y + (float)v[1] * mQuantizationScale.y;
+		vc[i].z = mQuantizationOrigin.z + (float)v[2] * mQuantizationScale.z;
+		vpe.vp.Vertex[i] = &vc[i];
+	}
+}
 #endif
 #endif
 
@@ -148,6 +148,21 @@
 												mFetchExTriangle = (value ? &MeshInterface::FetchExTriangleFromSingles : &MeshInterface::FetchExTriangleFromDoubles);
 											}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Quantized storage control: setups pointers to packed quantized data. Replaces the pointers, strides and precision settings.
+		 *	Each vertex is stored as three uwords decoded as \a origin + value * \a scale per axis.
+		 *	Each triangle is stored as three uwords if \a short_indices is true or as three udwords otherwise.
+		 *	\param		tris			[in] pointer to packed triangle vertex indices
+		 *	\param		verts			[in] pointer to packed quantized vertices
+		 *	\param		origin			[in] dequantization origin
+		 *	\param		scale			[in] dequantization scale
+		 *	\param		short_indices	[in] indicates whether triangle vertex indices are stored as uwords
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						bool				SetQuantizedPointers(const void* tris, const uword* verts, const Point& origin, const Point& scale, bool short_indices);
+
 	#else
 		inline_			bool				SetStrides(udword tri_stride=sizeof(IndexedTriangle), udword vertex_stride=sizeof(Point)) { return true; }
 		inline_			void				SetSingle(bool value) {}
@@ -222,6 +237,10 @@
 		void				FetchTriangleFromDoubles(VertexPointers& vp, udword index, ConversionArea vc) const;
 		void				FetchExTriangleFromSingles(VertexPointersEx& vpe, udword index, ConversionArea vc) const;
 		void				FetchExTriangleFromDoubles(VertexPointersEx& vpe, udword index, ConversionArea vc) const;
+		template<typename TIndex>
+		void				FetchTriangleFromQuantized(VertexPointers& vp, udword index, ConversionArea vc) const;
+		template<typename TIndex>
+		void				FetchExTriangleFromQuantized(VertexPointersEx& vpe, udword index, ConversionArea vc) const;
 	#endif
 #endif
 
@@ -271,6 +290,8 @@
 						TriangleFetchProc	mFetchTriangle;
 				typedef	void (MeshInterface:: *ExTriangleFetchProc)(VertexPointersEx& vpe, udword index, ConversionArea vc) const;
 						ExTriangleFetchProc	mFetchExTriangle;
+						Point				mQuantizationOrigin;	//!< Dequantization origin for quantized vertices
+						Point				mQuantizationScale;		//!< Dequantization scale for quantized vertices
 	#endif
 						const	IndexedTriangle*	mTris;				//!< Array of indexed triangles
 						const	Point*				mVerts;				//!< Array of vertices
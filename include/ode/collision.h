@@ -742,6 +742,12 @@ ODE_API void dGeomGetOffsetQuaternion (dGeomID geom, dQuaternion result);
  */
 #define CONTACTS_UNIMPORTANT			0x80000000
 
+/*
+ *	Reduce each contact manifold to its deepest point and at most three
+ *	more points spanning the largest area.
+ */
+#define CONTACTS_REDUCED			0x40000000
+
 /**
  *
  * @brief Given two geoms o1 and o2 that potentially intersect,
@@ -759,6 +765,8 @@ ODE_API void dGeomGetOffsetQuaternion (dGeomID geom, dQuaternion result);
  * ask for at least one contact. 
  * Additionally, following bits may be set:
  * CONTACTS_UNIMPORTANT -- just generate any contacts (skip contact refining).
+ * CONTACTS_REDUCED -- keep at most 4 contacts per manifold, the deepest one
+ * and those spanning the largest area (see also dSpaceSetContactReduction).
  * All other bits in flags must be set to zero. In the future the other bits 
  * may be used to select from different contact generation strategies.
  *
@@ -787,6 +795,11 @@ ODE_API void dGeomGetOffsetQuaternion (dGeomID geom, dQuaternion result);
  * @remarks This function does not care if o1 and o2 are in the same space or not
  * (or indeed if they are in any space at all).
  *
+ * @remarks Convex and cylinder geoms remember the axes that separated them
+ * from other geoms to reject those pairs early in later calls. A geom may be
+ * collided with different geoms from several threads at once, but a particular
+ * pair of geoms must not be collided by several threads at once.
+ *
  * @ingroup collide
  */
 ODE_API int dCollide (dGeomID o1, dGeomID o2, int flags, dContactGeom *contact,
@@ -975,6 +988,49 @@ ODE_API void dGeomSetConvex (dGeomID g,
 			     const dReal *_points,
 			     unsigned int _pointcount,
                  const unsigned int *_polygons);
+
+/**
+ * @brief Create a convex geom from the convex hull of a point cloud.
+ *
+ * The hull is built with quickhull, coplanar triangles are merged into
+ * polygons and the resulting planes, points and polygons are owned by
+ * the geom. Points within rounding of the faces around them may be left
+ * out of the hull.
+ *
+ * @param space the space to add the geom to, or 0
+ * @param points array of pointcount points (x,y,z) in the geom frame,
+ *        the origin must lie inside their hull
+ * @param pointcount number of points
+ * @param maxvertices if not 0, the hull keeps at most that many (and at
+ *        least 4) vertices, adding the points furthest out first
+ * @returns the new geom, or 0 if the points do not span a volume
+ * @sa dGeomConvexFromPoints
+ */
+ODE_API dGeomID dCreateConvexFromPoints (dSpaceID space,
+                                         const dReal *points,
+                                         unsigned int pointcount,
+                                         unsigned int maxvertices);
+
+/**
+ * @brief Set the shape of a convex geom to the convex hull of a point cloud.
+ *
+ * Arrays built by a previous call are released; they are also released
+ * when dGeomSetConvex is called or the geom is destroyed.
+ *
+ * @param g the convex geom
+ * @param points array of pointcount points (x,y,z) in the geom frame,
+ *        the origin must lie inside their hull
+ * @param pointcount number of points
+ * @param maxvertices if not 0, the hull keeps at most that many (and at
+ *        least 4) vertices, adding the points furthest out first
+ * @returns 1 on success, 0 if the points do not span a volume, in which
+ *          case the geom is left unchanged
+ * @sa dCreateConvexFromPoints
+ */
+ODE_API int dGeomConvexFromPoints (dGeomID g,
+                                   const dReal *points,
+                                   unsigned int pointcount,
+                                   unsigned int maxvertices);
 /*<-- Convex Functions*/
 
 /**
@@ -1124,6 +1180,61 @@ typedef struct dxHeightfieldData* dHeightfieldDataID;
 typedef dReal dHeightfieldGetHeight( void* p_user_data, int x, int z );
 
 
+/**
+ * @brief Block callback prototype
+ *
+ * Used by the callback heightfield data type to sample heights for a
+ * rectangular block of sample positions at once.
+ *
+ * @param p_user_data User data specified when creating the dHeightfieldDataID
+ * @param x The index of the first sample of the block in the local x axis.
+ * @param z The index of the first sample of the block in the local z axis.
+ * @param num_x The number of samples of the block along the x axis.
+ * @param num_z The number of samples of the block along the z axis.
+ * @param heights Receives num_x * num_z sample heights, row-major along x
+ * (the height of sample (x + i, z + j) goes to heights[i + j * num_x]).
+ * The heights are then scaled and offset using the values specified when
+ * the heightfield data was created.
+ *
+ * @ingroup collide
+ */
+typedef void dHeightfieldGetHeightBlock( void* p_user_data, int x, int z,
+                                         int num_x, int num_z, dReal *heights );
+
+
+/**
+ * @brief Tile provider callback prototype
+ *
+ * Used by the tiled heightfield data type to make a tile resident,
+ * e.g. by loading it from disk or mapping it into memory.
+ *
+ * @param p_user_data User data specified when creating the dHeightfieldDataID
+ * @param tile_x The index of the tile in the local x axis.
+ * @param tile_z The index of the tile in the local z axis.
+ *
+ * @return Pointer to (tileSize + 1) * (tileSize + 1) raw sample heights of
+ * the tile, row-major along x, which must stay valid until the tile is
+ * released. NULL if the tile is not available, in which case collisions
+ * are not generated for its cells.
+ *
+ * @remarks The callback may be invoked from collision detection,
+ * concurrently if collisions are run from several threads.
+ *
+ * @ingroup collide
+ */
+typedef const float *dHeightfieldGetTile( void* p_user_data, int tile_x, int tile_z );
+
+/**
+ * @brief Tile release callback prototype
+ *
+ * Called when a tile previously returned by dHeightfieldGetTile is evicted
+ * or the heightfield data is destroyed.
+ *
+ * @ingroup collide
+ */
+typedef void dHeightfieldReleaseTile( void* p_user_data, int tile_x, int tile_z, const float *tile_samples );
+
+
 
 /**
  * @brief Creates a heightfield geom.
@@ -1220,6 +1331,23 @@ ODE_API void dGeomHeightfieldDataBuildCallback( dHeightfieldDataID d,
 				dReal width, dReal depth, int widthSamples, int depthSamples,
 				dReal scale, dReal offset, dReal thickness, int bWrap );
 
+/**
+ * @brief Configures a dHeightfieldDataID to use a block callback to
+ * retrieve height data.
+ *
+ * Same as dGeomHeightfieldDataBuildCallback, except that collision detection
+ * requests all samples under a geom with a single callback invocation,
+ * which allows procedural generators to fill the block efficiently.
+ * Blocks never cross the heightfield border; zones of wrapped heightfields
+ * which do are sampled one sample per invocation.
+ *
+ * @ingroup collide
+ */
+ODE_API void dGeomHeightfieldDataBuildCallbackBlock( dHeightfieldDataID d,
+				void* pUserData, dHeightfieldGetHeightBlock* pCallback,
+				dReal width, dReal depth, int widthSamples, int depthSamples,
+				dReal scale, dReal offset, dReal thickness, int bWrap );
+
 /**
  * @brief Configures a dHeightfieldDataID to use height data in byte format.
  *
@@ -1416,6 +1544,56 @@ ODE_API void dGeomHeightfieldDataBuildDouble( dHeightfieldDataID d,
 				dReal width, dReal depth, int widthSamples, int depthSamples,
 				dReal scale, dReal offset, dReal thickness, int bWrap );
 
+/**
+ * @brief Configures a dHeightfieldDataID to use tiled height data
+ * supplied on demand by a tile provider.
+ *
+ * Before a dHeightfieldDataID can be used by a geom it must be
+ * configured to specify the format of the height data.
+ * This call specifies that the heightfield is split into square tiles of
+ * tileSize by tileSize cells which are requested through pGetTile the first
+ * time collision detection needs them, and stay resident until evicted
+ * with dGeomHeightfieldDataEvictTile. Each tile holds tileSize + 1 samples
+ * per edge, so that neighbouring tiles share their border samples; samples
+ * past the heightfield border are ignored. Tile height bounds are computed
+ * when a tile is loaded and are kept after eviction to cull collisions
+ * without reloading the tile.
+ *
+ * As for callback data the height bounds default to +/- infinity and
+ * should be set with dGeomHeightfieldDataSetBounds. Tiles are only skipped
+ * for finite heightfields; with wrapping enabled, samples of tiles which
+ * are not available read as zero.
+ *
+ * @param d A new dHeightfieldDataID created by dGeomHeightfieldDataCreate
+ * @param pUserData User data passed to the provider callbacks.
+ * @param pGetTile Callback making a tile resident.
+ * @param pReleaseTile Callback releasing a resident tile, may be NULL.
+ * @param tileSize Number of cells on a tile edge.
+ *
+ * The remaining parameters are as for dGeomHeightfieldDataBuildCallback.
+ *
+ * @ingroup collide
+ */
+ODE_API void dGeomHeightfieldDataBuildTiled( dHeightfieldDataID d,
+				void* pUserData, dHeightfieldGetTile* pGetTile,
+				dHeightfieldReleaseTile* pReleaseTile, int tileSize,
+				dReal width, dReal depth, int widthSamples, int depthSamples,
+				dReal scale, dReal offset, dReal thickness, int bWrap );
+
+/**
+ * @brief Evicts a resident tile of tiled heightfield data.
+ *
+ * The tile is released with the provider release callback and will be
+ * requested again when collision detection needs it. Must not be called
+ * while collisions are being detected against the heightfield.
+ *
+ * @param d A dHeightfieldDataID set up by dGeomHeightfieldDataBuildTiled
+ * @param tileX The index of the tile in the local x axis.
+ * @param tileZ The index of the tile in the local z axis.
+ * @ingroup collide
+ */
+ODE_API void dGeomHeightfieldDataEvictTile( dHeightfieldDataID d, int tileX, int tileZ );
+
 /**
  * @brief Manually set the minimum and maximum height bounds.
  *
@@ -1427,6 +1605,9 @@ ODE_API void dGeomHeightfieldDataBuildDouble( dHeightfieldDataID d,
  * @remarks The minimum and maximum values are used to compute the AABB
  * for the heightfield which is used for early rejection of collisions.
  * A close fit will yield a more efficient collision check.
+ * For sample array data the call also refreshes the local height bounds
+ * used to cull parts of the heightfield, so referenced samples which were
+ * changed in place are picked up.
  *
  * @param d A dHeightfieldDataID created by dGeomHeightfieldDataCreate
  * @param min_height The new minimum height value. Scale, offset and thickness is then applied.
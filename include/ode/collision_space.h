@@ -114,6 +114,36 @@ ODE_API void dSpaceSetSublevel (dSpaceID space, int sublevel);
 ODE_API int dSpaceGetSublevel (dSpaceID space);
 
 
+/**
+* @brief Sets contact reduction mode for a space.
+*
+* When contact reduction is enabled, @c dCollide reduces the contacts generated
+* for a geom of the space as if @c CONTACTS_REDUCED were passed in its flags:
+* each manifold is cut down to its deepest point and at most three more points
+* spanning the largest area. This keeps the solver load of stacked boxes, meshes
+* and heightfields low when many contacts are requested.
+*
+* The mode applies to the geoms directly contained in the space only.
+*
+* @param space the space to modify
+* @param mode 1 to reduce contacts and 0 (the default) to keep them all
+* @ingroup collide
+* @see dSpaceGetContactReduction
+* @see dCollide
+*/
+ODE_API void dSpaceSetContactReduction (dSpaceID space, int mode);
+
+/**
+* @brief Gets contact reduction mode of a space.
+*
+* @param space the space to query
+* @returns 1 if contacts of the space geoms are reduced and 0 otherwise
+* @ingroup collide
+* @see dSpaceSetContactReduction
+*/
+ODE_API int dSpaceGetContactReduction (dSpaceID space);
+
+
 /**
 * @brief Sets manual cleanup flag for a space.
 *
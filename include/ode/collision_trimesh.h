@@ -255,8 +255,31 @@ ODE_API dGeomID dCreateTriMesh(dSpaceID space, dTriMeshDataID Data, dTriCallback
 ODE_API void dGeomTriMeshSetData(dGeomID g, dTriMeshDataID Data);
 ODE_API dTriMeshDataID dGeomTriMeshGetData(dGeomID g);
 
+/**
+ * @brief Sets a per-geom scale applied to the trimesh data in model space.
+ *
+ * The scale allows instancing a single trimesh data (and its bounding volume tree)
+ * among many geoms of different sizes. The vertices are scaled before the geom 
+ * rotation and position are applied. Scale factors must be positive. 
+ * The default is (1, 1, 1).
+ *
+ * Colliders query the shared tree with conservatively enlarged volumes for 
+ * scaled geoms and then test the exactly scaled triangles. Trimesh-trimesh 
+ * collisions involving a scaled geom fall back to testing all triangle pairs 
+ * within the geoms' bounding box overlap and thus are slower than for unscaled ones.
+ * Face angles built by preprocessing are not adjusted for non-uniform scale.
+ *
+ * @ingroup collide_trimesh
+ */
+ODE_API void dGeomTriMeshSetScale(dGeomID g, dReal sx, dReal sy, dReal sz);
+ODE_API void dGeomTriMeshGetScale(dGeomID g, dVector3 result);
+
 
-/* enable/disable/check temporal coherence*/
+/*
+ * enable/disable/check temporal coherence
+ * Temporal coherence is disabled by default. With GIMPACT it is only
+ * implemented for boxes (also used for cylinders).
+ */
 ODE_API void dGeomTriMeshEnableTC(dGeomID g, int geomClass, int enable);
 ODE_API int dGeomTriMeshIsTCEnabled(dGeomID g, int geomClass);
 
@@ -265,6 +288,11 @@ ODE_API int dGeomTriMeshIsTCEnabled(dGeomID g, int geomClass);
  * collision checked with a trimesh once, data is stored inside the trimesh.
  * With large worlds with lots of seperate objects this list could get huge.
  * We should be able to do this automagically.
+ *
+ * The caches may be populated concurrently when the same trimesh is collided
+ * against different geoms from several threads (with OPCODE this requires
+ * ODE to be configured with TLS enabled). They must not be cleared while any
+ * collision involving the trimesh is in progress.
  */
 ODE_API void dGeomTriMeshClearTCCache(dGeomID g);
 
@@ -308,6 +336,30 @@ ODE_API int dGeomTriMeshGetTriangleCount (dGeomID g);
 
 ODE_API void dGeomTriMeshDataUpdate(dTriMeshDataID g);
 
+/**
+ * @brief Replaces the references to application's vertex and index arrays with a compact ODE-owned copy.
+ *
+ * The vertices are quantized to 16 bits per coordinate relative to the mesh bounding box 
+ * and the triangle indices are packed to 16 bits whenever the vertex count allows that. 
+ * This reduces the memory footprint of large static meshes and improves cache utilization 
+ * during collision queries at the cost of a position error of up to 1/131070 of the 
+ * bounding box size along each axis.
+ *
+ * After a successful call the application arrays passed to the build function (including
+ * the face normals, if any) are not accessed anymore and may be freed. Consequently, @c dGeomTriMeshDataUpdate will not
+ * pick up any later changes to those arrays. The data needs to be rebuilt with one of 
+ * build functions to replace the compact copy.
+ *
+ * The function is to be called after the data has been built and, optionally, 
+ * preprocessed. It is only supported with OPCODE trimesh implementation.
+ *
+ * @param g The trimesh data to compact
+ * @return 1 on success, 0 if compaction is not supported, the data has already been 
+ *         compacted or the compaction failed (in these cases the data stays unmodified)
+ * @ingroup collide_trimesh
+ */
+ODE_API int dGeomTriMeshDataCompact(dTriMeshDataID g);
+
 #ifdef __cplusplus
 }
 #endif
@@ -368,6 +368,7 @@ typedef struct dxGeom *dGeomID;
 typedef struct dxJoint *dJointID;
 typedef struct dxJointGroup *dJointGroupID;
 typedef struct dxWorldProcessThreadingManager *dWorldStepThreadingManagerID;
+typedef struct dxWorldStepRequest *dWorldStepRequestID;
 
 /* error numbers */
 
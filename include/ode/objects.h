@@ -171,6 +171,67 @@ ODE_API void dWorldSetStepIslandsProcessingMaxThreadCount(dWorldID w, unsigned c
  */
 ODE_API unsigned dWorldGetStepIslandsProcessingMaxThreadCount(dWorldID w);
 
+/**
+ * @brief Enable or disable deterministic stepping mode.
+ *
+ * In deterministic mode the results of @c dWorldStep and @c dWorldQuickStep 
+ * (as well as of their batch, asynchronous and frame variants) depend only on 
+ * the world state and the random seed (see @c dWorldSetStepRandomSeed) and 
+ * are the same bit for bit regardless of the threading implementation used 
+ * and of the thread count.
+ *
+ * The mode changes the following:
+ * @li Constraint reordering of @c dWorldQuickStep uses a random sequence seeded 
+ * per island instead of the global one of @c dRand.
+ * @li The geoms of the bodies moved are notified after all the islands have been 
+ * stepped, in the order of bodies in the world, rather than as the bodies 
+ * are stepped. This keeps the geom order in spaces and hence the order 
+ * of collision pairs independent of thread timing.
+ * @li Each island is stepped by a single thread. Islands are still stepped 
+ * in parallel with each other.
+ *
+ * The order of body moved callbacks (see @c dBodySetMovedCallback) is 
+ * still not deterministic in multithreaded stepping. Bodies with continuous 
+ * collision detection spaces are not covered either. The results are only
+ * reproducible with the same library build.
+ *
+ * The mode is disabled by default.
+ *
+ * @param w The world affected
+ * @param mode Non-zero to enable deterministic mode, zero to disable it
+ * @ingroup world
+ * @see dWorldGetStepDeterministic
+ * @see dWorldSetStepRandomSeed
+ */
+ODE_API void dWorldSetStepDeterministic(dWorldID w, int mode);
+/**
+ * @brief Get whether deterministic stepping mode is enabled.
+ * @ingroup world
+ * @see dWorldSetStepDeterministic
+ */
+ODE_API int dWorldGetStepDeterministic(dWorldID w);
+
+/**
+ * @brief Set the seed for random sequences of the next step.
+ *
+ * The seed is advanced by every step and the islands derive seeds of their own 
+ * from it. Saving the seed along with the world state allows to reproduce 
+ * the following steps in deterministic mode. New worlds start with zero seed.
+ *
+ * @param w The world affected
+ * @param seed The seed value
+ * @ingroup world
+ * @see dWorldSetStepDeterministic
+ * @see dWorldGetStepRandomSeed
+ */
+ODE_API void dWorldSetStepRandomSeed(dWorldID w, unsigned long seed);
+/**
+ * @brief Get the seed for random sequences of the next step.
+ * @ingroup world
+ * @see dWorldSetStepRandomSeed
+ */
+ODE_API unsigned long dWorldGetStepRandomSeed(dWorldID w);
+
 /**
  * @brief Set the world to use shared working memory along with another world.
  *
@@ -201,6 +262,10 @@ ODE_API unsigned dWorldGetStepIslandsProcessingMaxThreadCount(dWorldID w);
  * when the other world is assigned a multi-threaded implementation). 
  * For more information read section about threading approaches in ODE.
  *
+ * The worlds sharing working memory can't be stepped concurrently. In particular, 
+ * none of them may be stepped while another one has an asynchronous step in flight 
+ * (see @c dWorldStepAsync).
+ *
  * Failure result status means a memory allocation failure.
  *
  * @param w The world to use the shared memory with.
@@ -347,6 +412,34 @@ typedef struct
 */
 ODE_API int dWorldSetStepMemoryManager(dWorldID w, const dWorldStepMemoryFunctionsInfo *memfuncs);
 
+/**
+* @brief Set NUMA node for the world's simulation stepping memory to be placed on
+*
+* The function lets the working memory of a world be kept on the NUMA node of 
+* the threads that step it, e.g. the node a built-in thread pool serving the world's 
+* threading implementation has been bound to with @c dThreadingThreadPoolAffinityNUMANode.
+* While a node is set the working memory blocks are mapped from the system 
+* directly, bypassing the functions of the world's memory manager, so that the 
+* placement policy does not outlive the blocks. The working memory allocated so far 
+* is released for it to be allocated anew on the next step.
+*
+* The placement is only supported on Linux. Elsewhere the function fails unless
+* @a numa_node is -1.
+*
+* If the world uses working memory sharing, changing the node
+* affects all the worlds linked together. Resetting the memory manager with 
+* @c dWorldSetStepMemoryManager resets the node as well.
+*
+* @param w The world to change memory placement for.
+* @param numa_node Index of the NUMA node or -1 to leave the placement to the system.
+* @returns 1 for success and 0 for failure.
+*
+* @ingroup world
+* @see dWorldSetStepMemoryManager
+* @see dThreadingAllocateThreadPool
+*/
+ODE_API int dWorldSetStepMemoryNUMANode(dWorldID w, int numa_node/*=-1*/);
+
 /**
  * @brief Assign threading implementation to be used for [quick]stepping the world.
  *
@@ -427,6 +520,466 @@ ODE_API int dWorldStep (dWorldID w, dReal stepsize);
 ODE_API int dWorldQuickStep (dWorldID w, dReal stepsize);
 
 
+/**
+ * @brief Step several worlds at once.
+ *
+ * The function is equivalent to calling @c dWorldStep for each of the worlds
+ * except that the islands of all the worlds are posted for processing 
+ * together and the call only waits for them after that. With a multi-threaded
+ * threading implementation this lets the threads that run out of islands in one 
+ * world continue with islands of the others instead of waiting for a larger 
+ * world to finish. This helps most with many small worlds that would not keep
+ * all the threads busy being stepped one after another.
+ *
+ * All the worlds must have the same threading implementation assigned (or all 
+ * use the default one) and none of them may share working memory with another 
+ * world of the batch. As the worlds are stepped concurrently, geoms of bodies 
+ * of different worlds must not share a space, including the spaces swept by 
+ * continuous collision (see @c dBodySetCCD). Islands are built by the calling 
+ * thread before the calls are posted.
+ *
+ * Failure result status means that the memory allocation has failed for operation.
+ * If it has failed while the worlds were being prepared, before any islands 
+ * were posted, all the objects remain in unchanged state and simulation can be
+ * retried as soon as more memory is available. Once the islands have been posted 
+ * all the worlds are processed to the end and a failure reported by the stepping 
+ * of any of them fails the whole batch. Some or all of the worlds may have been 
+ * stepped then, and the batch must not be simply retried. Step the worlds 
+ * one by one with @c dWorldStep if the exact state of each of them after 
+ * a failure matters.
+ *
+ * @param worlds The array of worlds to be stepped
+ * @param world_count Number of worlds in the array
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns 1 for success and 0 for failure
+ *
+ * @ingroup world
+ * @see dWorldStep
+ * @see dWorldSetStepThreadingImplementation
+ */
+ODE_API int dWorldStepBatch (dWorldID *worlds, unsigned world_count, dReal stepsize);
+
+/**
+ * @brief Quick-step several worlds at once.
+ *
+ * This is the @c dWorldQuickStep counterpart of @c dWorldStepBatch. 
+ * The same requirements apply.
+ *
+ * @param worlds The array of worlds to be stepped
+ * @param world_count Number of worlds in the array
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns 1 for success and 0 for failure
+ *
+ * @ingroup world
+ * @see dWorldQuickStep
+ * @see dWorldStepBatch
+ */
+ODE_API int dWorldQuickStepBatch (dWorldID *worlds, unsigned world_count, dReal stepsize);
+
+
+/**
+ * @brief Start stepping the world without waiting for the step to complete.
+ *
+ * The function performs the same work as @c dWorldStep but returns as soon as 
+ * the islands have been built and posted to the world's threading implementation.
+ * The calling thread is then free to do other work while the pool threads step 
+ * the world. The request returned must be passed to @c dWorldStepRequestWait 
+ * exactly once to complete the step and to release the request.
+ *
+ * While the step is in flight the world and everything in it belong to the 
+ * stepping threads. Until @c dWorldStepRequestWait returns the caller must not:
+ * @li step, destroy or start another asynchronous step for the world;
+ * @li create, destroy, enable, disable or modify bodies and joints of the world,
+ *     or attach joints to them (this includes creating contact joints);
+ * @li change the world's parameters, working memory, memory policies or 
+ *     threading implementation;
+ * @li read body positions, velocities or joint feedback of the world, as these
+ *     are being updated concurrently;
+ * @li step any other world sharing working memory with the world 
+ *     (see @c dWorldUseSharedWorkingMemory), synchronously or asynchronously, 
+ *     as the stepping data are kept in that memory.
+ * The stepping threads move the geoms of the world's bodies, which relinks 
+ * them in their spaces and marks their bounding boxes for recomputation. 
+ * Therefore only the spaces that contain no geoms of the world's bodies 
+ * (e.g. a space of static geoms only) may be collided during the step, 
+ * and the geoms of the world's bodies must not be passed to collision 
+ * functions such as @c dCollide or @c dSpaceCollide2. The spaces swept by 
+ * the world's bodies for continuous collision (see @c dBodySetCCD) are 
+ * collided by the stepping threads and must not be collided either.
+ * Stepping the worlds with working memory of their own and unrelated 
+ * application work are safe.
+ *
+ * With the built-in self-threaded implementation (the default) no other threads 
+ * exist and the step is carried out by the thread that polls or waits for it.
+ *
+ * @param w The world to be stepped
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns A request to be waited for, or NULL if the memory allocation has failed.
+ * In the latter case all the objects remain in unchanged state and simulation 
+ * can be retried as soon as more memory is available.
+ *
+ * @ingroup world
+ * @see dWorldStep
+ * @see dWorldStepRequestPoll
+ * @see dWorldStepRequestWait
+ */
+ODE_API dWorldStepRequestID dWorldStepAsync (dWorldID w, dReal stepsize);
+
+/**
+ * @brief Start quick-stepping the world without waiting for the step to complete.
+ *
+ * This is the @c dWorldQuickStep counterpart of @c dWorldStepAsync. 
+ * The same rules apply while the step is in flight.
+ *
+ * @param w The world to be stepped
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns A request to be waited for, or NULL if the memory allocation has failed.
+ *
+ * @ingroup world
+ * @see dWorldQuickStep
+ * @see dWorldStepAsync
+ */
+ODE_API dWorldStepRequestID dWorldQuickStepAsync (dWorldID w, dReal stepsize);
+
+/**
+ * @brief Check whether an asynchronous step has completed.
+ *
+ * The function does not block. Once it has returned non-zero the world 
+ * is no longer being modified, however @c dWorldStepRequestWait still has 
+ * to be called to release the request.
+ *
+ * @param request The request returned by @c dWorldStepAsync or @c dWorldQuickStepAsync
+ * @returns 1 if the step has completed and 0 otherwise
+ *
+ * @ingroup world
+ * @see dWorldStepRequestWait
+ */
+ODE_API int dWorldStepRequestPoll (dWorldStepRequestID request);
+
+/**
+ * @brief Wait for an asynchronous step to complete and release the request.
+ *
+ * The request must not be used after this call.
+ *
+ * @param request The request returned by @c dWorldStepAsync or @c dWorldQuickStepAsync
+ * @returns 1 for success and 0 for failure (the meaning of failure is 
+ * the same as for @c dWorldStep)
+ *
+ * @ingroup world
+ * @see dWorldStepRequestPoll
+ */
+ODE_API int dWorldStepRequestWait (dWorldStepRequestID request);
+
+/**
+ * @brief Get the world an asynchronous step request belongs to.
+ * @ingroup world
+ */
+ODE_API dWorldID dWorldStepRequestGetWorld (dWorldStepRequestID request);
+
+
+/**
+ * @brief Callback to adjust contacts generated for a geom pair by frame stepping.
+ *
+ * The callback is invoked after the contacts of the pair have been generated
+ * and the @c surface member of each has been initialized from 
+ * @c dWorldFrameParameters::surface. It may change the surface parameters 
+ * and the friction directions of the contacts, reorder them or drop some.
+ *
+ * The callback is invoked from the threads of the world's threading 
+ * implementation, possibly for several pairs at once, and it must not 
+ * modify the world, its bodies and joints or the space.
+ *
+ * @param data The @c callback_data of the frame parameters
+ * @param o1 The first geom of the pair
+ * @param o2 The second geom of the pair
+ * @param contacts The contacts generated for the pair
+ * @param contact_count The number of contacts in the array (always positive)
+ * @returns The number of leading contacts to create joints for 
+ * (zero to ignore the pair)
+ *
+ * @ingroup world
+ * @see dWorldFrameParameters
+ */
+typedef int dFrameContactCallback (void *data, dGeomID o1, dGeomID o2, 
+                                   dContact *contacts, int contact_count);
+
+/**
+ * @struct dWorldFrameParameters
+ * @brief Collision parameters for @c dWorldStepFrame and @c dWorldQuickStepFrame.
+ *
+ * @c struct_size should be assigned the size of the structure.
+ *
+ * @c max_contacts is the maximum number of contacts to generate for a geom pair.
+ * It must be in range 1..0xFFFF.
+ *
+ * @c surface is the surface assigned to every contact generated.
+ *
+ * @c contact_callback is an optional callback to adjust the contacts of a pair
+ * before joints are created for them (see @c dFrameContactCallback).
+ * @c callback_data is passed to it.
+ *
+ * @c contact_group is the joint group to create contact joints in. 
+ * The group is not emptied by the frame stepping functions.
+ *
+ * @ingroup world
+ * @see dWorldQuickStepFrame
+ */
+typedef struct
+{
+  unsigned struct_size;
+  unsigned max_contacts;
+  dSurfaceParameters surface;
+  dFrameContactCallback *contact_callback;
+  void *callback_data;
+  dJointGroupID contact_group;
+
+} dWorldFrameParameters;
+
+/**
+ * @brief Collide a space and step the world with the contacts in a single call.
+ *
+ * The function replaces the usual frame sequence of @c dSpaceCollide with 
+ * a near callback creating contact joints followed by @c dWorldStep.
+ * The broadphase is run by the calling thread and collects the geom pairs to 
+ * be tested (nested spaces are descended into). The pairs are then collided 
+ * with @c dCollide by the threads of the world's threading implementation. 
+ * Contact joints are created serially, in the order the broadphase reported 
+ * the pairs, and the world is stepped on the same threading implementation.
+ *
+ * Pairs are skipped if neither geom has an enabled body or if the bodies 
+ * are connected by a non-contact joint. The pairs with heightfields or 
+ * user class geoms are all collided by the same thread, one after another, 
+ * as the heightfield colliders keep scratch data in the geoms and the user 
+ * class colliders are not required to be reentrant. So are the pairs with 
+ * trimeshes if the library has been configured without TLS for global caches, 
+ * as all the trimesh colliders share the same caches then.
+ *
+ * If the world's threading implementation has threads of its own, the pool
+ * must have been allocated with collision data allocation flags 
+ * (see @c dAllocateODEDataForThread) as they run collision tests.
+ *
+ * @param w The world to be stepped
+ * @param space The space with the geoms of the world
+ * @param parameters The collision parameters
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns 1 for success and 0 for failure. Failure means that the memory 
+ * allocation has failed. No contact joints are created if that happens 
+ * during collision.
+ *
+ * @ingroup world
+ * @see dWorldStep
+ * @see dWorldQuickStepFrame
+ */
+ODE_API int dWorldStepFrame (dWorldID w, dSpaceID space, 
+                             const dWorldFrameParameters *parameters, dReal stepsize);
+
+/**
+ * @brief Collide a space and quick-step the world with the contacts in a single call.
+ *
+ * This is the @c dWorldQuickStep counterpart of @c dWorldStepFrame.
+ *
+ * @param w The world to be stepped
+ * @param space The space with the geoms of the world
+ * @param parameters The collision parameters
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns 1 for success and 0 for failure
+ *
+ * @ingroup world
+ * @see dWorldQuickStep
+ * @see dWorldStepFrame
+ */
+ODE_API int dWorldQuickStepFrame (dWorldID w, dSpaceID space, 
+                                  const dWorldFrameParameters *parameters, dReal stepsize);
+
+
+/**
+ * @brief Island index value of the world level profile events.
+ * @ingroup world
+ */
+#define dSTEPPROFILE_NO_ISLAND (~0U)
+
+/**
+ * @brief Kinds of world step profile events.
+ *
+ * @c dSTEPPROFILE_EVENT_WORLD events are world level phases of a step 
+ * (island building, stepping of all the islands, frame collision) recorded 
+ * in the thread that has called the stepping function.
+ *
+ * @c dSTEPPROFILE_EVENT_ISLAND events span an island from the start of its 
+ * stepper to the completion of its last stage, possibly in another thread.
+ *
+ * @c dSTEPPROFILE_EVENT_QUEUED events span the time an island has waited 
+ * for a thread to start its stepper after the island was selected for stepping.
+ *
+ * @c dSTEPPROFILE_EVENT_STAGE events are parts of stepper stages executed 
+ * by a thread (e.g. "QuickStepIsland Stage2a" or narrowphase jobs of a frame).
+ * A stage may run nested into 
+ * another one in the same thread when the island is stepped by a single thread.
+ *
+ * @ingroup world
+ */
+enum
+{
+  dSTEPPROFILE_EVENT_WORLD,
+  dSTEPPROFILE_EVENT_ISLAND,
+  dSTEPPROFILE_EVENT_QUEUED,
+  dSTEPPROFILE_EVENT_STAGE
+};
+
+/**
+ * @struct dWorldStepProfileEvent
+ * @brief A world step profile event.
+ *
+ * @c name is a static string naming the phase or the stage.
+ *
+ * @c kind is one of @c dSTEPPROFILE_EVENT_* values.
+ *
+ * @c step_index is the number of the step the event belongs to, counted from 
+ * the moment profiling was enabled or reset.
+ *
+ * @c island_index is the index of the island within the step or 
+ * @c dSTEPPROFILE_NO_ISLAND for world level events.
+ *
+ * @c thread_index identifies the thread that has recorded the event. 
+ * Threads are numbered in the order of their first event.
+ *
+ * @c start_time is the time of the event start in seconds since profiling 
+ * was enabled or reset and @c duration is the event duration in seconds.
+ *
+ * @c self_time is the duration less the durations of stage events nested into
+ * the event in the same thread. It equals @c duration for events of other kinds.
+ *
+ * @ingroup world
+ * @see dWorldGetStepProfileEvents
+ */
+typedef struct
+{
+  const char *name;
+  int kind;
+  unsigned step_index;
+  unsigned island_index;
+  unsigned thread_index;
+  double start_time;
+  double duration;
+  double self_time;
+
+} dWorldStepProfileEvent;
+
+/**
+ * @struct dWorldStepProfileThreadStats
+ * @brief Utilization of a thread in the profiled steps.
+ *
+ * @c busy_time is the time the thread has spent executing stepper stages 
+ * and frame narrowphase jobs. 
+ * @c idle_time is the remainder of the time the world has spent in the 
+ * threaded phases (the total duration of "World Islands Stepping" and 
+ * "World Frame Narrowphase" events).
+ * @c stage_count is the number of stage events recorded by the thread.
+ *
+ * @ingroup world
+ * @see dWorldGetStepProfileThreadStats
+ */
+typedef struct
+{
+  double busy_time;
+  double idle_time;
+  unsigned stage_count;
+
+} dWorldStepProfileThreadStats;
+
+/**
+ * @brief Enable or disable profiling of world stepping.
+ *
+ * When enabled, the stepping functions record the durations of world level 
+ * phases, of islands and of individual stepper stages along with the threads
+ * they have been executed in. Besides the durations, the recorded events show 
+ * how long islands have waited in threading implementation queues and how 
+ * much time the threads have been idle.
+ *
+ * Events are recorded into a buffer of fixed capacity. When the buffer is full,
+ * the following events are dropped and counted. Enabling the profiling 
+ * for an already profiled world discards the events recorded.
+ *
+ * The timing uses the stopwatch facility of the library (see @c dStopwatchStart)
+ * and its resolution depends on the platform.
+ *
+ * @param w The world affected
+ * @param max_events The capacity of the event buffer or zero to disable profiling
+ * @returns 1 for success and 0 for failure. Failure means the memory allocation has failed.
+ * @ingroup world
+ * @see dWorldGetStepProfileEvents
+ * @see dWorldWriteStepProfileTrace
+ */
+ODE_API int dWorldSetStepProfiling (dWorldID w, unsigned max_events);
+/**
+ * @brief Get the capacity of the profile event buffer (zero if profiling is disabled).
+ * @ingroup world
+ * @see dWorldSetStepProfiling
+ */
+ODE_API unsigned dWorldGetStepProfiling (dWorldID w);
+/**
+ * @brief Discard the events recorded and restart the profile time and step counting.
+ * @ingroup world
+ * @see dWorldSetStepProfiling
+ */
+ODE_API void dWorldResetStepProfile (dWorldID w);
+/**
+ * @brief Get the count of events dropped since the buffer has become full.
+ * @ingroup world
+ * @see dWorldSetStepProfiling
+ */
+ODE_API unsigned dWorldGetStepProfileDroppedEventCount (dWorldID w);
+
+/**
+ * @brief Retrieve the profile events recorded.
+ *
+ * The events are retrieved in the order of their start times.
+ * The function may be called with zero @p max_count to query the event count.
+ *
+ * @param w The world queried
+ * @param events The array to store the events into
+ * @param max_count The capacity of the array
+ * @returns The total count of events recorded (which may exceed @p max_count)
+ * or zero if profiling is disabled or memory allocation has failed.
+ * @ingroup world
+ * @see dWorldStepProfileEvent
+ */
+ODE_API unsigned dWorldGetStepProfileEvents (dWorldID w, 
+                                             dWorldStepProfileEvent *events, unsigned max_count);
+
+/**
+ * @brief Retrieve the utilization statistics of the threads that have recorded events.
+ *
+ * The statistics are stored in the order of thread indices. 
+ * The function may be called with zero @p max_count to query the thread count.
+ *
+ * @param w The world queried
+ * @param stats The array to store the statistics into
+ * @param max_count The capacity of the array
+ * @returns The total count of threads (which may exceed @p max_count)
+ * or zero if profiling is disabled or memory allocation has failed.
+ * @ingroup world
+ * @see dWorldStepProfileThreadStats
+ */
+ODE_API unsigned dWorldGetStepProfileThreadStats (dWorldID w, 
+                                                  dWorldStepProfileThreadStats *stats, unsigned max_count);
+
+/**
+ * @brief Write the profile events in Chrome trace event format.
+ *
+ * The JSON written can be loaded into chrome://tracing or compatible viewers.
+ * World and stage events are shown as nested slices of their threads while 
+ * island and queued events are shown as asynchronous spans.
+ *
+ * @param w The world queried
+ * @param f The file to write to
+ * @returns 1 for success and 0 for failure (profiling is disabled, 
+ * memory allocation or writing has failed)
+ * @ingroup world
+ */
+ODE_API int dWorldWriteStepProfileTrace (dWorldID w, FILE *f);
+
+
 /**
 * @brief Converts an impulse to a force.
 * @ingroup world
@@ -1480,6 +2033,53 @@ ODE_API dReal dBodyGetMaxAngularSpeed (dBodyID b);
 ODE_API void dBodySetMaxAngularSpeed(dBodyID b, dReal max_speed);
 
 
+/**
+ * @brief Enable continuous collision detection for a body.
+ *
+ * A fast body may pass through a thin geom within one step without ever
+ * touching it at the step ends. With CCD enabled, a sphere of the given
+ * radius centered at the body's point of reference is swept along the
+ * motion of each step through the space, and the body is stopped where
+ * the sphere first touches a static geom (a geom without a body) its
+ * geoms collide with. The contacts generated by the next collision pass
+ * then take over.
+ *
+ * The sweep only runs for steps moving the body further than the radius.
+ * Choose a radius for a sphere contained in the body's geoms, so that
+ * the body touches whatever stopped the sphere. The space must outlive
+ * the setting.
+ *
+ * The sweeps collide the sphere with the geoms of the space from the
+ * threads stepping the world. Like any thread calling @c dCollide, these
+ * must have collision data allocated: pool threads with
+ * @c dAllocateFlagCollisionData passed to @c dThreadingAllocateThreadPool,
+ * other threads with @c dAllocateODEDataForThread. Otherwise sweeps
+ * against trimeshes fail where the collision data are kept per thread.
+ *
+ * @param b the body.
+ * @param space the space to sweep, 0 to disable CCD (the default).
+ * @param radius the radius of the swept sphere, must be positive.
+ * @ingroup bodies
+ */
+ODE_API void dBodySetCCD (dBodyID b, dSpaceID space, dReal radius);
+
+/**
+ * @brief Get the space swept for a body's continuous collision detection.
+ * @return the space, or 0 if CCD is disabled.
+ * @ingroup bodies
+ * @sa dBodySetCCD()
+ */
+ODE_API dSpaceID dBodyGetCCDSpace (dBodyID b);
+
+/**
+ * @brief Get the radius of a body's swept sphere.
+ * @return the radius, or 0 if CCD is disabled.
+ * @ingroup bodies
+ * @sa dBodySetCCD()
+ */
+ODE_API dReal dBodyGetCCDRadius (dBodyID b);
+
+
 
 /**
  * @brief Get the body's gyroscopic state.
@@ -1608,6 +2208,31 @@ ODE_API dJointID dJointCreateSlider (dWorldID, dJointGroupID);
  */
 ODE_API dJointID dJointCreateContact (dWorldID, dJointGroupID, const dContact *);
 
+/**
+ * @brief Create a new contact joint in a concurrent joint group.
+ * @ingroup joints
+ *
+ * The function may be called from several threads at once as long as each 
+ * thread uses its own segment of the group. It does not lock and does not touch 
+ * the world or the bodies. The joint is linked into the world and attached to
+ * the bodies later, by @c dJointGroupLinkJoints or automatically when the world
+ * is stepped.
+ *
+ * Until the joint is linked, only @c dJointSetFeedback and @c dJointSetData 
+ * may be called for it.
+ *
+ * @param group A group created with @c dJointGroupCreateConcurrent
+ * @param segment The segment of the group to allocate the joint in (typically
+ * the index of the calling thread)
+ * @param contact The contact information
+ * @param b1 The first body to attach the joint to (may be 0)
+ * @param b2 The second body to attach the joint to (may be 0)
+ * @returns The joint created
+ * @see dJointGroupCreateConcurrent
+ */
+ODE_API dJointID dJointCreateContactConcurrent (dJointGroupID group, unsigned segment,
+                                                const dContact *contact, dBodyID b1, dBodyID b2);
+
 /**
  * @brief Create a new joint of the hinge2 type.
  * @ingroup joints
@@ -1743,6 +2368,44 @@ ODE_API void dJointGroupDestroy (dJointGroupID);
  */
 ODE_API void dJointGroupEmpty (dJointGroupID);
 
+/**
+ * @brief Create a joint group for contact joints created from several threads.
+ * @ingroup joints
+ *
+ * The group is divided into segments, each with its own storage. Threads 
+ * create contact joints in their own segments with @c dJointCreateContactConcurrent
+ * without any synchronization. The joints are linked into the world serially, 
+ * segment by segment in the order of their creation, at the start of 
+ * @c dWorldStep, @c dWorldQuickStep and the other world stepping functions, or 
+ * explicitly by @c dJointGroupLinkJoints. If the threads are assigned the same 
+ * pairs in every run, the order of the joints (and thus the simulation) is 
+ * reproducible.
+ *
+ * The group can also be used with the normal joint creation functions, 
+ * from a single thread. It is emptied and destroyed as any other group.
+ * Neither may happen while joints are being created in it.
+ *
+ * @param w The world the joints of the group are to be created in
+ * @param segment_count The number of segments (typically the number of 
+ * threads creating contacts)
+ * @returns The group created or 0 if memory allocation has failed
+ * @see dJointCreateContactConcurrent
+ */
+ODE_API dJointGroupID dJointGroupCreateConcurrent (dWorldID w, unsigned segment_count);
+
+/**
+ * @brief Link the joints created in a concurrent joint group into the world.
+ * @ingroup joints
+ *
+ * The joints created since the last call are linked into the world and 
+ * attached to their bodies. The world stepping functions do this automatically 
+ * for all the concurrent groups of the world. The function must not be called 
+ * while joints are being created in the group.
+ *
+ * @see dJointGroupCreateConcurrent
+ */
+ODE_API void dJointGroupLinkJoints (dJointGroupID group);
+
 /**
  * @brief Return the number of bodies attached to the joint
  * @ingroup joints
@@ -87,6 +87,28 @@ ODE_API dThreadingImplementationID dThreadingAllocateSelfThreadedImplementation(
  */
 ODE_API dThreadingImplementationID dThreadingAllocateMultiThreadedImplementation();
 
+/**
+ * @brief Allocates built-in work-stealing multi-threaded threading implementation object.
+ *
+ * The implementation is served the same way as the one from 
+ * @c dThreadingAllocateMultiThreadedImplementation but keeps ready calls in
+ * per-thread stacks instead of a single list shared by all the threads. 
+ * A thread runs the calls of its own stack and steals calls from the other 
+ * stacks when it runs out of them. Calls waiting for dependencies are not 
+ * looked at until they become ready. This keeps the scheduling overhead low 
+ * when many threads serve the implementation or when a lot of small calls 
+ * are posted, as the stepper does.
+ * 
+ * @returns ID of object allocated or NULL on failure
+ * 
+ * @ingroup threading
+ * @see dThreadingAllocateMultiThreadedImplementation
+ * @see dThreadingThreadPoolServeMultiThreadedImplementation
+ * @see dExternalThreadingServeMultiThreadedImplementation
+ * @see dThreadingFreeImplementation
+ */
+ODE_API dThreadingImplementationID dThreadingAllocateWorkStealingImplementation();
+
 /**
  * @brief Retrieves the functions record of a built-in threading implementation.
  *
@@ -191,12 +213,88 @@ ODE_API void dExternalThreadingServeMultiThreadedImplementation(dThreadingImplem
   dThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/);
 
 
+/**
+ * @brief Waiting policies of built-in thread pool threads.
+ *
+ * The policy defines what pool threads do when they run out of calls to process 
+ * and what the thread waiting for a call completion does while the pool is serving 
+ * an implementation.
+ *
+ * @c dThreadingThreadPoolWaitPark blocks the threads in the system immediately. 
+ * This costs no CPU time while idle but every wakeup goes through the scheduler.
+ *
+ * @c dThreadingThreadPoolWaitYield makes the threads yield their time slices 
+ * for a while checking for new work in between before blocking.
+ *
+ * @c dThreadingThreadPoolWaitSpin makes the threads busy-spin for a while, then 
+ * yield, and only then block. This gives the lowest latency of transitions between 
+ * stepper stages at the cost of burning CPU while the pool is idle between steps.
+ *
+ * @ingroup threading
+ * @see dThreadingThreadPoolParameters
+ */
+enum dThreadingThreadPoolWaitPolicy {
+    dThreadingThreadPoolWaitPark = 0, /*@< Block in the system as soon as there is nothing to do*/
+    dThreadingThreadPoolWaitYield = 1, /*@< Yield time slices for a while before blocking*/
+    dThreadingThreadPoolWaitSpin = 2 /*@< Busy-spin, then yield, then block*/
+};
+
+/**
+ * @brief CPU affinity policies of built-in thread pool threads.
+ *
+ * @c dThreadingThreadPoolAffinityNone leaves the affinity to the system.
+ *
+ * @c dThreadingThreadPoolAffinityCPUList pins each thread to a single CPU 
+ * from the @c cpu_list of pool parameters. The CPUs are assigned to threads 
+ * in list order, wrapping around if there are more threads than CPUs.
+ *
+ * @c dThreadingThreadPoolAffinityNUMANode lets the threads run on any CPU
+ * of the @c numa_node of pool parameters but not on the other nodes.
+ *
+ * The affinity is assigned by the threads themselves on start, before 
+ * ODE data is allocated for them. The pool allocation fails if the affinity 
+ * can't be assigned or if the policy is not supported on the platform.
+ *
+ * @ingroup threading
+ * @see dThreadingThreadPoolParameters
+ * @see dWorldSetStepMemoryNUMANode
+ */
+enum dThreadingThreadPoolAffinityPolicy {
+    dThreadingThreadPoolAffinityNone = 0, /*@< Leave thread affinity to the system*/
+    dThreadingThreadPoolAffinityCPUList = 1, /*@< Pin every thread to a CPU from the list*/
+    dThreadingThreadPoolAffinityNUMANode = 2 /*@< Keep threads on the CPUs of a NUMA node*/
+};
+
+/**
+ * @brief Optional parameters of built-in thread pool creation.
+ *
+ * The @c struct_size must be set to the size of structure.
+ * Zero counts select default values for the policy chosen.
+ *
+ * @ingroup threading
+ * @see dThreadingAllocateThreadPool
+ */
+typedef struct dThreadingThreadPoolParameters
+{
+  unsigned struct_size;
+  unsigned wait_policy; /* One of dThreadingThreadPoolWait... values */
+  unsigned wait_spin_count; /* Number of busy-spin checks before yielding (dThreadingThreadPoolWaitSpin only) */
+  unsigned wait_yield_count; /* Number of time slice yields before blocking */
+
+  unsigned affinity_policy; /* One of dThreadingThreadPoolAffinity... values */
+  const unsigned *cpu_list; /* CPU indices for dThreadingThreadPoolAffinityCPUList */
+  unsigned cpu_count; /* Number of elements in cpu_list */
+  unsigned numa_node; /* NUMA node index for dThreadingThreadPoolAffinityNUMANode */
+
+} dThreadingThreadPoolParameters;
+
 /**
  * @brief Creates an instance of built-in thread pool object that can be used to serve
  * multi-threaded threading implementations.
  *
  * The threads allocated inherit priority of caller thread. Their affinity is not
- * explicitly adjusted and gets the value the system assigns by default. Threads 
+ * explicitly adjusted and gets the value the system assigns by default unless 
+ * an affinity policy is given with @p parameters. Threads 
  * have their stack memory fully committed immediately on start. On POSIX platforms 
  * threads are started with all the possible signals blocked. Threads execute 
  * calls to @c dAllocateODEDataForThread with @p ode_data_allocate_flags 
@@ -206,18 +304,25 @@ ODE_API void dExternalThreadingServeMultiThreadedImplementation(dThreadingImplem
  * or other measures must be taken to prevent reception of signals by calling thread 
  * for the duration of the call.
  * 
+ * Threads wait for calls in the way selected with @p parameters. If the parameters
+ * are not given threads block in the system as soon as they become idle.
+ * The parameters can also be used to pin the threads to particular CPUs 
+ * or to a NUMA node.
+ *
  * @param thread_count Number of threads to start in pool
  * @param stack_size Size of stack to be used for every thread or 0 for system default value
  * @param ode_data_allocate_flags Flags to be passed to @c dAllocateODEDataForThread on behalf of each thread
+ * @param parameters Optional pool parameters
  * @returns ID of object allocated or NULL on failure
  *
  * @ingroup threading
  * @see dThreadingAllocateMultiThreadedImplementation
  * @see dThreadingImplementationShutdownProcessing
  * @see dThreadingFreeThreadPool
+ * @see dThreadingThreadPoolParameters
  */
 ODE_API dThreadingThreadPoolID dThreadingAllocateThreadPool(unsigned thread_count, 
-  size_t stack_size, unsigned int ode_data_allocate_flags, void *reserved/*=NULL*/);
+  size_t stack_size, unsigned int ode_data_allocate_flags, const dThreadingThreadPoolParameters *parameters/*=NULL*/);
 
 /**
  * @brief Commands an instance of built-in thread pool to serve a built-in multi-threaded 
@@ -79,7 +79,15 @@ int dCollideConvexTrimesh( dxGeom *o1, dxGeom *o2, int flags, dContactGeom* cont
     
     OBBCache cache;
     dxTriMesh *trimesh = (dxTriMesh *)o2;
-    if (collider.Collide(cache, convexOOB, trimesh->retrieveMeshBVTreeRef(), null, &meshTransformation)) {
+
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshTransformation = &meshTransformation;
+    if (trimesh->isScaled()) {
+        trimesh->convertQueryOBBIntoUnscaledModelSpace(convexOOB, meshRotation);
+        pMeshTransformation = null;
+    }
+
+    if (collider.Collide(cache, convexOOB, trimesh->retrieveMeshBVTreeRef(), null, pMeshTransformation)) {
         int triCount = collider.GetNbTouchedPrimitives();
         if (triCount > 0) {
             int* triangles = (int*)collider.GetTouchedPrimitives();
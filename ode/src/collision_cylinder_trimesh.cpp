@@ -994,36 +994,27 @@ static void dQueryCTLPotentialCollisionTriangles(OBBCollider &Collider,
         mCylinderRot[1], mCylinderRot[5], mCylinderRot[9],
         mCylinderRot[2], mCylinderRot[6], mCylinderRot[10]);
 
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    if (Trimesh->isScaled())
+    {
+        Trimesh->convertQueryOBBIntoUnscaledModelSpace(obbCylinder, cData.m_mTrimeshRot);
+        pMeshMatrix = null;
+    }
+
     // TC results
     if (Trimesh->getDoTC(dxTriMesh::TTC_BOX)) 
     {
-        dxTriMesh::BoxTC* BoxTC = 0;
-        const int iBoxCacheSize = Trimesh->m_BoxTCCache.size();
-        for (int i = 0; i != iBoxCacheSize; i++)
-        {
-            if (Trimesh->m_BoxTCCache[i].Geom == Cylinder)
-            {
-                BoxTC = &Trimesh->m_BoxTCCache[i];
-                break;
-            }
-        }
-        if (!BoxTC)
-        {
-            Trimesh->m_BoxTCCache.push(dxTriMesh::BoxTC());
-
-            BoxTC = &Trimesh->m_BoxTCCache[Trimesh->m_BoxTCCache.size() - 1];
-            BoxTC->Geom = Cylinder;
-            BoxTC->FatCoeff = REAL(1.0);
-        }
+        dxTriMesh::BoxTC* BoxTC = Trimesh->m_BoxTCCache.retrieveEntry(Cylinder, dxTriMesh::BoxTCInitializer(1.0f));
 
         // Intersect
         Collider.SetTemporalCoherence(true);
-        Collider.Collide(*BoxTC, obbCylinder, Trimesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(*BoxTC, obbCylinder, Trimesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
     else 
     {
         Collider.SetTemporalCoherence(false);
-        Collider.Collide(BoxCache, obbCylinder, Trimesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(BoxCache, obbCylinder, Trimesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
 }
 
@@ -1110,19 +1101,19 @@ int dCollideCylinderTrimesh(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *con
     dxGeom *Cylinder = o1;
     dxTriMesh *Trimesh = (dxTriMesh *)o2;
 
+    Trimesh->recomputeAABB();
+    Cylinder->recomputeAABB();
+
     // Main data holder
     sCylinderTrimeshColliderData cData(flags, skip);
     cData._InitCylinderTrimeshData(Cylinder, Trimesh);
 
     //*****at first , collide box aabb******//
 
-    aabb3f test_aabb(o1->aabb[0], o1->aabb[1], o1->aabb[2], o1->aabb[3], o1->aabb[4], o1->aabb[5]);
-
-
     GDYNAMIC_ARRAY collision_result;
     GIM_CREATE_BOXQUERY_LIST(collision_result);
 
-    gim_aabbset_box_collision(&test_aabb, &Trimesh->m_collision_trimesh.m_aabbset , &collision_result);
+    Trimesh->queryGeomAABBTriangles(Cylinder, dxTriMesh::TTC_BOX, &collision_result);
 
     if (collision_result.m_size != 0)
     {
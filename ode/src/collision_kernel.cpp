@@ -40,6 +40,7 @@ for geometry objects
 #include "collision_trimesh_internal.h"
 #include "collision_space_internal.h"
 #include "odeou.h"
+#include "util.h"
 
 #ifdef dLIBCCD_ENABLED
 # include "collision_libccd.h"
@@ -312,6 +313,12 @@ int dCollide (dxGeom *o1, dxGeom *o2, int flags, dContactGeom *contact, int skip
     o1->recomputePosr();
     o2->recomputePosr();
 
+    // Let the colliders reduce their manifolds before they truncate them
+    if ((o1->parent_space && o1->parent_space->contact_reduction) ||
+        (o2->parent_space && o2->parent_space->contact_reduction)) {
+        flags |= CONTACTS_REDUCED;
+    }
+
     dColliderEntry *ce = &colliders[o1->type][o2->type];
     int count = 0;
     if (ce->fn) {
@@ -333,10 +340,221 @@ int dCollide (dxGeom *o1, dxGeom *o2, int flags, dContactGeom *contact, int skip
         else {
             count = (*ce->fn) (o1,o2,flags,contact,skip);
         }
+        if (count > 4 && (flags & CONTACTS_REDUCED)) {
+            count = dReduceContactManifolds (contact,count,skip);
+        }
     }
     return count;
 }
 
+//****************************************************************************
+// continuous collision detection
+
+// the swept sphere of a body is a capsule geom grown along the motion. the
+// volume it covers only grows with the swept fraction, so the first touch
+// of a geom is found by bisecting the fraction.
+
+#define dCCD_BISECTIONS 16
+
+struct dxSweepContext {
+    dxGeom *proxy;
+    dVector3 from;
+    dVector3 motion;
+    dReal distance;
+    dReal radius;
+    unsigned long category_bits;
+    unsigned long collide_bits;
+    dReal fraction;		// the fraction of motion free so far
+};
+
+
+// the static geoms of the CCD spaces of a world. they are gathered serially
+// before the islands step, so that the sweeps of the bodies neither walk the
+// spaces (whose geom lists are reordered by moving geoms) nor hold the
+// step-body serialization lock while looking for candidates.
+
+struct dxSweepCandidates : public dBase {
+    dArray<dxSpace*> spaces;	// the distinct CCD spaces
+    dArray<int> ends;		// end of the geoms of each space in `geoms'
+    dArray<dxGeom*> geoms;	// static geoms, sorted by aabb[0] per space
+};
+
+
+static int sweepCandidateCompare (const void *a, const void *b)
+{
+    dReal ax = (*(dxGeom *const *)a)->aabb[0];
+    dReal bx = (*(dxGeom *const *)b)->aabb[0];
+    return ax < bx ? -1 : (ax > bx ? 1 : 0);
+}
+
+
+static void gatherStaticGeoms (dArray<dxGeom*> &geoms, dxSpace *space)
+{
+    for (dxGeom *g = space->first; g; g = g->next) {
+        if (IS_SPACE(g)) {
+            gatherStaticGeoms (geoms,(dxSpace*)g);
+        }
+        // only static geoms stay put while the bodies step
+        else if (!g->body &&
+            (g->gflags & GEOM_ENABLE_TEST_MASK) == GEOM_ENABLE_TEST_VALUE) {
+            g->recomputeAABB();
+            geoms.push (g);
+        }
+    }
+}
+
+
+void dxGatherSweepCandidates (dxWorld *world)
+{
+    dxSweepCandidates *candidates = world->sweep_candidates;
+    if (candidates) {
+        candidates->spaces.setSize (0);
+        candidates->ends.setSize (0);
+        candidates->geoms.setSize (0);
+    }
+
+    for (dxBody *b = world->firstbody; b; b = (dxBody*)b->next) {
+        dxSpace *space = b->ccd_space;
+        if (!space) continue;
+
+        if (!candidates) {
+            candidates = new dxSweepCandidates;
+            world->sweep_candidates = candidates;
+        }
+
+        int i = 0;
+        while (i < candidates->spaces.size() && candidates->spaces[i] != space) i++;
+        if (i != candidates->spaces.size()) continue;
+
+        int begin = candidates->geoms.size();
+        gatherStaticGeoms (candidates->geoms,space);
+        int end = candidates->geoms.size();
+        if (end - begin > 1) {
+            qsort (candidates->geoms.data() + begin,end - begin,sizeof(dxGeom*),
+                &sweepCandidateCompare);
+        }
+        candidates->spaces.push (space);
+        candidates->ends.push (end);
+    }
+}
+
+
+void dxFreeSweepCandidates (dxWorld *world)
+{
+    delete world->sweep_candidates;
+    world->sweep_candidates = NULL;
+}
+
+
+static void sweepProxyTo (dxSweepContext &sweep, dReal fraction)
+{
+    dGeomCapsuleSetParams (sweep.proxy,sweep.radius,fraction*sweep.distance);
+    dReal half = REAL(0.5) * fraction;
+    dGeomSetPosition (sweep.proxy,
+        sweep.from[0] + half*sweep.motion[0],
+        sweep.from[1] + half*sweep.motion[1],
+        sweep.from[2] + half*sweep.motion[2]);
+}
+
+
+static bool sweepTouches (dxSweepContext &sweep, dxGeom *g, dReal fraction)
+{
+    dContactGeom contact;
+    sweepProxyTo (sweep,fraction);
+    return dCollide (sweep.proxy,g,1,&contact,sizeof(dContactGeom)) != 0;
+}
+
+
+static bool sweepOverlaps (const dxSweepContext &sweep, const dxGeom *g)
+{
+    // the bounds of the sweep over the fraction still free
+    for (int i=0; i<3; i++) {
+        dReal a = sweep.from[i];
+        dReal b = a + sweep.fraction*sweep.motion[i];
+        if (dMax(a,b) + sweep.radius < g->aabb[i*2]) return false;
+        if (dMin(a,b) - sweep.radius > g->aabb[i*2+1]) return false;
+    }
+    return true;
+}
+
+
+static void sweepGeom (dxSweepContext &sweep, dxGeom *g)
+{
+    // colliders retrieve their caches by the TLS kind of the geoms' spaces
+    // and require it to match, the proxy's own space takes that of g
+    sweep.proxy->parent_space->tls_kind = g->getParentSpaceTLSKind();
+
+    // geoms touched at the start are in contact already, the solver will
+    // deal with them
+    if (sweepTouches (sweep,g,0)) return;
+    if (!sweepTouches (sweep,g,sweep.fraction)) return;
+
+    dReal lo = 0, hi = sweep.fraction;
+    for (int i=0; i<dCCD_BISECTIONS; i++) {
+        dReal mid = REAL(0.5)*(lo+hi);
+        if (sweepTouches (sweep,g,mid)) hi = mid;
+        else lo = mid;
+    }
+    sweep.fraction = lo;
+}
+
+
+dReal dxSweepBody (dxBody *b, const dVector3 motion)
+{
+    dIASSERT (b->ccd_space && b->ccd_proxy);
+
+    dxSweepContext sweep;
+    sweep.proxy = b->ccd_proxy;
+    sweep.radius = ((dxCapsule*)sweep.proxy)->radius;
+    sweep.distance = dCalcVectorLength3 (motion);
+    // slower bodies can not pass through anything their sphere can not
+    // touch at the end of the step, discrete collision catches them
+    if (sweep.distance <= sweep.radius) return REAL(1.0);
+
+    // the space is looked up among the candidates gathered for this step
+    const dxSweepCandidates *candidates = b->world->sweep_candidates;
+    dIASSERT (candidates);
+    int space_index = 0;
+    while (candidates->spaces[space_index] != b->ccd_space) space_index++;
+    int begin = space_index ? candidates->ends[space_index-1] : 0;
+    int end = candidates->ends[space_index];
+    if (begin == end) return REAL(1.0);
+
+    dCopyVector3 (sweep.from,b->posr.pos);
+    dCopyVector3 (sweep.motion,motion);
+    // the pair is tested both ways, as dSpaceCollide does
+    sweep.category_bits = b->geom ? 0 : ~0UL;
+    sweep.collide_bits = b->geom ? 0 : ~0UL;
+    for (dxGeom *g = b->geom; g; g = g->body_next) {
+        sweep.category_bits |= g->category_bits;
+        sweep.collide_bits |= g->collide_bits;
+    }
+    sweep.fraction = REAL(1.0);
+
+    dMatrix3 R;
+    dRFromZAxis (R,motion[0],motion[1],motion[2]);
+    dGeomSetRotation (sweep.proxy,R);
+
+    // the candidates are sorted by their lower x bound, those past the
+    // upper x bound of the sweep can not overlap it
+    dReal max_x = dMax (sweep.from[0],sweep.from[0] + motion[0]) + sweep.radius;
+    dxWorldProcessContext *context = b->world->UnsafeGetWorldProcessingContext();
+    for (int i = begin; i < end; i++) {
+        dxGeom *g = candidates->geoms[i];
+        if (g->aabb[0] > max_x) break;
+        if (((g->category_bits & sweep.collide_bits) ||
+            (sweep.category_bits & g->collide_bits)) == 0) continue;
+        if (!sweepOverlaps (sweep,g)) continue;
+
+        // colliders may keep caches in the geoms, the candidates are
+        // shared by all the islands
+        context->LockForStepbodySerialization();
+        sweepGeom (sweep,g);
+        context->UnlockForStepbodySerialization();
+    }
+    return sweep.fraction;
+}
+
 //****************************************************************************
 // dxGeom
 
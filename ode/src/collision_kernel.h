@@ -230,6 +230,7 @@ struct dxSpace : public dxGeom {
     int cleanup;			// cleanup mode, 1=destroy geoms on exit
     int sublevel;         // space sublevel (used in dSpaceCollide2). NOT TRACKED AUTOMATICALLY!!!
     unsigned tls_kind;	// space TLS kind to be used for global caches retrieval
+    int contact_reduction;	// 1=reduce contact manifolds of member geoms in dCollide
 
     // cached state for getGeom()
     int current_index;		// only valid if current_geom != 0
@@ -250,6 +251,8 @@ struct dxSpace : public dxGeom {
     int getCleanup() const { return cleanup; }
     void setSublevel(int value) { sublevel = value; }
     int getSublevel() const { return sublevel; }
+    void setContactReduction (int mode) { contact_reduction = (mode != 0); }
+    int getContactReduction() const { return contact_reduction; }
     void setManulCleanup(int value) { tls_kind = (value ? dSPACE_TLS_KIND_MANUAL_VALUE : dSPACE_TLS_KIND_INIT_VALUE); }
     int getManualCleanup() const { return (tls_kind == dSPACE_TLS_KIND_MANUAL_VALUE) ? 1 : 0; }
     int query (dxGeom *geom) const { dAASSERT(geom); return (geom->parent_space == this); }
@@ -283,6 +286,15 @@ void dxGeom::markAABBBad() {
 //****************************************************************************
 // Initialization and finalization functions
 
+// gather the static geoms of the CCD spaces of a world, before its
+// islands step (serially)
+void dxGatherSweepCandidates (dxWorld *world);
+void dxFreeSweepCandidates (dxWorld *world);
+
+// return the fraction of `motion' the swept sphere of body b can travel
+// before touching a static geom of its CCD space
+dReal dxSweepBody (dxBody *b, const dVector3 motion);
+
 void dInitColliders();
 void dFinitColliders();
 
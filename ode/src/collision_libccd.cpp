@@ -71,6 +71,7 @@ typedef struct _ccd_sphere_t ccd_sphere_t;
 struct _ccd_convex_t {
     ccd_obj_t o;
     dxConvex *convex;
+    unsigned int supportHint; // hill climbing start, kept per collision as the geom may be collided in other threads
 };
 typedef struct _ccd_convex_t ccd_convex_t;
 
@@ -102,7 +103,12 @@ static void ccdCenter(const void *obj, ccd_vec3_t *c);
 static int ccdCollide(dGeomID o1, dGeomID o2, int flags,
     dContactGeom *contact, int skip,
     void *obj1, ccd_support_fn supp1, ccd_center_fn cen1,
-    void *obj2, ccd_support_fn supp2, ccd_center_fn cen2);
+    void *obj2, ccd_support_fn supp2, ccd_center_fn cen2,
+    dxSeparatingAxisCache *sepAxisCache = NULL, const dxGeom *sepAxisKey = NULL);
+
+/** Separating axis warm start */
+static bool ccdIsSeparatingAxis(const void *obj1, const void *obj2, const ccd_t *ccd, const ccd_vec3_t *axis);
+static bool ccdFindSeparatingAxis(const void *obj1, const void *obj2, const ccd_t *ccd, ccd_vec3_t *axis);
 
 static int collideCylCyl(dxGeom *o1, dxGeom *o2, ccd_cyl_t* cyl1, ccd_cyl_t* cyl2, int flags, dContactGeom *contacts, int skip);
 static bool testAndPrepareDiscContactForAngle(dReal angle, dReal radius, dReal length, dReal lSum, ccd_cyl_t *priCyl, ccd_cyl_t *secCyl, ccd_vec3_t &p, dReal &out_depth);
@@ -194,6 +200,7 @@ void ccdGeomToConvex(const dGeomID g, ccd_convex_t *c)
 {
     ccdGeomToObj(g, (ccd_obj_t *)c);
     c->convex = (dxConvex *)g;
+    c->supportHint = c->convex->supportHint;
 }
 
 
@@ -270,7 +277,7 @@ void ccdSupportSphere(const void *obj, const ccd_vec3_t *_dir, ccd_vec3_t *v)
 static 
 void ccdSupportConvex(const void *obj, const ccd_vec3_t *_dir, ccd_vec3_t *v)
 {
-    const ccd_convex_t *c = (const ccd_convex_t *)obj;
+    ccd_convex_t *c = (ccd_convex_t *)obj;
     ccd_vec3_t dir, p;
     ccd_real_t maxdot, dot;
     size_t i;
@@ -279,14 +286,21 @@ void ccdSupportConvex(const void *obj, const ccd_vec3_t *_dir, ccd_vec3_t *v)
     ccdVec3Copy(&dir, _dir);
     ccdQuatRotVec(&dir, &c->o.rot_inv);
 
-    maxdot = -CCD_REAL_MAX;
-    curp = c->convex->points;
-    for (i = 0; i < c->convex->pointcount; i++, curp += 3){
-        ccdVec3Set(&p, curp[0], curp[1], curp[2]);
-        dot = ccdVec3Dot(&dir, &p);
-        if (dot > maxdot){
-            ccdVec3Copy(v, &p);
-            maxdot = dot;
+    if (c->convex->adjacencyStart != NULL){
+        // hill climbing over the hull points
+        const dReal ldir[3] = { ccdVec3X(&dir), ccdVec3Y(&dir), ccdVec3Z(&dir) };
+        curp = c->convex->points + c->convex->SupportIndexLocal(ldir, c->supportHint) * 3;
+        ccdVec3Set(v, curp[0], curp[1], curp[2]);
+    }else{
+        maxdot = -CCD_REAL_MAX;
+        curp = c->convex->points;
+        for (i = 0; i < c->convex->pointcount; i++, curp += 3){
+            ccdVec3Set(&p, curp[0], curp[1], curp[2]);
+            dot = ccdVec3Dot(&dir, &p);
+            if (dot > maxdot){
+                ccdVec3Copy(v, &p);
+                maxdot = dot;
+            }
         }
     }
 
@@ -303,11 +317,73 @@ void ccdCenter(const void *obj, ccd_vec3_t *c)
     ccdVec3Copy(c, &o->pos);
 }
 
+// Returns true if the support points of the Minkowski difference prove
+// that the (unit) axis separates the objects.
+static 
+bool ccdIsSeparatingAxis(const void *obj1, const void *obj2, const ccd_t *ccd, const ccd_vec3_t *axis)
+{
+    ccd_vec3_t neg, v1, v2;
+
+    ccdVec3Copy(&neg, axis);
+    ccdVec3Scale(&neg, CCD_REAL(-1.0));
+    ccd->support1(obj1, &neg, &v1);
+    ccd->support2(obj2, axis, &v2);
+
+    // every point of obj1 - obj2 projects on -axis below zero
+    ccdVec3Sub(&v1, &v2);
+    return ccdVec3Dot(&v1, &neg) < CCD_ZERO;
+}
+
+// Looks for a separating axis of objects found disjoint by MPR,
+// moving the closest point of a segment of the Minkowski difference
+// towards the origin for a few iterations.
+static 
+bool ccdFindSeparatingAxis(const void *obj1, const void *obj2, const ccd_t *ccd, ccd_vec3_t *axis)
+{
+    ccd_vec3_t x, c2, w, e;
+
+    ccd->center1(obj1, &x);
+    ccd->center2(obj2, &c2);
+    ccdVec3Sub(&x, &c2);
+
+    for (int iteration = 0; iteration != 16; ++iteration) {
+        ccdVec3Copy(axis, &x);
+        if (ccdVec3Normalize(axis) != 0)
+            return false;
+
+        // support of obj1 - obj2 towards the origin
+        ccd_vec3_t v1, v2, neg;
+        ccdVec3Copy(&neg, axis);
+        ccdVec3Scale(&neg, CCD_REAL(-1.0));
+        ccd->support1(obj1, &neg, &v1);
+        ccd->support2(obj2, axis, &v2);
+        ccdVec3Sub2(&w, &v1, &v2);
+
+        if (ccdVec3Dot(&w, &neg) < CCD_ZERO)
+            return true;
+
+        ccdVec3Sub2(&e, &w, &x);
+        const ccd_real_t len2 = ccdVec3Len2(&e);
+        if (ccdIsZero(len2))
+            return false;
+
+        const ccd_real_t t = -ccdVec3Dot(&x, &e) / len2;
+        if (t <= CCD_ZERO)
+            return false;
+
+        ccdVec3Scale(&e, t < CCD_ONE ? t : CCD_ONE);
+        ccdVec3Add(&x, &e);
+    }
+
+    return false;
+}
+
 static 
 int ccdCollide(
     dGeomID o1, dGeomID o2, int flags, dContactGeom *contact, int skip,
     void *obj1, ccd_support_fn supp1, ccd_center_fn cen1,
-    void *obj2, ccd_support_fn supp2, ccd_center_fn cen2)
+    void *obj2, ccd_support_fn supp2, ccd_center_fn cen2,
+    dxSeparatingAxisCache *sepAxisCache, const dxGeom *sepAxisKey)
 {
     ccd_t ccd;
     int res;
@@ -326,16 +402,40 @@ int ccdCollide(
     ccd.max_iterations = 500;
     ccd.mpr_tolerance = (ccd_real_t)1E-6;
 
+    // Pairs which stay apart are rejected with the axis of the previous query
+    if (sepAxisCache != NULL) {
+        dReal cachedAxis[3];
+        if (sepAxisCache->find(sepAxisKey, cachedAxis)) {
+            ccd_vec3_t axis;
+            ccdVec3Set(&axis, cachedAxis[0], cachedAxis[1], cachedAxis[2]);
+            if (ccdIsSeparatingAxis(obj1, obj2, &ccd, &axis)) {
+                return 0;
+            }
+        }
+    }
 
     if (flags & CONTACTS_UNIMPORTANT){
-        if (ccdMPRIntersect(obj1, obj2, &ccd)){
+        res = ccdMPRIntersect(obj1, obj2, &ccd) ? 0 : -1;
+        if (res == 0){
+            if (sepAxisCache != NULL) {
+                sepAxisCache->remove(sepAxisKey);
+            }
             return 1;
-        }else{
-            return 0;
+        }
+    }else{
+        res = ccdMPRPenetration(obj1, obj2, &ccd, &depth, &dir, &pos);
+    }
+
+    if (sepAxisCache != NULL) {
+        ccd_vec3_t axis;
+        if (res != 0 && ccdFindSeparatingAxis(obj1, obj2, &ccd, &axis)) {
+            const dReal storedAxis[3] = { ccdVec3X(&axis), ccdVec3Y(&axis), ccdVec3Z(&axis) };
+            sepAxisCache->store(sepAxisKey, storedAxis);
+        } else {
+            sepAxisCache->remove(sepAxisKey);
         }
     }
 
-    res = ccdMPRPenetration(obj1, obj2, &ccd, &depth, &dir, &pos);
     if (res == 0){
         contact->g1 = o1;
         contact->g2 = o2;
@@ -370,7 +470,8 @@ int dCollideBoxCylinderCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *cont
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &box, ccdSupportBox, ccdCenter,
-        &cyl, ccdSupportCyl, ccdCenter);
+        &cyl, ccdSupportCyl, ccdCenter,
+        &((dxCylinder *)o2)->sepAxisCache, o1);
 }
 
 /*extern */
@@ -384,7 +485,8 @@ int dCollideCapsuleCylinder(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *con
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &cap, ccdSupportCap, ccdCenter,
-        &cyl, ccdSupportCyl, ccdCenter);
+        &cyl, ccdSupportCyl, ccdCenter,
+        &((dxCylinder *)o2)->sepAxisCache, o1);
 }
 
 /*extern */
@@ -398,7 +500,8 @@ int dCollideConvexBoxCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *contac
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &conv, ccdSupportConvex, ccdCenter,
-        &box, ccdSupportBox, ccdCenter);
+        &box, ccdSupportBox, ccdCenter,
+        &conv.convex->sepAxisCache, o2);
 }
 
 /*extern */
@@ -412,7 +515,8 @@ int dCollideConvexCapsuleCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *co
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &conv, ccdSupportConvex, ccdCenter,
-        &cap, ccdSupportCap, ccdCenter);
+        &cap, ccdSupportCap, ccdCenter,
+        &conv.convex->sepAxisCache, o2);
 }
 
 /*extern */
@@ -426,7 +530,8 @@ int dCollideConvexSphereCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *con
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &conv, ccdSupportConvex, ccdCenter,
-        &sphere, ccdSupportSphere, ccdCenter);
+        &sphere, ccdSupportSphere, ccdCenter,
+        &conv.convex->sepAxisCache, o2);
 }
 
 /*extern */
@@ -440,7 +545,8 @@ int dCollideConvexCylinderCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *c
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &conv, ccdSupportConvex, ccdCenter,
-        &cyl, ccdSupportCyl, ccdCenter);
+        &cyl, ccdSupportCyl, ccdCenter,
+        &conv.convex->sepAxisCache, o2);
 }
 
 /*extern */
@@ -453,7 +559,8 @@ int dCollideConvexConvexCCD(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *con
 
     return ccdCollide(o1, o2, flags, contact, skip,
         &c1, ccdSupportConvex, ccdCenter,
-        &c2, ccdSupportConvex, ccdCenter);
+        &c2, ccdSupportConvex, ccdCenter,
+        &c1.convex->sepAxisCache, o2);
 }
 
 
@@ -469,7 +576,8 @@ int dCollideCylinderCylinder(dxGeom *o1, dxGeom *o2, int flags, dContactGeom *co
     if (numContacts < 0) {
         numContacts = ccdCollide(o1, o2, flags, contact, skip,
                                  &cyl1, ccdSupportCyl, ccdCenter,
-                                 &cyl2, ccdSupportCyl, ccdCenter);
+                                 &cyl2, ccdSupportCyl, ccdCenter,
+                                 &((dxCylinder *)o1)->sepAxisCache, o2);
     }
     return numContacts;
 }
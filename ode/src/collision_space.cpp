@@ -86,6 +86,7 @@ dxSpace::dxSpace (dSpaceID _space) : dxGeom (_space,0)
     cleanup = 1;
     sublevel = 0;
     tls_kind = dSPACE_TLS_KIND_INIT_VALUE;
+    contact_reduction = 0;
     current_index = 0;
     current_geom = 0;
     lock_count = 0;
@@ -704,6 +705,21 @@ int dSpaceGetSublevel (dSpaceID space)
     return space->getSublevel();
 }
 
+void dSpaceSetContactReduction (dSpaceID space, int mode)
+{
+    dAASSERT (space);
+    dUASSERT (dGeomIsSpace(space),"argument not a space");
+    space->setContactReduction (mode);
+}
+
+
+int dSpaceGetContactReduction (dSpaceID space)
+{
+    dAASSERT (space);
+    dUASSERT (dGeomIsSpace(space),"argument not a space");
+    return space->getContactReduction();
+}
+
 void dSpaceSetManualCleanup (dSpaceID space, int mode)
 {
     dAASSERT (space);
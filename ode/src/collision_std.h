@@ -118,8 +118,79 @@ struct dxCapsule : public dxGeom {
 };
 
 
+// Separating axes last found by the libccd colliders (and the convex-convex
+// SAT collider) between a geom and its partners. A cached axis is verified
+// with support queries on both geoms before it is trusted, so stale entries
+// can only cost the early-out, never a wrong result.
+// The geom may be collided with different partners from several threads at
+// once. An entry is written by the pair of its key geom only after the pair
+// has claimed it, and a reader keeps the axis it copied only if the entry
+// still has its key afterwards. A particular pair must not be collided by
+// several threads at once.
+struct dxSeparatingAxisCache
+{
+    enum { ENTRY_COUNT = 4 };
+
+    volatile atomicptr geoms[ENTRY_COUNT]; // const dxGeom *, the cache itself while an entry is being written
+    dReal axes[ENTRY_COUNT][3];
+    volatile atomicord32 nextEntry;
+
+    dxSeparatingAxisCache(): nextEntry(0) { std::fill(geoms, geoms + ENTRY_COUNT, (atomicptr)NULL); }
+
+    bool find(const dxGeom *g, dReal *axis) const
+    {
+        for (unsigned i = 0; i != ENTRY_COUNT; ++i) {
+            if (geoms[i] == (atomicptr)g) {
+                axis[0] = axes[i][0]; axis[1] = axes[i][1]; axis[2] = axes[i][2];
+                // the entry may have been claimed by another pair while copying
+                return exchangeKey(i, (atomicptr)g, (atomicptr)g);
+            }
+        }
+        return false;
+    }
+
+    void store(const dxGeom *g, const dReal *axis)
+    {
+        unsigned i = 0;
+        while (i != ENTRY_COUNT && geoms[i] != (atomicptr)g) ++i;
+        if (i == ENTRY_COUNT) {
+#if dATOMICS_ENABLED
+            i = AtomicExchangeAdd(&nextEntry, 1) % ENTRY_COUNT;
+#else
+            i = nextEntry++ % ENTRY_COUNT;
+#endif
+        }
+        // the axis is not stored if another pair is writing the entry
+        const atomicptr owner = geoms[i];
+        if (owner == (atomicptr)this || !exchangeKey(i, owner, (atomicptr)this)) return;
+        axes[i][0] = axis[0]; axes[i][1] = axis[1]; axes[i][2] = axis[2];
+        exchangeKey(i, (atomicptr)this, (atomicptr)g);
+    }
+
+    void remove(const dxGeom *g)
+    {
+        for (unsigned i = 0; i != ENTRY_COUNT; ++i) {
+            if (geoms[i] == (atomicptr)g) exchangeKey(i, (atomicptr)g, (atomicptr)NULL);
+        }
+    }
+
+private:
+    bool exchangeKey(unsigned i, atomicptr expected, atomicptr desired) const
+    {
+#if dATOMICS_ENABLED
+        return AtomicCompareExchangePointer(const_cast<volatile atomicptr *>(geoms + i), expected, desired);
+#else
+        if (geoms[i] != expected) return false;
+        const_cast<volatile atomicptr *>(geoms)[i] = desired;
+        return true;
+#endif
+    }
+};
+
+
 struct dxCylinder : public dxGeom {
     dReal radius,lz;        // radius, length along z axis
+    dxSeparatingAxisCache sepAxisCache; // libccd separating axes against other geoms
     dxCylinder (dSpaceID space, dReal _radius, dReal _length);
     void computeAABB();
 };
@@ -149,6 +220,7 @@ struct dxConvex : public dxGeom
     unsigned int pointcount;/*!< Amount of points in points */
     unsigned int edgecount;/*!< Amount of edges in convex */
     dReal saabb[6];/*!< Static AABB */
+    dxSeparatingAxisCache sepAxisCache; /*!< libccd separating axes against other geoms */
     dxConvex(dSpaceID space,
         const dReal *planes,
         unsigned int planecount,
@@ -158,43 +230,106 @@ struct dxConvex : public dxGeom
     ~dxConvex()
     {
         if((edgecount!=0)&&(edges!=NULL)) delete[] edges;
+        FreeAdjacency();
+        FreeHull();
     }
     void computeAABB();
     struct edge
     {
         unsigned int first;
         unsigned int second;
+        unsigned int firstFace; /*!< The two planes sharing the edge, */
+        unsigned int secondFace; /*!< their normals are the edge arc on the Gauss map */
     };
     edge* edges;
 
-    /*! \brief A Support mapping function for convex shapes
-    \param dir [IN] direction to find the Support Point for
+    /*! Hulls with more points than this use hill climbing for support queries */
+    enum { HILL_CLIMBING_MIN_POINTS = 16 };
+
+    unsigned int *adjacencyStart; /*!< Index of the first neighbour of each point in adjacency (pointcount + 1 entries), NULL for small hulls */
+    unsigned int *adjacency; /*!< Neighbour point indices along the edges */
+    unsigned int supportHint; /*!< Start point of hill climbs, set with the adjacency. Colliders of different pairs
+                                   may run at once, each one climbs with a hint of its own started from this point */
+
+    dReal *hullPlanes; /*!< Arrays built by dGeomConvexFromPoints, owned by the geom */
+    dReal *hullPoints;
+    unsigned int *hullPolygons;
+
+    /*! \brief Rebuilds edges and point adjacency after the polygons change */
+    void ComputeConnectivity();
+    /*! \brief Releases the arrays built by dGeomConvexFromPoints */
+    void FreeHull();
+
+    /*! \brief Support mapping in convex space
+    \param ldir [IN] direction in convex space
+    \param hint [IN/OUT] start point of the hill climb, receives the support vertex (unused by small hulls)
     \return the index of the support vertex.
     */
-    inline unsigned int SupportIndex(dVector3 dir)
+    inline unsigned int SupportIndexLocal(const dReal *ldir, unsigned int &hint) const
     {
-        dVector3 rdir;
-        unsigned int index=0;
-        dMultiply1_331 (rdir,final_posr->R,dir);
-        dReal max = dCalcVectorDot3(points,rdir);
-        dReal tmp;
-        for (unsigned int i = 1; i < pointcount; ++i) 
+        unsigned int index;
+        dReal max;
+        if (adjacencyStart == NULL)
         {
-            tmp = dCalcVectorDot3(points+(i*3),rdir);
-            if (tmp > max) 
+            index = 0;
+            max = dCalcVectorDot3(points,ldir);
+            for (unsigned int i = 1; i < pointcount; ++i) 
             {
-                index=i;
-                max = tmp; 
+                const dReal tmp = dCalcVectorDot3(points+(i*3),ldir);
+                if (tmp > max) 
+                {
+                    index=i;
+                    max = tmp; 
+                }
             }
         }
+        else
+        {
+            // Walk to a better neighbour until there is none; on a convex hull
+            // a point without a better neighbour is a support point.
+            index = hint;
+            max = dCalcVectorDot3(points+(index*3),ldir);
+            for (;;)
+            {
+                const unsigned int current = index;
+                for (unsigned int k = adjacencyStart[current]; k != adjacencyStart[current+1]; ++k)
+                {
+                    const unsigned int neighbour = adjacency[k];
+                    const dReal tmp = dCalcVectorDot3(points+(neighbour*3),ldir);
+                    if (tmp > max)
+                    {
+                        index = neighbour;
+                        max = tmp;
+                    }
+                }
+                if (index == current) break;
+            }
+            hint = index;
+        }
         return index;
     }
 
+    /*! \brief A Support mapping function for convex shapes
+    \param dir [IN] direction to find the Support Point for
+    \return the index of the support vertex.
+    */
+    inline unsigned int SupportIndex(dVector3 dir) const
+    {
+        dVector3 rdir;
+        dMultiply1_331 (rdir,final_posr->R,dir);
+        unsigned int hint = supportHint;
+        return SupportIndexLocal(rdir, hint);
+    }
+
 private:
     // For Internal Use Only
     /*! \brief Fills the edges dynamic array based on points and polygons.
     */
     void FillEdges();
+    /*! \brief Builds the point adjacency from the edges for hill climbing.
+    */
+    void FillAdjacency();
+    void FreeAdjacency();
 #if 0
     /*
     What this does is the same as the Support function by doing some preprocessing
@@ -1232,31 +1232,25 @@ static void dQueryBTLPotentialCollisionTriangles(OBBCollider &Collider,
         mRotBox[1], mRotBox[5], mRotBox[9],
         mRotBox[2], mRotBox[6], mRotBox[10]);
 
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    if (TriMesh->isScaled()) {
+        TriMesh->convertQueryOBBIntoUnscaledModelSpace(Box, mRotMesh);
+        pMeshMatrix = null;
+    }
+
     // TC results
     if (TriMesh->getDoTC(dxTriMesh::TTC_BOX)) {
-        dxTriMesh::BoxTC* BoxTC = 0;
-        const int iBoxCacheSize = TriMesh->m_BoxTCCache.size();
-        for (int i = 0; i != iBoxCacheSize; i++){
-            if (TriMesh->m_BoxTCCache[i].Geom == BoxGeom){
-                BoxTC = &TriMesh->m_BoxTCCache[i];
-                break;
-            }
-        }
-        if (!BoxTC){
-            TriMesh->m_BoxTCCache.push(dxTriMesh::BoxTC());
-
-            BoxTC = &TriMesh->m_BoxTCCache[TriMesh->m_BoxTCCache.size() - 1];
-            BoxTC->Geom = BoxGeom;
-            BoxTC->FatCoeff = 1.1f; // Pierre recommends this, instead of 1.0
-        }
+        dxTriMesh::BoxTC* BoxTC = TriMesh->m_BoxTCCache.retrieveEntry(BoxGeom, 
+            dxTriMesh::BoxTCInitializer(1.1f)); // Pierre recommends this, instead of 1.0
 
         // Intersect
         Collider.SetTemporalCoherence(true);
-        Collider.Collide(*BoxTC, Box, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(*BoxTC, Box, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
     else {
         Collider.SetTemporalCoherence(false);
-        Collider.Collide(BoxCache, Box, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(BoxCache, Box, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
 }
 
@@ -1340,12 +1334,11 @@ int dCollideBTL(dxGeom* g1, dxGeom* BoxGeom, int Flags, dContactGeom* Contacts,
     //*****at first , collide box aabb******//
 
     GIM_TRIMESH * ptrimesh = &TriMesh->m_collision_trimesh;
-    aabb3f test_aabb(BoxGeom->aabb[0], BoxGeom->aabb[1], BoxGeom->aabb[2], BoxGeom->aabb[3], BoxGeom->aabb[4], BoxGeom->aabb[5]);
 
     GDYNAMIC_ARRAY collision_result;
     GIM_CREATE_BOXQUERY_LIST(collision_result);
 
-    gim_aabbset_box_collision(&test_aabb, &ptrimesh->m_aabbset , &collision_result);
+    TriMesh->queryGeomAABBTriangles(BoxGeom, dxTriMesh::TTC_BOX, &collision_result);
 
     if(collision_result.m_size==0)
     {
@@ -996,31 +996,24 @@ static void dQueryCCTLPotentialCollisionTriangles(OBBCollider &Collider,
         mCapsuleRot[1], mCapsuleRot[5], mCapsuleRot[9],
         mCapsuleRot[2], mCapsuleRot[6], mCapsuleRot[10]);
 
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    if (TriMesh->isScaled()) {
+        TriMesh->convertQueryOBBIntoUnscaledModelSpace(obbCapsule, cData.m_mTriMeshRot);
+        pMeshMatrix = null;
+    }
+
     // TC results
     if (TriMesh->getDoTC(dxTriMesh::TTC_BOX)) {
-        dxTriMesh::BoxTC* BoxTC = 0;
-        const int iBoxCacheSize = TriMesh->m_BoxTCCache.size();
-        for (int i = 0; i != iBoxCacheSize; i++){
-            if (TriMesh->m_BoxTCCache[i].Geom == Capsule){
-                BoxTC = &TriMesh->m_BoxTCCache[i];
-                break;
-            }
-        }
-        if (!BoxTC){
-            TriMesh->m_BoxTCCache.push(dxTriMesh::BoxTC());
-
-            BoxTC = &TriMesh->m_BoxTCCache[TriMesh->m_BoxTCCache.size() - 1];
-            BoxTC->Geom = Capsule;
-            BoxTC->FatCoeff = 1.0f;
-        }
+        dxTriMesh::BoxTC* BoxTC = TriMesh->m_BoxTCCache.retrieveEntry(Capsule, dxTriMesh::BoxTCInitializer(1.0f));
 
         // Intersect
         Collider.SetTemporalCoherence(true);
-        Collider.Collide(*BoxTC, obbCapsule, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(*BoxTC, obbCapsule, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
     else {
         Collider.SetTemporalCoherence(false);
-        Collider.Collide(BoxCache, obbCapsule, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(BoxCache, obbCapsule, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
 }
 
@@ -263,6 +263,18 @@ void dGeomTriMeshEnableTC(dGeomID g, int geomClass, int enable)
     // Do nothing
 }
 
+/*extern */
+void dGeomTriMeshSetScale(dGeomID g, dReal sx, dReal sy, dReal sz)
+{
+    // Do nothing
+}
+
+/*extern */
+void dGeomTriMeshGetScale(dGeomID g, dVector3 result)
+{
+    dAssignVector3(result, REAL(1.0), REAL(1.0), REAL(1.0));
+}
+
 /*extern */
 int dGeomTriMeshIsTCEnabled(dGeomID g, int geomClass)
 {
@@ -284,6 +296,14 @@ dTriMeshDataID dGeomTriMeshGetTriMeshDataID(dGeomID g)
 }
 
 
+/*extern */
+void dGeomTriMeshGetTriangle(dGeomID g, int Index, dVector3 *v0, dVector3 *v1, dVector3 *v2)
+{
+    if (v0 != NULL) dZeroVector3(*v0);
+    if (v1 != NULL) dZeroVector3(*v1);
+    if (v2 != NULL) dZeroVector3(*v2);
+}
+
 /*extern */
 int dGeomTriMeshGetTriangleCount (dGeomID g)
 {
@@ -296,6 +316,11 @@ void dGeomTriMeshDataUpdate(dTriMeshDataID g)
     // Do nothing
 }
 
+int dGeomTriMeshDataCompact(dTriMeshDataID g)
+{
+    return 0;
+}
+
 
 #endif // !dTRIMESH_ENABLED
 
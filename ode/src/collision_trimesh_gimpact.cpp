@@ -198,15 +198,87 @@ void dxTriMesh::computeAABB()
     mat4f transform;
     IDENTIFY_MATRIX_4X4(transform);
     MakeMatrix(this, transform);
-    gim_trimesh_set_tranform(&m_collision_trimesh, transform);
 
-    //Update trimesh boxes
-    gim_trimesh_update(&m_collision_trimesh);
+    // GIMPACT transforms the vertices with the full matrix, so the scale can just be merged in
+    if (isScaled())
+    {
+        const dReal *scale = retrieveScale();
+        for (unsigned row = 0; row != 3; ++row)
+        {
+            for (unsigned column = 0; column != 3; ++column)
+            {
+                transform[row][column] *= (GREAL)scale[column];
+            }
+        }
+    }
+
+    // The transform is compared exactly rather than with gim_trimesh_set_tranform()'s 
+    // tolerance so that small motions are not lost. Unchanged transforms skip the update.
+    if (memcmp(transform, m_collision_trimesh.m_transform, sizeof(mat4f)) != 0)
+    {
+        COPY_MATRIX_4X4(m_collision_trimesh.m_transform, transform);
+        gim_trimesh_post_update(&m_collision_trimesh);
+    }
+
+    if (gim_trimesh_needs_update(&m_collision_trimesh))
+    {
+        //Update trimesh boxes
+        gim_trimesh_update(&m_collision_trimesh);
+
+        // Invalidate temporal coherence results; zero is reserved for never queried entries
+        if (++m_UpdateStamp == 0)
+        {
+            m_UpdateStamp = 1;
+        }
+    }
 
     GIM_AABB_COPY( &m_collision_trimesh.m_aabbset.m_global_bound, aabb );
 }
 
 
+void dxTriMesh::queryGeomAABBTriangles(dxGeom *geom, TRIMESHTC tc, GDYNAMIC_ARRAY *out_collisionResult)
+{
+    const dReal *geomAABB = geom->aabb;
+    aabb3f test_aabb(geomAABB[0], geomAABB[1], geomAABB[2], geomAABB[3], geomAABB[4], geomAABB[5]);
+
+    if (!getDoTC(tc))
+    {
+        gim_aabbset_box_collision(&test_aabb, &m_collision_trimesh.m_aabbset, out_collisionResult);
+        return;
+    }
+
+    // Query with an enlarged box and reuse the results while the geom stays within it and the mesh does not move
+    BoxTC *boxTC = m_BoxTCCache.retrieveEntry(geom);
+
+    if (boxTC->UpdateStamp != m_UpdateStamp 
+        || test_aabb.minX < boxTC->FatAABB.minX || test_aabb.maxX > boxTC->FatAABB.maxX
+        || test_aabb.minY < boxTC->FatAABB.minY || test_aabb.maxY > boxTC->FatAABB.maxY
+        || test_aabb.minZ < boxTC->FatAABB.minZ || test_aabb.maxZ > boxTC->FatAABB.maxZ)
+    {
+        const GREAL fatCoeff = (GREAL)TC_FAT_COEFF_PERCENTS / 200.0f; // Half of the coefficient per side
+        GREAL marginX = (test_aabb.maxX - test_aabb.minX) * fatCoeff;
+        GREAL marginY = (test_aabb.maxY - test_aabb.minY) * fatCoeff;
+        GREAL marginZ = (test_aabb.maxZ - test_aabb.minZ) * fatCoeff;
+
+        aabb3f fat_aabb(test_aabb.minX - marginX, test_aabb.maxX + marginX, 
+            test_aabb.minY - marginY, test_aabb.maxY + marginY, 
+            test_aabb.minZ - marginZ, test_aabb.maxZ + marginZ);
+        gim_aabbset_box_collision(&fat_aabb, &m_collision_trimesh.m_aabbset, out_collisionResult);
+
+        boxTC->Triangles.setSize(out_collisionResult->m_size);
+        memcpy(boxTC->Triangles.data(), GIM_DYNARRAY_POINTER(GUINT32, *out_collisionResult), out_collisionResult->m_size * sizeof(GUINT32));
+        boxTC->FatAABB = fat_aabb;
+        boxTC->UpdateStamp = m_UpdateStamp;
+    }
+    else
+    {
+        GUINT32 triangleCount = boxTC->Triangles.size();
+        GIM_DYNARRAY_SET_SIZE(GUINT32, *out_collisionResult, triangleCount);
+        memcpy(GIM_DYNARRAY_POINTER(GUINT32, *out_collisionResult), boxTC->Triangles.data(), triangleCount * sizeof(GUINT32));
+    }
+}
+
+
 void dxTriMesh::assignMeshData(dxTriMeshData *Data)
 {
     // GIMPACT only supports stride 12, so we need to catch the error early.
@@ -240,6 +312,9 @@ void dxTriMesh::assignMeshData(dxTriMeshData *Data)
             0,                                              // copy indices?
             1                                               // transformed reply
         );
+
+        // Keep the work data locked to let several threads query the trimesh at once
+        gim_trimesh_pin_work_data(&m_collision_trimesh);
     }
 }
 
@@ -43,6 +43,7 @@
 #include <ode/collision_trimesh.h>
 
 #include "collision_trimesh_internal.h"
+#include "array.h"
 #include <GIMPACT/gimpact.h>
 
 
@@ -75,6 +76,10 @@ public:
     /* For when app changes the vertices */
     void updateData() { /* Do nothing */ }
 
+public:
+    /* Compaction is not supported as GIMPACT needs plain vertex and index arrays */
+    bool compactData() { return false; }
+
 public:
     const vec3f *retrieveVertexInstances() const { return (const vec3f *)dxTriMeshData_Parent::retrieveVertexInstances(); }
     const GUINT32 *retrieveTriangleVertexIndices() const { return (const GUINT32 *)dxTriMeshData_Parent::retrieveTriangleVertexIndices(); }
@@ -195,7 +200,8 @@ public:
     // Functions
     dxTriMesh(dxSpace *Space, dxTriMeshData *Data,
         dTriCallback *Callback, dTriArrayCallback *ArrayCallback, dTriRayCallback *RayCallback):
-        dxTriMesh_Parent(Space, NULL, Callback, ArrayCallback, RayCallback, true) // TC has speed/space 'issues' that don't make it a clear win by default on spheres/boxes.
+        dxTriMesh_Parent(Space, NULL, Callback, ArrayCallback, RayCallback, false), // TC is opt-in as with OPCODE, the cached triangles only pay off for geoms that stay near their last query
+        m_UpdateStamp(1)
     {
         gim_init_buffer_managers(m_buffer_managers);
         assignMeshData(Data);
@@ -203,7 +209,7 @@ public:
 
     ~dxTriMesh();
 
-    void clearTCCache() { /* do nothing */ }
+    void clearTCCache() { m_BoxTCCache.clear(); }
 
     virtual void computeAABB();
 
@@ -238,9 +244,34 @@ public:
 
     void assignMeshData(dxTriMeshData *Data);
 
+public:
+    /* Collects triangles with boxes overlapping the geom AABB (using temporal coherence if enabled) */
+    void queryGeomAABBTriangles(dxGeom *geom, TRIMESHTC tc, GDYNAMIC_ARRAY *out_collisionResult);
+
+    // Temporal coherence
+    struct BoxTC
+    {
+        BoxTC(): Geom(NULL), UpdateStamp(0) {}
+
+        dxGeom *Geom;
+        unsigned UpdateStamp; // Mesh update stamp the triangles were queried at
+        aabb3f FatAABB;
+        dArray<GUINT32> Triangles;
+    };
+
+private:
+    enum
+    {
+        TC_FAT_COEFF_PERCENTS = 10,
+    };
+
 public:
     GIM_TRIMESH  m_collision_trimesh;
     GBUFFER_MANAGER_DATA m_buffer_managers[G_BUFFER_MANAGER__MAX];
+
+    // Incremented whenever the transformed vertices are updated
+    unsigned m_UpdateStamp;
+    dxTriMeshTCStore<BoxTC> m_BoxTCCache;
 };
 
 
@@ -571,6 +571,16 @@ void dGeomTriMeshDataUpdate(dTriMeshDataID g)
     data->updateData();
 }
 
+/*extern ODE_API */
+int dGeomTriMeshDataCompact(dTriMeshDataID g)
+{
+    dUASSERT(g, "The argument is not a trimesh data");
+
+    dxTriMeshData *data = g;
+    bool result = data->compactData();
+    return result;
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -726,6 +736,28 @@ void dGeomTriMeshClearTCCache(dGeomID g)
 }
 
 
+/*extern ODE_API */
+void dGeomTriMeshSetScale(dGeomID g, dReal sx, dReal sy, dReal sz)
+{
+    dUASSERT(g && g->type == dTriMeshClass, "The argument is not a trimesh");
+    dUASSERT(sx > REAL(0.0) && sy > REAL(0.0) && sz > REAL(0.0), "Scale factors must be positive");
+
+    dxTriMesh *mesh = static_cast<dxTriMesh *>(g);
+    mesh->assignScale(sx, sy, sz);
+
+    dGeomMoved(g);
+}
+
+/*extern ODE_API */
+void dGeomTriMeshGetScale(dGeomID g, dVector3 result)
+{
+    dUASSERT(g && g->type == dTriMeshClass, "The argument is not a trimesh");
+
+    const dxTriMesh *mesh = static_cast<dxTriMesh *>(g);
+    dCopyVector3(result, mesh->retrieveScale());
+}
+
+
 /*extern ODE_API */
 int dGeomTriMeshGetTriangleCount(dGeomID g)
 {
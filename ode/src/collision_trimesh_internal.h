@@ -39,6 +39,9 @@
 #include "collision_util.h"
 #include <ode/collision_trimesh.h>
 
+#include "odeou.h"
+#include <algorithm>
+
 #if dTLS_ENABLED
 #include "odetls.h"
 #endif
@@ -300,6 +303,129 @@ private:
 };
 
 
+// Temporal coherence cache store.
+// Entries are sharded by the colliding geom address into lock-free lists and
+// are never relocated after insertion. This allows several threads to collide
+// the same trimesh against different geoms simultaneously. A particular geom 
+// pair must still be collided by a single thread at a time and the store must 
+// not be cleared while any collision with the trimesh is in progress.
+template<class TTCEntry>
+class dxTriMeshTCStore
+{
+public:
+    dxTriMeshTCStore() { std::fill(m_Buckets, m_Buckets + dARRAY_SIZE(m_Buckets), (atomicptr)NULL); }
+    ~dxTriMeshTCStore() { clear(); }
+
+    struct DefaultEntryInitializer
+    {
+        void operator ()(TTCEntry &) const {}
+    };
+
+    TTCEntry *retrieveEntry(dxGeom *geom) { return retrieveEntry(geom, DefaultEntryInitializer()); }
+
+    // The initializer is applied to a new entry before it is published to other threads
+    template<class TEntryInitializer>
+    TTCEntry *retrieveEntry(dxGeom *geom, const TEntryInitializer &initializer);
+
+    void clear();
+
+private:
+    struct EntryNode:
+        public dBase
+    {
+        explicit EntryNode(dxGeom *geom): m_Next(NULL) { m_Entry.Geom = geom; }
+
+        TTCEntry m_Entry;
+        EntryNode *m_Next;
+    };
+
+    enum
+    {
+        BUCKET_COUNT_BITS = 4,
+        BUCKET_COUNT = 1 << BUCKET_COUNT_BITS,
+    };
+
+    static unsigned getGeomBucketIndex(dxGeom *geom)
+    {
+        // Drop the alignment bits and fold the rest of the address into the index
+        size_t geomAddress = (size_t)geom / sizeof(void *);
+        return (unsigned)((geomAddress ^ (geomAddress >> BUCKET_COUNT_BITS) ^ (geomAddress >> (2 * BUCKET_COUNT_BITS))) & (BUCKET_COUNT - 1));
+    }
+
+    static EntryNode *findEntryNode(EntryNode *listBegin, EntryNode *listEnd, dxGeom *geom)
+    {
+        EntryNode *currentNode = listBegin;
+        for (; currentNode != listEnd && currentNode->m_Entry.Geom != geom; currentNode = currentNode->m_Next) {}
+        return currentNode != listEnd ? currentNode : NULL;
+    }
+
+private:
+    volatile atomicptr m_Buckets[BUCKET_COUNT]; // EntryNode *
+};
+
+template<class TTCEntry>
+template<class TEntryInitializer>
+TTCEntry *dxTriMeshTCStore<TTCEntry>::retrieveEntry(dxGeom *geom, const TEntryInitializer &initializer)
+{
+    volatile atomicptr *bucketPtr = m_Buckets + getGeomBucketIndex(geom);
+
+    EntryNode *listHead = (EntryNode *)*bucketPtr;
+    EntryNode *existingNode = findEntryNode(listHead, NULL, geom);
+
+    if (existingNode == NULL)
+    {
+        EntryNode *newNode = new EntryNode(geom);
+        initializer(newNode->m_Entry);
+
+        while (true)
+        {
+            newNode->m_Next = listHead;
+
+#if dATOMICS_ENABLED
+            if (AtomicCompareExchangePointer(bucketPtr, (atomicptr)listHead, (atomicptr)newNode))
+#else
+            *bucketPtr = (atomicptr)newNode;
+#endif
+            {
+                existingNode = newNode;
+                break;
+            }
+
+            // Another thread has inserted into the bucket -- only the nodes added in front of the old head need to be checked
+            EntryNode *updatedHead = (EntryNode *)*bucketPtr;
+            existingNode = findEntryNode(updatedHead, listHead, geom);
+
+            if (existingNode != NULL)
+            {
+                delete newNode;
+                break;
+            }
+
+            listHead = updatedHead;
+        }
+    }
+
+    return &existingNode->m_Entry;
+}
+
+template<class TTCEntry>
+void dxTriMeshTCStore<TTCEntry>::clear()
+{
+    for (unsigned bucketIndex = 0; bucketIndex != BUCKET_COUNT; ++bucketIndex)
+    {
+        EntryNode *currentNode = (EntryNode *)m_Buckets[bucketIndex];
+        m_Buckets[bucketIndex] = (atomicptr)NULL;
+
+        while (currentNode != NULL)
+        {
+            EntryNode *nextNode = currentNode->m_Next;
+            delete currentNode;
+            currentNode = nextNode;
+        }
+    }
+}
+
+
 typedef dxGeom dxMeshBase_Parent;
 struct dxMeshBase:
     public dxMeshBase_Parent
@@ -313,9 +439,11 @@ public:
         m_ArrayCallback(ArrayCallback),
         m_RayCallback(RayCallback),
         m_TriMergeCallback(NULL),
-        m_Data(Data)
+        m_Data(Data),
+        m_Scaled(false)
     {
         std::fill(m_DoTCs, m_DoTCs + dARRAY_SIZE(m_DoTCs), doTCs);
+        dAssignVector3(m_Scale, REAL(1.0), REAL(1.0), REAL(1.0));
         type = dTriMeshClass;
     }
 
@@ -363,6 +491,14 @@ public:
     void assignDoTC(TRIMESHTC tc, bool value) { setDoTC(tc, value); }
     bool retrieveDoTC(TRIMESHTC tc) const { return getDoTC(tc); }
 
+    void assignScale(dReal scaleX, dReal scaleY, dReal scaleZ)
+    {
+        dAssignVector3(m_Scale, scaleX, scaleY, scaleZ);
+        m_Scaled = scaleX != REAL(1.0) || scaleY != REAL(1.0) || scaleZ != REAL(1.0);
+    }
+    const dReal *retrieveScale() const { return m_Scale; }
+    bool isScaled() const { return m_Scaled; }
+
 public:
     void setDoTC(TRIMESHTC tc, bool value) { dIASSERT(dIN_RANGE(tc, TTC__MIN, TTC__MAX)); m_DoTCs[tc] = value; }
     bool getDoTC(TRIMESHTC tc) const { dIASSERT(dIN_RANGE(tc, TTC__MIN, TTC__MAX)); return m_DoTCs[tc]; }
@@ -386,6 +522,11 @@ private:
 
 public:
     bool m_DoTCs[TTC__MAX];
+
+private:
+    // Per instance scale applied to the shared mesh data in model space
+    dVector3 m_Scale;
+    bool m_Scaled;
 };
 
 
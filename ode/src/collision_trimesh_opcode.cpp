@@ -94,6 +94,8 @@ dxTriMeshData::~dxTriMeshData()
         size_t flagsMemoryRequired = calculateUseFlagsMemoryRequirement();
         dFree(m_InternalUseFlags, flagsMemoryRequired);
     }
+
+    freeCompactStorage();
 }
 
 void dxTriMeshData::buildData(const Point *Vertices, int VertexStide, unsigned VertexCount,
@@ -101,6 +103,8 @@ void dxTriMeshData::buildData(const Point *Vertices, int VertexStide, unsigned V
     const dReal *in_Normals,
     bool Single)
 {
+    freeCompactStorage();
+
     dxTriMeshData_Parent::buildData(Vertices, VertexStide, VertexCount, Indices, IndexCount, TriStride, in_Normals, Single);
     dAASSERT(IndexCount % dMTV__MAX == 0);
 
@@ -203,20 +207,20 @@ bool dxTriMeshData::preprocessData(bool buildUseFlags/*=false*/, FaceAngleStorag
 
 struct TrimeshDataVertexIndexAccessor_OPCODE
 {
-    TrimeshDataVertexIndexAccessor_OPCODE(const IndexedTriangle *triIndicesBegin, unsigned triStride):
-        m_TriIndicesBegin(triIndicesBegin),
-        m_TriStride(triStride)
+    TrimeshDataVertexIndexAccessor_OPCODE(const MeshInterface &mesh):
+        m_Mesh(mesh)
     {
     }
 
     void getTriangleVertexIndices(unsigned out_VertexIndices[dMTV__MAX], unsigned triangleIdx) const
     {
-        const IndexedTriangle *triIndicesBegin = m_TriIndicesBegin;
-        const unsigned triStride = m_TriStride;
+        // The indices are fetched via the mesh interface as they might have been packed by compaction
+        VertexPointersEx vpeTriangle;
+        ConversionArea vc;
+        m_Mesh.GetExTriangle(vpeTriangle, triangleIdx, vc);
 
-        const IndexedTriangle *triIndicesOfInterest = (const IndexedTriangle *)((const uint8 *)triIndicesBegin + triangleIdx * (size_t)triStride);
-        std::copy(triIndicesOfInterest->mVRef, triIndicesOfInterest->mVRef + dMTV__MAX, out_VertexIndices);
-        dSASSERT(dMTV__MAX == dARRAY_SIZE(triIndicesOfInterest->mVRef));
+        std::copy(vpeTriangle.Index, vpeTriangle.Index + dMTV__MAX, out_VertexIndices);
+        dSASSERT(dMTV__MAX == dARRAY_SIZE(vpeTriangle.Index));
         dSASSERT(dMTV_FIRST == 0);
         dSASSERT(dMTV_SECOND == 1);
         dSASSERT(dMTV_THIRD == 2);
@@ -224,8 +228,7 @@ struct TrimeshDataVertexIndexAccessor_OPCODE
     }
 
 
-    const IndexedTriangle   *m_TriIndicesBegin;
-    unsigned                m_TriStride;
+    const MeshInterface     &m_Mesh;
 };
 
 struct TrimeshDataTrianglePointAccessor_OPCODE
@@ -316,9 +319,7 @@ bool dxTriMeshData::meaningfulPreprocessData(bool buildUseFlags/*=false*/, FaceA
             memset(useFlags, 0, flagsMemoryRequired);
         }
 
-        const IndexedTriangle *triIndicesBegin = m_Mesh.GetTris();
-        unsigned triStride = m_Mesh.GetTriStride();
-        TrimeshDataVertexIndexAccessor_OPCODE indexAccessor(triIndicesBegin, triStride);
+        TrimeshDataVertexIndexAccessor_OPCODE indexAccessor(m_Mesh);
         meaningfulPreprocess_SetupEdgeRecords(edges, numEdges, indexAccessor);
 
         // Sort the edges, so the ones sharing the same verts are beside each other
@@ -369,42 +370,166 @@ void dxTriMeshData::updateData()
 }
 
 
+bool dxTriMeshData::compactData()
+{
+    bool result = false;
 
-//////////////////////////////////////////////////////////////////////////
-// dxTriMesh
+    do 
+    {
+        // Nothing is left to compact
+        if (hasCompactStorage())
+        {
+            break;
+        }
 
-dxTriMesh::~dxTriMesh()
-{
-    //
+        const unsigned vertexCount = m_Mesh.GetNbVertices();
+        const unsigned triangleCount = m_Mesh.GetNbTriangles();
+        const dReal *externalNormals = retrieveNormals();
+
+        // Vertex indices are only packed into 16 bits if all of the vertices can be addressed
+        const bool shortIndices = vertexCount <= 0x10000U;
+        const size_t verticesMemoryRequired = dEFFICIENT_SIZE((size_t)vertexCount * (sizeof(uint16) * dSA__MAX));
+        const size_t indicesMemoryRequired = dEFFICIENT_SIZE((size_t)triangleCount * ((shortIndices ? sizeof(uint16) : sizeof(uint32)) * dMTV__MAX));
+        const size_t normalsMemoryRequired = externalNormals != NULL ? calculateNormalsMemoryRequirement() : 0;
+        const size_t totalMemoryRequired = verticesMemoryRequired + indicesMemoryRequired + normalsMemoryRequired;
+
+        void *compactStorage = dAlloc(totalMemoryRequired);
+
+        if (compactStorage == NULL)
+        {
+            break;
+        }
+
+        // Quantize within the model space AABB. Flat axes are stored as zeros.
+        dVector3 origin, scale, inverseScale;
+        dSubtractVectors3(origin, m_AABBCenter, m_AABBExtents);
+
+        for (unsigned axis = dV3E__AXES_MIN; axis != dV3E__AXES_MAX; ++axis)
+        {
+            const dReal axisExtent = m_AABBExtents[axis] * REAL(2.0);
+            scale[axis] = axisExtent / (dReal)0xFFFF;
+            inverseScale[axis] = axisExtent > REAL(0.0) ? (dReal)0xFFFF / axisExtent : REAL(0.0);
+        }
+
+        uint16 *quantizedVertices = (uint16 *)compactStorage;
+
+        if (isSingle())
+        {
+            templateQuantizeVertices<float>(quantizedVertices, origin, inverseScale);
+        }
+        else
+        {
+            templateQuantizeVertices<double>(quantizedVertices, origin, inverseScale);
+        }
+
+        void *triangleIndices = (uint8 *)compactStorage + verticesMemoryRequired;
+
+        if (shortIndices)
+        {
+            templateCopyTriangleIndices<uint16>((uint16 *)triangleIndices);
+        }
+        else
+        {
+            templateCopyTriangleIndices<uint32>((uint32 *)triangleIndices);
+        }
+
+        // Face normals are also an application array and are taken over the same way
+        if (externalNormals != NULL)
+        {
+            dReal *normalsCopy = (dReal *)((uint8 *)triangleIndices + indicesMemoryRequired);
+            memcpy(normalsCopy, externalNormals, normalsMemoryRequired);
+            assignNormals(normalsCopy);
+        }
+
+        Point meshOrigin((float)origin[dV3E_X], (float)origin[dV3E_Y], (float)origin[dV3E_Z]);
+        Point meshScale((float)scale[dV3E_X], (float)scale[dV3E_Y], (float)scale[dV3E_Z]);
+        m_Mesh.SetQuantizedPointers(triangleIndices, quantizedVertices, meshOrigin, meshScale, shortIndices);
+
+        m_CompactStorage = compactStorage;
+        m_CompactStorageSize = totalMemoryRequired;
+
+        // The tree must enclose the dequantized triangles rather than the original ones
+        m_BVTree.Refit();
+
+        result = true;
+    }
+    while (false);
+
+    return result;
 }
 
-void dxTriMesh::clearTCCache()
+template<typename treal>
+void dxTriMeshData::templateQuantizeVertices(uint16 *out_quantizedVertices, const dVector3 origin, const dVector3 inverseScale) const
 {
-    /* dxTriMesh::ClearTCCache uses dArray's setSize(0) to clear the caches -
-    but the destructor isn't called when doing this, so we would leak.
-    So, call the previous caches' containers' destructors by hand first. */
-    int i, n;
+    dIASSERT(isSingle() == (sizeof(treal) == sizeof(float)));
+
+    const uint8 *verts = (const uint8 *)retrieveVertexInstances();
+    const int vertexStide = retrieveVertexStride();
+    const unsigned vertexCount = retrieveVertexCount();
 
-    n = m_SphereTCCache.size();
-    for( i = 0; i != n; ++i ) 
+    uint16 *currentQuantizedVertex = out_quantizedVertices;
+    for (unsigned i = 0; i != vertexCount; ++i)
     {
-        m_SphereTCCache[i].~SphereTC();
+        const treal *v = (const treal *)verts;
+
+        for (unsigned axis = dV3E__AXES_MIN; axis != dV3E__AXES_MAX; ++axis)
+        {
+            dReal quantizedValue = dFloor(((dReal)v[axis] - origin[axis]) * inverseScale[axis] + REAL(0.5));
+            currentQuantizedVertex[axis] = (uint16)dCLAMP(quantizedValue, REAL(0.0), (dReal)0xFFFF);
+        }
+        dSASSERT((unsigned)dV3E__AXES_COUNT == (unsigned)dSA__MAX);
+
+        currentQuantizedVertex += dSA__MAX;
+        verts += vertexStide;
     }
-    m_SphereTCCache.setSize(0);
+}
 
-    n = m_BoxTCCache.size();
-    for( i = 0; i != n; ++i ) 
+template<typename tindexint>
+void dxTriMeshData::templateCopyTriangleIndices(tindexint *out_triangleIndices) const
+{
+    const unsigned triangleCount = m_Mesh.GetNbTriangles();
+
+    tindexint *currentTriangleIndices = out_triangleIndices;
+    for (unsigned triangleIndex = 0; triangleIndex != triangleCount; ++triangleIndex)
     {
-        m_BoxTCCache[i].~BoxTC();
+        VertexPointersEx vpeTriangle;
+        ConversionArea vc;
+        m_Mesh.GetExTriangle(vpeTriangle, triangleIndex, vc);
+
+        for (unsigned vertexIndex = dMTV__MIN; vertexIndex != dMTV__MAX; ++vertexIndex)
+        {
+            currentTriangleIndices[vertexIndex] = (tindexint)vpeTriangle.Index[vertexIndex];
+        }
+
+        currentTriangleIndices += dMTV__MAX;
     }
-    m_BoxTCCache.setSize(0);
+}
 
-    n = m_CapsuleTCCache.size();
-    for( i = 0; i != n; ++i ) 
+void dxTriMeshData::freeCompactStorage()
+{
+    if (m_CompactStorage != NULL)
     {
-        m_CapsuleTCCache[i].~CapsuleTC();
+        dFree(m_CompactStorage, m_CompactStorageSize);
+        m_CompactStorage = NULL;
+        m_CompactStorageSize = 0;
     }
-    m_CapsuleTCCache.setSize(0);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// dxTriMesh
+
+dxTriMesh::~dxTriMesh()
+{
+    //
+}
+
+void dxTriMesh::clearTCCache()
+{
+    m_SphereTCCache.clear();
+    m_BoxTCCache.clear();
+    m_CapsuleTCCache.clear();
 }
 
 
@@ -486,17 +611,31 @@ void dxTriMesh::computeAABB()
     const dMatrix3& R = final_posr->R;
     const dVector3& pos = final_posr->pos;
 
-    dMultiply0_331( c, R, meshData->m_AABBCenter );
+    dVector3 center, extents;
+    if (!isScaled())
+    {
+        dCopyVector3(center, meshData->m_AABBCenter);
+        dCopyVector3(extents, meshData->m_AABBExtents);
+    }
+    else
+    {
+        // Scale factors are positive, so the scaled box is just the box of scaled vertices
+        const dReal *scale = retrieveScale();
+        dAssignVector3(center, meshData->m_AABBCenter[dV3E_X] * scale[dV3E_X], meshData->m_AABBCenter[dV3E_Y] * scale[dV3E_Y], meshData->m_AABBCenter[dV3E_Z] * scale[dV3E_Z]);
+        dAssignVector3(extents, meshData->m_AABBExtents[dV3E_X] * scale[dV3E_X], meshData->m_AABBExtents[dV3E_Y] * scale[dV3E_Y], meshData->m_AABBExtents[dV3E_Z] * scale[dV3E_Z]);
+    }
+
+    dMultiply0_331( c, R, center );
 
-    dReal xrange = dFabs(R[0] * meshData->m_AABBExtents[0]) +
-        dFabs(R[1] * meshData->m_AABBExtents[1]) + 
-        dFabs(R[2] * meshData->m_AABBExtents[2]);
-    dReal yrange = dFabs(R[4] * meshData->m_AABBExtents[0]) +
-        dFabs(R[5] * meshData->m_AABBExtents[1]) + 
-        dFabs(R[6] * meshData->m_AABBExtents[2]);
-    dReal zrange = dFabs(R[8] * meshData->m_AABBExtents[0]) +
-        dFabs(R[9] * meshData->m_AABBExtents[1]) + 
-        dFabs(R[10] * meshData->m_AABBExtents[2]);
+    dReal xrange = dFabs(R[0] * extents[0]) +
+        dFabs(R[1] * extents[1]) + 
+        dFabs(R[2] * extents[2]);
+    dReal yrange = dFabs(R[4] * extents[0]) +
+        dFabs(R[5] * extents[1]) + 
+        dFabs(R[6] * extents[2]);
+    dReal zrange = dFabs(R[8] * extents[0]) +
+        dFabs(R[9] * extents[1]) + 
+        dFabs(R[10] * extents[2]);
 
     aabb[0] = c[0] + pos[0] - xrange;
     aabb[1] = c[0] + pos[0] + xrange;
@@ -540,6 +679,11 @@ void dxTriMesh::fetchMeshTriangle(dVector3 *const pout_triangle[3], unsigned ind
             v[dV3E_Y] = VP.Vertex[i]->y;
             v[dV3E_Z] = VP.Vertex[i]->z;
 
+            if (isScaled())
+            {
+                applyScale(v);
+            }
+
             dVector3 &out_triangle = *(pout_triangle[i]);
             dMultiply0_331(out_triangle, rotation, v);
             dAddVectors3(out_triangle, out_triangle, position);
@@ -565,6 +709,11 @@ void dxTriMesh::fetchMeshTriangle(dVector3 out_triangle[3], unsigned index, cons
         v[dV3E_Y] = VP.Vertex[i]->y;
         v[dV3E_Z] = VP.Vertex[i]->z;
 
+        if (isScaled())
+        {
+            applyScale(v);
+        }
+
         dMultiply0_331(out_triangle[i], rotation, v);
         dAddVectors3(out_triangle[i], out_triangle[i], position);
         out_triangle[i][dV3E_PAD] = REAL(0.0);
@@ -572,6 +721,82 @@ void dxTriMesh::fetchMeshTriangle(dVector3 out_triangle[3], unsigned index, cons
 }
 
 
+void dxTriMesh::convertQuerySphereIntoUnscaledModelSpace(Sphere &inout_Sphere, const dMatrix3 rotation) const
+{
+    dIASSERT(isScaled());
+
+    const dReal *scale = retrieveScale();
+
+    dVector3 offsetCenter, modelCenter;
+    dAssignVector3(offsetCenter, inout_Sphere.mCenter.x, inout_Sphere.mCenter.y, inout_Sphere.mCenter.z);
+    dMultiply1_331(modelCenter, rotation, offsetCenter);
+
+    // The sphere becomes an ellipsoid -- take its bounding sphere
+    const dReal minScale = dMin(dMin(scale[dV3E_X], scale[dV3E_Y]), scale[dV3E_Z]);
+    inout_Sphere.mCenter.Set((float)(modelCenter[dV3E_X] / scale[dV3E_X]), (float)(modelCenter[dV3E_Y] / scale[dV3E_Y]), (float)(modelCenter[dV3E_Z] / scale[dV3E_Z]));
+    inout_Sphere.mRadius = (float)(inout_Sphere.mRadius / minScale);
+}
+
+void dxTriMesh::convertQueryOBBIntoUnscaledModelSpace(OBB &inout_Box, const dMatrix3 rotation) const
+{
+    dIASSERT(isScaled());
+
+    const dReal *scale = retrieveScale();
+
+    dVector3 offsetCenter, modelCenter;
+    dAssignVector3(offsetCenter, inout_Box.mCenter.x, inout_Box.mCenter.y, inout_Box.mCenter.z);
+    dMultiply1_331(modelCenter, rotation, offsetCenter);
+
+    // The box becomes a parallelepiped -- take its axis aligned bounding box
+    dVector3 modelExtents = { REAL(0.0), REAL(0.0), REAL(0.0) };
+    for (unsigned boxAxis = 0; boxAxis != 3; ++boxAxis)
+    {
+        dVector3 worldAxis, modelAxis;
+        dAssignVector3(worldAxis, inout_Box.mRot.m[boxAxis][0], inout_Box.mRot.m[boxAxis][1], inout_Box.mRot.m[boxAxis][2]);
+        dMultiply1_331(modelAxis, rotation, worldAxis);
+
+        const dReal boxExtent = inout_Box.mExtents[boxAxis];
+        for (unsigned axis = dV3E__AXES_MIN; axis != dV3E__AXES_MAX; ++axis)
+        {
+            modelExtents[axis] += dFabs(modelAxis[axis]) * boxExtent;
+        }
+    }
+
+    inout_Box.mCenter.Set((float)(modelCenter[dV3E_X] / scale[dV3E_X]), (float)(modelCenter[dV3E_Y] / scale[dV3E_Y]), (float)(modelCenter[dV3E_Z] / scale[dV3E_Z]));
+    inout_Box.mExtents.Set((float)(modelExtents[dV3E_X] / scale[dV3E_X]), (float)(modelExtents[dV3E_Y] / scale[dV3E_Y]), (float)(modelExtents[dV3E_Z] / scale[dV3E_Z]));
+    inout_Box.mRot.Identity();
+}
+
+dReal dxTriMesh::convertQueryRayIntoUnscaledModelSpace(Ray &inout_Ray, const dMatrix3 rotation) const
+{
+    dIASSERT(isScaled());
+
+    const dReal *scale = retrieveScale();
+
+    dVector3 offsetOrigin, modelOrigin;
+    dAssignVector3(offsetOrigin, inout_Ray.mOrig.x, inout_Ray.mOrig.y, inout_Ray.mOrig.z);
+    dMultiply1_331(modelOrigin, rotation, offsetOrigin);
+
+    dVector3 worldDirection, modelDirection;
+    dAssignVector3(worldDirection, inout_Ray.mDir.x, inout_Ray.mDir.y, inout_Ray.mDir.z);
+    dMultiply1_331(modelDirection, rotation, worldDirection);
+
+    for (unsigned axis = dV3E__AXES_MIN; axis != dV3E__AXES_MAX; ++axis)
+    {
+        modelOrigin[axis] /= scale[axis];
+        modelDirection[axis] /= scale[axis];
+    }
+
+    // Affine mappings preserve the ray parameter up to the direction length change
+    const dReal lengthFactor = dCalcVectorLength3(modelDirection);
+    dScaleVector3(modelDirection, dRecip(lengthFactor));
+
+    inout_Ray.mOrig.Set((float)modelOrigin[dV3E_X], (float)modelOrigin[dV3E_Y], (float)modelOrigin[dV3E_Z]);
+    inout_Ray.mDir.Set((float)modelDirection[dV3E_X], (float)modelDirection[dV3E_Y], (float)modelDirection[dV3E_Z]);
+    return lengthFactor;
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 
 /*extern */
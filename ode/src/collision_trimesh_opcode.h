@@ -176,7 +176,9 @@ public:
     dxTriMeshData():
         dxTriMeshData_Parent(),
         m_ExternalUseFlags(NULL),
-        m_InternalUseFlags(NULL)
+        m_InternalUseFlags(NULL),
+        m_CompactStorage(NULL),
+        m_CompactStorageSize(0)
     {
     }
 
@@ -203,6 +205,19 @@ public:
     /* For when app changes the vertices */
     void updateData();
 
+public:
+    /* Replace references to the app's vertex and index arrays with a quantized copy */
+    bool compactData();
+    bool hasCompactStorage() const { return m_CompactStorage != NULL; }
+    size_t retrieveCompactStorageSize() const { return m_CompactStorageSize; }
+
+private:
+    template<typename treal>
+    void templateQuantizeVertices(uint16 *out_quantizedVertices, const dVector3 origin, const dVector3 inverseScale) const;
+    template<typename tindexint>
+    void templateCopyTriangleIndices(tindexint *out_triangleIndices) const;
+    void freeCompactStorage();
+
 public:
     const Point *retrieveVertexInstances() const { return (const Point *)dxTriMeshData_Parent::retrieveVertexInstances(); }
 
@@ -229,6 +244,10 @@ public:
     uint8 *m_ExternalUseFlags;
     uint8 *m_InternalUseFlags;
 
+    // ODE-owned quantized vertices and packed indices (if compacted)
+    void *m_CompactStorage;
+    size_t m_CompactStorageSize;
+
 };
 
 
@@ -266,6 +285,22 @@ public:
     void fetchMeshTriangle(dVector3 *const pout_triangle[3], unsigned index, const dVector3 position, const dMatrix3 rotation) const;
     void fetchMeshTriangle(dVector3 out_triangle[3], unsigned index, const dVector3 position, const dMatrix3 rotation) const;
 
+    void applyScale(dVector3 inout_vertex) const
+    {
+        const dReal *scale = retrieveScale();
+        inout_vertex[dV3E_X] *= scale[dV3E_X];
+        inout_vertex[dV3E_Y] *= scale[dV3E_Y];
+        inout_vertex[dV3E_Z] *= scale[dV3E_Z];
+    }
+
+public:
+    // OPCODE colliders do not support scaled mesh matrices. For scaled meshes the query volumes,
+    // given relative to the mesh position and to be used with the rotation-only mesh matrix, 
+    // are converted into conservative volumes in unscaled model space to be used without the matrix.
+    void convertQuerySphereIntoUnscaledModelSpace(Sphere &inout_Sphere, const dMatrix3 rotation) const;
+    void convertQueryOBBIntoUnscaledModelSpace(OBB &inout_Box, const dMatrix3 rotation) const;
+    dReal convertQueryRayIntoUnscaledModelSpace(Ray &inout_Ray, const dMatrix3 rotation) const; // Returns the factor of ray length change
+
 public:
     void assignLastTransform(const dMatrix4 last_trans) { dCopyMatrix4x4(m_last_trans, last_trans); }
     const dReal *retrieveLastTransform() const { return m_last_trans; }
@@ -297,15 +332,24 @@ public:
         dxGeom* Geom;
     };
 
+    struct BoxTCInitializer
+    {
+        explicit BoxTCInitializer(float fatCoeff): m_FatCoeff(fatCoeff) {}
+
+        void operator ()(BoxTC &boxTC) const { boxTC.FatCoeff = m_FatCoeff; }
+
+        float m_FatCoeff;
+    };
+
 public:
     // Contact merging option
     dxContactMergeOptions m_SphereContactsMergeOption;
     // Instance data for last transform.
     dMatrix4 m_last_trans;
 
-    dArray<SphereTC> m_SphereTCCache;
-    dArray<BoxTC> m_BoxTCCache;
-    dArray<CapsuleTC> m_CapsuleTCCache;
+    dxTriMeshTCStore<SphereTC> m_SphereTCCache;
+    dxTriMeshTCStore<BoxTC> m_BoxTCCache;
+    dxTriMeshTCStore<CapsuleTC> m_CapsuleTCCache;
 };
 
 
@@ -118,6 +118,11 @@ int dCollideTrimeshPlane( dxGeom *o1, dxGeom *o2, int flags, dContactGeom* conta
             int_vertex[ 1 ] = VP.Vertex[ v ]->y;
             int_vertex[ 2 ] = VP.Vertex[ v ]->z;
 
+            if ( trimesh->isScaled() )
+            {
+                trimesh->applyScale( int_vertex );
+            }
+
             dMultiply0_331( vertex, trimesh_R, int_vertex );
 
 #endif // dSINGLE/dDOUBLE
@@ -76,9 +76,18 @@ int dCollideRTL(dxGeom* g1, dxGeom* RayGeom, int Flags, dContactGeom* Contacts,
     WorldRay.mOrig.Set(OffsetOrigin[0], OffsetOrigin[1], OffsetOrigin[2]);
     WorldRay.mDir.Set(Direction[0], Direction[1], Direction[2]);
 
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    dReal DistanceFactor = REAL(1.0);
+    if (TriMesh->isScaled()) {
+        DistanceFactor = TriMesh->convertQueryRayIntoUnscaledModelSpace(WorldRay, TLRotation);
+        Collider.SetMaxDist(Length * DistanceFactor);
+        pMeshMatrix = null;
+    }
+
     /* Intersect */
     int TriCount = 0;
-    if (Collider.Collide(WorldRay, TriMesh->retrieveMeshBVTreeRef(), &MeshMatrix)) {
+    if (Collider.Collide(WorldRay, TriMesh->retrieveMeshBVTreeRef(), pMeshMatrix)) {
         TriCount = pccColliderCache->m_Faces.GetNbFaces();
     }
 
@@ -126,7 +135,7 @@ int dCollideRTL(dxGeom* g1, dxGeom* RayGeom, int Flags, dContactGeom* Contacts,
                     // If there would be a custom typedef for distance type it could be used 
                     // instead of dReal. However using float directly is the loss of abstraction 
                     // and possible loss of precision in future.
-                    /*float*/ dReal T = Faces[i].mDistance;
+                    /*float*/ dReal T = Faces[i].mDistance / DistanceFactor;
                     Contact->pos[0] = Origin[0] + (Direction[0] * T);
                     Contact->pos[1] = Origin[1] + (Direction[1] * T);
                     Contact->pos[2] = Origin[2] + (Direction[2] * T);
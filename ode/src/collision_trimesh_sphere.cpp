@@ -276,31 +276,24 @@ int dCollideSTL(dxGeom* g1, dxGeom* SphereGeom, int Flags, dContactGeom* Contact
     Sphere.mRadius = Radius;
 
 
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    if (TriMesh->isScaled()) {
+        TriMesh->convertQuerySphereIntoUnscaledModelSpace(Sphere, TLRotation);
+        pMeshMatrix = null;
+    }
+
     // TC results
     if (TriMesh->getDoTC(dxTriMesh::TTC_SPHERE)) {
-        dxTriMesh::SphereTC* sphereTC = 0;
-        const int sphereCacheSize = TriMesh->m_SphereTCCache.size();
-        for (int i = 0; i != sphereCacheSize; i++){
-            if (TriMesh->m_SphereTCCache[i].Geom == SphereGeom){
-                sphereTC = &TriMesh->m_SphereTCCache[i];
-                break;
-            }
-        }
-
-        if (!sphereTC) {
-            TriMesh->m_SphereTCCache.push(dxTriMesh::SphereTC());
-
-            sphereTC = &TriMesh->m_SphereTCCache[TriMesh->m_SphereTCCache.size() - 1];
-            sphereTC->Geom = SphereGeom;
-        }
+        dxTriMesh::SphereTC* sphereTC = TriMesh->m_SphereTCCache.retrieveEntry(SphereGeom);
 
         // Intersect
         Collider.SetTemporalCoherence(true);
-        Collider.Collide(*sphereTC, Sphere, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(*sphereTC, Sphere, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
     else {
         Collider.SetTemporalCoherence(false);
-        Collider.Collide(pccColliderCache->m_DefaultSphereCache, Sphere, TriMesh->retrieveMeshBVTreeRef(), null, &MeshMatrix);
+        Collider.Collide(pccColliderCache->m_DefaultSphereCache, Sphere, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix);
     }
 
     if (! Collider.GetContactStatus()) {
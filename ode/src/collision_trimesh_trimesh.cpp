@@ -38,6 +38,7 @@
 
 #include "collision_util.h"
 #include "collision_trimesh_internal.h"
+#include "array.h"
 
 
 #if !dTLS_ENABLED
@@ -83,8 +84,15 @@ static dReal MostDeepPoints(
                             dReal plane_dist,
                             LineContactSet & deep_points);
 
-static bool TriTriContacts(const dVector3 tr1[3],
-                           const dVector3 tr2[3],
+struct TransformedTriangle
+{
+    dVector3 Vertices[3];
+    dVector4 Plane;
+    bool     PlaneValid;
+};
+
+static bool TriTriContacts(const TransformedTriangle &tr1,
+                           const TransformedTriangle &tr2,
                            int TriIndex1, int TriIndex2,
                            dxGeom* g1, dxGeom* g2, int Flags,
                            CONTACT_KEY_HASH_TABLE &hashcontactset,
@@ -476,7 +484,200 @@ dContactGeom *  PushNewContact( dxGeom* g1, dxGeom* g2, int TriIndex1, int TriIn
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+static bool BuildPlane(const dVector3 s0, const dVector3 s1,const dVector3 s2,
+                       dVector3 Normal, dReal & Dist);
+
+static void BuildTransformedTriangle(TransformedTriangle &out_triangle, 
+                                     dxTriMesh *triMesh, int triIndex, const dVector3 position, const dMatrix3 rotation)
+{
+    triMesh->fetchMeshTriangle(out_triangle.Vertices, triIndex, position, rotation);
+
+    // Since we'll be doing matrix transformations, we need to
+    //  make sure that all vertices have four elements
+    for (int j=0; j<3; j++) {
+        out_triangle.Vertices[j][3] = 1.0;
+    }
+
+    out_triangle.PlaneValid = BuildPlane(out_triangle.Vertices[0], out_triangle.Vertices[1], out_triangle.Vertices[2], 
+        out_triangle.Plane, out_triangle.Plane[3]);
+}
+
+// Consecutive pairs reported by OPCODE tend to share a triangle of one of the meshes
+// (the no-leaf tree traversal tests a single leaf triangle against a whole subtree).
+// The small direct-mapped cache avoids repeating the vertex transformations 
+// and the plane computations for such triangles.
+class TransformedTriangleCache
+{
+public:
+    TransformedTriangleCache(dxTriMesh *triMesh, const dVector3 position, const dMatrix3 rotation):
+        m_TriMesh(triMesh),
+        m_Position(position),
+        m_Rotation(rotation)
+    {
+        for (unsigned entryIndex = 0; entryIndex != CACHE_SIZE; ++entryIndex)
+        {
+            m_TriIndices[entryIndex] = -1;
+        }
+    }
+
+    const TransformedTriangle &RetrieveTriangle(int triIndex)
+    {
+        dIASSERT(triIndex >= 0);
+
+        const unsigned entryIndex = (unsigned)triIndex & (CACHE_SIZE - 1);
+        TransformedTriangle &triangle = m_Triangles[entryIndex];
+
+        if (m_TriIndices[entryIndex] != triIndex)
+        {
+            BuildTransformedTriangle(triangle, m_TriMesh, triIndex, m_Position, m_Rotation);
+
+            m_TriIndices[entryIndex] = triIndex;
+        }
+
+        return triangle;
+    }
+
+private:
+    enum
+    {
+        CACHE_SIZE_BITS = 3,
+        CACHE_SIZE = 1 << CACHE_SIZE_BITS,
+    };
+
+    dxTriMesh           *m_TriMesh;
+    const dReal         *m_Position;
+    const dReal         *m_Rotation;
+    int                 m_TriIndices[CACHE_SIZE];
+    TransformedTriangle m_Triangles[CACHE_SIZE];
+};
+
+
+static void CalculateTriangleBounds(dReal out_bounds[6], const TransformedTriangle &triangle)
+{
+    for (int axis = 0; axis != 3; ++axis) {
+        out_bounds[axis * 2] = dMin(dMin(triangle.Vertices[0][axis], triangle.Vertices[1][axis]), triangle.Vertices[2][axis]);
+        out_bounds[axis * 2 + 1] = dMax(dMax(triangle.Vertices[0][axis], triangle.Vertices[1][axis]), triangle.Vertices[2][axis]);
+    }
+}
+
+static inline bool TriangleBoundsOverlap(const dReal bounds1[6], const dReal bounds2[6])
+{
+    return bounds1[0] <= bounds2[1] && bounds2[0] <= bounds1[1]
+        && bounds1[2] <= bounds2[3] && bounds2[2] <= bounds1[3]
+        && bounds1[4] <= bounds2[5] && bounds2[4] <= bounds1[5];
+}
+
+static bool QueryTrianglesInWorldBox(OBBCollider &Collider, OBBCache &Cache, dxTriMesh *TriMesh,
+                                     const dVector3 BoxCenter, const dVector3 BoxExtents)
+{
+    const dVector3& TLPosition = *(const dVector3*) dGeomGetPosition(TriMesh);
+    const dMatrix3& TLRotation = *(const dMatrix3*) dGeomGetRotation(TriMesh);
+
+    Matrix4x4 MeshMatrix;
+    const dVector3 ZeroVector3 = { REAL(0.0), };
+    MakeMatrix(ZeroVector3, TLRotation, MeshMatrix);
+
+    OBB Box;
+    Box.mCenter.Set(BoxCenter[0] - TLPosition[0], BoxCenter[1] - TLPosition[1], BoxCenter[2] - TLPosition[2]);
+    Box.mExtents.Set(BoxExtents[0], BoxExtents[1], BoxExtents[2]);
+    Box.mRot.Identity();
+
+    // OPCODE does not support scaled matrices -- query scaled meshes in model space
+    const Matrix4x4 *pMeshMatrix = &MeshMatrix;
+    if (TriMesh->isScaled()) {
+        TriMesh->convertQueryOBBIntoUnscaledModelSpace(Box, TLRotation);
+        pMeshMatrix = null;
+    }
+
+    return Collider.Collide(Cache, Box, TriMesh->retrieveMeshBVTreeRef(), null, pMeshMatrix) 
+        && Collider.GetContactStatus();
+}
+
+// OPCODE tree-tree collider does not support scaled matrices. For scaled meshes
+// the triangles of either mesh within the overlap of geom AABBs are selected with 
+// OBB queries and all the pairs of them with overlapping bounds are tested.
+static int CollideScaledTTL(dxTriMesh *TriMesh1, dxTriMesh *TriMesh2, int Flags, 
+                            CONTACT_KEY_HASH_TABLE &hashcontactset, dContactGeom* Contacts, int Stride)
+{
+    // The AABBs are already current if called from a space collision
+    TriMesh1->recomputeAABB();
+    TriMesh2->recomputeAABB();
+
+    dVector3 BoxCenter, BoxExtents;
+    for (int axis = 0; axis != 3; ++axis) {
+        dReal boxMin = dMax(TriMesh1->aabb[axis * 2], TriMesh2->aabb[axis * 2]);
+        dReal boxMax = dMin(TriMesh1->aabb[axis * 2 + 1], TriMesh2->aabb[axis * 2 + 1]);
+        if (boxMin > boxMax) {
+            return 0;
+        }
+
+        BoxCenter[axis] = (boxMin + boxMax) * REAL(0.5);
+        BoxExtents[axis] = (boxMax - boxMin) * REAL(0.5);
+    }
+
+    // The touched primitives are stored in the caches
+    OBBCollider Collider1, Collider2;
+    OBBCache Cache1, Cache2;
+    Collider1.SetFirstContact(false);
+    Collider1.SetTemporalCoherence(false);
+    Collider2.SetFirstContact(false);
+    Collider2.SetTemporalCoherence(false);
 
+    if (!QueryTrianglesInWorldBox(Collider1, Cache1, TriMesh1, BoxCenter, BoxExtents) 
+        || !QueryTrianglesInWorldBox(Collider2, Cache2, TriMesh2, BoxCenter, BoxExtents)) {
+        return 0;
+    }
+
+    const int TriCount1 = Collider1.GetNbTouchedPrimitives();
+    const int* Triangles1 = (const int*)Collider1.GetTouchedPrimitives();
+    const int TriCount2 = Collider2.GetNbTouchedPrimitives();
+    const int* Triangles2 = (const int*)Collider2.GetTouchedPrimitives();
+
+    const dVector3& TLPosition1 = *(const dVector3*) dGeomGetPosition(TriMesh1);
+    const dMatrix3& TLRotation1 = *(const dMatrix3*) dGeomGetRotation(TriMesh1);
+    const dVector3& TLPosition2 = *(const dVector3*) dGeomGetPosition(TriMesh2);
+    const dMatrix3& TLRotation2 = *(const dMatrix3*) dGeomGetRotation(TriMesh2);
+
+    // The second mesh triangles are transformed once as they are tested against every triangle of the first mesh
+    dArray<TransformedTriangle> triangles2;
+    dArray<dReal> bounds2;
+    triangles2.setSize(TriCount2);
+    bounds2.setSize(TriCount2 * 6);
+
+    for (int j = 0; j < TriCount2; j++) {
+        BuildTransformedTriangle(triangles2[j], TriMesh2, Triangles2[j], TLPosition2, TLRotation2);
+        CalculateTriangleBounds(&bounds2[j * 6], triangles2[j]);
+    }
+
+    int OutTriCount = 0;
+
+    for (int i = 0; i < TriCount1; i++) {
+        const int id1 = Triangles1[i];
+
+        TransformedTriangle triangle1;
+        BuildTransformedTriangle(triangle1, TriMesh1, id1, TLPosition1, TLRotation1);
+
+        dReal bounds1[6];
+        CalculateTriangleBounds(bounds1, triangle1);
+
+        for (int j = 0; j < TriCount2; j++) {
+            if (!TriangleBoundsOverlap(bounds1, &bounds2[j * 6])) {
+                continue;
+            }
+
+            TriTriContacts(triangle1, triangles2[j], id1, Triangles2[j],
+                TriMesh1, TriMesh2, Flags, hashcontactset,
+                Contacts, Stride, OutTriCount);
+
+            // Break only if contacts are not important (see dCollideTTL)
+            if ((OutTriCount | CONTACTS_UNIMPORTANT) == (Flags & (NUMC_MASK | CONTACTS_UNIMPORTANT))) {
+                return OutTriCount;
+            }
+        }
+    }
+
+    return OutTriCount;
+}
 
 
 /*extern */
@@ -514,6 +715,10 @@ int dCollideTTL(dxGeom* g1, dxGeom* g2, int Flags, dContactGeom* Contacts, int S
     ////Prepare contact list
     ClearContactSet(hashcontactset);
 
+    if (TriMesh1->isScaled() || TriMesh2->isScaled()) {
+        return CollideScaledTTL(TriMesh1, TriMesh2, Flags, hashcontactset, Contacts, Stride);
+    }
+
     // Collision query
     Matrix4x4 amatrix, bmatrix;
     dVector3 TLOffsetPosition1 = { REAL(0.0), };
@@ -535,7 +740,9 @@ int dCollideTTL(dxGeom* g1, dxGeom* g2, int Flags, dContactGeom* Contacts, int S
                 // step through the pairs, adding contacts
                 int             id1, id2;
                 int             OutTriCount = 0;
-                dVector3        v1[3], v2[3];
+
+                TransformedTriangleCache triangleCache1(TriMesh1, TLPosition1, TLRotation1);
+                TransformedTriangleCache triangleCache2(TriMesh2, TLPosition2, TLRotation2);
 
                 for (int i = 0; i < TriCount; i++)
                 {
@@ -543,17 +750,10 @@ int dCollideTTL(dxGeom* g1, dxGeom* g2, int Flags, dContactGeom* Contacts, int S
                     id2 = CollidingPairs[i].id1;
 
                     // grab the colliding triangles
-                    static_cast<dxTriMesh *>(g1)->fetchMeshTriangle(v1, id1, TLPosition1, TLRotation1);
-                    static_cast<dxTriMesh *>(g2)->fetchMeshTriangle(v2, id2, TLPosition2, TLRotation2);
-
-                    // Since we'll be doing matrix transformations, we need to
-                    //  make sure that all vertices have four elements
-                    for (int j=0; j<3; j++) {
-                        v1[j][3] = 1.0;
-                        v2[j][3] = 1.0;
-                    }
+                    const TransformedTriangle &triangle1 = triangleCache1.RetrieveTriangle(id1);
+                    const TransformedTriangle &triangle2 = triangleCache2.RetrieveTriangle(id2);
 
-                    TriTriContacts(v1,v2, id1,id2,
+                    TriTriContacts(triangle1,triangle2, id1,id2,
                         g1, g2, Flags, hashcontactset,
                         Contacts,Stride,OutTriCount);
 
@@ -833,6 +1033,7 @@ ClipConvexPolygonAgainstPlane( const dVector3 N, dReal C,
 }
 
 
+static 
 bool BuildPlane(const dVector3 s0, const dVector3 s1,const dVector3 s2,
                 dVector3 Normal, dReal & Dist)
 {
@@ -1015,19 +1216,42 @@ void ClipPointsByTri(
 }
 
 
+/*
+Returns the largest depth of the points below the plane.
+Points clipped from a triangle can't be deeper than the triangle vertices,
+hence a negative result means the face plane is a separating axis and
+the polygon clipping can be skipped.
+*/
+static inline 
+dReal MaxVertexDepthBelowPlane(const dVector3 tri[3], const dVector4 plane)
+{
+    dReal maxdeep = plane[3] - DOT(plane, tri[0]);
+    dReal dist;
+
+    dist = plane[3] - DOT(plane, tri[1]);
+    if (dist > maxdeep) maxdeep = dist;
+
+    dist = plane[3] - DOT(plane, tri[2]);
+    if (dist > maxdeep) maxdeep = dist;
+
+    return maxdeep;
+}
+
 ///returns the penetration depth
 dReal FindTriangleTriangleCollision(
-                                    const dVector3 tri1[3],
-                                    const dVector3 tri2[3],
+                                    const TransformedTriangle &triangle1,
+                                    const TransformedTriangle &triangle2,
                                     dVector3 separating_normal,
                                     LineContactSet & deep_points)
 {
+    const dVector3 *tri1 = triangle1.Vertices, *tri2 = triangle2.Vertices;
+
     dReal maxdeep=dInfinity;
     dReal dist;
     int mostdir=0, /*mostface=0,*/ currdir=0;
     //	dReal vmin1,vmax1,vmin2,vmax2;
     //	dVector3 crossdir, pt1,pt2;
-    dVector4 tri1plane,tri2plane;
+    const dReal *tri1plane = triangle1.Plane, *tri2plane = triangle2.Plane;
     separating_normal[3] = 0.0f;
     bool bl;
     LineContactSet clipped_points1,clipped_points2;
@@ -1036,10 +1260,23 @@ dReal FindTriangleTriangleCollision(
     // might be skipped leading to uninitialized count being used for memcpy in if(mostdir==0)
     deep_points1.Count = 0;
 
+    ////early-out on face planes before doing any clipping
+
+    if (triangle1.PlaneValid)
+    {
+        dist = MaxVertexDepthBelowPlane(tri2, tri1plane);
+        if (dist < -DISTANCE_EPSILON) return dist;
+    }
+
+    if (triangle2.PlaneValid)
+    {
+        dist = MaxVertexDepthBelowPlane(tri1, tri2plane);
+        if (dist < -DISTANCE_EPSILON) return dist;
+    }
+
     ////find interval face1
 
-    bl = BuildPlane(tri1[0],tri1[1],tri1[2],
-        tri1plane,tri1plane[3]);
+    bl = triangle1.PlaneValid;
     clipped_points1.Count = 0;
 
     if(bl)
@@ -1065,8 +1302,7 @@ dReal FindTriangleTriangleCollision(
 
     ////find interval face2
 
-    bl = BuildPlane(tri2[0],tri2[1],tri2[2],
-        tri2plane,tri2plane[3]);
+    bl = triangle2.PlaneValid;
 
 
     clipped_points2.Count = 0;
@@ -1249,8 +1485,8 @@ dReal FindTriangleTriangleCollision(
 
 
 ///SUPPORT UP TO 8 CONTACTS
-bool TriTriContacts(const dVector3 tr1[3],
-                    const dVector3 tr2[3],
+bool TriTriContacts(const TransformedTriangle &tr1,
+                    const TransformedTriangle &tr2,
                     int TriIndex1, int TriIndex2,
                     dxGeom* g1, dxGeom* g2, int Flags, 
                     CONTACT_KEY_HASH_TABLE &hashcontactset,
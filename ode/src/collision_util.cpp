@@ -611,3 +611,107 @@ void		 dClipPolyToCircle(const dVector3 avArrayIn[], const int ctIn,
     }	
 }
 
+
+static void dSwapContacts (dContactGeom *a, dContactGeom *b)
+{
+    if (a != b) {
+        dContactGeom tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+}
+
+// picks up to 4 of the `count' contacts at `contacts' sharing `normal':
+// the first one (the deepest), the furthest from it, the one making the
+// largest triangle with them and the one adding the largest area outside
+// that triangle. they are copied to the front and their count returned.
+
+static int dReduceManifold (dContactGeom *contacts, int count, int skip,
+                            const dReal *normal)
+{
+    int keep[4] = { 0, 0, 0, 0 };
+    int kept = 1;
+    dReal best = 0;
+    dVector3 u,v,w;
+    const dReal *p0 = contacts->pos;
+    for (int i=1; i<count; i++) {
+        dSubtractVectors3 (u,CONTACT(contacts,i*skip)->pos,p0);
+        dReal d = dCalcVectorLengthSquare3 (u);
+        if (d > best) { best = d; keep[1] = i; }
+    }
+    if (best > 0) {
+        kept = 2;
+        dSubtractVectors3 (u,CONTACT(contacts,keep[1]*skip)->pos,p0);
+        dReal triangle = 0;
+        best = 0;
+        for (int i=1; i<count; i++) {
+            dSubtractVectors3 (v,CONTACT(contacts,i*skip)->pos,p0);
+            dCalcVectorCross3 (w,u,v);
+            dReal area = dCalcVectorDot3 (w,normal);
+            if (dFabs(area) > best) { best = dFabs(area); triangle = area; keep[2] = i; }
+        }
+        if (best > 0) {
+            kept = 3;
+            best = 0;
+            for (int i=1; i<count; i++) {
+                const dReal *p = CONTACT(contacts,i*skip)->pos;
+                for (int k=0; k<3; k++) {
+                    const dReal *a = CONTACT(contacts,keep[k]*skip)->pos;
+                    const dReal *b = CONTACT(contacts,keep[(k+1)%3]*skip)->pos;
+                    dSubtractVectors3 (u,b,a);
+                    dSubtractVectors3 (v,p,a);
+                    dCalcVectorCross3 (w,u,v);
+                    // outside the edge when of opposite winding to the triangle
+                    dReal area = dCalcVectorDot3 (w,normal);
+                    if (triangle > 0) area = -area;
+                    if (area > best) { best = area; keep[3] = i; }
+                }
+            }
+            if (best > 0) kept = 4;
+        }
+    }
+    dContactGeom reduced[4];
+    for (int k=0; k<kept; k++) reduced[k] = *CONTACT(contacts,keep[k]*skip);
+    for (int k=0; k<kept; k++) *CONTACT(contacts,k*skip) = reduced[k];
+    return kept;
+}
+
+
+int dReduceContactManifolds (dContactGeom *contacts, int count, int skip)
+{
+    int done = 0;
+    while (count - done > 4) {
+        // the deepest remaining contact seeds the next manifold
+        int seed = done;
+        for (int i=done+1; i<count; i++) {
+            if (CONTACT(contacts,i*skip)->depth > CONTACT(contacts,seed*skip)->depth) seed = i;
+        }
+        dSwapContacts (CONTACT(contacts,done*skip),CONTACT(contacts,seed*skip));
+        const dContactGeom *first = CONTACT(contacts,done*skip);
+
+        // gather the manifold behind it
+        int members = 1;
+        for (int i=done+1; i<count; i++) {
+            const dContactGeom *c = CONTACT(contacts,i*skip);
+            if (c->g1 == first->g1 && c->g2 == first->g2 &&
+                dCalcVectorDot3 (c->normal,first->normal) >= dCONTACT_MANIFOLD_NORMAL_COS) {
+                dSwapContacts (CONTACT(contacts,(done+members)*skip),CONTACT(contacts,i*skip));
+                members++;
+            }
+        }
+
+        int kept = members;
+        if (members > 4) {
+            dVector3 normal;
+            dCopyVector3 (normal,first->normal);
+            kept = dReduceManifold (CONTACT(contacts,done*skip),members,skip,normal);
+            // close the gap left by the dropped contacts
+            for (int i=done+members; i<count; i++) {
+                *CONTACT(contacts,(i-members+kept)*skip) = *CONTACT(contacts,i*skip);
+            }
+            count -= members - kept;
+        }
+        done += kept;
+    }
+    return count;
+}
@@ -89,6 +89,15 @@ void dClipPolyToPlane(const dVector3 avArrayIn[], const int ctIn, dVector3 avArr
 
 void dClipPolyToCircle(const dVector3 avArrayIn[], const int ctIn, dVector3 avArrayOut[], int &ctOut, const dVector4 &plPlane ,dReal fRadius);
 
+// reduce contact manifolds: contacts of the same geom pair with normals
+// within dCONTACT_MANIFOLD_NORMAL_COS of the deepest one make a manifold, of
+// which the deepest contact and the three spreading it the most are kept.
+// the kept contacts are packed at the start of the array, their count is
+// returned.
+#define dCONTACT_MANIFOLD_NORMAL_COS REAL(0.95)
+
+int dReduceContactManifolds (dContactGeom *contacts, int count, int skip);
+
 // Some vector math
 static inline 
 void dVector3Subtract(const dVector3& a,const dVector3& b,dVector3& c)
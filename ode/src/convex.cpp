@@ -31,7 +31,9 @@ By Rodrigo Hernandez
 #include "odemath.h"
 #include "collision_kernel.h"
 #include "collision_std.h"
+#include "util.h"
 #include "collision_util.h"
+#include "array.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4291)  // for VC++, no complaints about "no matching operator delete found"
@@ -67,7 +69,13 @@ dxConvex::dxConvex (dSpaceID space,
     pointcount = _pointcount;
     polygons=_polygons;
     edges = NULL;
-    FillEdges();
+    adjacencyStart = NULL;
+    adjacency = NULL;
+    supportHint = 0;
+    hullPlanes = NULL;
+    hullPoints = NULL;
+    hullPolygons = NULL;
+    ComputeConnectivity();
 #ifndef dNODEBUG
     // Check for properly build polygons by calculating the determinant
     // of the 3x3 matrix composed of the first 3 points in the polygon.
@@ -120,13 +128,90 @@ void dxConvex::computeAABB()
     }
 }
 
+void dxConvex::ComputeConnectivity()
+{
+    FillEdges();
+    FillAdjacency();
+}
+
+/*! \brief Builds compressed point adjacency lists from the edges, hill climbing
+  support queries walk them instead of scanning all the points */
+void dxConvex::FillAdjacency()
+{
+    FreeAdjacency();
+    supportHint = 0;
+
+    if (pointcount <= HILL_CLIMBING_MIN_POINTS || edgecount == 0)
+        return;
+
+    adjacencyStart = new unsigned int[pointcount+1];
+    adjacency = new unsigned int[edgecount*2];
+
+    // count neighbours, then turn counts into start offsets
+    memset(adjacencyStart,0,(pointcount+1)*sizeof(unsigned int));
+    for(unsigned int i=0;i<edgecount;++i)
+    {
+        ++adjacencyStart[edges[i].first+1];
+        ++adjacencyStart[edges[i].second+1];
+    }
+    for(unsigned int i=0;i<pointcount;++i)
+    {
+        adjacencyStart[i+1]+=adjacencyStart[i];
+    }
+
+    unsigned int *fill = new unsigned int[pointcount];
+    memcpy(fill,adjacencyStart,pointcount*sizeof(unsigned int));
+    for(unsigned int i=0;i<edgecount;++i)
+    {
+        adjacency[fill[edges[i].first]++] = edges[i].second;
+        adjacency[fill[edges[i].second]++] = edges[i].first;
+    }
+    delete[] fill;
+
+    // start climbing from a point of the hull surface
+    supportHint = edges[0].first;
+}
+
+void dxConvex::FreeHull()
+{
+    delete[] hullPlanes;
+    delete[] hullPoints;
+    delete[] hullPolygons;
+    hullPlanes = NULL;
+    hullPoints = NULL;
+    hullPolygons = NULL;
+}
+
+void dxConvex::FreeAdjacency()
+{
+    delete[] adjacencyStart;
+    delete[] adjacency;
+    adjacencyStart = NULL;
+    adjacency = NULL;
+}
+
 /*! \brief Populates the edges set, should be called only once whenever the polygon array gets updated */
 void dxConvex::FillEdges()
 {
     const unsigned int *points_in_poly=polygons;
     const unsigned int *index=polygons+1;
     if (edges!=NULL) delete[] edges;
+    edges = NULL;
     edgecount = 0;
+    // every polygon side is an edge at most once, and edges are found
+    // again through the ones sharing their lower point
+    unsigned int sides = 0;
+    for(unsigned int i=0;i<planecount;++i)
+    {
+        sides+=*points_in_poly;
+        points_in_poly+=(*points_in_poly+1);
+    }
+    if(sides==0) return;
+    edge* tmp = new edge[sides];
+    unsigned int *firstEdge = new unsigned int[pointcount];
+    unsigned int *nextEdge = new unsigned int[sides];
+    for(unsigned int i=0;i<pointcount;++i) firstEdge[i]=sides;
+    points_in_poly=polygons;
     edge e;
     bool isinset;
     for(unsigned int i=0;i<planecount;++i)
@@ -136,31 +221,34 @@ void dxConvex::FillEdges()
             e.first = dMIN(index[j],index[(j+1)%*points_in_poly]);
             e.second = dMAX(index[j],index[(j+1)%*points_in_poly]);
             isinset=false;
-            for(unsigned int k=0;k<edgecount;++k)
+            for(unsigned int k=firstEdge[e.first];k!=sides;k=nextEdge[k])
             {
-                if((edges[k].first==e.first)&&(edges[k].second==e.second))
+                if(tmp[k].second==e.second)
                 {
+                    tmp[k].secondFace=i;
                     isinset=true;
                     break;
                 }
             }
             if(!isinset)
             {
-                edge* tmp = new edge[edgecount+1];
-                if(edgecount!=0)
-                {
-                    memcpy(tmp,edges,(edgecount)*sizeof(edge));
-                    delete[] edges;
-                }
                 tmp[edgecount].first=e.first;
                 tmp[edgecount].second=e.second;
-                edges = tmp;
+                tmp[edgecount].firstFace=i;
+                tmp[edgecount].secondFace=i;
+                nextEdge[edgecount]=firstEdge[e.first];
+                firstEdge[e.first]=edgecount;
                 ++edgecount;
             }
         }
         points_in_poly+=(*points_in_poly+1);
         index=points_in_poly+1;
     }
+    delete[] firstEdge;
+    delete[] nextEdge;
+    edges = new edge[edgecount];
+    memcpy(edges,tmp,edgecount*sizeof(edge));
+    delete[] tmp;
 }
 #if 0
 dxConvex::BSPNode* dxConvex::CreateNode(std::vector<Arc> Arcs,std::vector<Polygon> Polygons)
@@ -230,6 +318,516 @@ void dGeomSetConvex (dGeomID g,const dReal *_planes,unsigned int _planecount,
     s->points = _points;
     s->pointcount = _pointcount;
     s->polygons=_polygons;
+    s->FreeHull();
+    s->ComputeConnectivity();
+    dGeomMoved(g);
+}
+
+//****************************************************************************
+// Hull construction from point clouds (quickhull)
+//
+
+/*
+Triangle of the hull under construction, v is counter clockwise seen from
+outside and neighbour[k] is the face across the edge v[k] -> v[k+1].
+*/
+struct dxHullFace
+{
+    unsigned int v[3];
+    int neighbour[3];
+    dReal n[3];
+    dReal d;
+    int visible; // the last flood the face was seen from the eye in
+    bool alive;
+};
+
+struct dxConvexHullBuilder
+{
+    const dReal *points;
+    unsigned int pointcount;
+    dReal epsilon;
+    dArray<dxHullFace> faces;
+    dArray<int> outside;        // face each point is outside of, -1 once it is on or inside the hull
+    dArray<dReal> distance;     // distance of each point to its outside face
+    dArray<int> startOf, endOf; // horizon vertex to new face maps
+    dArray<int> horizonFlood;   // the last flood each vertex started a horizon edge in
+    dArray<unsigned int> horizonNext; // the end of the horizon edge started by each vertex
+    dArray<int> stack, visibleFaces;
+    int flood;                  // stamp of the last flood of visible faces
+
+    dxConvexHullBuilder(const dReal *_points, unsigned int _pointcount):
+        points(_points), pointcount(_pointcount), epsilon(0), flood(0) {}
+
+    const dReal *Point(unsigned int i) const { return points+(i*3); }
+
+    dReal Distance(const dxHullFace& f, unsigned int i) const
+    {
+        return dCalcVectorDot3(f.n,Point(i))-f.d;
+    }
+
+    int AddFace(unsigned int a, unsigned int b, unsigned int c)
+    {
+        dxHullFace f;
+        dVector3 e1,e2;
+        f.v[0]=a; f.v[1]=b; f.v[2]=c;
+        f.neighbour[0]=f.neighbour[1]=f.neighbour[2]=-1;
+        dSubtractVectors3(e1,Point(b),Point(a));
+        dSubtractVectors3(e2,Point(c),Point(a));
+        dCalcVectorCross3(f.n,e1,e2);
+        dNormalize3(f.n);
+        f.d = dCalcVectorDot3(f.n,Point(a));
+        f.visible = -1;
+        f.alive = true;
+        faces.push(f);
+        return faces.size()-1;
+    }
+
+    void AssignOutside(unsigned int i, int first, int last)
+    {
+        outside[i] = -1;
+        for (int j = first; j < last; ++j)
+        {
+            if (!faces[j].alive) continue;
+            const dReal dist = Distance(faces[j],i);
+            if (dist > epsilon)
+            {
+                outside[i] = j;
+                distance[i] = dist;
+                return;
+            }
+        }
+    }
+
+    bool BuildSimplex();
+    bool FloodVisible(unsigned int eye, dReal threshold);
+    bool AddPoint(unsigned int eye);
+    bool Build(unsigned int maxvertices);
+    void Export(dReal *&planes, unsigned int &planecount, dReal *&hullpoints,
+                unsigned int &hullpointcount, unsigned int *&polygons) const;
+};
+
+bool dxConvexHullBuilder::BuildSimplex()
+{
+    // the pair of axis extremes furthest apart
+    unsigned int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+    dReal scale = 0;
+    for (unsigned int i = 1; i < pointcount; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if (Point(i)[k] < Point(extremes[k*2])[k]) extremes[k*2] = i;
+            if (Point(i)[k] > Point(extremes[k*2+1])[k]) extremes[k*2+1] = i;
+        }
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        scale += dMAX(dFabs(Point(extremes[k*2])[k]),dFabs(Point(extremes[k*2+1])[k]));
+    }
+    epsilon = 3 * scale * dEpsilon;
+
+    unsigned int s[4];
+    dReal best = 0;
+    dVector3 u,v,w;
+    for (int k = 0; k < 3; ++k)
+    {
+        const dReal span = Point(extremes[k*2+1])[k]-Point(extremes[k*2])[k];
+        if (span > best) { best = span; s[0] = extremes[k*2]; s[1] = extremes[k*2+1]; }
+    }
+    if (best <= epsilon) return false;
+    // furthest from the line
+    dSubtractVectors3(u,Point(s[1]),Point(s[0]));
+    dNormalize3(u);
+    best = 0;
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        dSubtractVectors3(v,Point(i),Point(s[0]));
+        dCalcVectorCross3(w,u,v);
+        const dReal dist = dCalcVectorLengthSquare3(w);
+        if (dist > best) { best = dist; s[2] = i; }
+    }
+    if (best <= epsilon*epsilon) return false;
+    // furthest from the plane
+    dSubtractVectors3(v,Point(s[2]),Point(s[0]));
+    dCalcVectorCross3(w,u,v);
+    dNormalize3(w);
+    best = 0;
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        dSubtractVectors3(v,Point(i),Point(s[0]));
+        const dReal dist = dFabs(dCalcVectorDot3(w,v));
+        if (dist > best) { best = dist; s[3] = i; }
+    }
+    if (best <= epsilon) return false;
+
+    static const unsigned int tetrahedron[4][3] = { {0,1,2}, {0,3,1}, {1,3,2}, {2,3,0} };
+    dVector3 centroid;
+    for (int k = 0; k < 3; ++k)
+    {
+        centroid[k] = (Point(s[0])[k]+Point(s[1])[k]+Point(s[2])[k]+Point(s[3])[k])*REAL(0.25);
+    }
+    for (int f = 0; f < 4; ++f)
+    {
+        const int index = AddFace(s[tetrahedron[f][0]],s[tetrahedron[f][1]],s[tetrahedron[f][2]]);
+        dxHullFace& face = faces[index];
+        if (dCalcVectorDot3(face.n,centroid)-face.d > 0)
+        {
+            const unsigned int tmp = face.v[1];
+            face.v[1] = face.v[2];
+            face.v[2] = tmp;
+            dNegateVector3(face.n);
+            face.d = -face.d;
+        }
+    }
+    // every edge of a tetrahedron is shared by two of its faces
+    for (int f = 0; f < 4; ++f)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const unsigned int a = faces[f].v[k], b = faces[f].v[(k+1)%3];
+            for (int g = 0; g < 4; ++g)
+            {
+                for (int l = 0; g != f && l < 3; ++l)
+                {
+                    if (faces[g].v[l] == b && faces[g].v[(l+1)%3] == a) faces[f].neighbour[k] = g;
+                }
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        AssignOutside(i,0,4);
+    }
+    for (int k = 0; k < 4; ++k)
+    {
+        outside[s[k]] = -1;
+    }
+    return true;
+}
+
+/*! \brief Collects the faces the eye point is further than threshold above of
+  \return true if the horizon of the faces is a single simple loop
+ */
+bool dxConvexHullBuilder::FloodVisible(unsigned int eye, dReal threshold)
+{
+    // visible faces are flooded from the one the eye is outside of
+    ++flood;
+    stack.setSize(0);
+    visibleFaces.setSize(0);
+    stack.push(outside[eye]);
+    faces[outside[eye]].visible = flood;
+    while (stack.size() != 0)
+    {
+        const int f = stack[stack.size()-1];
+        stack.setSize(stack.size()-1);
+        visibleFaces.push(f);
+        for (int k = 0; k < 3; ++k)
+        {
+            const int nb = faces[f].neighbour[k];
+            if (faces[nb].visible != flood && Distance(faces[nb],eye) > threshold)
+            {
+                faces[nb].visible = flood;
+                stack.push(nb);
+            }
+        }
+    }
+
+    // each horizon vertex starts a single edge, and following the edges
+    // from any of them passes all the others before coming back
+    int edgecount = 0;
+    unsigned int first = 0;
+    for (int v = 0; v < visibleFaces.size(); ++v)
+    {
+        const int f = visibleFaces[v];
+        for (int k = 0; k < 3; ++k)
+        {
+            if (faces[faces[f].neighbour[k]].visible == flood) continue;
+            const unsigned int a = faces[f].v[k];
+            if (horizonFlood[a] == flood) return false;
+            horizonFlood[a] = flood;
+            horizonNext[a] = faces[f].v[(k+1)%3];
+            first = a;
+            ++edgecount;
+        }
+    }
+    unsigned int i = first;
+    for (int e = 0; e < edgecount; ++e)
+    {
+        if (horizonFlood[i] != flood || (e != 0 && i == first)) return false;
+        i = horizonNext[i];
+    }
+    return i == first;
+}
+
+/*! \brief Replaces the faces seen from the eye point by a cone to it
+  \return false if the faces seen from the eye can not be replaced by a
+  cone (see below), the hull is left unchanged then
+ */
+bool dxConvexHullBuilder::AddPoint(unsigned int eye)
+{
+    // Rounding may show the eye faces nearly coplanar with it inconsistently,
+    // and leave holes or pinches in the visible faces. Their horizon is not
+    // a simple loop then, and the faces the eye is not clearly below are
+    // taken as visible too.
+    if (!FloodVisible(eye,epsilon) && !FloodVisible(eye,-epsilon)) return false;
+
+    // a cone face on each horizon edge
+    const int firstNew = faces.size();
+    for (int v = 0; v < visibleFaces.size(); ++v)
+    {
+        const int f = visibleFaces[v];
+        faces[f].alive = false;
+        for (int k = 0; k < 3; ++k)
+        {
+            const int nb = faces[f].neighbour[k];
+            if (faces[nb].visible == flood) continue;
+            const unsigned int a = faces[f].v[k], b = faces[f].v[(k+1)%3];
+            const int cone = AddFace(a,b,eye);
+            faces[cone].neighbour[0] = nb;
+            for (int l = 0; l < 3; ++l)
+            {
+                if (faces[nb].neighbour[l] == f) faces[nb].neighbour[l] = cone;
+            }
+            startOf[a] = cone;
+            endOf[b] = cone;
+        }
+    }
+    for (int f = firstNew; f < faces.size(); ++f)
+    {
+        faces[f].neighbour[1] = startOf[faces[f].v[1]];
+        faces[f].neighbour[2] = endOf[faces[f].v[0]];
+    }
+
+    // points outside of removed faces move to the cone
+    outside[eye] = -1;
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        if (outside[i] >= 0 && outside[i] < firstNew && faces[outside[i]].visible == flood)
+        {
+            AssignOutside(i,firstNew,faces.size());
+        }
+    }
+    return true;
+}
+
+bool dxConvexHullBuilder::Build(unsigned int maxvertices)
+{
+    if (pointcount < 4) return false;
+    outside.setSize(pointcount);
+    distance.setSize(pointcount);
+    startOf.setSize(pointcount);
+    endOf.setSize(pointcount);
+    horizonFlood.setSize(pointcount);
+    horizonNext.setSize(pointcount);
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        startOf[i] = endOf[i] = -1;
+        horizonFlood[i] = 0;
+    }
+    if (!BuildSimplex()) return false;
+
+    // The furthest point goes first, so stopping at maxvertices leaves out the least significant ones.
+    // Points that can not be added are retried once against the hull grown without them.
+    dArray<unsigned int> deferred;
+    bool retrying = false;
+    for (unsigned int vertexcount = 4; maxvertices == 0 || vertexcount < maxvertices; )
+    {
+        int eye = -1;
+        for (unsigned int i = 0; i < pointcount; ++i)
+        {
+            if (outside[i] >= 0 && (eye < 0 || distance[i] > distance[eye])) eye = i;
+        }
+        if (eye < 0)
+        {
+            if (retrying || deferred.size() == 0) break;
+            retrying = true;
+            for (int k = 0; k < deferred.size(); ++k)
+            {
+                AssignOutside(deferred[k],0,faces.size());
+            }
+            continue;
+        }
+        if (AddPoint(eye)) ++vertexcount;
+        else
+        {
+            // a point failing on the retry too is within rounding of the faces around it and is left out
+            outside[eye] = -1;
+            if (!retrying) deferred.push(eye);
+        }
+    }
+    return true;
+}
+
+/*! \brief Merges coplanar triangles into polygons and writes the dxConvex arrays
+ */
+void dxConvexHullBuilder::Export(dReal *&planes, unsigned int &planecount, dReal *&hullpoints,
+                                 unsigned int &hullpointcount, unsigned int *&polygons) const
+{
+    const int facecount = faces.size();
+    // union-find over coplanar neighbours
+    dArray<int> group;
+    group.setSize(facecount);
+    for (int f = 0; f < facecount; ++f) group[f] = f;
+    for (int f = 0; f < facecount; ++f)
+    {
+        if (!faces[f].alive) continue;
+        for (int k = 0; k < 3; ++k)
+        {
+            const int nb = faces[f].neighbour[k];
+            // the vertex of each face opposite to the shared edge lies on the other's plane
+            if (dFabs(Distance(faces[f],faces[nb].v[0])) > epsilon ||
+                dFabs(Distance(faces[f],faces[nb].v[1])) > epsilon ||
+                dFabs(Distance(faces[f],faces[nb].v[2])) > epsilon ||
+                dFabs(Distance(faces[nb],faces[f].v[(k+2)%3])) > epsilon) continue;
+            int a = f, b = nb;
+            while (group[a] != a) a = group[a];
+            while (group[b] != b) b = group[b];
+            if (a != b) group[dMAX(a,b)] = dMIN(a,b);
+        }
+    }
+
+    // resolve the roots and chain the members of each group
+    dArray<int> member;
+    member.setSize(facecount);
+    for (int f = 0; f < facecount; ++f) member[f] = -1;
+    for (int f = facecount-1; f >= 0; --f)
+    {
+        int root = f;
+        while (group[root] != root) root = group[root];
+        group[f] = root;
+        if (faces[f].alive && root != f)
+        {
+            member[f] = member[root];
+            member[root] = f;
+        }
+    }
+
+    // polygons are the boundary loops of the groups
+    planecount = 0;
+    unsigned int polygonsize = 0;
+    for (int f = 0; f < facecount; ++f)
+    {
+        if (!faces[f].alive) continue;
+        if (group[f] == f) ++planecount;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (group[faces[f].neighbour[k]] != group[f]) ++polygonsize;
+        }
+    }
+    planes = new dReal[planecount*4];
+    polygons = new unsigned int[planecount+polygonsize];
+
+    // hull points are numbered as the polygons reach them, points inside
+    // merged polygons are left out
+    dArray<int> vertex, next;
+    vertex.setSize(pointcount);
+    next.setSize(pointcount);
+    for (unsigned int i = 0; i < pointcount; ++i) vertex[i] = -1;
+    hullpointcount = 0;
+    unsigned int plane = 0;
+    unsigned int *polygon = polygons;
+    for (int g = 0; g < facecount; ++g)
+    {
+        if (!faces[g].alive || group[g] != g) continue;
+        // area weighted normal and boundary edges of the group
+        dVector3 normal = { 0, 0, 0 };
+        int start = -1;
+        for (int f = g; f >= 0; f = member[f])
+        {
+            dVector3 e1,e2,c;
+            dSubtractVectors3(e1,Point(faces[f].v[1]),Point(faces[f].v[0]));
+            dSubtractVectors3(e2,Point(faces[f].v[2]),Point(faces[f].v[0]));
+            dCalcVectorCross3(c,e1,e2);
+            dAddVectors3(normal,normal,c);
+            for (int k = 0; k < 3; ++k)
+            {
+                if (group[faces[f].neighbour[k]] == g) continue;
+                next[faces[f].v[k]] = faces[f].v[(k+1)%3];
+                start = faces[f].v[k];
+            }
+        }
+        dNormalize3(normal);
+        // the loop starts before its sharpest corner, merged polygons may
+        // have runs of collinear points and the first three must make a turn
+        int previous = start;
+        while (next[previous] != start) previous = next[previous];
+        const int first = start;
+        dReal sharpest = -dInfinity;
+        int i = first;
+        do
+        {
+            dVector3 e1,e2,c;
+            dSubtractVectors3(e1,Point(i),Point(previous));
+            dSubtractVectors3(e2,Point(next[i]),Point(i));
+            dCalcVectorCross3(c,e1,e2);
+            const dReal turn = dCalcVectorDot3(c,normal);
+            if (turn > sharpest) { sharpest = turn; start = previous; }
+            previous = i;
+            i = next[i];
+        } while (i != first);
+        dReal d = -dInfinity;
+        unsigned int *count = polygon++;
+        *count = 0;
+        i = start;
+        do
+        {
+            if (vertex[i] < 0) vertex[i] = hullpointcount++;
+            *polygon++ = vertex[i];
+            ++*count;
+            d = dMAX(d,dCalcVectorDot3(normal,Point(i)));
+            i = next[i];
+        } while (i != start);
+        dCopyVector3(planes+(plane*4),normal);
+        planes[plane*4+3] = d;
+        ++plane;
+    }
+    hullpoints = new dReal[hullpointcount*3];
+    for (unsigned int i = 0; i < pointcount; ++i)
+    {
+        if (vertex[i] >= 0) dCopyVector3(hullpoints+(vertex[i]*3),Point(i));
+    }
+}
+
+static bool dBuildConvexHull(const dReal *points, unsigned int pointcount, unsigned int maxvertices,
+                             dReal *&hullplanes, unsigned int &planecount, dReal *&hullpoints,
+                             unsigned int &hullpointcount, unsigned int *&polygons)
+{
+    dxConvexHullBuilder builder(points,pointcount);
+    if (!builder.Build(maxvertices)) return false;
+    builder.Export(hullplanes,planecount,hullpoints,hullpointcount,polygons);
+    return true;
+}
+
+dGeomID dCreateConvexFromPoints (dSpaceID space, const dReal *_points,
+                                 unsigned int _pointcount, unsigned int maxvertices)
+{
+    dAASSERT (_points != NULL || _pointcount == 0);
+    dReal *planes, *points;
+    unsigned int planecount, pointcount, *polygons;
+    if (!dBuildConvexHull(_points,_pointcount,maxvertices,planes,planecount,points,pointcount,polygons))
+        return NULL;
+    dxConvex *s = new dxConvex(space,planes,planecount,points,pointcount,polygons);
+    s->hullPlanes = planes;
+    s->hullPoints = points;
+    s->hullPolygons = polygons;
+    return s;
+}
+
+int dGeomConvexFromPoints (dGeomID g, const dReal *_points,
+                           unsigned int _pointcount, unsigned int maxvertices)
+{
+    dUASSERT (g && g->type == dConvexClass,"argument not a convex shape");
+    dAASSERT (_points != NULL || _pointcount == 0);
+    dReal *planes, *points;
+    unsigned int planecount, pointcount, *polygons;
+    if (!dBuildConvexHull(_points,_pointcount,maxvertices,planes,planecount,points,pointcount,polygons))
+        return 0;
+    dGeomSetConvex(g,planes,planecount,points,pointcount,polygons);
+    dxConvex *s = (dxConvex*) g;
+    s->hullPlanes = planes;
+    s->hullPoints = points;
+    s->hullPolygons = polygons;
+    return 1;
 }
 
 //****************************************************************************
@@ -795,25 +1393,27 @@ int dCollideConvexCapsule (dxGeom *o1, dxGeom *o2,
     return 0;
 }
 
-inline void ComputeInterval(dxConvex& cvx,dVector4 axis,dReal& min,dReal& max)
+/*! \brief Projects a convex onto a direction given in its own space
+  \param ldir [IN] direction in convex space
+  \param offset [IN] added to the projections, to measure them from a plane
+  \param hints [IN/OUT] hill climbing start points for the min and max ends
+ */
+inline void ComputeLocalInterval(const dxConvex& cvx,const dVector3 ldir,dReal offset,
+                                 unsigned int hints[2],dReal& min,dReal& max)
 {
-    /* TODO: Use Support points here */
-    dVector3 point;
-    dReal value;
-    //fprintf(stdout,"Compute Interval Axis %f,%f,%f\n",axis[0],axis[1],axis[2]);
-    dMultiply0_331(point,cvx.final_posr->R,cvx.points);
-    //fprintf(stdout,"initial point %f,%f,%f\n",point[0],point[1],point[2]);
-    point[0]+=cvx.final_posr->pos[0];
-    point[1]+=cvx.final_posr->pos[1];
-    point[2]+=cvx.final_posr->pos[2];
-    max = min = dCalcVectorDot3(point,axis)-axis[3];//(*)
+    if (cvx.adjacencyStart != NULL)
+    {
+        // extreme points along the axis by hill climbing
+        dVector3 ndir;
+        dCopyNegatedVector3(ndir,ldir);
+        max = dCalcVectorDot3(cvx.points+(cvx.SupportIndexLocal(ldir,hints[1])*3),ldir)+offset;
+        min = -dCalcVectorDot3(cvx.points+(cvx.SupportIndexLocal(ndir,hints[0])*3),ndir)+offset;
+        return;
+    }
+    max = min = dCalcVectorDot3(cvx.points,ldir);
     for (unsigned int i = 1; i < cvx.pointcount; ++i)
     {
-        dMultiply0_331(point,cvx.final_posr->R,cvx.points+(i*3));
-        point[0]+=cvx.final_posr->pos[0];
-        point[1]+=cvx.final_posr->pos[1];
-        point[2]+=cvx.final_posr->pos[2];
-        value=dCalcVectorDot3(point,axis)-axis[3];//(*)
+        const dReal value=dCalcVectorDot3(cvx.points+(i*3),ldir);
         if(value<min)
         {
             min=value;
@@ -823,9 +1423,19 @@ inline void ComputeInterval(dxConvex& cvx,dVector4 axis,dReal& min,dReal& max)
             max=value;
         }
     }
-    // *: usually using the distance part of the plane (axis) is
+    min+=offset;
+    max+=offset;
+}
+
+inline void ComputeInterval(dxConvex& cvx,dVector4 axis,dReal& min,dReal& max)
+{
+    dVector3 ldir;
+    unsigned int hints[2] = { cvx.supportHint, cvx.supportHint };
+    dMultiply1_331(ldir,cvx.final_posr->R,axis);
+    // usually using the distance part of the plane (axis) is
     // not necesary, however, here we need it here in order to know
     // which face to pick when there are 2 parallel sides.
+    ComputeLocalInterval(cvx,ldir,dCalcVectorDot3(cvx.final_posr->pos,axis)-axis[3],hints,min,max);
 }
 
 bool CheckEdgeIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,int& curc,
@@ -909,6 +1519,9 @@ struct ConvexConvexSATOutput
     int depth_type;
     dVector3 dist; // distance from center to center, from cvx1 to cvx2
     dVector3 e1a,e1b,e2a,e2b; // e1a to e1b = edge in cvx1,e2a to e2b = edge in cvx2.
+    dVector3 axis; // separating axis found by a failed test
+    dVector3 normal; // outward normal of the minimum depth face
+    dxConvex *face_convex; // the convex owning that face
 };
 
 /*! \brief Does an axis separation test using cvx1 planes on cvx1 and cvx2, returns true for a collision false for no collision
@@ -924,21 +1537,32 @@ inline bool CheckSATConvexFaces(dxConvex& cvx1,
 {
     dReal min,max,min1,max1,min2,max2,depth;
     dVector4 plane;
+    dVector3 ldir1,ldir2;
+    // Neighbouring faces have nearby supports, each interval end climbs from the last one
+    unsigned int hints1[2] = { cvx1.supportHint, cvx1.supportHint };
+    unsigned int hints2[2] = { cvx2.supportHint, cvx2.supportHint };
     for(unsigned int i=0;i<cvx1.planecount;++i)
     {
+        dCopyVector3(ldir1,cvx1.planes+(i*4));
+        dNormalize3(ldir1);
         // -- Apply Transforms --
         // Rotate
-        dMultiply0_331(plane,cvx1.final_posr->R,cvx1.planes+(i*4));
-        dNormalize3(plane);
+        dMultiply0_331(plane,cvx1.final_posr->R,ldir1);
         // Translate
         plane[3]=
             (cvx1.planes[(i*4)+3])+
             ((plane[0] * cvx1.final_posr->pos[0]) +
             (plane[1] * cvx1.final_posr->pos[1])  +
             (plane[2] * cvx1.final_posr->pos[2]));
-        ComputeInterval(cvx1,plane,min1,max1);
-        ComputeInterval(cvx2,plane,min2,max2);
-        if(max2<min1 || max1<min2) return false;
+        // Project both convexes in their own space
+        dMultiply1_331(ldir2,cvx2.final_posr->R,plane);
+        ComputeLocalInterval(cvx1,ldir1,-cvx1.planes[(i*4)+3],hints1,min1,max1);
+        ComputeLocalInterval(cvx2,ldir2,dCalcVectorDot3(cvx2.final_posr->pos,plane)-plane[3],hints2,min2,max2);
+        if(max2<min1 || max1<min2)
+        {
+            dVector3Copy(plane,ccso.axis);
+            return false;
+        }
         min = dMAX(min1, min2);
         max = dMIN(max1, max2);
         depth = max-min;
@@ -954,86 +1578,112 @@ inline bool CheckSATConvexFaces(dxConvex& cvx1,
             // plus the integrator seems to like positive depths better than negative ones
             ccso.min_depth=-depth;
             ccso.depth_type = 1; // 1 = face-something
+            dVector3Copy(plane,ccso.normal);
+            ccso.face_convex = &cvx1;
         }
     }
     return true;
 }
 /*! \brief Does an axis separation test using cvx1 and cvx2 edges, returns true for a collision false for no collision
+
+  Only the edge pairs whose arcs cross on the Gauss maps of cvx1 and -cvx2 build a
+  face of the Minkowski difference, the cross products of the other pairs can neither
+  separate the convexes nor give the minimum depth, so they are pruned with a few dot
+  products before any support query.
   \param cvx1 [IN] First Convex object
   \param cvx2 [IN] Second Convex object
-  \param min_depth [IN/OUT] Used to input as well as output the minimum depth so far, must be set to a huge value such as dInfinity for initialization.
-  \param g1 [OUT] Pointer to the convex which should be used in the returned contact as g1
-  \param g2 [OUT] Pointer to the convex which should be used in the returned contact as g2
+  \param ccso [IN/OUT] Minimum depth and edges so far, the separating axis on return false
  */
 inline bool CheckSATConvexEdges(dxConvex& cvx1,
                                 dxConvex& cvx2,
                                 ConvexConvexSATOutput& ccso)
 {
-    // Test cross products of pairs of edges
-    dReal depth,min,max,min1,max1,min2,max2;
-    dVector4 plane;
-    dVector3 e1,e2,e1a,e1b,e2a,e2b;
-    dVector3 dist;
-    dVector3Copy(ccso.dist,dist);
-    unsigned int s1 = cvx1.SupportIndex(dist);
-    // invert direction
-    dVector3Inv(dist);
-    unsigned int s2 = cvx2.SupportIndex(dist);
-    for(unsigned int i = 0;i<cvx1.edgecount;++i)
+    // Everything is done in cvx2 space, cvx1 is brought in with R and center
+    dMatrix3 R;
+    dVector3 center,tmp;
+    dMultiply1_333(R,cvx2.final_posr->R,cvx1.final_posr->R);
+    dSubtractVectors3(tmp,cvx1.final_posr->pos,cvx2.final_posr->pos);
+    dMultiply1_331(center,cvx2.final_posr->R,tmp);
+    dVector3 a,b,bxa,e1a,e1b,e1,e2,dxc,axis,pb;
+    dReal depth;
+    // Side of each cvx2 plane normal to the great circle of the current cvx1 arc
+    dReal sideBuffer[64];
+    dReal *side = (cvx2.planecount<=64) ? sideBuffer : new dReal[cvx2.planecount];
+    bool separated = false;
+    for(unsigned int i = 0;i<cvx1.edgecount && !separated;++i)
     {
-        // Skip edge if it doesn't contain the extremal vertex
-        if((cvx1.edges[i].first!=s1)&&(cvx1.edges[i].second!=s1)) continue;
-        // we only need to apply rotation here
-        dMultiply0_331(e1a,cvx1.final_posr->R,cvx1.points+(cvx1.edges[i].first*3));
-        dMultiply0_331(e1b,cvx1.final_posr->R,cvx1.points+(cvx1.edges[i].second*3));
-        e1[0]=e1b[0]-e1a[0];
-        e1[1]=e1b[1]-e1a[1];
-        e1[2]=e1b[2]-e1a[2];
+        const dxConvex::edge& edge1 = cvx1.edges[i];
+        // arc of the edge on the Gauss map of cvx1
+        dMultiply0_331(a,R,cvx1.planes+(edge1.firstFace*4));
+        dMultiply0_331(b,R,cvx1.planes+(edge1.secondFace*4));
+        dCalcVectorCross3(bxa,b,a);
+        for(unsigned int j = 0;j<cvx2.planecount;++j)
+        {
+            side[j] = dCalcVectorDot3(cvx2.planes+(j*4),bxa);
+        }
+        bool transformed = false;
         for(unsigned int j = 0;j<cvx2.edgecount;++j)
         {
-            // Skip edge if it doesn't contain the extremal vertex
-            if((cvx2.edges[j].first!=s2)&&(cvx2.edges[j].second!=s2)) continue;
-            // we only need to apply rotation here
-            dMultiply0_331 (e2a,cvx2.final_posr->R,cvx2.points+(cvx2.edges[j].first*3));
-            dMultiply0_331 (e2b,cvx2.final_posr->R,cvx2.points+(cvx2.edges[j].second*3));
-            e2[0]=e2b[0]-e2a[0];
-            e2[1]=e2b[1]-e2a[1];
-            e2[2]=e2b[2]-e2a[2];
-            dCalcVectorCross3(plane,e1,e2);
-            if(dCalcVectorDot3(plane,plane)<dEpsilon) /* edges are parallel */ continue;
-            dNormalize3(plane);
-            plane[3]=0;
-            ComputeInterval(cvx1,plane,min1,max1);
-            ComputeInterval(cvx2,plane,min2,max2);
-            if(max2 < min1 || max1 < min2) return false;
-            min = dMAX(min1, min2);
-            max = dMIN(max1, max2);
-            depth = max-min;
+            const dxConvex::edge& edge2 = cvx2.edges[j];
+            // arc of the edge on the Gauss map of -cvx2, its end points c and d are
+            // the negated plane normals; the signs below already account for that
+            const dReal cba = -side[edge2.firstFace];
+            const dReal dba = -side[edge2.secondFace];
+            if(cba*dba >= 0) continue;
+            const dReal *nc = cvx2.planes+(edge2.firstFace*4);
+            const dReal *nd = cvx2.planes+(edge2.secondFace*4);
+            dCalcVectorCross3(dxc,nd,nc);
+            const dReal adc = dCalcVectorDot3(a,dxc);
+            const dReal bdc = dCalcVectorDot3(b,dxc);
+            if(adc*bdc >= 0 || cba*bdc <= 0) continue;
+            // The arcs cross, test the edge cross product
+            if(!transformed)
+            {
+                dVector3 p;
+                dMultiply0_331(p,R,cvx1.points+(edge1.first*3));
+                dAddVectors3(e1a,p,center);
+                dMultiply0_331(p,R,cvx1.points+(edge1.second*3));
+                dAddVectors3(e1b,p,center);
+                dSubtractVectors3(e1,e1b,e1a);
+                transformed = true;
+            }
+            const dReal *e2a = cvx2.points+(edge2.first*3);
+            const dReal *e2b = cvx2.points+(edge2.second*3);
+            dSubtractVectors3(e2,e2b,e2a);
+            dCalcVectorCross3(axis,e1,e2);
+            const dReal length = dCalcVectorLengthSquare3(axis);
+            if(length<dEpsilon*dCalcVectorLengthSquare3(e1)*dCalcVectorLengthSquare3(e2)) /* edges are parallel */ continue;
+            dScaleVector3(axis,dRecipSqrt(length));
+            // point the axis away from cvx1
+            dSubtractVectors3(tmp,e1a,center);
+            if(dCalcVectorDot3(axis,tmp)<0) dNegateVector3(axis);
+            // Both edges are on the support planes of the axis
+            dSubtractVectors3(pb,e2a,e1a);
+            depth = -dCalcVectorDot3(axis,pb);
+            if(depth<0)
+            {
+                dMultiply0_331(ccso.axis,cvx2.final_posr->R,axis);
+                separated = true;
+                break;
+            }
             if (((dFabs(depth)+dEpsilon)<dFabs(ccso.min_depth)))
             {
                 ccso.min_depth=depth;
                 ccso.depth_type = 2; // 2 means edge-edge
-                // use cached values, add position
-                dVector3Copy(e1a,ccso.e1a);
-                dVector3Copy(e1b,ccso.e1b);
-                ccso.e1a[0]+=cvx1.final_posr->pos[0];
-                ccso.e1a[1]+=cvx1.final_posr->pos[1];
-                ccso.e1a[2]+=cvx1.final_posr->pos[2];
-                ccso.e1b[0]+=cvx1.final_posr->pos[0];
-                ccso.e1b[1]+=cvx1.final_posr->pos[1];
-                ccso.e1b[2]+=cvx1.final_posr->pos[2];
-                dVector3Copy(e2a,ccso.e2a);
-                dVector3Copy(e2b,ccso.e2b);
-                ccso.e2a[0]+=cvx2.final_posr->pos[0];
-                ccso.e2a[1]+=cvx2.final_posr->pos[1];
-                ccso.e2a[2]+=cvx2.final_posr->pos[2];
-                ccso.e2b[0]+=cvx2.final_posr->pos[0];
-                ccso.e2b[1]+=cvx2.final_posr->pos[1];
-                ccso.e2b[2]+=cvx2.final_posr->pos[2];
+                // bring the edges to world space
+                dMultiply0_331(ccso.e1a,cvx2.final_posr->R,e1a);
+                dAddVectors3(ccso.e1a,ccso.e1a,cvx2.final_posr->pos);
+                dMultiply0_331(ccso.e1b,cvx2.final_posr->R,e1b);
+                dAddVectors3(ccso.e1b,ccso.e1b,cvx2.final_posr->pos);
+                dMultiply0_331(ccso.e2a,cvx2.final_posr->R,e2a);
+                dAddVectors3(ccso.e2a,ccso.e2a,cvx2.final_posr->pos);
+                dMultiply0_331(ccso.e2b,cvx2.final_posr->R,e2b);
+                dAddVectors3(ccso.e2b,ccso.e2b,cvx2.final_posr->pos);
             }
         }
     }
-    return true;
+    if(side!=sideBuffer) delete[] side;
+    return !separated;
 }
 
 #if 0
@@ -1108,19 +1758,24 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
     dIASSERT(maxc != 0);
     dVector3 i1,i2,r1,r2; // edges of incident and reference faces respectively
     int contacts=0;
-    if(!CheckSATConvexFaces(cvx1,cvx2,ccso))
+    // Pairs which stay apart are rejected with the axis that separated them last time
+    dVector4 axis;
+    if(cvx1.sepAxisCache.find(&cvx2,axis))
     {
+        dReal min1,max1,min2,max2;
+        axis[3]=0;
+        ComputeInterval(cvx1,axis,min1,max1);
+        ComputeInterval(cvx2,axis,min2,max2);
+        if(max2<min1 || max1<min2) return 0;
+    }
+    if(!CheckSATConvexFaces(cvx1,cvx2,ccso) ||
+       !CheckSATConvexFaces(cvx2,cvx1,ccso) ||
+       !CheckSATConvexEdges(cvx1,cvx2,ccso))
+    {
+        cvx1.sepAxisCache.store(&cvx2,ccso.axis);
         return 0;
     }
-    else
-        if(!CheckSATConvexFaces(cvx2,cvx1,ccso))
-        {
-            return 0;
-        }
-        else if(!CheckSATConvexEdges(cvx1,cvx2,ccso))
-        {
-            return 0;
-        }
+    cvx1.sepAxisCache.remove(&cvx2);
         // If we get here, there was a collision
         if(ccso.depth_type==1) // face-face
         {
@@ -1166,6 +1821,19 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
                 pIncidentPoly+=pIncidentPoly[0]+1;
             }
             pIncidentPoints = pIncidentPoly+1;
+            // Reduced manifolds are clipped into a buffer which takes every clipped
+            // point (edge crossings, incident and reference points), so they are
+            // reduced before being truncated to the caller's contact count
+            dContactGeom *clip = contact;
+            int clipSkip = skip;
+            int clipMax = maxc;
+            if(flags & CONTACTS_REDUCED)
+            {
+                clipMax = pIncidentPoly[0]*(cvx1.planecount+1)+cvx1.pointcount;
+                clip = (dContactGeom *)dALLOCA16(clipMax*sizeof(dContactGeom));
+                clipSkip = sizeof(dContactGeom);
+            }
+            const int clipFlags = (flags & ~NUMC_MASK) | clipMax;
             // Get the first point of the incident face
             dMultiply0_331(i2,cvx2.final_posr->R,&cvx2.points[(pIncidentPoints[0]*3)]);
             dVector3Add(i2,cvx2.final_posr->pos,i2);
@@ -1242,13 +1910,13 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
                                 rplane[3];
                             if(d>0)
                             {
-                                dVector3Copy(p,SAFECONTACT(flags, contact, contacts, skip)->pos);
-                                dVector3Copy(rplane,SAFECONTACT(flags, contact, contacts, skip)->normal);
-                                SAFECONTACT(flags, contact, contacts, skip)->g1=&cvx1;
-                                SAFECONTACT(flags, contact, contacts, skip)->g2=&cvx2;
-                                SAFECONTACT(flags, contact, contacts, skip)->depth=d;
+                                dVector3Copy(p,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->pos);
+                                dVector3Copy(rplane,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->normal);
+                                SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g1=&cvx1;
+                                SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g2=&cvx2;
+                                SAFECONTACT(clipFlags, clip, contacts, clipSkip)->depth=d;
                                 ++contacts;
-                                if (contacts==maxc) return contacts;
+                                if (contacts==clipMax) return contacts;
                             }
                         }
                     }
@@ -1264,13 +1932,13 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
                     rplane[3];
                 if(d>0)
                 {
-                    dVector3Copy(i1,SAFECONTACT(flags, contact, contacts, skip)->pos);
-                    dVector3Copy(rplane,SAFECONTACT(flags, contact, contacts, skip)->normal);
-                    SAFECONTACT(flags, contact, contacts, skip)->g1=&cvx1;
-                    SAFECONTACT(flags, contact, contacts, skip)->g2=&cvx2;
-                    SAFECONTACT(flags, contact, contacts, skip)->depth=d;
+                    dVector3Copy(i1,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->pos);
+                    dVector3Copy(rplane,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->normal);
+                    SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g1=&cvx1;
+                    SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g2=&cvx2;
+                    SAFECONTACT(clipFlags, clip, contacts, clipSkip)->depth=d;
                     ++contacts;
-                    if (contacts==maxc) return contacts;
+                    if (contacts==clipMax) return contacts;
                 }
             }
             // IF we get here, we got the easiest contacts to calculate,
@@ -1328,9 +1996,9 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
                     outside = false;
                     for(int j=0;j<contacts;++j)
                     {
-                        if((SAFECONTACT(flags, contact, j, skip)->pos[0]==i1[0])&&
-                            (SAFECONTACT(flags, contact, j, skip)->pos[1]==i1[1])&&
-                            (SAFECONTACT(flags, contact, j, skip)->pos[2]==i1[2]))
+                        if((SAFECONTACT(clipFlags, clip, j, clipSkip)->pos[0]==i1[0])&&
+                            (SAFECONTACT(clipFlags, clip, j, clipSkip)->pos[1]==i1[1])&&
+                            (SAFECONTACT(clipFlags, clip, j, clipSkip)->pos[2]==i1[2]))
                         {
                             outside=true;
                         }
@@ -1343,17 +2011,45 @@ int TestConvexIntersection(dxConvex& cvx1,dxConvex& cvx2, int flags,
                             rplane[3];
                         if(d>0)
                         {
-                            dVector3Copy(i1,SAFECONTACT(flags, contact, contacts, skip)->pos);
-                            dVector3Copy(rplane,SAFECONTACT(flags, contact, contacts, skip)->normal);
-                            SAFECONTACT(flags, contact, contacts, skip)->g1=&cvx1;
-                            SAFECONTACT(flags, contact, contacts, skip)->g2=&cvx2;
-                            SAFECONTACT(flags, contact, contacts, skip)->depth=d;
+                            dVector3Copy(i1,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->pos);
+                            dVector3Copy(rplane,SAFECONTACT(clipFlags, clip, contacts, clipSkip)->normal);
+                            SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g1=&cvx1;
+                            SAFECONTACT(clipFlags, clip, contacts, clipSkip)->g2=&cvx2;
+                            SAFECONTACT(clipFlags, clip, contacts, clipSkip)->depth=d;
                             ++contacts;
-                            if (contacts==maxc) return contacts;
+                            if (contacts==clipMax) return contacts;
                         }
                     }
                 }
             }
+            if(clip!=contact)
+            {
+                // reduce the whole manifold, then keep as many as requested
+                contacts = dReduceContactManifolds(clip,contacts,clipSkip);
+                if(contacts>maxc) contacts=maxc;
+                for(int j=0;j<contacts;++j)
+                {
+                    *SAFECONTACT(flags, contact, j, skip) = *SAFECONTACT(clipFlags, clip, j, clipSkip);
+                }
+            }
+            if(contacts==0)
+            {
+                // Clipping against the faces facing the other center missed, fall back
+                // to the deepest point along the minimum depth face normal
+                dContactGeom *target = SAFECONTACT(flags, contact, 0, skip);
+                dxConvex& other = (ccso.face_convex==&cvx1) ? cvx2 : cvx1;
+                dVector3Copy(ccso.normal,dist);
+                dVector3Inv(dist);
+                dMultiply0_331(p,other.final_posr->R,other.points+(other.SupportIndex(dist)*3));
+                dAddVectors3(target->pos,p,other.final_posr->pos);
+                // the normal points into cvx1
+                dVector3Copy(ccso.normal,target->normal);
+                if(ccso.face_convex==&cvx1) dVector3Inv(target->normal);
+                target->depth = dFabs(ccso.min_depth);
+                target->g1=&cvx1;
+                target->g2=&cvx2;
+                contacts = 1;
+            }
         }
         else if(ccso.depth_type==2) // edge-edge
         {
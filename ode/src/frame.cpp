@@ -0,0 +1,347 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+// Collision stage of the world frame stepping (dWorldStepFrame/dWorldQuickStepFrame)
+
+#include <ode/ode.h>
+#include "config.h"
+#include "objects.h"
+#include "array.h"
+#include "frame.h"
+#include "util.h"
+#include "profile.h"
+#include "threadingutils.h"
+
+#include <algorithm>
+
+
+#define dxFRAME_NARROWPHASE_PAIRS_STEP 8U
+
+
+struct dxFrameCollisionPair
+{
+    dxFrameCollisionPair(dxGeom *geom1, dxGeom *geom2, bool serial): m_geom1(geom1), m_geom2(geom2), m_contactCount(0), m_serial(serial) {}
+
+    dxGeom          *m_geom1;
+    dxGeom          *m_geom2;
+    unsigned        m_contactCount;
+    bool            m_serial; // The pair must not be tested concurrently with other serial pairs
+};
+
+typedef dArray<dxFrameCollisionPair> dxFrameCollisionPairArray;
+
+
+struct dxFrameCollisionCallContext
+{
+    dxFrameCollisionCallContext(const dWorldFrameParameters *parameters, dxStepProfile *profile, 
+        dxFrameCollisionPair *pairs, unsigned pairCount, dContact *contacts):
+        m_parameters(parameters), m_profile(profile), m_pairs(pairs), m_pairCount(pairCount), m_contacts(contacts),
+        m_pairStepCount((pairCount + (dxFRAME_NARROWPHASE_PAIRS_STEP - 1)) / dxFRAME_NARROWPHASE_PAIRS_STEP), 
+        m_pairStepIndex(0), m_serialPairCount(0), m_serialPairsClaim(0)
+    {
+        for (unsigned pairIndex = 0; pairIndex != pairCount; ++pairIndex) {
+            m_serialPairCount += pairs[pairIndex].m_serial;
+        }
+    }
+
+    static int ThreadedNarrowphaseGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+    static int ThreadedNarrowphase_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+    void ThreadedNarrowphase();
+
+    void CollideSerialPairs();
+    void CollidePair(dxFrameCollisionPair *pair, dContact *pairContacts) const;
+
+    const dWorldFrameParameters     *m_parameters;
+    dxStepProfile                   *m_profile;
+    dxFrameCollisionPair            *m_pairs;
+    unsigned                        m_pairCount;
+    dContact                        *m_contacts;
+    unsigned                        m_pairStepCount;
+    volatile atomicord32            m_pairStepIndex;
+    unsigned                        m_serialPairCount;
+    volatile atomicord32            m_serialPairsClaim;
+};
+
+
+static bool IsBodyEnabledForFrame(dxBody *body)
+{
+    return body != NULL && dBodyIsEnabled(body);
+}
+
+// Heightfield colliders keep their scratch buffers in the geom data and invoke 
+// the user height callbacks, and user classes are not known to be reentrant.
+// Without TLS all the trimesh colliders share a single global colliders cache.
+// The pairs with such geoms are all tested by a single thread.
+static bool IsGeomCollisionReentrant(dxGeom *geom)
+{
+    const int geomClass = dGeomGetClass(geom);
+    return geomClass != dHeightfieldClass && geomClass < dFirstUserClass
+#if !dTLS_ENABLED
+        && geomClass != dTriMeshClass
+#endif
+        ;
+}
+
+static void RecordCollisionPair(void *data, dGeomID o1, dGeomID o2)
+{
+    if (dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+        // Geoms inside of the spaces are tested against each other by CollectSpaceCollisionPairs()
+        dSpaceCollide2(o1, o2, data, &RecordCollisionPair);
+        return;
+    }
+
+    dxBody *b1 = dGeomGetBody(o1), *b2 = dGeomGetBody(o2);
+    if (!IsBodyEnabledForFrame(b1) && !IsBodyEnabledForFrame(b2)) {
+        return;
+    }
+
+    if (b1 != NULL && b2 != NULL && dAreConnectedExcluding(b1, b2, dJointTypeContact)) {
+        return;
+    }
+
+    dxFrameCollisionPairArray *pairs = (dxFrameCollisionPairArray *)data;
+    pairs->push(dxFrameCollisionPair(o1, o2, !IsGeomCollisionReentrant(o1) || !IsGeomCollisionReentrant(o2)));
+}
+
+static void CollectSpaceCollisionPairs(dxSpace *space, dxFrameCollisionPairArray *pairs)
+{
+    dSpaceCollide(space, pairs, &RecordCollisionPair);
+
+    const int geomCount = dSpaceGetNumGeoms(space);
+    for (int geomIndex = 0; geomIndex != geomCount; ++geomIndex) {
+        dxGeom *geom = dSpaceGetGeom(space, geomIndex);
+
+        if (dGeomIsSpace(geom) && dGeomIsEnabled(geom)) {
+            CollectSpaceCollisionPairs((dxSpace *)geom, pairs);
+        }
+    }
+}
+
+
+int dxFrameCollisionCallContext::ThreadedNarrowphaseGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callContext; // unused
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    // The group call only serves as a completion point for the narrowphase jobs
+    return 1;
+}
+
+int dxFrameCollisionCallContext::ThreadedNarrowphase_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    static_cast<dxFrameCollisionCallContext *>(callContext)->ThreadedNarrowphase();
+    return 1;
+}
+
+void dxFrameCollisionCallContext::ThreadedNarrowphase()
+{
+    dxStepProfileScope profileScope(m_profile, dSTEPPROFILE_EVENT_STAGE, "World Frame Narrowphase Pairs");
+
+    const unsigned pairCount = m_pairCount;
+    const unsigned pairStepCount = m_pairStepCount;
+    const unsigned maxContacts = m_parameters->max_contacts;
+
+    // The first thread to get here takes the serial pairs on before sharing the rest with the others
+    if (m_serialPairCount != 0 && ThrsafeIncrementIntUpToLimit(&m_serialPairsClaim, 1) == 0) {
+        CollideSerialPairs();
+    }
+
+    unsigned pairStep;
+    while ((pairStep = ThrsafeIncrementIntUpToLimit(&m_pairStepIndex, pairStepCount)) != pairStepCount) {
+        unsigned pairIndex = pairStep * dxFRAME_NARROWPHASE_PAIRS_STEP;
+        const unsigned pairEnd = std::min(pairIndex + dxFRAME_NARROWPHASE_PAIRS_STEP, pairCount);
+
+        for (; pairIndex != pairEnd; ++pairIndex) {
+            dxFrameCollisionPair *pair = m_pairs + pairIndex;
+
+            if (!pair->m_serial) {
+                CollidePair(pair, m_contacts + (size_t)pairIndex * maxContacts);
+            }
+        }
+    }
+}
+
+void dxFrameCollisionCallContext::CollideSerialPairs()
+{
+    dxStepProfileScope profileScope(m_profile, dSTEPPROFILE_EVENT_STAGE, "World Frame Narrowphase Serial Pairs");
+
+    const unsigned pairCount = m_pairCount;
+    const unsigned maxContacts = m_parameters->max_contacts;
+
+    for (unsigned pairIndex = 0; pairIndex != pairCount; ++pairIndex) {
+        dxFrameCollisionPair *pair = m_pairs + pairIndex;
+
+        if (pair->m_serial) {
+            CollidePair(pair, m_contacts + (size_t)pairIndex * maxContacts);
+        }
+    }
+}
+
+void dxFrameCollisionCallContext::CollidePair(dxFrameCollisionPair *pair, dContact *pairContacts) const
+{
+    const dWorldFrameParameters *parameters = m_parameters;
+
+    int contactCount = dCollide(pair->m_geom1, pair->m_geom2, parameters->max_contacts, &pairContacts[0].geom, sizeof(dContact));
+
+    for (int contactIndex = 0; contactIndex != contactCount; ++contactIndex) {
+        dContact *contact = pairContacts + contactIndex;
+        contact->surface = parameters->surface;
+        dSetZero(contact->fdir1, 4);
+    }
+
+    if (contactCount != 0 && parameters->contact_callback != NULL) {
+        int keptCount = parameters->contact_callback(parameters->callback_data, pair->m_geom1, pair->m_geom2, pairContacts, contactCount);
+        dUASSERT(keptCount >= 0 && keptCount <= contactCount, "Invalid contact count returned from frame contact callback");
+
+        contactCount = std::max(0, std::min(keptCount, contactCount));
+    }
+
+    pair->m_contactCount = contactCount;
+}
+
+
+static bool RunFrameNarrowphase(dxWorld *world, dxFrameCollisionCallContext *callContext)
+{
+    bool result = false;
+
+    do {
+        dxStepWorkingMemory *wmem = AllocateOnDemand(world->wmem);
+        if (wmem == NULL) {
+            break;
+        }
+
+        dxWorldProcessContext *context = wmem->SureGetWorldProcessingContext();
+        if (context == NULL || !context->EnsureStepperSyncObjectsAreAllocated(world)) {
+            break;
+        }
+
+        unsigned allowedThreadCount = world->GetThreadingIslandsMaxThreadsCount();
+        dIASSERT(allowedThreadCount != 0);
+
+        const unsigned jobCount = std::max(std::min(allowedThreadCount, callContext->m_pairStepCount), 1U);
+        if (!world->PreallocateResourcesForThreadedCalls(1 + jobCount)) {
+            break;
+        }
+
+        // The islands stepping wait is free between the steps and is borrowed for the narrowphase
+        dCallWaitID pcwGroupCallWait = context->GetIslandsSteppingWait();
+
+        dxStepProfile *profile = world->step_profile;
+        const double profileStart = profile != NULL ? profile->GetCurrentTime() : 0.0;
+
+        int summaryFault = 0;
+
+        dCallReleaseeID groupReleasee;
+        world->PostThreadedCall(&summaryFault, &groupReleasee, jobCount, NULL, pcwGroupCallWait, 
+            &dxFrameCollisionCallContext::ThreadedNarrowphaseGroup_Callback, (void *)callContext, 0, "World Frame Narrowphase Group");
+
+        world->PostThreadedCallsGroup(NULL, jobCount, groupReleasee, 
+            &dxFrameCollisionCallContext::ThreadedNarrowphase_Callback, (void *)callContext, "World Frame Narrowphase");
+
+        world->WaitThreadedCallExclusively(NULL, pcwGroupCallWait, NULL, "World Frame Narrowphase Wait");
+
+        if (profile != NULL) {
+            profile->RecordThreadedPhase("World Frame Narrowphase", profileStart, profile->GetCurrentTime());
+        }
+
+        if (summaryFault != 0) {
+            break;
+        }
+
+        result = true;
+    }
+    while (false);
+
+    return result;
+}
+
+static void CreateFrameContactJoints(dxWorld *world, const dWorldFrameParameters *parameters, 
+    const dxFrameCollisionPair *pairs, unsigned pairCount, dContact *contacts)
+{
+    dxStepProfileScope profileScope(world->step_profile, dSTEPPROFILE_EVENT_WORLD, "World Frame Contact Joints");
+
+    const unsigned maxContacts = parameters->max_contacts;
+    dJointGroupID contactGroup = parameters->contact_group;
+
+    // The joints are created in the order of pairs to keep the result independent of thread scheduling
+    for (unsigned pairIndex = 0; pairIndex != pairCount; ++pairIndex) {
+        const dxFrameCollisionPair *pair = pairs + pairIndex;
+        const unsigned contactCount = pair->m_contactCount;
+
+        if (contactCount != 0) {
+            dxBody *b1 = dGeomGetBody(pair->m_geom1), *b2 = dGeomGetBody(pair->m_geom2);
+            dContact *pairContacts = contacts + (size_t)pairIndex * maxContacts;
+
+            for (unsigned contactIndex = 0; contactIndex != contactCount; ++contactIndex) {
+                dJointID joint = dJointCreateContact(world, contactGroup, pairContacts + contactIndex);
+                dJointAttach(joint, b1, b2);
+            }
+        }
+    }
+}
+
+// Collides the space and creates contact joints for the frame.
+// Pair testing is distributed among the threads of the world's threading implementation.
+bool dxCollideWorldFrame(dxWorld *world, dxSpace *space, const dWorldFrameParameters *parameters)
+{
+    bool result = false;
+
+    dxFrameCollisionPairArray pairs;
+    {
+        dxStepProfileScope profileScope(world->step_profile, dSTEPPROFILE_EVENT_WORLD, "World Frame Broadphase");
+        CollectSpaceCollisionPairs(space, &pairs);
+    }
+
+    const unsigned pairCount = pairs.size();
+    const size_t contactsSize = (size_t)pairCount * parameters->max_contacts * sizeof(dContact);
+    dContact *contacts = pairCount != 0 ? (dContact *)dAlloc(contactsSize) : NULL;
+
+    do {
+        if (pairCount == 0) {
+            result = true;
+            break;
+        }
+
+        if (contacts == NULL) {
+            break;
+        }
+
+        dxFrameCollisionCallContext callContext(parameters, world->step_profile, pairs.data(), pairCount, contacts);
+
+        if (!RunFrameNarrowphase(world, &callContext)) {
+            break;
+        }
+
+        CreateFrameContactJoints(world, parameters, pairs.data(), pairCount, contacts);
+
+        result = true;
+    }
+    while (false);
+
+    if (contacts != NULL) {
+        dFree(contacts, contactsSize);
+    }
+
+    return result;
+}
@@ -38,6 +38,7 @@
 #include "collision_std.h"
 #include "collision_util.h"
 #include "heightfield.h"
+#include "util.h"
 
 
 
@@ -121,7 +122,18 @@ dxHeightfieldData::dxHeightfieldData():
     m_pHeightData( NULL ),
     m_pUserData( NULL ),
 
-    m_pGetHeightCallback( NULL )
+    m_pGetHeightCallback( NULL ),
+    m_pGetHeightBlockCallback( NULL ),
+
+    m_pGetTileCallback( NULL ),
+    m_pReleaseTileCallback( NULL ),
+    m_pTiles( NULL ),
+    m_nTileSize( 0 ),
+    m_nTilesX( 0 ),
+    m_nTilesZ( 0 ),
+
+    m_pBoundsPyramid( NULL ),
+    m_nBoundsLevels( 0 )
 {
     memset( m_contacts, 0, sizeof( m_contacts ) );
 }
@@ -166,6 +178,10 @@ void dxHeightfieldData::SetData( int nWidthSamples, int nDepthSamples,
 
     // finite or repeated terrain?
     m_bWrapMode = bWrapMode;
+
+    // bounds and tiles of any previous data are no longer valid
+    FreeBoundsPyramid();
+    FreeTiles();
 }
 
 
@@ -257,6 +273,265 @@ void dxHeightfieldData::ComputeHeightBounds()
 
     // add thickness
     m_fMinHeight -= m_fThickness;
+
+    // local bounds for zone culling
+    BuildBoundsPyramid();
+}
+
+
+// returns raw (unscaled) sample value, sample coordinates must be in range
+dReal dxHeightfieldData::GetSampleValue( int x, int z ) const
+{
+    const int i = x + ( z * m_nWidthSamples );
+
+    switch ( m_nGetHeightMode )
+    {
+    case 1:     return ((const unsigned char*)m_pHeightData)[i];
+    case 2:     return ((const short*)m_pHeightData)[i];
+    case 3:     return ((const float*)m_pHeightData)[i];
+    case 4:     return (dReal)( ((const double*)m_pHeightData)[i] );
+    }
+
+    dIASSERT( 0 );
+    return 0;
+}
+
+
+// builds min/max pyramid of raw sample values over cell tiles
+void dxHeightfieldData::BuildBoundsPyramid()
+{
+    FreeBoundsPyramid();
+
+    // callback data is not known in advance, tiles keep bounds of their own
+    if ( m_nGetHeightMode == 0 || m_nGetHeightMode == 5 )
+        return;
+
+    const int nCellsX = m_nWidthSamples - 1;
+    const int nCellsZ = m_nDepthSamples - 1;
+    const int nTileSize = 1 << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+
+    int nWidth = ( nCellsX + nTileSize - 1 ) >> HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+    int nDepth = ( nCellsZ + nTileSize - 1 ) >> HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+    int nNodes = 0;
+    int nLevels = 0;
+
+    for ( ; ; )
+    {
+        dIASSERT( nLevels < HEIGHTFIELD_BOUNDS_MAX_LEVELS );
+        m_anBoundsLevelWidth[ nLevels ] = nWidth;
+        m_anBoundsLevelDepth[ nLevels ] = nDepth;
+        m_anBoundsLevelOffset[ nLevels ] = nNodes;
+        nNodes += nWidth * nDepth;
+        ++nLevels;
+
+        if ( nWidth == 1 && nDepth == 1 )
+            break;
+
+        nWidth = ( nWidth + 1 ) >> 1;
+        nDepth = ( nDepth + 1 ) >> 1;
+    }
+
+    dReal *pNodes = new dReal[ 2 * nNodes ];
+
+    // level 0: every tile covers the samples of all its cells, borders included
+    dReal *pNode = pNodes;
+    for ( int tz = 0; tz != m_anBoundsLevelDepth[ 0 ]; ++tz )
+    {
+        const int z0 = tz << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+        const int z1 = dMIN( z0 + nTileSize, nCellsZ );
+
+        for ( int tx = 0; tx != m_anBoundsLevelWidth[ 0 ]; ++tx, pNode += 2 )
+        {
+            const int x0 = tx << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+            const int x1 = dMIN( x0 + nTileSize, nCellsX );
+
+            dReal fMin = dInfinity, fMax = -dInfinity;
+            for ( int z = z0; z <= z1; ++z )
+            {
+                for ( int x = x0; x <= x1; ++x )
+                {
+                    const dReal h = GetSampleValue( x, z );
+                    if ( h < fMin ) fMin = h;
+                    if ( h > fMax ) fMax = h;
+                }
+            }
+
+            pNode[ 0 ] = fMin;
+            pNode[ 1 ] = fMax;
+        }
+    }
+
+    // upper levels: merge up to 2x2 nodes of the level below
+    for ( int nLevel = 1; nLevel != nLevels; ++nLevel )
+    {
+        const int nChildWidth = m_anBoundsLevelWidth[ nLevel - 1 ];
+        const int nChildDepth = m_anBoundsLevelDepth[ nLevel - 1 ];
+        const dReal *pChildren = pNodes + 2 * m_anBoundsLevelOffset[ nLevel - 1 ];
+
+        for ( int nz = 0; nz != m_anBoundsLevelDepth[ nLevel ]; ++nz )
+        {
+            for ( int nx = 0; nx != m_anBoundsLevelWidth[ nLevel ]; ++nx, pNode += 2 )
+            {
+                dReal fMin = dInfinity, fMax = -dInfinity;
+                for ( int cz = nz * 2; cz != dMIN( nz * 2 + 2, nChildDepth ); ++cz )
+                {
+                    for ( int cx = nx * 2; cx != dMIN( nx * 2 + 2, nChildWidth ); ++cx )
+                    {
+                        const dReal *pChild = pChildren + 2 * ( cz * nChildWidth + cx );
+                        if ( pChild[ 0 ] < fMin ) fMin = pChild[ 0 ];
+                        if ( pChild[ 1 ] > fMax ) fMax = pChild[ 1 ];
+                    }
+                }
+
+                pNode[ 0 ] = fMin;
+                pNode[ 1 ] = fMax;
+            }
+        }
+    }
+
+    dIASSERT( pNode == pNodes + 2 * nNodes );
+    m_pBoundsPyramid = pNodes;
+    m_nBoundsLevels = nLevels;
+}
+
+
+void dxHeightfieldData::FreeBoundsPyramid()
+{
+    delete [] m_pBoundsPyramid;
+    m_pBoundsPyramid = NULL;
+    m_nBoundsLevels = 0;
+}
+
+
+// folds raw bounds of the pyramid node and its children which overlap the tile range
+void dxHeightfieldData::AccumulateBounds( int nLevel, int nNodeX, int nNodeZ,
+                                         int nMinTileX, int nMaxTileX, int nMinTileZ, int nMaxTileZ,
+                                         dReal &fMin, dReal &fMax ) const
+{
+    if ( nNodeX >= m_anBoundsLevelWidth[ nLevel ] || nNodeZ >= m_anBoundsLevelDepth[ nLevel ] )
+        return;
+
+    const int nFirstTileX = nNodeX << nLevel, nLastTileX = ( ( nNodeX + 1 ) << nLevel ) - 1;
+    const int nFirstTileZ = nNodeZ << nLevel, nLastTileZ = ( ( nNodeZ + 1 ) << nLevel ) - 1;
+
+    if ( nFirstTileX > nMaxTileX || nLastTileX < nMinTileX
+        || nFirstTileZ > nMaxTileZ || nLastTileZ < nMinTileZ )
+        return;
+
+    const dReal *pNode = m_pBoundsPyramid
+        + 2 * ( m_anBoundsLevelOffset[ nLevel ] + nNodeZ * m_anBoundsLevelWidth[ nLevel ] + nNodeX );
+
+    // nothing inside can widen the result
+    if ( pNode[ 0 ] >= fMin && pNode[ 1 ] <= fMax )
+        return;
+
+    if ( nLevel == 0
+        || ( nFirstTileX >= nMinTileX && nLastTileX <= nMaxTileX
+            && nFirstTileZ >= nMinTileZ && nLastTileZ <= nMaxTileZ ) )
+    {
+        if ( pNode[ 0 ] < fMin ) fMin = pNode[ 0 ];
+        if ( pNode[ 1 ] > fMax ) fMax = pNode[ 1 ];
+        return;
+    }
+
+    for ( int dz = 0; dz != 2; ++dz )
+    {
+        for ( int dx = 0; dx != 2; ++dx )
+        {
+            AccumulateBounds( nLevel - 1, nNodeX * 2 + dx, nNodeZ * 2 + dz,
+                nMinTileX, nMaxTileX, nMinTileZ, nMaxTileZ, fMin, fMax );
+        }
+    }
+}
+
+
+// returns conservative (scaled and offset) height bounds of the cell range,
+// or false if no bounds pyramid is available
+bool dxHeightfieldData::GetCellRangeHeightBounds( int nMinCellX, int nMaxCellX, int nMinCellZ, int nMaxCellZ,
+                                                 dReal &fMinHeight, dReal &fMaxHeight ) const
+{
+    if ( m_pBoundsPyramid == NULL || m_bWrapMode != 0 )
+        return false;
+
+    dIASSERT( nMinCellX >= 0 && nMaxCellX < m_nWidthSamples - 1 && nMinCellX <= nMaxCellX );
+    dIASSERT( nMinCellZ >= 0 && nMaxCellZ < m_nDepthSamples - 1 && nMinCellZ <= nMaxCellZ );
+
+    dReal fMin = dInfinity, fMax = -dInfinity;
+    const int nTopLevel = m_nBoundsLevels - 1;
+    AccumulateBounds( nTopLevel, 0, 0,
+        nMinCellX >> HEIGHTFIELD_BOUNDS_TILE_SHIFT, nMaxCellX >> HEIGHTFIELD_BOUNDS_TILE_SHIFT,
+        nMinCellZ >> HEIGHTFIELD_BOUNDS_TILE_SHIFT, nMaxCellZ >> HEIGHTFIELD_BOUNDS_TILE_SHIFT,
+        fMin, fMax );
+
+    fMin = ( fMin * m_fScale ) + m_fOffset;
+    fMax = ( fMax * m_fScale ) + m_fOffset;
+    fMinHeight = dMIN( fMin, fMax );
+    fMaxHeight = dMAX( fMin, fMax );
+    return true;
+}
+
+
+// Shrinks sample zone [nMinX..nMaxX]x[nMinZ..nMaxZ] by whole border tiles
+// whose samples are all below fMinO2Height (they can not produce triangles).
+// Returns false if the zone is entirely below fMinO2Height.
+bool dxHeightfieldData::CullZone( int &nMinX, int &nMaxX, int &nMinZ, int &nMaxZ, dReal fMinO2Height ) const
+{
+    dReal fMinHeight, fMaxHeight;
+
+    if ( !GetCellRangeHeightBounds( nMinX, nMaxX - 1, nMinZ, nMaxZ - 1, fMinHeight, fMaxHeight ) )
+        return true;
+
+    // Pyramid bounds are scaled here while the zone scales every sample on
+    // its own, so only parts below o2 by more than a rounding tolerance are culled
+    const dReal fCullHeight = fMinO2Height
+        - ( dFabs( fMinO2Height ) + REAL(1.0) ) * ( dEpsilon * HEIGHTFIELD_BOUNDS_CULL_TOLERANCE );
+
+    if ( fMaxHeight < fCullHeight )
+        return false;
+
+    // Trimmed tiles keep their shared border samples in the zone, so
+    // results of the remaining zone are the same as for the whole one.
+    for ( ; ; )
+    {
+        const int nNext = ( ( nMinX >> HEIGHTFIELD_BOUNDS_TILE_SHIFT ) + 1 ) << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+        if ( nNext >= nMaxX
+            || !GetCellRangeHeightBounds( nMinX, nNext - 1, nMinZ, nMaxZ - 1, fMinHeight, fMaxHeight )
+            || fMaxHeight >= fCullHeight )
+            break;
+        nMinX = nNext;
+    }
+
+    for ( ; ; )
+    {
+        const int nPrev = ( ( nMaxX - 1 ) >> HEIGHTFIELD_BOUNDS_TILE_SHIFT ) << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+        if ( nPrev <= nMinX
+            || !GetCellRangeHeightBounds( nPrev, nMaxX - 1, nMinZ, nMaxZ - 1, fMinHeight, fMaxHeight )
+            || fMaxHeight >= fCullHeight )
+            break;
+        nMaxX = nPrev;
+    }
+
+    for ( ; ; )
+    {
+        const int nNext = ( ( nMinZ >> HEIGHTFIELD_BOUNDS_TILE_SHIFT ) + 1 ) << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+        if ( nNext >= nMaxZ
+            || !GetCellRangeHeightBounds( nMinX, nMaxX - 1, nMinZ, nNext - 1, fMinHeight, fMaxHeight )
+            || fMaxHeight >= fCullHeight )
+            break;
+        nMinZ = nNext;
+    }
+
+    for ( ; ; )
+    {
+        const int nPrev = ( ( nMaxZ - 1 ) >> HEIGHTFIELD_BOUNDS_TILE_SHIFT ) << HEIGHTFIELD_BOUNDS_TILE_SHIFT;
+        if ( nPrev <= nMinZ
+            || !GetCellRangeHeightBounds( nMinX, nMaxX - 1, nPrev, nMaxZ - 1, fMinHeight, fMaxHeight )
+            || fMaxHeight >= fCullHeight )
+            break;
+        nMaxZ = nPrev;
+    }
+
+    return true;
 }
 
 
@@ -352,7 +627,10 @@ dReal dxHeightfieldData::GetHeight( int x, int z )
 
         // callback (dReal)
     case 0:
-        h = (*m_pGetHeightCallback)(m_pUserData, x, z);
+        if ( m_pGetHeightCallback != NULL )
+            h = (*m_pGetHeightCallback)(m_pUserData, x, z);
+        else
+            (*m_pGetHeightBlockCallback)(m_pUserData, x, z, 1, 1, &h);
         break;
 
         // byte
@@ -378,6 +656,21 @@ dReal dxHeightfieldData::GetHeight( int x, int z )
         data_double = (double*)m_pHeightData;
         h = (dReal)( data_double[x+(z * m_nWidthSamples)] );
         break;
+
+        // tiled
+    case 5:
+        {
+            // the last sample row belongs to the last tile
+            const int nTileX = dMIN( x / m_nTileSize, m_nTilesX - 1 );
+            const int nTileZ = dMIN( z / m_nTileSize, m_nTilesZ - 1 );
+            const float *pSamples = AcquireTile( nTileX, nTileZ );
+            // not available tiles are skipped by dCollideHeightfieldTiles
+            if ( pSamples != NULL )
+            {
+                h = pSamples[ ( x - nTileX * m_nTileSize ) + ( z - nTileZ * m_nTileSize ) * ( m_nTileSize + 1 ) ];
+            }
+        }
+        break;
     }
 
     return (h * m_fScale) + m_fOffset;
@@ -468,6 +761,134 @@ dxHeightfieldData::~dxHeightfieldData()
 
         }
     }
+
+    FreeBoundsPyramid();
+    FreeTiles();
+}
+
+
+// returns samples of a tile of tiled data, requesting it from the provider if not resident
+const float* dxHeightfieldData::AcquireTile( int nTileX, int nTileZ )
+{
+    dIASSERT( m_pTiles );
+    dIASSERT( nTileX >= 0 && nTileX < m_nTilesX && nTileZ >= 0 && nTileZ < m_nTilesZ );
+
+    dxHeightfieldTile *pTile = m_pTiles + ( nTileZ * m_nTilesX + nTileX );
+
+    const float *pSamples = (const float *)pTile->m_pSamples;
+    if ( pSamples == NULL )
+    {
+        pSamples = (*m_pGetTileCallback)( m_pUserData, nTileX, nTileZ );
+
+        if ( pSamples != NULL )
+        {
+            // Bounds are published before the samples, and only by one thread.
+            // A thread which loses the race just leaves the bounds unknown for a while.
+#if dATOMICS_ENABLED
+            if ( AtomicCompareExchange( &pTile->m_nBoundsState, dxHeightfieldTile::BOUNDS_UNKNOWN, dxHeightfieldTile::BOUNDS_COMPUTING ) )
+#else
+            if ( pTile->m_nBoundsState == dxHeightfieldTile::BOUNDS_UNKNOWN )
+#endif
+            {
+                const int nStride = m_nTileSize + 1;
+                const int nSamplesX = dMIN( m_nTileSize, m_nWidthSamples - 1 - nTileX * m_nTileSize ) + 1;
+                const int nSamplesZ = dMIN( m_nTileSize, m_nDepthSamples - 1 - nTileZ * m_nTileSize ) + 1;
+
+                float fMin = pSamples[ 0 ], fMax = pSamples[ 0 ];
+                for ( int z = 0; z != nSamplesZ; ++z )
+                {
+                    const float *pRow = pSamples + z * nStride;
+                    for ( int x = 0; x != nSamplesX; ++x )
+                    {
+                        if ( pRow[ x ] < fMin ) fMin = pRow[ x ];
+                        if ( pRow[ x ] > fMax ) fMax = pRow[ x ];
+                    }
+                }
+
+                pTile->m_fMinSample = fMin;
+                pTile->m_fMaxSample = fMax;
+
+                // release: the bounds are visible to whoever sees the state changed
+#if dATOMICS_ENABLED
+                AtomicExchange( &pTile->m_nBoundsState, dxHeightfieldTile::BOUNDS_KNOWN );
+#else
+                pTile->m_nBoundsState = dxHeightfieldTile::BOUNDS_KNOWN;
+#endif
+            }
+
+#if dATOMICS_ENABLED
+            if ( !AtomicCompareExchangePointer( &pTile->m_pSamples, (atomicptr)NULL, (atomicptr)pSamples ) )
+            {
+                // another thread made the tile resident first
+                if ( m_pReleaseTileCallback )
+                    (*m_pReleaseTileCallback)( m_pUserData, nTileX, nTileZ, pSamples );
+
+                pSamples = (const float *)pTile->m_pSamples;
+            }
+#else
+            pTile->m_pSamples = (atomicptr)pSamples;
+#endif
+        }
+    }
+
+    return pSamples;
+}
+
+
+// returns scaled maximal height of a tile if its bounds are known
+bool dxHeightfieldData::GetTileMaxHeight( int nTileX, int nTileZ, dReal &fMaxHeight ) const
+{
+    dxHeightfieldTile *pTile = m_pTiles + ( nTileZ * m_nTilesX + nTileX );
+
+    // acquire: the bounds are only read after their state has been seen as known
+#if dATOMICS_ENABLED
+    if ( !AtomicCompareExchange( &pTile->m_nBoundsState, dxHeightfieldTile::BOUNDS_KNOWN, dxHeightfieldTile::BOUNDS_KNOWN ) )
+#else
+    if ( pTile->m_nBoundsState != dxHeightfieldTile::BOUNDS_KNOWN )
+#endif
+        return false;
+
+    fMaxHeight = dMAX( pTile->m_fMinSample * m_fScale, pTile->m_fMaxSample * m_fScale ) + m_fOffset;
+    return true;
+}
+
+
+void dxHeightfieldData::EvictTile( int nTileX, int nTileZ )
+{
+    dIASSERT( m_pTiles );
+    dIASSERT( nTileX >= 0 && nTileX < m_nTilesX && nTileZ >= 0 && nTileZ < m_nTilesZ );
+
+    dxHeightfieldTile *pTile = m_pTiles + ( nTileZ * m_nTilesX + nTileX );
+
+    const float *pSamples = (const float *)pTile->m_pSamples;
+    if ( pSamples != NULL )
+    {
+        pTile->m_pSamples = (atomicptr)NULL;
+
+        if ( m_pReleaseTileCallback )
+            (*m_pReleaseTileCallback)( m_pUserData, nTileX, nTileZ, pSamples );
+    }
+}
+
+
+void dxHeightfieldData::FreeTiles()
+{
+    if ( m_pTiles != NULL )
+    {
+        for ( int nTileZ = 0; nTileZ != m_nTilesZ; ++nTileZ )
+        {
+            for ( int nTileX = 0; nTileX != m_nTilesX; ++nTileX )
+            {
+                EvictTile( nTileX, nTileZ );
+            }
+        }
+
+        delete [] m_pTiles;
+        m_pTiles = NULL;
+    }
+
+    m_nTilesX = 0;
+    m_nTilesZ = 0;
 }
 
 
@@ -487,7 +908,9 @@ dxHeightfield::dxHeightfield( dSpaceID space,
     tempHeightBuffer(0),
     tempHeightInstances(0),
     tempHeightBufferSizeX(0),
-    tempHeightBufferSizeZ(0)
+    tempHeightBufferSizeZ(0),
+    tempSampleBlock(0),
+    tempSampleBlockSize(0)
 {
     type = dHeightfieldClass;
     this->m_p_data = data;
@@ -629,6 +1052,7 @@ dxHeightfield::~dxHeightfield()
     resetTriangleBuffer();
     resetPlaneBuffer();
     resetHeightBuffer();
+    resetSampleBlock();
 }
 
 void dxHeightfield::allocateTriangleBuffer(size_t numTri)
@@ -687,6 +1111,18 @@ void dxHeightfield::resetHeightBuffer()
     delete[] tempHeightInstances;
     delete[] tempHeightBuffer;
 }
+
+void dxHeightfield::allocateSampleBlock(size_t numSamples)
+{
+    size_t alignedNumSamples = AlignBufferSize(numSamples, TEMP_HEIGHT_BUFFER_ELEMENT_COUNT_ALIGNMENT_X * TEMP_HEIGHT_BUFFER_ELEMENT_COUNT_ALIGNMENT_Z);
+    tempSampleBlockSize = alignedNumSamples;
+    tempSampleBlock = new dReal [alignedNumSamples];
+}
+
+void dxHeightfield::resetSampleBlock()
+{
+    delete[] tempSampleBlock;
+}
 //////// Heightfield data interface ////////////////////////////////////////////////////
 
 
@@ -710,6 +1146,32 @@ void dGeomHeightfieldDataBuildCallback( dHeightfieldDataID d,
     d->m_nGetHeightMode = 0;
     d->m_pUserData = pUserData;
     d->m_pGetHeightCallback = pCallback;
+    d->m_pGetHeightBlockCallback = NULL;
+
+    // set info
+    d->SetData( widthSamples, depthSamples, width, depth, scale, offset, thickness, bWrap );
+
+    // default bounds
+    d->m_fMinHeight = -dInfinity;
+    d->m_fMaxHeight = dInfinity;
+}
+
+
+void dGeomHeightfieldDataBuildCallbackBlock( dHeightfieldDataID d,
+                                            void* pUserData, dHeightfieldGetHeightBlock* pCallback,
+                                            dReal width, dReal depth, int widthSamples, int depthSamples,
+                                            dReal scale, dReal offset, dReal thickness, int bWrap )
+{
+    dUASSERT( d, "argument not Heightfield data" );
+    dIASSERT( pCallback );
+    dIASSERT( widthSamples >= 2 );	// Ensure we're making something with at least one cell.
+    dIASSERT( depthSamples >= 2 );
+
+    // callback, sampled by blocks
+    d->m_nGetHeightMode = 0;
+    d->m_pUserData = pUserData;
+    d->m_pGetHeightCallback = NULL;
+    d->m_pGetHeightBlockCallback = pCallback;
 
     // set info
     d->SetData( widthSamples, depthSamples, width, depth, scale, offset, thickness, bWrap );
@@ -865,11 +1327,58 @@ void dGeomHeightfieldDataBuildDouble( dHeightfieldDataID d,
 
 
 
+void dGeomHeightfieldDataBuildTiled( dHeightfieldDataID d,
+                                    void* pUserData, dHeightfieldGetTile* pGetTile,
+                                    dHeightfieldReleaseTile* pReleaseTile, int tileSize,
+                                    dReal width, dReal depth, int widthSamples, int depthSamples,
+                                    dReal scale, dReal offset, dReal thickness, int bWrap )
+{
+    dUASSERT( d, "argument not Heightfield data" );
+    dIASSERT( pGetTile );
+    dIASSERT( tileSize >= 1 );
+    dIASSERT( widthSamples >= 2 );	// Ensure we're making something with at least one cell.
+    dIASSERT( depthSamples >= 2 );
+
+    // set info, releasing tiles of a previous provider
+    d->SetData( widthSamples, depthSamples, width, depth, scale, offset, thickness, bWrap );
+
+    // tiled
+    d->m_nGetHeightMode = 5;
+    d->m_pUserData = pUserData;
+    d->m_pGetTileCallback = pGetTile;
+    d->m_pReleaseTileCallback = pReleaseTile;
+    d->m_nTileSize = tileSize;
+    d->m_nTilesX = ( widthSamples - 1 + tileSize - 1 ) / tileSize;
+    d->m_nTilesZ = ( depthSamples - 1 + tileSize - 1 ) / tileSize;
+
+    const int nTileCount = d->m_nTilesX * d->m_nTilesZ;
+    d->m_pTiles = new dxHeightfieldTile[ nTileCount ];
+    memset( d->m_pTiles, 0, sizeof( dxHeightfieldTile ) * nTileCount );
+
+    // default bounds
+    d->m_fMinHeight = -dInfinity;
+    d->m_fMaxHeight = dInfinity;
+}
+
+
+void dGeomHeightfieldDataEvictTile( dHeightfieldDataID d, int tileX, int tileZ )
+{
+    dUASSERT( d, "argument not Heightfield data" );
+    dUASSERT( d->m_nGetHeightMode == 5, "Heightfield data is not tiled" );
+    dUASSERT( tileX >= 0 && tileX < d->m_nTilesX && tileZ >= 0 && tileZ < d->m_nTilesZ, "tile index out of range" );
+
+    d->EvictTile( tileX, tileZ );
+}
+
+
 void dGeomHeightfieldDataSetBounds( dHeightfieldDataID d, dReal minHeight, dReal maxHeight )
 {
     dUASSERT(d, "Argument not Heightfield data");
     d->m_fMinHeight = ( minHeight * d->m_fScale ) + d->m_fOffset - d->m_fThickness;
     d->m_fMaxHeight = ( maxHeight * d->m_fScale ) + d->m_fOffset;
+
+    // referenced samples may have changed, local bounds must follow
+    d->BuildBoundsPyramid();
 }
 
 
@@ -975,7 +1484,7 @@ static inline dReal DistancePointToLine(const dVector3 &_point,
 int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, const int minZ, const int maxZ, 
                                            dxGeom* o2, const int numMaxContactsPossible,
                                            int flags, dContactGeom* contact, 
-                                           int skip )
+                                           int skip, const dxHeightfieldTileOwnership *pOwnership )
 {
     dContactGeom *pContact = 0;
     int  x, z;
@@ -998,6 +1507,39 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
             allocateHeightBuffer(numX, numZ);
         }
 
+        // Request the whole zone from a block callback at once
+        // if it does not cross the heightfield border
+        const dReal *sampleBlock = NULL;
+        if ( m_p_data->m_nGetHeightMode == 0 && m_p_data->m_pGetHeightCallback == NULL )
+        {
+            int blockMinX = minX, blockMinZ = minZ;
+            int blockLimitX = m_p_data->m_nWidthSamples, blockLimitZ = m_p_data->m_nDepthSamples;
+            if ( m_p_data->m_bWrapMode != 0 )
+            {
+                // the last wrapped sample is read from the first one
+                --blockLimitX;
+                --blockLimitZ;
+                blockMinX %= blockLimitX;
+                blockMinZ %= blockLimitZ;
+                if ( blockMinX < 0 ) blockMinX += blockLimitX;
+                if ( blockMinZ < 0 ) blockMinZ += blockLimitZ;
+            }
+
+            if ( blockMinX >= 0 && blockMinX + (int)numX <= blockLimitX
+                && blockMinZ >= 0 && blockMinZ + (int)numZ <= blockLimitZ )
+            {
+                if (tempSampleBlockSize < numX * numZ)
+                {
+                    resetSampleBlock();
+                    allocateSampleBlock(numX * numZ);
+                }
+
+                (*m_p_data->m_pGetHeightBlockCallback)( m_p_data->m_pUserData,
+                    blockMinX, blockMinZ, numX, numZ, tempSampleBlock );
+                sampleBlock = tempSampleBlock;
+            }
+        }
+
         dReal Xpos, Ypos;
 
         for ( x = minX, x_local = 0; x_local < numX; x++, x_local++)
@@ -1010,7 +1552,9 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
             {
                 Ypos = z * cfSampleDepth; // Always calculate pos via multiplication to avoid computational error accumulation during multiple additions
 
-                const dReal h = m_p_data->GetHeight(x, z);
+                const dReal h = sampleBlock != NULL
+                    ? ( sampleBlock[ x_local + z_local * numX ] * m_p_data->m_fScale ) + m_p_data->m_fOffset
+                    : m_p_data->GetHeight(x, z);
                 HeightFieldRow[z_local].vertex[0] = c_Xpos;
                 HeightFieldRow[z_local].vertex[1] = h;
                 HeightFieldRow[z_local].vertex[2] = Ypos;
@@ -1029,6 +1573,13 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
         if (minY - maxO2Height > -dEpsilon )
         {
             // totally under heightfield
+            if (pOwnership != NULL
+                && !pOwnership->IsPointOwned(o2->final_posr->pos[0], o2->final_posr->pos[2], m_p_data->m_fInvSampleWidth, m_p_data->m_fInvSampleDepth))
+            {
+                // reported by the tile under the geom
+                return 0;
+            }
+
             pContact = CONTACT(contact, 0);
 
             pContact->pos[0] = o2->final_posr->pos[0];
@@ -1130,12 +1681,27 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
         triplane[3] =  minY;
         dGeomPlaneSetNoNormalize (sliding_plane, triplane);
         // find collision and compute contact points
-        const int numTerrainContacts = geomNPlaneCollider (o2, sliding_plane, flags, contact, skip);
-        dIASSERT(numTerrainContacts <= numMaxContactsPossible);
-        for (i = 0; i < numTerrainContacts; i++)
+        const int numPlaneContacts = geomNPlaneCollider (o2, sliding_plane, flags, contact, skip);
+        dIASSERT(numPlaneContacts <= numMaxContactsPossible);
+        int numTerrainContacts = 0;
+        for (i = 0; i < numPlaneContacts; i++)
         {
-            pContact = CONTACT(contact, i*skip);
+            dContactGeom *planeContact = CONTACT(contact, i*skip);
+
+            // the plane extends past the tile, keep the points over it only
+            if (pOwnership != NULL
+                && !pOwnership->IsPointOwned(planeContact->pos[0], planeContact->pos[2], m_p_data->m_fInvSampleWidth, m_p_data->m_fInvSampleDepth))
+            {
+                continue;
+            }
+
+            pContact = CONTACT(contact, numTerrainContacts*skip);
+            if (pContact != planeContact)
+            {
+                *pContact = *planeContact;
+            }
             dOPESIGN(pContact->normal, =, -, triplane);
+            numTerrainContacts++;
         }
         return numTerrainContacts;
     }
@@ -1557,6 +2123,21 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
     // pass2: VS triangle vertices
     if (needFurtherPasses)
     {
+        // samples on shared tile borders are only tested by the tile owning them
+        if (pOwnership != NULL)
+        {
+            for ( x_local = 0; x_local < numX; x_local++)
+            {
+                HeightFieldVertex *HeightFieldRow = tempHeightBuffer[x_local];
+                for ( z_local = 0; z_local < numZ; z_local++)
+                {
+                    HeightFieldVertex *vertex = &HeightFieldRow[z_local];
+                    if (!pOwnership->IsSampleOwned(vertex->coords[0], vertex->coords[1]))
+                        vertex->state = true;
+                }
+            }
+        }
+
         dxRay tempRay(0, 1); 
         dReal depth;
         bool vertexCollided;
@@ -1697,6 +2278,259 @@ int dxHeightfield::dCollideHeightfieldZone( const int minX, const int maxX, cons
     return numTerrainContacts;
 }
 
+// Collides ray with the heightfield by marching the cells under the ray
+// in order of distance (2D DDA) and intersecting both triangles of each
+// cell directly, instead of building planes for the whole zone.
+int dxHeightfield::dCollideHeightfieldRay( dxGeom* o2, const int numMaxContactsPossible,
+                                          dContactGeom* contact, int skip )
+{
+    dIASSERT( o2->type == dRayClass );
+
+    dxHeightfieldData *const data = m_p_data;
+    const dReal *const P = o2->final_posr->pos;
+    const dReal Dir[3] = { o2->final_posr->R[0*4+2], o2->final_posr->R[1*4+2], o2->final_posr->R[2*4+2] };
+    const int numMaxContacts = ( o2->gflags & (RAY_FIRSTCONTACT | RAY_CLOSEST_HIT) ) ? 1 : numMaxContactsPossible;
+
+    // clip the ray against the heightfield extents
+    dReal tMin = 0, tMax = ((dxRay *)o2)->length;
+    const dReal lo[3] = { 0, data->m_fMinHeight, 0 };
+    const dReal hi[3] = { data->m_fWidth, data->m_fMaxHeight, data->m_fDepth };
+    for ( int axis = 0; axis != 3; ++axis )
+    {
+        if ( axis != 1 && data->m_bWrapMode != 0 )
+            continue;
+
+        if ( Dir[axis] == 0 )
+        {
+            if ( P[axis] < lo[axis] || P[axis] > hi[axis] )
+                return 0;
+            continue;
+        }
+
+        const dReal invDir = REAL(1.0) / Dir[axis];
+        dReal t0 = ( lo[axis] - P[axis] ) * invDir, t1 = ( hi[axis] - P[axis] ) * invDir;
+        if ( t0 > t1 ) { const dReal tmp = t0; t0 = t1; t1 = tmp; }
+        // infinite height bounds (callback data) give infinite t values which keep the range
+        if ( t0 > tMin ) tMin = t0;
+        if ( t1 < tMax ) tMax = t1;
+    }
+
+    if ( tMin > tMax )
+        return 0;
+
+    const dReal fSampleWidth = data->m_fSampleWidth, fSampleDepth = data->m_fSampleDepth;
+    const dReal fInvSampleWidth = data->m_fInvSampleWidth, fInvSampleDepth = data->m_fInvSampleDepth;
+    const int nLastCellX = data->m_nWidthSamples - 2, nLastCellZ = data->m_nDepthSamples - 2;
+    const bool wrapped = data->m_bWrapMode != 0;
+
+    int cx = (int)dFloor( ( P[0] + Dir[0] * tMin ) * fInvSampleWidth );
+    int cz = (int)dFloor( ( P[2] + Dir[2] * tMin ) * fInvSampleDepth );
+    if ( !wrapped )
+    {
+        cx = dMAX( 0, dMIN( cx, nLastCellX ) );
+        cz = dMAX( 0, dMIN( cz, nLastCellZ ) );
+    }
+
+    const int stepX = Dir[0] > 0 ? 1 : -1, stepZ = Dir[2] > 0 ? 1 : -1;
+    const dReal tDeltaX = Dir[0] != 0 ? fSampleWidth / dFabs( Dir[0] ) : dInfinity;
+    const dReal tDeltaZ = Dir[2] != 0 ? fSampleDepth / dFabs( Dir[2] ) : dInfinity;
+    dReal tNextX = Dir[0] != 0 ? ( ( cx + ( stepX > 0 ? 1 : 0 ) ) * fSampleWidth - P[0] ) / Dir[0] : dInfinity;
+    dReal tNextZ = Dir[2] != 0 ? ( ( cz + ( stepZ > 0 ? 1 : 0 ) ) * fSampleDepth - P[2] ) / Dir[2] : dInfinity;
+
+    int numTerrainContacts = 0;
+    dReal tEnter = tMin;
+
+    while ( numTerrainContacts < numMaxContacts )
+    {
+        const dReal tNext = dMIN( tNextX, tNextZ );
+        const bool isLastCell = tNext >= tMax;
+        const dReal tExit = isLastCell ? tMax : tNext;
+
+        if ( data->m_nGetHeightMode != 5 || wrapped
+            || data->AcquireTile( cx / data->m_nTileSize, cz / data->m_nTileSize ) != NULL )
+        {
+            const dReal hA = data->GetHeight( cx, cz );
+            const dReal hB = data->GetHeight( cx + 1, cz );
+            const dReal hC = data->GetHeight( cx, cz + 1 );
+            const dReal hD = data->GetHeight( cx + 1, cz + 1 );
+
+            // skip cells the ray passes entirely above or below
+            const dReal yEnter = P[1] + Dir[1] * tEnter, yExit = P[1] + Dir[1] * tExit;
+            const dReal yRayMin = dMIN( yEnter, yExit ), yRayMax = dMAX( yEnter, yExit );
+            const dReal hMin = dMIN( dMIN( hA, hB ), dMIN( hC, hD ) );
+            const dReal hMax = dMAX( dMAX( hA, hB ), dMAX( hC, hD ) );
+
+            if ( yRayMin <= hMax && yRayMax >= hMin )
+            {
+                const dReal x0 = cx * fSampleWidth, z0 = cz * fSampleDepth;
+                dReal hitT[2], hitPlane[2][4];
+                int numHits = 0;
+
+                for ( int isUp = 1; isUp >= 0; --isUp )
+                {
+                    dVector3 v0, Edge1, Edge2, n;
+                    if ( isUp )
+                    {
+                        // A, B, C
+                        v0[0] = x0; v0[1] = hA; v0[2] = z0;
+                        Edge1[0] = 0; Edge1[1] = hC - hA; Edge1[2] = fSampleDepth;
+                        Edge2[0] = fSampleWidth; Edge2[1] = hB - hA; Edge2[2] = 0;
+                    }
+                    else
+                    {
+                        // D, B, C
+                        v0[0] = x0 + fSampleWidth; v0[1] = hD; v0[2] = z0 + fSampleDepth;
+                        Edge1[0] = 0; Edge1[1] = hB - hD; Edge1[2] = -fSampleDepth;
+                        Edge2[0] = -fSampleWidth; Edge2[1] = hC - hD; Edge2[2] = 0;
+                    }
+                    dVector3Cross( Edge1, Edge2, n );
+                    const dReal dinvlength = REAL(1.0) / dVector3Length( n );
+                    n[0] *= dinvlength; n[1] *= dinvlength; n[2] *= dinvlength;
+
+                    const dReal k = dCalcVectorDot3( n, Dir );
+                    if ( k == 0 )
+                        continue;
+
+                    const dReal d = dCalcVectorDot3( n, v0 );
+                    const dReal t = ( d - dCalcVectorDot3( n, P ) ) / k;
+                    // half-open window so that cell borders are hit only once
+                    if ( t < tEnter || ( isLastCell ? t > tExit : t >= tExit ) )
+                        continue;
+
+                    // same triangle split as GetHeight() and IsOnHeightfield2()
+                    const dReal u = ( P[0] + Dir[0] * t - x0 ) * fInvSampleWidth;
+                    const dReal v = ( P[2] + Dir[2] * t - z0 ) * fInvSampleDepth;
+                    if ( isUp ? ( u + v > REAL(1.0) ) : ( u + v <= REAL(1.0) ) )
+                        continue;
+
+                    int slot = numHits;
+                    if ( numHits != 0 && t < hitT[0] )
+                    {
+                        // keep hits of the cell ordered by distance
+                        hitT[1] = hitT[0];
+                        dVector4Copy( hitPlane[0], hitPlane[1] );
+                        slot = 0;
+                    }
+                    hitT[slot] = t;
+                    hitPlane[slot][0] = n[0]; hitPlane[slot][1] = n[1]; hitPlane[slot][2] = n[2]; hitPlane[slot][3] = d;
+                    ++numHits;
+                }
+
+                for ( int h = 0; h != numHits && numTerrainContacts < numMaxContacts; ++h )
+                {
+                    dContactGeom *pContact = CONTACT( contact, numTerrainContacts * skip );
+                    pContact->pos[0] = P[0] + Dir[0] * hitT[h];
+                    pContact->pos[1] = P[1] + Dir[1] * hitT[h];
+                    pContact->pos[2] = P[2] + Dir[2] * hitT[h];
+                    dOPESIGN( pContact->normal, =, -, hitPlane[h] );
+                    pContact->depth = hitT[h];
+                    pContact->side1 = -1;
+                    pContact->side2 = -1;
+                    ++numTerrainContacts;
+                }
+            }
+        }
+
+        if ( isLastCell )
+            break;
+
+        // step into the next cell
+        tEnter = tNext;
+        if ( tNextX <= tNextZ )
+        {
+            cx += stepX;
+            tNextX += tDeltaX;
+            if ( !wrapped && ( cx < 0 || cx > nLastCellX ) )
+                break;
+        }
+        else
+        {
+            cz += stepZ;
+            tNextZ += tDeltaZ;
+            if ( !wrapped && ( cz < 0 || cz > nLastCellZ ) )
+                break;
+        }
+    }
+
+    return numTerrainContacts;
+}
+
+
+// Collides zone of tiled data. Tiles which can not reach o2 by their known bounds
+// are skipped; if all of the remaining tiles are resident, the zone is collided
+// as a whole, otherwise each available tile is collided separately.
+int dxHeightfield::dCollideHeightfieldTiles( const int minX, const int maxX, const int minZ, const int maxZ,
+                                            dxGeom* o2, const int numMaxContactsPossible,
+                                            int flags, dContactGeom* contact,
+                                            int skip )
+{
+    dxHeightfieldData *const data = m_p_data;
+    const int nTileSize = data->m_nTileSize;
+    const int nMinTileX = minX / nTileSize, nMaxTileX = ( maxX - 1 ) / nTileSize;
+    const int nMinTileZ = minZ / nTileSize, nMaxTileZ = ( maxZ - 1 ) / nTileSize;
+    const int nZoneTilesX = nMaxTileX - nMinTileX + 1;
+    const dReal minO2Height = o2->aabb[2];
+
+    // Tiles to be collided are decided once, as other threads may make tiles resident meanwhile
+    bool *pCollided = (bool *)dALLOCA16( nZoneTilesX * ( nMaxTileZ - nMinTileZ + 1 ) * sizeof( bool ) );
+    bool bSplit = false;
+    int nTileX, nTileZ;
+
+    for ( nTileZ = nMinTileZ; nTileZ <= nMaxTileZ; ++nTileZ )
+    {
+        for ( nTileX = nMinTileX; nTileX <= nMaxTileX; ++nTileX )
+        {
+            bool &bCollided = pCollided[ ( nTileZ - nMinTileZ ) * nZoneTilesX + ( nTileX - nMinTileX ) ];
+            dReal fMax;
+
+            bCollided = !( data->GetTileMaxHeight( nTileX, nTileZ, fMax ) && minO2Height - fMax > -dEpsilon )
+                && data->AcquireTile( nTileX, nTileZ ) != NULL;
+
+            if ( !bCollided )
+                bSplit = true;
+        }
+    }
+
+    if ( !bSplit )
+        return dCollideHeightfieldZone( minX, maxX, minZ, maxZ, o2, numMaxContactsPossible, flags, contact, skip, NULL );
+
+    dxHeightfieldTileOwnership ownership;
+    ownership.m_nTileSize = nTileSize;
+    ownership.m_nMinTileX = nMinTileX;
+    ownership.m_nMaxTileX = nMaxTileX;
+    ownership.m_nMinTileZ = nMinTileZ;
+    ownership.m_nMaxTileZ = nMaxTileZ;
+    ownership.m_pCollided = pCollided;
+
+    int numTerrainContacts = 0;
+
+    for ( nTileZ = nMinTileZ; nTileZ <= nMaxTileZ && numTerrainContacts < numMaxContactsPossible; ++nTileZ )
+    {
+        for ( nTileX = nMinTileX; nTileX <= nMaxTileX && numTerrainContacts < numMaxContactsPossible; ++nTileX )
+        {
+            if ( !ownership.IsTileCollided( nTileX, nTileZ ) )
+                continue;
+
+            const int nTileMinX = dMAX( minX, nTileX * nTileSize );
+            const int nTileMaxX = dMIN( maxX, ( nTileX + 1 ) * nTileSize );
+            const int nTileMinZ = dMAX( minZ, nTileZ * nTileSize );
+            const int nTileMaxZ = dMIN( maxZ, ( nTileZ + 1 ) * nTileSize );
+
+            // border samples and contact points are collided by one tile only
+            ownership.m_nTileX = nTileX;
+            ownership.m_nTileZ = nTileZ;
+
+            const int numTileMaxContacts = numMaxContactsPossible - numTerrainContacts;
+            numTerrainContacts += dCollideHeightfieldZone( nTileMinX, nTileMaxX, nTileMinZ, nTileMaxZ,
+                o2, numTileMaxContacts, ( flags & ~NUMC_MASK ) | numTileMaxContacts,
+                CONTACT( contact, numTerrainContacts * skip ), skip, &ownership );
+        }
+    }
+
+    return numTerrainContacts;
+}
+
+
 int dCollideHeightfield( dxGeom *o1, dxGeom *o2, int flags, dContactGeom* contact, int skip )
 {
     dIASSERT( skip >= (int)sizeof(dContactGeom) );
@@ -1801,12 +2635,32 @@ int dCollideHeightfield( dxGeom *o1, dxGeom *o2, int flags, dContactGeom* contac
             nMaxZ = dMIN( nMaxZ, terrain->m_p_data->m_nDepthSamples - 1 );
 
             dIASSERT ((nMinX < nMaxX) && (nMinZ < nMaxZ));
+
+            // Skip the zone, or trim its borders, where the height
+            // bounds pyramid shows no sample can reach o2
+            if ( !terrain->m_p_data->CullZone( nMinX, nMaxX, nMinZ, nMaxZ, o2->aabb[2] ) )
+                goto dCollideHeightfieldExit;
         }
 
         numTerrainOrigContacts = numTerrainContacts;
-        numTerrainContacts += terrain->dCollideHeightfieldZone(
-            nMinX,nMaxX,nMinZ,nMaxZ,o2,numMaxTerrainContacts - numTerrainContacts,
-            flags,CONTACT(contact,numTerrainContacts*skip),skip	);
+        if ( o2->type == dRayClass )
+        {
+            numTerrainContacts += terrain->dCollideHeightfieldRay(
+                o2,numMaxTerrainContacts - numTerrainContacts,
+                CONTACT(contact,numTerrainContacts*skip),skip );
+        }
+        else if ( terrain->m_p_data->m_nGetHeightMode == 5 && !wrapped )
+        {
+            numTerrainContacts += terrain->dCollideHeightfieldTiles(
+                nMinX,nMaxX,nMinZ,nMaxZ,o2,numMaxTerrainContacts - numTerrainContacts,
+                flags,CONTACT(contact,numTerrainContacts*skip),skip	);
+        }
+        else
+        {
+            numTerrainContacts += terrain->dCollideHeightfieldZone(
+                nMinX,nMaxX,nMinZ,nMaxZ,o2,numMaxTerrainContacts - numTerrainContacts,
+                flags,CONTACT(contact,numTerrainContacts*skip),skip,NULL	);
+        }
         dIASSERT( numTerrainContacts <= numMaxTerrainContacts );
     }
 
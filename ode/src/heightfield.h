@@ -31,10 +31,88 @@
 
 #include <ode/common.h>
 #include "collision_kernel.h"
+#include "odeou.h"
 
 
 #define HEIGHTFIELDMAXCONTACTPERCELL 10
 
+// Height bounds pyramid: level 0 keeps min/max per tile of
+// (1 << HEIGHTFIELD_BOUNDS_TILE_SHIFT)^2 cells, upper levels merge 2x2 nodes.
+#define HEIGHTFIELD_BOUNDS_TILE_SHIFT 2
+#define HEIGHTFIELD_BOUNDS_MAX_LEVELS 32
+// Culling tolerance in dEpsilon units relative to the compared height
+#define HEIGHTFIELD_BOUNDS_CULL_TOLERANCE 64
+
+
+// Tile of tiled heightfield data
+struct dxHeightfieldTile
+{
+    enum
+    {
+        BOUNDS_UNKNOWN,
+        BOUNDS_COMPUTING,
+        BOUNDS_KNOWN,
+    };
+
+    volatile atomicptr m_pSamples;  // const float * given by the tile provider (NULL if not resident)
+    float m_fMinSample;             // Raw sample bounds, kept after eviction
+    float m_fMaxSample;
+    volatile atomicord32 m_nBoundsState; // BOUNDS_xxx, the bounds are only read after BOUNDS_KNOWN is seen
+};
+
+// Ownership of samples and points among the tiles of a zone which are collided
+// one by one. Samples on shared tile borders and contact points are attributed
+// to a single collided tile, so that no contact is generated twice.
+struct dxHeightfieldTileOwnership
+{
+    int m_nTileSize;            // Cell count on a tile edge
+    int m_nMinTileX;            // Tile range of the zone
+    int m_nMaxTileX;
+    int m_nMinTileZ;
+    int m_nMaxTileZ;
+    int m_nTileX;               // Tile being collided
+    int m_nTileZ;
+    const bool *m_pCollided;    // Flags of the zone tiles being collided, row-major by Z
+
+    bool IsTileCollided( int nTileX, int nTileZ ) const
+    {
+        return m_pCollided[ ( nTileZ - m_nMinTileZ ) * ( m_nMaxTileX - m_nMinTileX + 1 ) + ( nTileX - m_nMinTileX ) ];
+    }
+
+    // A shared sample belongs to the collided tile with the greatest X and then Z index
+    bool IsSampleOwned( int x, int z ) const
+    {
+        const int nCellTileX = x / m_nTileSize, nCellTileZ = z / m_nTileSize;
+        const int nLastTileX = nCellTileX < m_nMaxTileX ? nCellTileX : m_nMaxTileX;
+        const int nLastTileZ = nCellTileZ < m_nMaxTileZ ? nCellTileZ : m_nMaxTileZ;
+        // a sample on a tile border is shared with the preceding tile
+        const int nBorderTileX = x % m_nTileSize == 0 ? nCellTileX - 1 : nCellTileX;
+        const int nBorderTileZ = z % m_nTileSize == 0 ? nCellTileZ - 1 : nCellTileZ;
+        const int nFirstTileX = nBorderTileX > m_nMinTileX ? nBorderTileX : m_nMinTileX;
+        const int nFirstTileZ = nBorderTileZ > m_nMinTileZ ? nBorderTileZ : m_nMinTileZ;
+
+        for ( int nTileX = nLastTileX; nTileX >= nFirstTileX; --nTileX )
+        {
+            for ( int nTileZ = nLastTileZ; nTileZ >= nFirstTileZ; --nTileZ )
+            {
+                if ( IsTileCollided( nTileX, nTileZ ) )
+                    return nTileX == m_nTileX && nTileZ == m_nTileZ;
+            }
+        }
+
+        return false;
+    }
+
+    // A point belongs to the zone tile of its cell (cells are half-open)
+    bool IsPointOwned( dReal fX, dReal fZ, dReal fInvSampleWidth, dReal fInvSampleDepth ) const
+    {
+        const dReal fTileCellsX = dFloor( fX * fInvSampleWidth ) / m_nTileSize;
+        const dReal fTileCellsZ = dFloor( fZ * fInvSampleDepth ) / m_nTileSize;
+        const int nTileX = fTileCellsX < m_nMinTileX ? m_nMinTileX : fTileCellsX >= m_nMaxTileX ? m_nMaxTileX : (int)fTileCellsX;
+        const int nTileZ = fTileCellsZ < m_nMinTileZ ? m_nMinTileZ : fTileCellsZ >= m_nMaxTileZ ? m_nMaxTileZ : (int)fTileCellsZ;
+        return nTileX == m_nTileX && nTileZ == m_nTileZ;
+    }
+};
 
 class HeightFieldVertex;
 class HeightFieldEdge;
@@ -68,7 +146,7 @@ struct dxHeightfieldData
     int	m_nDepthSamples;       // Vertex count on Z axis edge (number of samples)
     int m_bCopyHeightData;     // Do we own the sample data?
     int	m_bWrapMode;           // Heightfield wrapping mode (0=finite, 1=infinite)
-    int m_nGetHeightMode;      // GetHeight mode ( 0=callback, 1=byte, 2=short, 3=float )
+    int m_nGetHeightMode;      // GetHeight mode ( 0=callback, 1=byte, 2=short, 3=float, 4=double, 5=tiled )
 
     const void* m_pHeightData; // Sample data array
     void* m_pUserData;         // Callback user data
@@ -76,6 +154,20 @@ struct dxHeightfieldData
     dContactGeom            m_contacts[HEIGHTFIELDMAXCONTACTPERCELL];
 
     dHeightfieldGetHeight* m_pGetHeightCallback;		// Callback pointer.
+    dHeightfieldGetHeightBlock* m_pGetHeightBlockCallback;	// Block callback pointer (used if m_pGetHeightCallback is NULL)
+
+    dHeightfieldGetTile* m_pGetTileCallback;          // Tile provider load callback (tiled mode)
+    dHeightfieldReleaseTile* m_pReleaseTileCallback;  // Tile provider release callback (tiled mode, may be NULL)
+    dxHeightfieldTile* m_pTiles;   // Tile states, row-major by Z
+    int m_nTileSize;               // Cell count on a tile edge
+    int m_nTilesX;                 // Tile count on X axis
+    int m_nTilesZ;                 // Tile count on Z axis
+
+    dReal* m_pBoundsPyramid;   // Raw sample min/max pairs per pyramid node, level 0 first (NULL if not built)
+    int m_nBoundsLevels;       // Number of pyramid levels
+    int m_anBoundsLevelWidth[HEIGHTFIELD_BOUNDS_MAX_LEVELS];  // Pyramid node count on X axis per level
+    int m_anBoundsLevelDepth[HEIGHTFIELD_BOUNDS_MAX_LEVELS];  // Pyramid node count on Z axis per level
+    int m_anBoundsLevelOffset[HEIGHTFIELD_BOUNDS_MAX_LEVELS]; // Index of the first node of each level
 
     dxHeightfieldData();
     ~dxHeightfieldData();
@@ -87,6 +179,21 @@ struct dxHeightfieldData
 
     void ComputeHeightBounds();
 
+    void BuildBoundsPyramid();
+    void FreeBoundsPyramid();
+    void AccumulateBounds( int nLevel, int nNodeX, int nNodeZ,
+        int nMinTileX, int nMaxTileX, int nMinTileZ, int nMaxTileZ,
+        dReal &fMin, dReal &fMax ) const;
+    bool GetCellRangeHeightBounds( int nMinCellX, int nMaxCellX, int nMinCellZ, int nMaxCellZ,
+        dReal &fMinHeight, dReal &fMaxHeight ) const;
+    bool CullZone( int &nMinX, int &nMaxX, int &nMinZ, int &nMaxZ, dReal fMinO2Height ) const;
+    dReal GetSampleValue( int x, int z ) const;
+
+    const float* AcquireTile( int nTileX, int nTileZ );
+    bool GetTileMaxHeight( int nTileX, int nTileZ, dReal &fMaxHeight ) const;
+    void EvictTile( int nTileX, int nTileZ );
+    void FreeTiles();
+
     bool IsOnHeightfield2  ( const HeightFieldVertex * const CellCorner, 
         const dReal * const pos,  const bool isABC) const;
 
@@ -204,6 +311,14 @@ struct dxHeightfield : public dxGeom
     void computeAABB();
 
     int dCollideHeightfieldZone( const int minX, const int maxX, const int minZ, const int maxZ,  
+        dxGeom *o2, const int numMaxContacts,
+        int flags, dContactGeom *contact, int skip,
+        const dxHeightfieldTileOwnership *pOwnership/*=NULL*/ );
+
+    int dCollideHeightfieldRay( dxGeom *o2, const int numMaxContacts,
+        dContactGeom *contact, int skip );
+
+    int dCollideHeightfieldTiles( const int minX, const int maxX, const int minZ, const int maxZ,
         dxGeom *o2, const int numMaxContacts,
         int flags, dContactGeom *contact, int skip );
 
@@ -223,6 +338,8 @@ struct dxHeightfield : public dxGeom
     void  resetPlaneBuffer();
     void  allocateHeightBuffer(size_t numX, size_t numZ);
     void  resetHeightBuffer();
+    void  allocateSampleBlock(size_t numSamples);
+    void  resetSampleBlock();
 
     void  sortPlanes(const size_t numPlanes);
 
@@ -238,6 +355,9 @@ struct dxHeightfield : public dxGeom
     size_t              tempHeightBufferSizeX;
     size_t              tempHeightBufferSizeZ;
 
+    dReal               *tempSampleBlock;       // Raw samples requested from block callback
+    size_t              tempSampleBlockSize;
+
 };
 
 
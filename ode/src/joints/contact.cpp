@@ -31,8 +31,8 @@
 //****************************************************************************
 // contact
 
-dxJointContact::dxJointContact( dxWorld *w ) :
-    dxJoint( w )
+dxJointContact::dxJointContact( dxWorld *w, bool link_to_world/*=true*/ ) :
+    dxJoint( w, link_to_world )
 {
 }
 
@@ -40,7 +40,7 @@ transform is the identity.
 
 extern void addObjectToList( dObject *obj, dObject **first );
 
-dxJoint::dxJoint( dxWorld *w ) :
+dxJoint::dxJoint( dxWorld *w, bool link_to_world/*=true*/ ) :
     dObject( w )
 {
     //printf("constructing %p\n", this);
@@ -54,9 +54,12 @@ dxJoint::dxJoint( dxWorld *w ) :
     node[1].next = 0;
     dSetZero( lambda, 6 );
 
-    addObjectToList( this, ( dObject ** ) &w->firstjoint );
+    if ( link_to_world )
+    {
+        addObjectToList( this, ( dObject ** ) &w->firstjoint );
+        w->nj++;
+    }
 
-    w->nj++;
     feedback = 0;
 }
 
@@ -78,6 +81,46 @@ bool dxJoint::isEnabled() const
 }
 
 
+dxJointGroup::~dxJointGroup()
+{
+    if (m_segments != NULL) {
+        for (unsigned i = 0; i != m_segment_count; ++i) {
+            delete m_segments[i];
+        }
+        dFree(m_segments, m_segment_count * sizeof(dxJointGroupSegment *));
+    }
+}
+
+bool dxJointGroup::initConcurrent(dxWorld *w, unsigned segment_count)
+{
+    dIASSERT(m_segments == NULL && segment_count != 0);
+
+    dxJointGroupSegment **segments = (dxJointGroupSegment **)dAlloc(segment_count * sizeof(dxJointGroupSegment *));
+    if (segments == NULL) {
+        return false;
+    }
+
+    // the segments are allocated separately so that the threads filling them
+    // do not share cache lines
+    for (unsigned i = 0; i != segment_count; ++i) {
+        segments[i] = new dxJointGroupSegment();
+    }
+
+    m_world = w;
+    m_segments = segments;
+    m_segment_count = segment_count;
+    return true;
+}
+
+size_t dxJointGroup::getJointCount() const
+{
+    size_t num = m_num;
+    for (unsigned i = 0; i != m_segment_count; ++i) {
+        num += m_segments[i]->m_num;
+    }
+    return num;
+}
+
 size_t dxJointGroup::exportJoints(dxJoint **jlist)
 {
     size_t i=0;
@@ -86,6 +129,14 @@ size_t dxJointGroup::exportJoints(dxJoint **jlist)
         jlist[i++] = j;
         j = (dxJoint*) (m_stack.next (j->size()));
     }
+    for (unsigned s = 0; s != m_segment_count; ++s) {
+        dObStack &segment_stack = m_segments[s]->m_stack;
+        j = (dxJoint*) segment_stack.rewind();
+        while (j != NULL) {
+            jlist[i++] = j;
+            j = (dxJoint*) (segment_stack.next (j->size()));
+        }
+    }
     return i;
 }
 
@@ -93,6 +144,13 @@ void dxJointGroup::freeAll()
 {
     m_num = 0;
     m_stack.freeAll();
+
+    for (unsigned i = 0; i != m_segment_count; ++i) {
+        dxJointGroupSegment *segment = m_segments[i];
+        dIASSERT(segment->m_unlinked_first == NULL);
+        segment->m_num = 0;
+        segment->m_stack.freeAll();
+    }
 }
 
 
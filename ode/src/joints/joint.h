@@ -46,7 +46,12 @@ enum
     // it must have either zero or two bodies attached.
     dJOINT_TWOBODIES = 4,
 
-    dJOINT_DISABLED = 8
+    dJOINT_DISABLED = 8,
+
+    // if this flag is set, the joint was created in a concurrent joint group
+    // segment and has not been linked into the world and body lists yet.
+    // the bodies to attach to are kept in node[0].body and node[1].body.
+    dJOINT_UNLINKED = 16
 };
 
 
@@ -198,7 +203,7 @@ struct dxJoint : public dObject
     dReal lambda[6];            // lambda generated by last step
 
 
-    dxJoint( dxWorld *w );
+    dxJoint( dxWorld *w, bool link_to_world = true );
     virtual ~dxJoint();
 
     bool GetIsJointReverse() const { return (this->flags & dJOINT_REVERSE) != 0; }
@@ -250,7 +255,8 @@ struct dxJoint : public dObject
 
 struct dxJointGroup : public dBase
 {
-    dxJointGroup(): m_num(0), m_stack() {}
+    dxJointGroup(): m_num(0), m_stack(), m_world(NULL), m_segments(NULL), m_segment_count(0), m_next_concurrent(NULL) {}
+    ~dxJointGroup();
 
     template<class T>
     T *alloc(dWorldID w)
@@ -264,7 +270,7 @@ struct dxJointGroup : public dBase
         return j;
     }
 
-    size_t getJointCount() const { return m_num; }
+    size_t getJointCount() const;
     size_t exportJoints(dxJoint **jlist);
 
     void *beginEnum() { return m_stack.rewind(); }
@@ -272,9 +278,72 @@ struct dxJointGroup : public dBase
 
     void freeAll();
 
+    // concurrent groups have their joints allocated in segments, one segment per
+    // creating thread. the joints are linked into the world serially later.
+    bool initConcurrent(dxWorld *w, unsigned segment_count);
+    bool isConcurrent() const { return m_segments != NULL; }
+    unsigned getSegmentCount() const { return m_segment_count; }
+    dxWorld *getWorld() const { return m_world; }
+    void detachFromWorld() { m_world = NULL; }
+
+    dxJointGroup *getNextConcurrent() const { return m_next_concurrent; }
+    void setNextConcurrent(dxJointGroup *next_group) { m_next_concurrent = next_group; }
+
+    template<class T>
+    T *allocUnlinked(unsigned segment_index)
+    {
+        dIASSERT(segment_index < m_segment_count);
+        dxJointGroupSegment *segment = m_segments[segment_index];
+
+        T *j = (T *)segment->m_stack.alloc(sizeof(T));
+        if (j != NULL) {
+            ++segment->m_num;
+            new(j) T(m_world, false);
+            j->flags |= dJOINT_INGROUP | dJOINT_UNLINKED;
+
+            // the unlinked joints are chained through their `next' pointers
+            // in the order of creation
+            if (segment->m_unlinked_last != NULL) {
+                segment->m_unlinked_last->next = j;
+            } else {
+                segment->m_unlinked_first = j;
+            }
+            segment->m_unlinked_last = j;
+        }
+        return j;
+    }
+
+    dxJoint *extractUnlinkedJoints(unsigned segment_index)
+    {
+        dxJointGroupSegment *segment = m_segments[segment_index];
+        dxJoint *first = segment->m_unlinked_first;
+        segment->m_unlinked_first = NULL;
+        segment->m_unlinked_last = NULL;
+        return first;
+    }
+
+    void *beginSegmentEnum(unsigned segment_index) { return m_segments[segment_index]->m_stack.rewind(); }
+    void *continueSegmentEnum(unsigned segment_index, size_t num_bytes) { return m_segments[segment_index]->m_stack.next(num_bytes); }
+
+private:
+    struct dxJointGroupSegment : public dBase
+    {
+        dxJointGroupSegment(): m_num(0), m_stack(), m_unlinked_first(NULL), m_unlinked_last(NULL) {}
+
+        size_t m_num;
+        dObStack m_stack;
+        dxJoint *m_unlinked_first;
+        dxJoint *m_unlinked_last;
+    };
+
 private:
     size_t m_num;        // number of joints on the stack
     dObStack m_stack; // a stack of (possibly differently sized) dxJoint objects.
+
+    dxWorld *m_world;                       // world of a concurrent group
+    dxJointGroupSegment **m_segments;       // per thread segments of a concurrent group
+    unsigned m_segment_count;
+    dxJointGroup *m_next_concurrent;        // next concurrent group of the world
 };
 
 // common limit and motor information for a single joint axis of movement
@@ -26,6 +26,7 @@
 #include "matrix.h"
 #include "error.h"
 #include "odeou.h"
+#include "util.h"
 
 //****************************************************************************
 // random numbers
@@ -75,14 +76,11 @@ int dTestRand()
 
 
 // adam's all-int straightforward(?) dRandInt (0..n-1)
-int dRandInt (int n)
+static inline 
+int dxMapRandToRange(duint32 r, int n)
 {
     int result;
-    // Since there is no memory barrier macro in ODE assign via volatile variable 
-    // to prevent compiler reusing seed as value of `r'
-    volatile unsigned long raw_r = dRand();
-    duint32 r = (duint32)raw_r;
-    
+
     duint32 un = n;
     dIASSERT(sizeof(n) == sizeof(un));
 
@@ -138,6 +136,32 @@ int dRandInt (int n)
     return result;
 }
 
+int dRandInt (int n)
+{
+    // Since there is no memory barrier macro in ODE assign via volatile variable 
+    // to prevent compiler reusing seed as value of `r'
+    volatile unsigned long raw_r = dRand();
+    duint32 r = (duint32)raw_r;
+
+    return dxMapRandToRange(r, n);
+}
+
+
+// The counterparts of dRand() and dRandInt() advancing a caller owned state
+// instead of the global seed. They are not thread safe for a shared state.
+unsigned long dxRandSeeded (duint32 *state)
+{
+    duint32 newSeed = ((duint32)1664525 * *state + (duint32)1013904223) & (duint32)0xffffffff;
+    *state = newSeed;
+    return newSeed;
+}
+
+int dxRandIntSeeded (duint32 *state, int n)
+{
+    duint32 r = (duint32)dxRandSeeded(state);
+    return dxMapRandToRange(r, n);
+}
+
 
 dReal dRandReal()
 {
@@ -30,6 +30,8 @@
 #include "matrix.h"
 #include "objects.h"
 #include "util.h"
+#include "collision_kernel.h"
+#include "profile.h"
 #include "threading_impl.h"
 
 
@@ -95,6 +97,12 @@ dxWorld::dxWorld():
     body_flags(0),
     islands_max_threads(dWORLDSTEP_THREADCOUNT_UNLIMITED),
     wmem(NULL),
+    step_request(NULL),
+    firstconcurrentgroup(NULL),
+    step_deterministic(false),
+    step_random_seed(0),
+    step_profile(NULL),
+    sweep_candidates(NULL),
     qs(NULL),
     contactp(NULL),
     dampingp(NULL),
@@ -108,6 +116,13 @@ dxWorld::dxWorld():
 
 dxWorld::~dxWorld()
 {
+    if (step_profile)
+    {
+        step_profile->Destroy();
+    }
+
+    dxFreeSweepCandidates(this);
+
     if (wmem)
     {
         wmem->CleanupWorldReferences(this);
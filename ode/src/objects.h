@@ -36,6 +36,7 @@
 
 class dxStepWorkingMemory;
 class dxWorldProcessContext;
+struct dxStepProfile;
 
 // some body flags
 
@@ -48,7 +49,8 @@ enum {
     dxBodyLinearDamping =             32, // use linear damping
     dxBodyAngularDamping =            64, // use angular damping
     dxBodyMaxAngularSpeed =           128,// use maximum angular speed
-    dxBodyGyroscopic =                256 // use gyroscopic term
+    dxBodyGyroscopic =                256,// use gyroscopic term
+    dxBodyGeomsMovePending =          512 // geoms are to be notified of the step move (deterministic stepping)
 };
 
 
@@ -154,6 +156,9 @@ struct dxBody : public dObject {
     dxDampingParameters dampingp; // damping parameters, depends on flags
     dReal max_angular_speed;      // limit the angular velocity to this magnitude
 
+    dSpaceID ccd_space;		// space swept for continuous collision, 0=none
+    dGeomID ccd_proxy;		// capsule sweeping the CCD sphere
+
     dxBody(dxWorld *w);
 };
 
@@ -169,6 +174,12 @@ struct dxWorld : public dBase, public dxThreadingBase, private dxIThreadingDefau
     int body_flags;               // flags for new bodies
     unsigned islands_max_threads; // maximum threads to allocate for island processing
     dxStepWorkingMemory *wmem; // Working memory object for dWorldStep/dWorldQuickStep
+    dxWorldStepRequest *step_request; // Asynchronous step in progress, if any
+    dxJointGroup *firstconcurrentgroup; // Concurrent joint groups with joints to be linked before stepping
+    bool step_deterministic;      // results of stepping must not depend on threads
+    duint32 step_random_seed;     // seed for the random sequences of the next step
+    dxStepProfile *step_profile;  // Step profiling events, if enabled
+    struct dxSweepCandidates *sweep_candidates; // Static geoms swept by CCD bodies in the step in progress
 
     dxQuickStepParameters qs;
     dxContactParameters contactp;
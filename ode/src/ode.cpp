@@ -37,7 +37,9 @@
 #include "joints/joints.h"
 #include "step.h"
 #include "quickstep.h"
+#include "frame.h"
 #include "util.h"
+#include "profile.h"
 #include "odetls.h"
 
 // misc defines
@@ -280,6 +282,9 @@ dxBody *dBodyCreate (dxWorld *w)
 
     b->flags |= dxBodyGyroscopic;
 
+    b->ccd_space = NULL;
+    b->ccd_proxy = NULL;
+
     return b;
 }
 
@@ -312,6 +317,11 @@ void dBodyDestroy (dxBody *b)
     removeObjectFromList (b);
     b->world->nb--;
 
+    if (b->ccd_proxy) {
+        // the proxy's own space destroys it too
+        dSpaceDestroy (dGeomGetSpace (b->ccd_proxy));
+    }
+
     // delete the average buffers
     if(b->average_lvel_buffer)
     {
@@ -1110,6 +1120,42 @@ void dBodySetMaxAngularSpeed(dBodyID b, dReal max_speed)
     b->max_angular_speed = max_speed;
 }
 
+void dBodySetCCD(dBodyID b, dSpaceID space, dReal radius)
+{
+    dAASSERT(b);
+    dUASSERT(!space || dGeomIsSpace((dGeomID)space), "argument not a space");
+    if (space) {
+        dUASSERT(radius > 0, "CCD radius must be positive");
+        if (b->ccd_proxy)
+            dGeomCapsuleSetParams(b->ccd_proxy, radius, 0);
+        else {
+            // The proxy is kept in a space of its own so that the TLS kind 
+            // the colliders see for it can follow the geoms swept against
+            b->ccd_proxy = dCreateCapsule(dSimpleSpaceCreate(0), radius, 0);
+        }
+    }
+    else if (b->ccd_proxy) {
+        dSpaceDestroy(dGeomGetSpace(b->ccd_proxy));
+        b->ccd_proxy = NULL;
+    }
+    b->ccd_space = space;
+}
+
+dSpaceID dBodyGetCCDSpace(dBodyID b)
+{
+    dAASSERT(b);
+    return b->ccd_space;
+}
+
+dReal dBodyGetCCDRadius(dBodyID b)
+{
+    dAASSERT(b);
+    dReal radius = 0, length;
+    if (b->ccd_proxy)
+        dGeomCapsuleGetParams(b->ccd_proxy, &radius, &length);
+    return radius;
+}
+
 void dBodySetMovedCallback(dBodyID b, void (*callback)(dBodyID))
 {
     dAASSERT(b);
@@ -1198,6 +1244,29 @@ dxJoint * dJointCreateContact (dWorldID w, dJointGroupID group,
 }
 
 
+dxJoint * dJointCreateContactConcurrent (dJointGroupID group, unsigned segment,
+                                         const dContact *c, dBodyID b1, dBodyID b2)
+{
+    dAASSERT (group && c);
+    dUASSERT (group->isConcurrent(), "joint group is not concurrent");
+    dUASSERT (segment < group->getSegmentCount(), "bad segment index");
+    dUASSERT (group->getWorld(), "world of the group has been destroyed");
+    dUASSERT (b1 == NULL || b1 != b2, "can't have body1==body2");
+    dUASSERT ((b1 == NULL || b1->world == group->getWorld()) &&
+        (b2 == NULL || b2->world == group->getWorld()),
+        "joint and bodies must be in same world");
+
+    dxJointContact *j = group->allocUnlinked<dxJointContact>(segment);
+    if (j != NULL) {
+        j->contact = *c;
+        // the bodies are attached when the joint is linked
+        j->node[0].body = b1;
+        j->node[1].body = b2;
+    }
+    return j;
+}
+
+
 dxJoint * dJointCreateHinge2 (dWorldID w, dJointGroupID group)
 {
     dAASSERT (w);
@@ -1313,17 +1382,96 @@ dJointGroupID dJointGroupCreate (int /*max_size*/)
 }
 
 
+dJointGroupID dJointGroupCreateConcurrent (dWorldID w, unsigned segment_count)
+{
+    dUASSERT (w,"bad world argument");
+    dUASSERT (segment_count != 0,"segment count must be > 0");
+
+    dxJointGroup *group = new dxJointGroup();
+    if (!group->initConcurrent(w, segment_count)) {
+        delete group;
+        return NULL;
+    }
+
+    group->setNextConcurrent(w->firstconcurrentgroup);
+    w->firstconcurrentgroup = group;
+    return group;
+}
+
+
+static void unregisterConcurrentJointGroup (dxJointGroup *group)
+{
+    dxWorld *w = group->getWorld();
+    if (w != NULL) {
+        if (w->firstconcurrentgroup == group) {
+            w->firstconcurrentgroup = group->getNextConcurrent();
+        }
+        else {
+            dxJointGroup *previous = w->firstconcurrentgroup;
+            while (previous->getNextConcurrent() != group) {
+                previous = previous->getNextConcurrent();
+                dIASSERT(previous != NULL);
+            }
+            previous->setNextConcurrent(group->getNextConcurrent());
+        }
+        group->detachFromWorld();
+    }
+}
+
+
 void dJointGroupDestroy (dJointGroupID group)
 {
     dAASSERT (group);
     dJointGroupEmpty (group);
+    if (group->isConcurrent()) {
+        unregisterConcurrentJointGroup (group);
+    }
     delete group;
 }
 
+void dJointGroupLinkJoints (dJointGroupID group)
+{
+    dAASSERT (group);
+    dUASSERT (group->isConcurrent(), "joint group is not concurrent");
+
+    const unsigned segment_count = group->getSegmentCount();
+    for (unsigned segment = 0; segment != segment_count; ++segment) {
+        dxJoint *next;
+        for (dxJoint *j = group->extractUnlinkedJoints(segment); j != NULL; j = next) {
+            next = (dxJoint *)j->next;
+
+            dxBody *body1 = j->node[0].body, *body2 = j->node[1].body;
+            j->node[0].body = NULL;
+            j->node[1].body = NULL;
+            j->next = NULL;
+            j->flags &= ~dJOINT_UNLINKED;
+
+            // the world may have been destroyed since the joint was created
+            if (j->world != NULL) {
+                addObjectToList (j, (dObject **) &j->world->firstjoint);
+                j->world->nj++;
+                dJointAttach (j, body1, body2);
+            }
+        }
+    }
+}
+
+static void linkWorldConcurrentJointGroups (dxWorld *w)
+{
+    for (dxJointGroup *group = w->firstconcurrentgroup; group != NULL; group = group->getNextConcurrent()) {
+        dJointGroupLinkJoints (group);
+    }
+}
+
 void dJointGroupEmpty (dJointGroupID group)
 {
     dAASSERT (group);
 
+    if (group->isConcurrent()) {
+        // unlinked joints are linked first so that they are all destroyed the same way
+        dJointGroupLinkJoints (group);
+    }
+
     const size_t num_joints = group->getJointCount();
     if (num_joints != 0) {
         // Local array is used since ALLOCA leads to mysterious NULL values in first array element and crashes under VS2005 :)
@@ -1353,6 +1501,14 @@ void dJointGroupEmpty (dJointGroupID group)
                 joint_bytes = j->size(); // Get size before object is destroyed!
                 FinalizeAndDestroyJointInstance(j, false);
             }
+
+            const unsigned segment_count = group->getSegmentCount();
+            for (unsigned segment = 0; segment != segment_count; ++segment) {
+                for (dxJoint *j = (dxJoint *)group->beginSegmentEnum(segment); j != NULL; j = (dxJoint *)group->continueSegmentEnum(segment, joint_bytes)) {
+                    joint_bytes = j->size(); // Get size before object is destroyed!
+                    FinalizeAndDestroyJointInstance(j, false);
+                }
+            }
         }
 
         group->freeAll();
@@ -1383,6 +1539,7 @@ void dJointAttach (dxJoint *joint, dxBody *body1, dxBody *body2)
     // check arguments
     dUASSERT (joint,"bad joint argument");
     dUASSERT (body1 == NULL || body1 != body2, "can't have body1==body2");
+    dUASSERT (!(joint->flags & dJOINT_UNLINKED), "joint has not been linked into the world yet");
     dxWorld *world = joint->world;
     dUASSERT ( (body1 == NULL || body1->world == world) &&
         (body2 == NULL || body2->world == world),
@@ -1589,6 +1746,14 @@ void dWorldDestroy (dxWorld *w)
 {
     // delete all bodies and joints
     dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    // concurrent groups' joints are linked to be deactivated together with other grouped joints
+    while (w->firstconcurrentgroup != NULL) {
+        dxJointGroup *group = w->firstconcurrentgroup;
+        dJointGroupLinkJoints (group);
+        unregisterConcurrentJointGroup (group);
+    }
     dxBody *nextb, *b = w->firstbody;
     while (b) {
         nextb = (dxBody*) b->next;
@@ -1684,6 +1849,7 @@ dReal dWorldGetCFM (dWorldID w)
 void dWorldSetStepIslandsProcessingMaxThreadCount(dWorldID w, unsigned count)
 {
     dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
     w->islands_max_threads = count;
 }
 
@@ -1693,9 +1859,113 @@ unsigned dWorldGetStepIslandsProcessingMaxThreadCount(dWorldID w)
     return w->islands_max_threads;
 }
 
+void dWorldSetStepDeterministic(dWorldID w, int mode)
+{
+    dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
+    w->step_deterministic = mode != 0;
+}
+
+int dWorldGetStepDeterministic(dWorldID w)
+{
+    dAASSERT (w);
+    return w->step_deterministic;
+}
+
+void dWorldSetStepRandomSeed(dWorldID w, unsigned long seed)
+{
+    dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
+    w->step_random_seed = (duint32)seed;
+}
+
+unsigned long dWorldGetStepRandomSeed(dWorldID w)
+{
+    dAASSERT (w);
+    return w->step_random_seed;
+}
+
+int dWorldSetStepProfiling(dWorldID w, unsigned max_events)
+{
+    dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    dxStepProfile *oldProfile = w->step_profile;
+    w->step_profile = NULL;
+
+    if (oldProfile != NULL) {
+        oldProfile->Destroy();
+    }
+
+    bool result = true;
+
+    if (max_events != 0) {
+        dxStepProfile *newProfile = dxStepProfile::Create(max_events);
+        w->step_profile = newProfile;
+        result = newProfile != NULL;
+    }
+
+    return result;
+}
+
+unsigned dWorldGetStepProfiling(dWorldID w)
+{
+    dAASSERT (w);
+    dxStepProfile *profile = w->step_profile;
+    return profile != NULL ? profile->GetEventCapacity() : 0;
+}
+
+void dWorldResetStepProfile(dWorldID w)
+{
+    dAASSERT (w);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    dxStepProfile *profile = w->step_profile;
+    if (profile != NULL) {
+        profile->Reset();
+    }
+}
+
+unsigned dWorldGetStepProfileDroppedEventCount(dWorldID w)
+{
+    dAASSERT (w);
+    dxStepProfile *profile = w->step_profile;
+    return profile != NULL ? profile->GetDroppedEventCount() : 0;
+}
+
+unsigned dWorldGetStepProfileEvents(dWorldID w, dWorldStepProfileEvent *events, unsigned max_count)
+{
+    dAASSERT (w);
+    dAASSERT (events != NULL || max_count == 0);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    dxStepProfile *profile = w->step_profile;
+    return profile != NULL ? profile->RetrieveEvents(events, max_count) : 0;
+}
+
+unsigned dWorldGetStepProfileThreadStats(dWorldID w, dWorldStepProfileThreadStats *stats, unsigned max_count)
+{
+    dAASSERT (w);
+    dAASSERT (stats != NULL || max_count == 0);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    dxStepProfile *profile = w->step_profile;
+    return profile != NULL ? profile->RetrieveThreadStats(stats, max_count) : 0;
+}
+
+int dWorldWriteStepProfileTrace(dWorldID w, FILE *f)
+{
+    dAASSERT (w && f);
+    dUASSERT (!w->step_request, "world step is in progress");
+
+    dxStepProfile *profile = w->step_profile;
+    return profile != NULL && profile->WriteTrace(f);
+}
+
 int dWorldUseSharedWorkingMemory(dWorldID w, dWorldID from_world)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
 
     bool result = false;
 
@@ -1740,6 +2010,7 @@ int dWorldUseSharedWorkingMemory(dWorldID w, dWorldID from_world)
 void dWorldCleanupWorkingMemory(dWorldID w)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
 
     dxStepWorkingMemory *wmem = w->wmem;
 
@@ -1752,6 +2023,7 @@ void dWorldCleanupWorkingMemory(dWorldID w)
 int dWorldSetStepMemoryReservationPolicy(dWorldID w, const dWorldStepReserveInfo *policyinfo)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
     dUASSERT (!policyinfo || (policyinfo->struct_size >= sizeof(*policyinfo) && policyinfo->reserve_factor >= 1.0f), "Bad policy info");
 
     bool result = false;
@@ -1782,6 +2054,7 @@ int dWorldSetStepMemoryReservationPolicy(dWorldID w, const dWorldStepReserveInfo
 int dWorldSetStepMemoryManager(dWorldID w, const dWorldStepMemoryFunctionsInfo *memfuncs)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
     dUASSERT (!memfuncs || memfuncs->struct_size >= sizeof(*memfuncs), "Bad memory functions info");
 
     bool result = false;
@@ -1809,10 +2082,40 @@ int dWorldSetStepMemoryManager(dWorldID w, const dWorldStepMemoryFunctionsInfo *
     return result;
 }
 
+int dWorldSetStepMemoryNUMANode(dWorldID w, int numa_node)
+{
+    dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
+    dUASSERT (numa_node >= -1, "Bad NUMA node index");
+
+    bool result = false;
+
+    if (numa_node < 0 || dxIsNUMAMemoryPlacementSupported())
+    {
+        dxStepWorkingMemory *wmem = numa_node >= 0 ? AllocateOnDemand(w->wmem) : w->wmem;
+
+        if (wmem)
+        {
+            wmem->SetMemoryNUMANode(numa_node);
+            result = numa_node < 0 || wmem->GetMemoryManager() != NULL;
+
+            // Release the memory allocated so far for it to be placed anew on the next step
+            wmem->CleanupMemory();
+        }
+        else if (numa_node < 0)
+        {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
 void dWorldSetStepThreadingImplementation(dWorldID w, 
     const dxThreadingFunctionsInfo *functions_info, dThreadingImplementationID threading_impl)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
     dUASSERT (!functions_info || functions_info->struct_size >= sizeof(*functions_info), "Bad threading functions info");
 
 #if dTHREADING_INTF_DISABLED
@@ -1823,11 +2126,20 @@ void dWorldSetStepThreadingImplementation(dWorldID w,
 }
 
 
+static inline bool IsWorkingMemoryInAsyncStep (dWorldID w)
+{
+    return w->wmem != NULL && w->wmem->GetAsyncStepWorld() != NULL;
+}
+
 int dWorldStep (dWorldID w, dReal stepsize)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
+    dUASSERT (!IsWorkingMemoryInAsyncStep (w), "world shares working memory with a world being stepped asynchronously");
     dUASSERT (stepsize > 0,"stepsize must be > 0");
 
+    linkWorldConcurrentJointGroups (w);
+
     bool result = false;
 
     dxWorldProcessIslandsInfo islandsinfo;
@@ -1845,8 +2157,12 @@ int dWorldStep (dWorldID w, dReal stepsize)
 int dWorldQuickStep (dWorldID w, dReal stepsize)
 {
     dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
+    dUASSERT (!IsWorkingMemoryInAsyncStep (w), "world shares working memory with a world being stepped asynchronously");
     dUASSERT (stepsize > 0,"stepsize must be > 0");
 
+    linkWorldConcurrentJointGroups (w);
+
     bool result = false;
 
     dxWorldProcessIslandsInfo islandsinfo;
@@ -1862,6 +2178,153 @@ int dWorldQuickStep (dWorldID w, dReal stepsize)
 }
 
 
+static dWorldStepRequestID StartWorldStepAsync (dWorldID w, dReal stepsize, 
+    dmemestimate_fn_t stepperestimate, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxcallcountestimate)
+{
+    dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
+    dUASSERT (!IsWorkingMemoryInAsyncStep (w), "world shares working memory with a world being stepped asynchronously");
+    dUASSERT (stepsize > 0,"stepsize must be > 0");
+
+    linkWorldConcurrentJointGroups (w);
+
+    dxWorldStepRequest *request = dxStartProcessingIslands (w, stepsize, stepperestimate, stepper, maxcallcountestimate);
+    w->step_request = request;
+
+    if (request != NULL) {
+        // The working memory is in use until the request is waited for
+        w->wmem->AssignAsyncStepWorld (w);
+    }
+
+    return request;
+}
+
+dWorldStepRequestID dWorldStepAsync (dWorldID w, dReal stepsize)
+{
+    return StartWorldStepAsync (w, stepsize, 
+        &dxEstimateStepMemoryRequirements, &dxStepIsland, &dxEstimateStepMaxCallCount);
+}
+
+dWorldStepRequestID dWorldQuickStepAsync (dWorldID w, dReal stepsize)
+{
+    return StartWorldStepAsync (w, stepsize, 
+        &dxEstimateQuickStepMemoryRequirements, &dxQuickStepIsland, &dxEstimateQuickStepMaxCallCount);
+}
+
+int dWorldStepRequestPoll (dWorldStepRequestID request)
+{
+    dAASSERT (request);
+
+    bool result = dxPollProcessingIslands (request);
+    return result;
+}
+
+int dWorldStepRequestWait (dWorldStepRequestID request)
+{
+    dAASSERT (request);
+
+    dxWorld *w = dxGetProcessingIslandsWorld (request);
+    dIASSERT (w->step_request == request);
+
+    bool result = dxFinishProcessingIslands (request);
+    w->step_request = NULL;
+    w->wmem->AssignAsyncStepWorld (NULL);
+
+    return result;
+}
+
+dWorldID dWorldStepRequestGetWorld (dWorldStepRequestID request)
+{
+    dAASSERT (request);
+    return dxGetProcessingIslandsWorld (request);
+}
+
+static void CheckFrameArguments (dWorldID w, dSpaceID space, 
+    const dWorldFrameParameters *parameters, dReal stepsize)
+{
+    dUASSERT (w,"bad world argument");
+    dUASSERT (!w->step_request, "world step is in progress");
+    dUASSERT (space,"bad space argument");
+    dUASSERT (parameters && parameters->struct_size >= sizeof(*parameters), "Bad frame parameters");
+    dUASSERT (parameters->max_contacts != 0 && parameters->max_contacts <= 0xFFFF, "Bad frame contact count");
+    dUASSERT (parameters->contact_group, "bad contact group");
+    dUASSERT (stepsize > 0,"stepsize must be > 0");
+}
+
+int dWorldStepFrame (dWorldID w, dSpaceID space, 
+    const dWorldFrameParameters *parameters, dReal stepsize)
+{
+    CheckFrameArguments (w, space, parameters, stepsize);
+
+    bool result = dxCollideWorldFrame (w, space, parameters) 
+        && dWorldStep (w, stepsize);
+    return result;
+}
+
+int dWorldQuickStepFrame (dWorldID w, dSpaceID space, 
+    const dWorldFrameParameters *parameters, dReal stepsize)
+{
+    CheckFrameArguments (w, space, parameters, stepsize);
+
+    bool result = dxCollideWorldFrame (w, space, parameters) 
+        && dWorldQuickStep (w, stepsize);
+    return result;
+}
+
+static void CheckWorldsBatch (dWorldID *worlds, unsigned world_count)
+{
+    dUASSERT (worlds && world_count != 0, "bad worlds argument");
+
+#ifndef dNODEBUG
+    for (unsigned i = 0; i != world_count; ++i) {
+        dUASSERT (worlds[i], "bad world in batch");
+        dUASSERT (!worlds[i]->step_request, "world step is in progress");
+        dUASSERT (!IsWorkingMemoryInAsyncStep (worlds[i]), "world shares working memory with a world being stepped asynchronously");
+        dUASSERT (worlds[i]->IsThreadingImplSharedWith(worlds[0]), "worlds in batch must share threading implementation");
+
+        for (unsigned j = 0; j != i; ++j) {
+            dUASSERT (worlds[i] != worlds[j], "world is repeated in batch");
+            dUASSERT (worlds[i]->wmem == NULL || worlds[i]->wmem != worlds[j]->wmem, "worlds in batch must not share working memory");
+        }
+    }
+#else
+    (void)worlds; // unused
+    (void)world_count; // unused
+#endif
+}
+
+static void LinkWorldsBatchConcurrentJointGroups (dWorldID *worlds, unsigned world_count)
+{
+    for (unsigned i = 0; i != world_count; ++i) {
+        linkWorldConcurrentJointGroups (worlds[i]);
+    }
+}
+
+int dWorldStepBatch (dWorldID *worlds, unsigned world_count, dReal stepsize)
+{
+    CheckWorldsBatch (worlds, world_count);
+    dUASSERT (stepsize > 0,"stepsize must be > 0");
+
+    LinkWorldsBatchConcurrentJointGroups (worlds, world_count);
+
+    bool result = dxProcessIslandsBatch (worlds, world_count, stepsize, 
+        &dxEstimateStepMemoryRequirements, &dxStepIsland, &dxEstimateStepMaxCallCount);
+    return result;
+}
+
+int dWorldQuickStepBatch (dWorldID *worlds, unsigned world_count, dReal stepsize)
+{
+    CheckWorldsBatch (worlds, world_count);
+    dUASSERT (stepsize > 0,"stepsize must be > 0");
+
+    LinkWorldsBatchConcurrentJointGroups (worlds, world_count);
+
+    bool result = dxProcessIslandsBatch (worlds, world_count, stepsize, 
+        &dxEstimateQuickStepMemoryRequirements, &dxQuickStepIsland, &dxEstimateQuickStepMaxCallCount);
+    return result;
+}
+
+
 void dWorldImpulseToForce (dWorldID w, dReal stepsize,
                            dReal ix, dReal iy, dReal iz,
                            dVector3 force)
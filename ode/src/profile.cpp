@@ -0,0 +1,396 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+// World step profiling (dWorldSetStepProfiling)
+
+#include <ode/ode.h>
+#include "config.h"
+#include "objects.h"
+#include "profile.h"
+#include "threadingutils.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+// The key is taken for every event and must not cost a system call.
+// It only tells the threads apart and is not shown to the user.
+static uintptr_t GetCurrentThreadKey()
+{
+#if defined(_WIN32)
+    return (uintptr_t)GetCurrentThreadId();
+#else
+    return (uintptr_t)pthread_self();
+#endif
+}
+
+// Formats the time in microseconds with three decimals. The decimal point
+// is written explicitly as printf would use the one of the current locale.
+static const char *FormatTraceMicroseconds(char *buffer, double seconds)
+{
+    const double nanoseconds = floor(seconds * 1.0e9 + 0.5);
+    const double wholeMicroseconds = floor(nanoseconds * 1.0e-3);
+    const unsigned fractionNanoseconds = (unsigned)(nanoseconds - wholeMicroseconds * 1.0e3);
+
+    sprintf(buffer, "%.0f.%03u", wholeMicroseconds, fractionNanoseconds < 1000U ? fractionNanoseconds : 999U);
+    return buffer;
+}
+
+
+struct dxStepProfileExportItem
+{
+    dWorldStepProfileEvent  m_event;
+    uintptr_t               m_threadKey;
+    double                  m_endTime;
+};
+
+static int CompareExportItems(const void *a, const void *b)
+{
+    const dxStepProfileExportItem *item1 = (const dxStepProfileExportItem *)a;
+    const dxStepProfileExportItem *item2 = (const dxStepProfileExportItem *)b;
+
+    // Enclosing events are to precede the nested ones
+    return item1->m_event.start_time != item2->m_event.start_time 
+        ? (item1->m_event.start_time < item2->m_event.start_time ? -1 : 1)
+        : item1->m_endTime != item2->m_endTime 
+        ? (item1->m_endTime > item2->m_endTime ? -1 : 1)
+        : item1->m_event.kind - item2->m_event.kind;
+}
+
+
+/*static */
+dxStepProfile *dxStepProfile::Create(unsigned eventCapacity)
+{
+    dxStepProfile *result = NULL;
+
+    dIASSERT(eventCapacity != 0);
+    dxStepProfileRecord *records = (dxStepProfileRecord *)dAlloc(eventCapacity * sizeof(dxStepProfileRecord));
+
+    if (records != NULL) {
+        result = new dxStepProfile(records, eventCapacity);
+
+        if (result == NULL) {
+            dFree(records, eventCapacity * sizeof(dxStepProfileRecord));
+        }
+    }
+
+    return result;
+}
+
+dxStepProfile::dxStepProfile(dxStepProfileRecord *records, unsigned recordCapacity):
+    m_records(records), m_recordCapacity(recordCapacity), m_recordCount(0), m_droppedEventCount(0), 
+    m_stepIndex(0), m_threadedPhasesTime(0.0), m_originTime(0.0)
+{
+    Reset();
+}
+
+void dxStepProfile::Destroy()
+{
+    dFree(m_records, m_recordCapacity * sizeof(dxStepProfileRecord));
+    delete this;
+}
+
+void dxStepProfile::Reset()
+{
+    m_recordCount = 0;
+    m_droppedEventCount = 0;
+    m_stepIndex = 0;
+    m_threadedPhasesTime = 0.0;
+    m_originTime = dxGetMonotonicTime();
+}
+
+
+bool dxStepProfile::RecordEvent(int kind, const char *name, unsigned islandIndex, double startTime, double endTime)
+{
+    bool result = false;
+
+    unsigned recordIndex = ThrsafeIncrementIntUpToLimit(&m_recordCount, m_recordCapacity);
+
+    if (recordIndex != m_recordCapacity) {
+        dxStepProfileRecord *record = m_records + recordIndex;
+        record->m_name = name;
+        record->m_kind = kind;
+        record->m_stepIndex = m_stepIndex;
+        record->m_islandIndex = islandIndex;
+        record->m_threadKey = GetCurrentThreadKey();
+        record->m_startTime = startTime;
+        record->m_endTime = endTime;
+        result = true;
+    }
+    else {
+        ThrsafeAdd(&m_droppedEventCount, 1);
+    }
+
+    return result;
+}
+
+// The world level phases executed by the threads of the threading implementation 
+// are the reference time for the thread idle time. Only the phases recorded are accounted
+// for the idle time to remain consistent with the busy time once the buffer gets full.
+void dxStepProfile::RecordThreadedPhase(const char *name, double startTime, double endTime)
+{
+    if (RecordEvent(dSTEPPROFILE_EVENT_WORLD, name, dSTEPPROFILE_NO_ISLAND, startTime, endTime)) {
+        m_threadedPhasesTime += endTime - startTime;
+    }
+}
+
+
+bool dxStepProfile::BuildExport(dxStepProfileExportItem *&outItems, unsigned &outItemCount, 
+    dWorldStepProfileThreadStats *&outThreadStats, unsigned &outThreadCount) const
+{
+    bool result = false;
+
+    const unsigned itemCount = m_recordCount;
+    dxStepProfileExportItem *items = NULL;
+    uintptr_t *threadKeys = NULL;
+    unsigned *stageStack = NULL;
+    dWorldStepProfileThreadStats *threadStats = NULL;
+    unsigned threadCount = 0;
+
+    do {
+        if (itemCount == 0) {
+            outItems = NULL;
+            outItemCount = 0;
+            outThreadStats = NULL;
+            outThreadCount = 0;
+            result = true;
+            break;
+        }
+
+        items = (dxStepProfileExportItem *)dAlloc(itemCount * sizeof(dxStepProfileExportItem));
+        threadKeys = (uintptr_t *)dAlloc(itemCount * sizeof(uintptr_t));
+        stageStack = (unsigned *)dAlloc(itemCount * sizeof(unsigned));
+        if (items == NULL || threadKeys == NULL || stageStack == NULL) {
+            break;
+        }
+
+        for (unsigned recordIndex = 0; recordIndex != itemCount; ++recordIndex) {
+            const dxStepProfileRecord *record = m_records + recordIndex;
+            dxStepProfileExportItem *item = items + recordIndex;
+            item->m_event.name = record->m_name;
+            item->m_event.kind = record->m_kind;
+            item->m_event.step_index = record->m_stepIndex;
+            item->m_event.island_index = record->m_islandIndex;
+            item->m_event.thread_index = 0;
+            item->m_event.start_time = record->m_startTime;
+            item->m_event.duration = record->m_endTime - record->m_startTime;
+            item->m_event.self_time = item->m_event.duration;
+            item->m_threadKey = record->m_threadKey;
+            item->m_endTime = record->m_endTime;
+        }
+
+        qsort(items, itemCount, sizeof(dxStepProfileExportItem), &CompareExportItems);
+
+        // Number the threads in the order of their first events
+        for (unsigned itemIndex = 0; itemIndex != itemCount; ++itemIndex) {
+            dxStepProfileExportItem *item = items + itemIndex;
+
+            unsigned threadIndex = 0;
+            for (; threadIndex != threadCount && threadKeys[threadIndex] != item->m_threadKey; ++threadIndex) {}
+
+            if (threadIndex == threadCount) {
+                threadKeys[threadCount++] = item->m_threadKey;
+            }
+
+            item->m_event.thread_index = threadIndex;
+        }
+
+        threadStats = (dWorldStepProfileThreadStats *)dAlloc(threadCount * sizeof(dWorldStepProfileThreadStats));
+        if (threadStats == NULL) {
+            break;
+        }
+
+        // Stage events of a thread either nest or do not overlap at all. Only the outermost 
+        // ones are accounted as busy time and the nested ones are excluded from self times.
+        for (unsigned threadIndex = 0; threadIndex != threadCount; ++threadIndex) {
+            dWorldStepProfileThreadStats *stats = threadStats + threadIndex;
+            stats->busy_time = 0.0;
+            stats->stage_count = 0;
+
+            unsigned stackSize = 0;
+
+            for (unsigned itemIndex = 0; itemIndex != itemCount; ++itemIndex) {
+                dxStepProfileExportItem *item = items + itemIndex;
+
+                if (item->m_event.kind == dSTEPPROFILE_EVENT_STAGE && item->m_event.thread_index == threadIndex) {
+                    while (stackSize != 0 && items[stageStack[stackSize - 1]].m_endTime < item->m_endTime) {
+                        --stackSize;
+                    }
+
+                    if (stackSize != 0) {
+                        items[stageStack[stackSize - 1]].m_event.self_time -= item->m_event.duration;
+                    }
+                    else {
+                        stats->busy_time += item->m_event.duration;
+                    }
+
+                    stats->stage_count += 1;
+                    stageStack[stackSize++] = itemIndex;
+                }
+            }
+
+            stats->idle_time = dMACRO_MAX(m_threadedPhasesTime - stats->busy_time, 0.0);
+        }
+
+        outItems = items;
+        outItemCount = itemCount;
+        outThreadStats = threadStats;
+        outThreadCount = threadCount;
+        items = NULL;
+        threadStats = NULL;
+        result = true;
+    }
+    while (false);
+
+    if (stageStack != NULL) {
+        dFree(stageStack, itemCount * sizeof(unsigned));
+    }
+
+    if (threadKeys != NULL) {
+        dFree(threadKeys, itemCount * sizeof(uintptr_t));
+    }
+
+    FreeExport(items, itemCount, threadStats, threadCount);
+
+    return result;
+}
+
+void dxStepProfile::FreeExport(dxStepProfileExportItem *items, unsigned itemCount, 
+    dWorldStepProfileThreadStats *threadStats, unsigned threadCount) const
+{
+    if (threadStats != NULL) {
+        dFree(threadStats, threadCount * sizeof(dWorldStepProfileThreadStats));
+    }
+
+    if (items != NULL) {
+        dFree(items, itemCount * sizeof(dxStepProfileExportItem));
+    }
+}
+
+
+unsigned dxStepProfile::RetrieveEvents(dWorldStepProfileEvent *events, unsigned maxCount) const
+{
+    unsigned result = 0;
+
+    dxStepProfileExportItem *items;
+    unsigned itemCount;
+    dWorldStepProfileThreadStats *threadStats;
+    unsigned threadCount;
+
+    if (BuildExport(items, itemCount, threadStats, threadCount)) {
+        const unsigned copyCount = dMACRO_MIN(itemCount, maxCount);
+        for (unsigned itemIndex = 0; itemIndex != copyCount; ++itemIndex) {
+            events[itemIndex] = items[itemIndex].m_event;
+        }
+
+        FreeExport(items, itemCount, threadStats, threadCount);
+        result = itemCount;
+    }
+
+    return result;
+}
+
+unsigned dxStepProfile::RetrieveThreadStats(dWorldStepProfileThreadStats *stats, unsigned maxCount) const
+{
+    unsigned result = 0;
+
+    dxStepProfileExportItem *items;
+    unsigned itemCount;
+    dWorldStepProfileThreadStats *threadStats;
+    unsigned threadCount;
+
+    if (BuildExport(items, itemCount, threadStats, threadCount)) {
+        const unsigned copyCount = dMACRO_MIN(threadCount, maxCount);
+        for (unsigned threadIndex = 0; threadIndex != copyCount; ++threadIndex) {
+            stats[threadIndex] = threadStats[threadIndex];
+        }
+
+        FreeExport(items, itemCount, threadStats, threadCount);
+        result = threadCount;
+    }
+
+    return result;
+}
+
+
+// Chrome trace event format: complete ("X") events nest within a thread track 
+// while island spans may cross threads and are written as async ("b"/"e") pairs.
+bool dxStepProfile::WriteTrace(FILE *f) const
+{
+    bool result = false;
+
+    dxStepProfileExportItem *items;
+    unsigned itemCount;
+    dWorldStepProfileThreadStats *threadStats;
+    unsigned threadCount;
+
+    if (BuildExport(items, itemCount, threadStats, threadCount)) {
+        const char *separator = "";
+        char startBuffer[32], endBuffer[32];
+
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+        for (unsigned threadIndex = 0; threadIndex != threadCount; ++threadIndex) {
+            fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", 
+                separator, threadIndex, threadIndex);
+            separator = ",";
+        }
+
+        for (unsigned itemIndex = 0; itemIndex != itemCount; ++itemIndex) {
+            const dWorldStepProfileEvent *event = &items[itemIndex].m_event;
+
+            if (event->kind == dSTEPPROFILE_EVENT_WORLD || event->kind == dSTEPPROFILE_EVENT_STAGE) {
+                const char *category = event->kind == dSTEPPROFILE_EVENT_WORLD ? "world" : "stage";
+                fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%s,\"dur\":%s,\"args\":{\"step\":%u", 
+                    separator, event->name, category, event->thread_index, FormatTraceMicroseconds(startBuffer, event->start_time), 
+                    FormatTraceMicroseconds(endBuffer, event->duration), event->step_index);
+            }
+            else {
+                const char *category = event->kind == dSTEPPROFILE_EVENT_ISLAND ? "island" : "queued";
+                fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"b\",\"id\":\"%u.%u\",\"pid\":1,\"tid\":%u,\"ts\":%s}", 
+                    separator, event->name, category, event->step_index, event->island_index, event->thread_index, FormatTraceMicroseconds(startBuffer, event->start_time));
+                fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"e\",\"id\":\"%u.%u\",\"pid\":1,\"tid\":%u,\"ts\":%s,\"args\":{\"step\":%u", 
+                    event->name, category, event->step_index, event->island_index, event->thread_index, FormatTraceMicroseconds(endBuffer, event->start_time + event->duration), event->step_index);
+            }
+
+            if (event->island_index != dSTEPPROFILE_NO_ISLAND) {
+                fprintf(f, ",\"island\":%u", event->island_index);
+            }
+
+            fprintf(f, "}}");
+            separator = ",";
+        }
+
+        fprintf(f, "\n]}\n");
+
+        FreeExport(items, itemCount, threadStats, threadCount);
+        result = !ferror(f);
+    }
+
+    return result;
+}
@@ -0,0 +1,131 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+#ifndef _ODE_PROFILE_H_
+#define _ODE_PROFILE_H_
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include "objects.h"
+#include "util.h"
+#include "odeou.h"
+
+
+struct dxStepProfileRecord
+{
+    const char      *m_name;
+    int             m_kind;
+    unsigned        m_stepIndex;
+    unsigned        m_islandIndex;
+    uintptr_t       m_threadKey;
+    double          m_startTime;
+    double          m_endTime;
+};
+
+struct dxStepProfileExportItem;
+
+// Per-world recording of world step profile events (see dWorldSetStepProfiling).
+// Events are appended without locks from any thread, while the other methods 
+// must only be called when the world is not being stepped.
+struct dxStepProfile:
+    public dBase
+{
+    static dxStepProfile *Create(unsigned eventCapacity);
+    void Destroy();
+
+    unsigned GetEventCapacity() const { return m_recordCapacity; }
+    unsigned GetDroppedEventCount() const { return m_droppedEventCount; }
+
+    void Reset();
+    void FinishStep() { m_stepIndex += 1; }
+
+    double GetCurrentTime() const
+    {
+        return dxGetMonotonicTime() - m_originTime;
+    }
+
+    bool RecordEvent(int kind, const char *name, unsigned islandIndex, double startTime, double endTime);
+    void RecordThreadedPhase(const char *name, double startTime, double endTime);
+
+    unsigned RetrieveEvents(dWorldStepProfileEvent *events, unsigned maxCount) const;
+    unsigned RetrieveThreadStats(dWorldStepProfileThreadStats *stats, unsigned maxCount) const;
+    bool WriteTrace(FILE *f) const;
+
+private:
+    dxStepProfile(dxStepProfileRecord *records, unsigned recordCapacity);
+    friend struct dBase; // To avoid GCC warning regarding private destructor
+    ~dxStepProfile() {}
+
+    bool BuildExport(dxStepProfileExportItem *&outItems, unsigned &outItemCount, 
+        dWorldStepProfileThreadStats *&outThreadStats, unsigned &outThreadCount) const;
+    void FreeExport(dxStepProfileExportItem *items, unsigned itemCount, 
+        dWorldStepProfileThreadStats *threadStats, unsigned threadCount) const;
+
+private:
+    dxStepProfileRecord     *m_records;
+    unsigned                m_recordCapacity;
+    volatile atomicord32    m_recordCount;
+    volatile atomicord32    m_droppedEventCount;
+    unsigned                m_stepIndex;
+    double                  m_threadedPhasesTime;
+    double                  m_originTime; // The monotonic clock time the profile has been reset at
+};
+
+
+// Records an event for the scope lifetime if the profile is present
+class dxStepProfileScope
+{
+public:
+    dxStepProfileScope(dxStepProfile *profile, int kind, const char *name, unsigned islandIndex=dSTEPPROFILE_NO_ISLAND):
+        m_profile(profile), m_name(name), m_kind(kind), m_islandIndex(islandIndex), 
+        m_startTime(profile != NULL ? profile->GetCurrentTime() : 0.0)
+    {
+    }
+
+    ~dxStepProfileScope()
+    {
+        if (m_profile != NULL) {
+            m_profile->RecordEvent(m_kind, m_name, m_islandIndex, m_startTime, m_profile->GetCurrentTime());
+        }
+    }
+
+private:
+    dxStepProfile   *m_profile;
+    const char      *m_name;
+    int             m_kind;
+    unsigned        m_islandIndex;
+    double          m_startTime;
+};
+
+// Records a stepper stage part executed by the current thread
+class dxStepProfileStageScope:
+    public dxStepProfileScope
+{
+public:
+    dxStepProfileStageScope(const dxStepperProcessingCallContext *callContext, const char *stageName):
+        dxStepProfileScope(callContext->m_world->step_profile, dSTEPPROFILE_EVENT_STAGE, stageName, callContext->m_islandIndex)
+    {
+    }
+};
+
+
+#endif
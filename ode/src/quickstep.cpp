@@ -32,6 +32,7 @@
 #include "joints/joint.h"
 #include "lcp.h"
 #include "util.h"
+#include "profile.h"
 #include "threadingutils.h"
 
 #include <new>
@@ -84,6 +85,10 @@ struct IndexError;
 #define dMAX(A,B)  ((B)>(A) ? (B) : (A))
 
 
+// TODO: The stage steps below are fixed work chunk sizes that also bound each stage's thread count.
+// They should be tuned from per-stage times measured online as the island cost model in util.cpp
+// does for whole islands. That needs the steps turned from template arguments of the chunked
+// loops into values computed per island, and stage timing that does not add synchronization.
 #define dxQUICKSTEPISLAND_STAGE2B_STEP  16U
 #define dxQUICKSTEPISLAND_STAGE2C_STEP  32U
 
@@ -644,6 +649,8 @@ struct dxQuickStepperStage4CallContext
         m_LCP_iteration = 0;
         m_cf_4b = 0;
         m_ji_4b = 0;
+        m_SOR_reorderHeadRandomSeed = callContext->m_islandRandomSeed;
+        m_SOR_reorderTailRandomSeed = ~callContext->m_islandRandomSeed;
     }
 
     void AssignLCP_IterationData(dCallReleaseeID releaseeInstance, unsigned int iterationAllowedThreads)
@@ -716,6 +723,8 @@ struct dxQuickStepperStage4CallContext
     volatile atomicord32            m_SOR_mi_zeroHeadTaken;
     volatile atomicord32            m_SOR_mi_zeroTailTaken;
     volatile atomicord32            m_SOR_reorderThreadsRemaining;
+    duint32                         m_SOR_reorderHeadRandomSeed; // Head and tail are reordered by different threads and need sequences of their own
+    duint32                         m_SOR_reorderTailRandomSeed;
     volatile atomicord32            m_cf_4b;
     volatile atomicord32            m_ji_4b;
 };
@@ -1093,6 +1102,8 @@ int dxQuickStepIsland_Stage0_Bodies_Callback(void *_callContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage0_Bodies(dxQuickStepperStage0BodiesCallContext *callContext)
 {
+    dxStepProfileStageScope profileScope(callContext->m_stepperCallContext, "QuickStepIsland Stage0-Bodies");
+
     dxBody * const *body = callContext->m_stepperCallContext->m_islandBodiesStart;
     unsigned int nb = callContext->m_stepperCallContext->m_islandBodiesCount;
 
@@ -1236,6 +1247,8 @@ int dxQuickStepIsland_Stage0_Joints_Callback(void *_callContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage0_Joints(dxQuickStepperStage0JointsCallContext *callContext)
 {
+    dxStepProfileStageScope profileScope(callContext->m_stepperCallContext, "QuickStepIsland Stage0-Joints");
+
     dxJoint * const *_joint = callContext->m_stepperCallContext->m_islandJointsStart;
     unsigned int _nj = callContext->m_stepperCallContext->m_islandJointsCount;
 
@@ -1281,6 +1294,8 @@ int dxQuickStepIsland_Stage1_Callback(void *_stage1CallContext, dcallindex_t cal
 static 
 void dxQuickStepIsland_Stage1(dxQuickStepperStage1CallContext *stage1CallContext)
 {
+    dxStepProfileStageScope profileScope(stage1CallContext->m_stepperCallContext, "QuickStepIsland Stage1");
+
     const dxStepperProcessingCallContext *callContext = stage1CallContext->m_stepperCallContext;
     dReal *invI = stage1CallContext->m_invI;
     dJointWithInfo1 *jointinfos = stage1CallContext->m_jointinfos;
@@ -1403,6 +1418,8 @@ int dxQuickStepIsland_Stage2a_Callback(void *_stage2CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage2a(dxQuickStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "QuickStepIsland Stage2a");
+
     const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     dxQuickStepperLocalContext *localContext = stage2CallContext->m_localContext;
     dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
@@ -1560,6 +1577,8 @@ int dxQuickStepIsland_Stage2b_Callback(void *_stage2CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage2b(dxQuickStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "QuickStepIsland Stage2b");
+
     const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage2CallContext->m_localContext;
 
@@ -1643,6 +1662,8 @@ int dxQuickStepIsland_Stage2c_Callback(void *_stage2CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage2c(dxQuickStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "QuickStepIsland Stage2c");
+
     //const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage2CallContext->m_localContext;
 
@@ -1677,6 +1698,8 @@ int dxQuickStepIsland_Stage3_Callback(void *_stage3CallContext, dcallindex_t cal
 static 
 void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext)
 {
+    dxStepProfileStageScope profileScope(stage3CallContext->m_stepperCallContext, "QuickStepIsland Stage3");
+
     const dxStepperProcessingCallContext *callContext = stage3CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage3CallContext->m_localContext;
 
@@ -1815,6 +1838,8 @@ int dxQuickStepIsland_Stage4a_Callback(void *_stage4CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage4a(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4a");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -1872,6 +1897,8 @@ int dxQuickStepIsland_Stage4LCP_iMJ_Callback(void *_stage4CallContext, dcallinde
 static 
 void dxQuickStepIsland_Stage4LCP_iMJComputation(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_iMJ");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -1963,6 +1990,8 @@ int dxQuickStepIsland_Stage4LCP_fc_Callback(void *_stage4CallContext, dcallindex
 static 
 void dxQuickStepIsland_Stage4LCP_MTfcComputation(dxQuickStepperStage4CallContext *stage4CallContext, dCallReleaseeID callThisReleasee)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_fc");
+
 #ifdef WARM_STARTING
     dxQuickStepIsland_Stage4LCP_MTfcComputation_warm(stage4CallContext, callThisReleasee);
 #else
@@ -2033,6 +2062,8 @@ int dxQuickStepIsland_Stage4LCP_fcWarmComplete_Callback(void *_stage4CallContext
 static 
 void dxQuickStepIsland_Stage4LCP_MTfcComputation_warmComplete(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_fcWarmComplete");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -2073,6 +2104,8 @@ void dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(dxQuickStepperStage4CallCo
 static 
 void dxQuickStepIsland_Stage4LCP_STfcComputation(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_fc");
+
 #ifdef WARM_STARTING
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
@@ -2110,6 +2143,8 @@ int dxQuickStepIsland_Stage4LCP_Ad_Callback(void *_stage4CallContext, dcallindex
 static 
 void dxQuickStepIsland_Stage4LCP_AdComputation(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_Ad");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -2188,6 +2223,8 @@ int dxQuickStepIsland_Stage4LCP_ReorderPrep_Callback(void *_stage4CallContext, d
 static 
 void dxQuickStepIsland_Stage4LCP_ReorderPrep(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_ReorderPrep");
+
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
     unsigned int m = localContext->m_m;
     unsigned int valid_findices = localContext->m_valid_findices;
@@ -2308,6 +2345,8 @@ int dxQuickStepIsland_Stage4LCP_ConstraintsReordering_Callback(void *_stage4Call
 static 
 void dxQuickStepIsland_Stage4LCP_ConstraintsReordering(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_ConstraintsReordering");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
 
     unsigned int iteration = stage4CallContext->m_LCP_iteration - 1; // Iteration is pre-incremented before scheduled tasks are released for execution
@@ -2400,12 +2439,16 @@ bool dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(dxQuickStepperStage4CallCo
 #elif CONSTRAINTS_REORDERING_METHOD == REORDERING_METHOD__RANDOMLY
     struct ConstraintsReorderingHelper
     {
-        void operator ()(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int startIndex, unsigned int indicesCount)
+        void operator ()(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int startIndex, unsigned int indicesCount, duint32 *randomSeed)
         {
             IndexError *order = stage4CallContext->m_order + startIndex;
 
+            // The global sequence is shared by all the islands being stepped and 
+            // the values they obtain depend on thread timing
+            const bool useIslandSequence = stage4CallContext->m_stepperCallContext->m_world->step_deterministic;
+
             for (unsigned int index = 1; index < indicesCount; ++index) {
-                int swapIndex = dRandInt(index + 1);
+                int swapIndex = !useIslandSequence ? dRandInt(index + 1) : dxRandIntSeeded(randomSeed, index + 1);
                 IndexError tmp = order[index];
                 order[index] = order[swapIndex];
                 order[swapIndex] = tmp;
@@ -2416,13 +2459,13 @@ bool dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(dxQuickStepperStage4CallCo
     if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderHeadTaken, 1) == 0) {
         // Process the head
         const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
-        ConstraintsReorderingHelper()(stage4CallContext, 0, localContext->m_m - localContext->m_valid_findices);
+        ConstraintsReorderingHelper()(stage4CallContext, 0, localContext->m_m - localContext->m_valid_findices, &stage4CallContext->m_SOR_reorderHeadRandomSeed);
     }
 
     if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderTailTaken, 1) == 0) {
         // Process the tail
         const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
-        ConstraintsReorderingHelper()(stage4CallContext, localContext->m_m - localContext->m_valid_findices, localContext->m_valid_findices);
+        ConstraintsReorderingHelper()(stage4CallContext, localContext->m_m - localContext->m_valid_findices, localContext->m_valid_findices, &stage4CallContext->m_SOR_reorderTailRandomSeed);
     }
 
     result = true;
@@ -2570,6 +2613,8 @@ int dxQuickStepIsland_Stage4LCP_Iteration_Callback(void *_stage4CallContext, dca
 static 
 void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int initiallyKnownToBeCompletedLevel)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_Iteration");
+
     atomicord32 *mi_levels = stage4CallContext->m_bi_links_or_mi_levels;
     atomicord32 *mi_links = stage4CallContext->m_mi_links;
 
@@ -2656,6 +2701,8 @@ void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *st
 static 
 void dxQuickStepIsland_Stage4LCP_STIteration(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4LCP_Iteration");
+
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
     unsigned int m = localContext->m_m;
@@ -2832,6 +2879,8 @@ int dxQuickStepIsland_Stage4b_Callback(void *_stage4CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "QuickStepIsland Stage4b");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -2934,6 +2983,8 @@ int dxQuickStepIsland_Stage5_Callback(void *_stage5CallContext, dcallindex_t cal
 static 
 void dxQuickStepIsland_Stage5(dxQuickStepperStage5CallContext *stage5CallContext)
 {
+    dxStepProfileStageScope profileScope(stage5CallContext->m_stepperCallContext, "QuickStepIsland Stage5");
+
     const dxStepperProcessingCallContext *callContext = stage5CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage5CallContext->m_localContext;
 
@@ -2989,6 +3040,8 @@ int dxQuickStepIsland_Stage6a_Callback(void *_stage6CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage6a(dxQuickStepperStage6CallContext *stage6CallContext)
 {
+    dxStepProfileStageScope profileScope(stage6CallContext->m_stepperCallContext, "QuickStepIsland Stage6a");
+
     const dxStepperProcessingCallContext *callContext = stage6CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage6CallContext->m_localContext;
 
@@ -3099,6 +3152,8 @@ int dxQuickStepIsland_Stage6b_Callback(void *_stage6CallContext, dcallindex_t ca
 static 
 void dxQuickStepIsland_Stage6b(dxQuickStepperStage6CallContext *stage6CallContext)
 {
+    dxStepProfileStageScope profileScope(stage6CallContext->m_stepperCallContext, "QuickStepIsland Stage6b");
+
     const dxStepperProcessingCallContext *callContext = stage6CallContext->m_stepperCallContext;
 
     dReal stepsize = callContext->m_stepSize;
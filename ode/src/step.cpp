@@ -31,6 +31,7 @@
 #include "joints/joint.h"
 #include "lcp.h"
 #include "util.h"
+#include "profile.h"
 #include "threadingutils.h"
 
 #include <new>
@@ -575,6 +576,8 @@ int dxStepIsland_Stage0_Bodies_Callback(void *_callContext, dcallindex_t callIns
 static 
 void dxStepIsland_Stage0_Bodies(dxStepperStage0BodiesCallContext *callContext)
 {
+    dxStepProfileStageScope profileScope(callContext->m_stepperCallContext, "StepIsland Stage0-Bodies");
+
     dxBody * const *body = callContext->m_stepperCallContext->m_islandBodiesStart;
     unsigned int nb = callContext->m_stepperCallContext->m_islandBodiesCount;
 
@@ -724,6 +727,8 @@ void dxStepIsland_Stage0_Bodies(dxStepperStage0BodiesCallContext *callContext)
 static 
 void dxStepIsland_Stage0_Joints(dxStepperStage0JointsCallContext *callContext)
 {
+    dxStepProfileStageScope profileScope(callContext->m_stepperCallContext, "StepIsland Stage0-Joints");
+
     dxJoint * const *_joint = callContext->m_stepperCallContext->m_islandJointsStart;
     dJointWithInfo1 *jointinfos = callContext->m_jointinfos;
     unsigned int _nj = callContext->m_stepperCallContext->m_islandJointsCount;
@@ -891,6 +896,8 @@ int dxStepIsland_Stage1_Callback(void *_stage1CallContext, dcallindex_t callInst
 static 
 void dxStepIsland_Stage1(dxStepperStage1CallContext *stage1CallContext)
 {
+    dxStepProfileStageScope profileScope(stage1CallContext->m_stepperCallContext, "StepIsland Stage1");
+
     const dxStepperProcessingCallContext *callContext = stage1CallContext->m_stepperCallContext;
     dJointWithInfo1 *_jointinfos = stage1CallContext->m_jointinfos;
     dReal *invI = stage1CallContext->m_invI;
@@ -1018,6 +1025,8 @@ int dxStepIsland_Stage2a_Callback(void *_stage2CallContext, dcallindex_t callIns
 static 
 void dxStepIsland_Stage2a(dxStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "StepIsland Stage2a");
+
     const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     const dxStepperLocalContext *localContext = stage2CallContext->m_localContext;
     dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
@@ -1137,6 +1146,8 @@ int dxStepIsland_Stage2b_Callback(void *_stage2CallContext, dcallindex_t callIns
 static 
 void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "StepIsland Stage2b");
+
     const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     const dxStepperLocalContext *localContext = stage2CallContext->m_localContext;
     dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
@@ -1284,6 +1295,8 @@ int dxStepIsland_Stage2c_Callback(void *_stage2CallContext, dcallindex_t callIns
 static 
 void dxStepIsland_Stage2c(dxStepperStage2CallContext *stage2CallContext)
 {
+    dxStepProfileStageScope profileScope(stage2CallContext->m_stepperCallContext, "StepIsland Stage2c");
+
     //const dxStepperProcessingCallContext *callContext = stage2CallContext->m_stepperCallContext;
     const dxStepperLocalContext *localContext = stage2CallContext->m_localContext;
     dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
@@ -1434,6 +1447,8 @@ int dxStepIsland_Stage3_Callback(void *_stage3CallContext, dcallindex_t callInst
 static 
 void dxStepIsland_Stage3(dxStepperStage3CallContext *stage3CallContext)
 {
+    dxStepProfileStageScope profileScope(stage3CallContext->m_stepperCallContext, "StepIsland Stage3");
+
     const dxStepperProcessingCallContext *callContext = stage3CallContext->m_stepperCallContext;
     const dxStepperLocalContext *localContext = stage3CallContext->m_localContext;
 
@@ -1510,6 +1525,8 @@ int dxStepIsland_Stage4_Callback(void *_stage4CallContext, dcallindex_t callInst
 static 
 void dxStepIsland_Stage4(dxStepperStage4CallContext *stage4CallContext)
 {
+    dxStepProfileStageScope profileScope(stage4CallContext->m_stepperCallContext, "StepIsland Stage4");
+
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
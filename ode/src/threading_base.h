@@ -177,6 +177,14 @@ public:
         return functions->preallocate_resources_for_calls(impl, max_simultaneous_calls_estimate) != 0;
     }
 
+    bool IsThreadingImplSharedWith(const dxThreadingBase *other_base) const
+    {
+        dThreadingImplementationID impl, other_impl;
+        FindThreadingImpl(impl);
+        other_base->FindThreadingImpl(other_impl);
+        return impl == other_impl;
+    }
+
 public:
     void PostThreadedCallsGroup(int *out_summary_fault/*=NULL*/, 
         ddependencycount_t member_count, dCallReleaseeID dependent_releasee/*=NULL*/, 
@@ -63,6 +63,10 @@ public:
 
     bool WaitWakeup(const dThreadedWaitTime *timeout_time_ptr);
 
+public:
+    static void PauseProcessor() { /* Do nothing */ }
+    static void YieldThread() { /* Do nothing */ }
+
 private:
     bool          m_wakeup_state;
     bool          m_state_is_permanent;
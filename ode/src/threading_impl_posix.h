@@ -46,6 +46,7 @@
 #if dBUILTIN_THREADING_IMPL_ENABLED
 
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 #include <errno.h>
 
@@ -102,6 +103,10 @@ public:
 
     bool WaitWakeup(const dThreadedWaitTime *timeout_time_ptr);
 
+public:
+    static void PauseProcessor();
+    static void YieldThread() { sched_yield(); }
+
 private:
     bool BlockAsAWaiter(const dThreadedWaitTime *timeout_time_ptr);
 
@@ -133,6 +138,18 @@ private:
 };
 
 
+void dxCondvarWakeup::PauseProcessor()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__ ("pause" ::: "memory");
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7))
+    __asm__ __volatile__ ("yield" ::: "memory");
+#elif defined(__GNUC__)
+    __asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+
 bool dxCondvarWakeup::DoInitializeObject()
 {
     dIASSERT(!m_object_initialized);
@@ -571,6 +588,74 @@ void dxMutexMutex::UnlockMutex()
 }
 
 
+/************************************************************************/
+/* dxThreadKeySlot class implementation                                 */
+/************************************************************************/
+
+class dxThreadKeySlot
+{
+public:
+    dxThreadKeySlot(): m_key_allocated(false) {}
+    ~dxThreadKeySlot() { DoFinalizeObject(); }
+
+    bool InitializeObject() { return DoInitializeObject(); }
+
+private:
+    bool DoInitializeObject();
+    void DoFinalizeObject();
+
+public:
+    void *GetSlotValue() const { return pthread_getspecific(m_key_instance); }
+    void SetSlotValue(void *value);
+
+private:
+    pthread_key_t       m_key_instance;
+    bool                m_key_allocated;
+};
+
+
+bool dxThreadKeySlot::DoInitializeObject()
+{
+    dIASSERT(!m_key_allocated);
+
+    bool init_result = false;
+
+    do
+    {
+        int key_result = pthread_key_create(&m_key_instance, NULL);
+        if (key_result != EOK)
+        {
+            errno = key_result;
+            break;
+        }
+
+        m_key_allocated = true;
+        init_result = true;
+    }
+    while (false);
+
+    return init_result;
+}
+
+void dxThreadKeySlot::DoFinalizeObject()
+{
+    if (m_key_allocated)
+    {
+        int key_result = pthread_key_delete(m_key_instance);
+        dICHECK(key_result == EOK || ((errno = key_result), false));
+
+        m_key_allocated = false;
+    }
+}
+
+
+void dxThreadKeySlot::SetSlotValue(void *value)
+{
+    int set_result = pthread_setspecific(m_key_instance, value);
+    dICHECK(set_result == EOK || ((errno = set_result), false));
+}
+
+
 #endif // #if dBUILTIN_THREADING_IMPL_ENABLED
 
 
@@ -594,6 +679,17 @@ typedef dxtemplateJobListThreadedHandler<dxCondvarWakeup, dxMultiThreadedJobList
 typedef dxtemplateThreadingImplementation<dxMultiThreadedJobListContainer, dxMultiThreadedJobListHandler> dxMultiThreadedThreading;
 
 
+/************************************************************************/
+/* Work-stealing job list definition                                    */
+/************************************************************************/
+
+#define dWORK_STEALING_JOB_STACK_COUNT 16U
+
+typedef dxtemplateJobStacksContainer<dxtemplateThreadedLull<dxCondvarWakeup, dxOUAtomicsProvider, false>, dxMutexMutex, dxOUAtomicsProvider, dxThreadKeySlot, dWORK_STEALING_JOB_STACK_COUNT> dxWorkStealingJobListContainer;
+typedef dxtemplateJobListThreadedHandler<dxCondvarWakeup, dxWorkStealingJobListContainer> dxWorkStealingJobListHandler;
+typedef dxtemplateThreadingImplementation<dxWorkStealingJobListContainer, dxWorkStealingJobListHandler> dxWorkStealingThreading;
+
+
 #endif // #if dBUILTIN_THREADING_IMPL_ENABLED
 
 
@@ -79,12 +79,32 @@ private:
     tThreadMutex      m_Mutex_array[1];
 };
 
+/*
+ *  Waiting policy: the number of busy-spin and time slice yield iterations
+ *  a thread makes checking for the awaited condition before blocking.
+ *  The all-zero policy blocks immediately.
+ */
+#define dTHREADING_WAIT_DEFAULT_SPIN_COUNT  2000U
+#define dTHREADING_WAIT_DEFAULT_YIELD_COUNT 64U
+
+struct dxThreadingWaitPolicy
+{
+    dxThreadingWaitPolicy(): m_spin_count(0), m_yield_count(0) {}
+    dxThreadingWaitPolicy(unsigned spin_count, unsigned yield_count): m_spin_count(spin_count), m_yield_count(yield_count) {}
+
+    bool IsBlockingImmediately() const { return m_spin_count == 0 && m_yield_count == 0; }
+
+    unsigned                m_spin_count;
+    unsigned                m_yield_count;
+};
+
+
 template<class tThreadWakeup>
 class dxtemplateCallWait:
     public dBase
 {
 public:
-    dxtemplateCallWait() {}
+    dxtemplateCallWait(): m_wait_signaled(false) {}
     ~dxtemplateCallWait() { DoFinalizeObject(); }
 
     bool InitializeObject() { return DoInitializeObject(); }
@@ -97,17 +117,42 @@ public:
     typedef dxtemplateCallWait<tThreadWakeup> dxCallWait;
 
 public:
-    void ResetTheWait() { m_wait_wakeup.ResetWakeup(); }
-    void SignalTheWait() { m_wait_wakeup.WakeupAllThreads(); }
-    bool PerformWaiting(const dThreadedWaitTime *timeout_time_ptr/*=NULL*/) { return m_wait_wakeup.WaitWakeup(timeout_time_ptr); }
+    void ResetTheWait() { m_wait_signaled = false; m_wait_wakeup.ResetWakeup(); }
+    void SignalTheWait() { m_wait_signaled = true; m_wait_wakeup.WakeupAllThreads(); }
+    inline bool PerformWaiting(const dThreadedWaitTime *timeout_time_ptr/*=NULL*/, const dxThreadingWaitPolicy *wait_policy/*=NULL*/);
 
 public:
     static void AbstractSignalTheWait(void *wait_wakeup_ptr) { ((dxCallWait *)wait_wakeup_ptr)->SignalTheWait(); }
 
 private:
+    volatile bool           m_wait_signaled;
     tThreadWakeup           m_wait_wakeup;
 };
 
+template<class tThreadWakeup>
+bool dxtemplateCallWait<tThreadWakeup>::PerformWaiting(const dThreadedWaitTime *timeout_time_ptr/*=NULL*/, const dxThreadingWaitPolicy *wait_policy/*=NULL*/)
+{
+    // A zero timeout is a poll and should not be delayed by spinning
+    bool zero_timeout = timeout_time_ptr != NULL && timeout_time_ptr->wait_sec == 0 && timeout_time_ptr->wait_nsec == 0;
+
+    if (wait_policy != NULL && !zero_timeout)
+    {
+        // Poll the flag first to avoid being put to sleep if the calls are about to complete.
+        // The wakeup object is still waited for after that to synchronize with the signaling thread.
+        for (unsigned spin_index = wait_policy->m_spin_count; spin_index != 0 && !m_wait_signaled; --spin_index)
+        {
+            tThreadWakeup::PauseProcessor();
+        }
+
+        for (unsigned yield_index = wait_policy->m_yield_count; yield_index != 0 && !m_wait_signaled; --yield_index)
+        {
+            tThreadWakeup::YieldThread();
+        }
+    }
+
+    return m_wait_wakeup.WaitWakeup(timeout_time_ptr);
+}
+
 
 #if dBUILTIN_THREADING_IMPL_ENABLED
 
@@ -241,10 +286,15 @@ public:
     typedef dxtemplateThreadingLockHelper<tThreadMutex> dxMutexLockHelper;
     typedef void dWaitSignallingFunction(void *job_call_wait);
 
+public:
+    // There is a single list for all the workers
+    void AttachWorkerThread(unsigned worker_index) { (void)worker_index; }
+    void DetachWorkerThread() {}
+
 public:
     dxThreadedJobInfo *ReleaseAJobAndPickNextPendingOne(
         dxThreadedJobInfo *job_to_release, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, 
-        bool &out_last_job_flag);
+        bool &out_last_job_flag, unsigned worker_index);
 
 private:
     dxThreadedJobInfo *PickNextPendingJob(bool &out_last_job_flag);
@@ -257,13 +307,16 @@ public:
     void AlterJobProcessingDependencies(dxThreadedJobInfo *job_instance, ddependencychange_t dependencies_count_change, 
         bool &out_job_has_become_ready);
 
-private:
+protected:
     inline ddependencycount_t SmartAddJobDependenciesCount(dxThreadedJobInfo *job_instance, ddependencychange_t dependencies_count_change);
 
+private:
     inline void InsertJobInfoIntoListHead(dxThreadedJobInfo *job_instance);
     inline void RemoveJobInfoFromList(dxThreadedJobInfo *job_instance);
 
     dxThreadedJobInfo *ExtractJobInfoFromPoolOrAllocate();
+
+protected:
     inline void ReleaseJobInfoIntoPool(dxThreadedJobInfo *job_instance);
 
 private:
@@ -288,6 +341,110 @@ private:
 };
 
 
+#if dBUILTIN_THREADING_IMPL_ENABLED
+
+/*
+ *  A job list for many threads. Ready jobs are kept in a set of stacks, 
+ *  one per worker (workers beyond the stack count share them), instead of 
+ *  the single list scanned under a global lock. 
+ *  Jobs still waiting for dependencies are not kept anywhere and get pushed 
+ *  by whoever releases their last dependency. A worker pushes the jobs it 
+ *  schedules or makes ready onto its own stack, takes jobs from there and 
+ *  steals from the other stacks when it runs dry. Jobs scheduled by threads 
+ *  which are not workers are spread over the stacks round-robin.
+ *  Pushing is lock free. Extraction is locked per stack, for the same reason 
+ *  as with the info pool, which is inherited from the job list. Thieves take 
+ *  jobs from the top of a stack, like the owner, as the stacks are singly 
+ *  linked lists.
+ */
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+class dxtemplateJobStacksContainer:
+    public dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>
+{
+private:
+    typedef dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider> dxJobListContainer;
+
+public:
+    dxtemplateJobStacksContainer():
+        dxJobListContainer(),
+        m_ready_count(0),
+        m_queued_count(0),
+        m_push_cursor(0)
+    {
+        for (unsigned stack_index = 0; stack_index != tstack_count; ++stack_index)
+        {
+            m_job_stacks[stack_index].m_head = (atomicptr_t)NULL;
+        }
+    }
+
+    ~dxtemplateJobStacksContainer()
+    {
+        dIASSERT(m_queued_count == 0);
+
+        DoFinalizeObject();
+    }
+
+    bool InitializeObject() { return dxJobListContainer::InitializeObject() && DoInitializeObject(); }
+
+private:
+    bool DoInitializeObject();
+    void DoFinalizeObject() { /* Do nothing */ }
+
+public:
+    // The worker index of the current thread, for it to push onto its own stack
+    void AttachWorkerThread(unsigned worker_index) { m_worker_slot.SetSlotValue((void *)(size_t)(worker_index + 1)); }
+    void DetachWorkerThread() { m_worker_slot.SetSlotValue(NULL); }
+
+public:
+    typedef typename dxJobListContainer::dxAtomicsProvider dxAtomicsProvider;
+    typedef typename dxJobListContainer::atomicord_t atomicord_t;
+    typedef typename dxJobListContainer::atomicptr_t atomicptr_t;
+    typedef typename dxJobListContainer::dxThreadMutex dxThreadMutex;
+    typedef typename dxJobListContainer::dxMutexLockHelper dxMutexLockHelper;
+    typedef typename dxJobListContainer::dWaitSignallingFunction dWaitSignallingFunction;
+
+public:
+    dxThreadedJobInfo *ReleaseAJobAndPickNextPendingOne(
+        dxThreadedJobInfo *job_to_release, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, 
+        bool &out_last_job_flag, unsigned worker_index);
+
+private:
+    dxThreadedJobInfo *PickNextPendingJob(bool &out_last_job_flag, unsigned worker_index);
+    void ReleaseAJob(dxThreadedJobInfo *job_instance, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, 
+        unsigned worker_index);
+
+public:
+    void QueueJobForProcessing(dxThreadedJobInfo *job_instance);
+
+    void AlterJobProcessingDependencies(dxThreadedJobInfo *job_instance, ddependencychange_t dependencies_count_change, 
+        bool &out_job_has_become_ready);
+
+private:
+    inline unsigned SelectStackForPush();
+    void PushReadyJob(dxThreadedJobInfo *job_instance, unsigned stack_index);
+    dxThreadedJobInfo *PopReadyJob(unsigned stack_index);
+
+public:
+    bool IsJobListReadyForShutdown() const { return m_queued_count == 0; }
+
+private:
+    struct dxJobStack
+    {
+        volatile atomicptr_t    m_head; // dxThreadedJobInfo *
+        tThreadMutex            m_pop_lock;
+    };
+
+    dxJobStack              m_job_stacks[tstack_count];
+    volatile atomicord_t    m_ready_count; // never less than the jobs in the stacks
+    volatile atomicord_t    m_queued_count; // jobs queued and not picked yet, ready or not
+    volatile atomicord_t    m_push_cursor;
+    tThreadSlot             m_worker_slot; // worker index + 1 of the current thread, NULL for other threads
+};
+
+
+#endif // #if dBUILTIN_THREADING_IMPL_ENABLED
+
+
 typedef void (dxThreadReadyToServeCallback)(void *callback_context);
 
 
@@ -301,7 +458,10 @@ public:
         m_job_list_ptr(list_container_ptr),
         m_processing_wakeup(),
         m_active_thread_count(0),
-        m_shutdown_requested(0)
+        m_wakeup_request_count(0),
+        m_spinning_thread_count(0),
+        m_shutdown_requested(0),
+        m_call_wait_policy()
     {
     }
 
@@ -321,19 +481,26 @@ private:
 public:
     typedef dxtemplateCallWait<tThreadWakeup> dxCallWait;
 
+private:
+    typedef typename tJobListContainer::dxAtomicsProvider dxAtomicsProvider;
+    typedef typename tJobListContainer::atomicord_t atomicord_t;
+
 public:
     inline void ProcessActiveJobAddition();
     inline void PrepareForWaitingAJobCompletion();
+    inline const dxThreadingWaitPolicy *RetrieveCallWaitPolicy();
 
 public:
     inline unsigned RetrieveActiveThreadsCount();
-    inline void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/);
+    inline void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+        const dxThreadingWaitPolicy *wait_policy/*=NULL*/);
 
 private:
-    void PerformJobProcessingUntilShutdown();
-    void PerformJobProcessingSession();
+    void PerformJobProcessingUntilShutdown(unsigned worker_index, const dxThreadingWaitPolicy &wait_policy);
+    void PerformJobProcessingSession(unsigned worker_index);
 
-    void BlockAsIdleThread();
+    void BlockAsIdleThread(const dxThreadingWaitPolicy &wait_policy, atomicord_t wakeup_request_mark);
+    bool SpinForWakeupRequest(const dxThreadingWaitPolicy &wait_policy, atomicord_t wakeup_request_mark);
     void ActivateAnIdleThread();
 
 public:
@@ -344,18 +511,19 @@ private:
     bool IsShutdownRequested() const { return m_shutdown_requested != 0; }
 
 private:
-    typedef typename tJobListContainer::dxAtomicsProvider dxAtomicsProvider;
-    typedef typename tJobListContainer::atomicord_t atomicord_t;
-
+    atomicord_t GetWakeupRequestCount() { return dxAtomicsProvider::QueryTargetValue(&m_wakeup_request_count); }
     atomicord_t GetActiveThreadsCount() const { return m_active_thread_count; }
-    void RegisterAsActiveThread() { dxAtomicsProvider::template AddValueToTarget<sizeof(atomicord_t)>((volatile void *)&m_active_thread_count, 1); }
+    unsigned RegisterAsActiveThread() { return (unsigned)dxAtomicsProvider::template AddValueToTarget<sizeof(atomicord_t)>((volatile void *)&m_active_thread_count, 1); }
     void UnregisterAsActiveThread() { dxAtomicsProvider::template AddValueToTarget<sizeof(atomicord_t)>((volatile void *)&m_active_thread_count, -1); }
 
 private:
     tJobListContainer       *m_job_list_ptr;
     tThreadWakeup           m_processing_wakeup;
     volatile atomicord_t    m_active_thread_count;
+    volatile atomicord_t    m_wakeup_request_count;
+    volatile atomicord_t    m_spinning_thread_count;
     int                     m_shutdown_requested;
+    dxThreadingWaitPolicy   m_call_wait_policy;
 };
 
 
@@ -384,10 +552,12 @@ public:
 public:
     inline void ProcessActiveJobAddition();
     inline void PrepareForWaitingAJobCompletion();
+    inline const dxThreadingWaitPolicy *RetrieveCallWaitPolicy();
 
 public:
     inline unsigned RetrieveActiveThreadsCount();
-    inline void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/);
+    inline void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+        const dxThreadingWaitPolicy *wait_policy/*=NULL*/);
 
 private:
     void PerformJobProcessingUntilExhaustion();
@@ -434,7 +604,8 @@ public:
 
 public:
     virtual unsigned RetrieveActiveThreadsCount() = 0;
-    virtual void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/) = 0;
+    virtual void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+        const dxThreadingWaitPolicy *wait_policy/*=NULL*/) = 0;
     virtual void ShutdownProcessing() = 0;
     virtual void CleanupForRestart() = 0;
 };
@@ -495,7 +666,8 @@ protected:
 
 protected:
     virtual unsigned RetrieveActiveThreadsCount();
-    virtual void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/);
+    virtual void StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+        const dxThreadingWaitPolicy *wait_policy/*=NULL*/);
     virtual void ShutdownProcessing();
     virtual void CleanupForRestart();
 
@@ -594,8 +766,11 @@ void dxtemplateMutexGroup<tThreadMutex>::FinalizeMutexArray(dmutexindex_t Mutex_
 
 template<class tThreadLull, class tThreadMutex, class tAtomicsProvider>
 dxThreadedJobInfo *dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>::ReleaseAJobAndPickNextPendingOne(
-    dxThreadedJobInfo *job_to_release, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, bool &out_last_job_flag)
+    dxThreadedJobInfo *job_to_release, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, bool &out_last_job_flag, 
+    unsigned worker_index)
 {
+    (void)worker_index; // unused - there is a single list for all the workers
+
     if (job_to_release != NULL)
     {
         ReleaseAJob(job_to_release, job_result, wait_signal_proc_ptr);
@@ -660,18 +835,20 @@ void dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>::Re
             break;
         }
 
-        void *job_call_wait = current_job->m_call_wait;
+        int call_fault = current_job->m_call_fault;
 
-        if (job_call_wait != NULL)
+        // The fault must be stored before the wait is signaled as the accumulator 
+        // is likely to be on the waiter's stack which is gone after it wakes up
+        if (current_job->m_fault_accumulator_ptr)
         {
-            wait_signal_proc_ptr(job_call_wait);
+            *current_job->m_fault_accumulator_ptr = call_fault;
         }
 
-        int call_fault = current_job->m_call_fault;
+        void *job_call_wait = current_job->m_call_wait;
 
-        if (current_job->m_fault_accumulator_ptr)
+        if (job_call_wait != NULL)
         {
-            *current_job->m_fault_accumulator_ptr = call_fault;
+            wait_signal_proc_ptr(job_call_wait);
         }
 
         dxThreadedJobInfo *dependent_job = current_job->m_dependent_job;
@@ -907,6 +1084,249 @@ bool dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>::Do
 
 #if dBUILTIN_THREADING_IMPL_ENABLED
 
+/************************************************************************/
+/* Implementation of dxtemplateJobStacksContainer                       */
+/************************************************************************/
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+bool dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::DoInitializeObject()
+{
+    bool result = true;
+
+    for (unsigned stack_index = 0; stack_index != tstack_count; ++stack_index)
+    {
+        if (!m_job_stacks[stack_index].m_pop_lock.InitializeObject())
+        {
+            result = false;
+            break;
+        }
+    }
+
+    if (result && !m_worker_slot.InitializeObject())
+    {
+        result = false;
+    }
+
+    return result;
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+unsigned dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::SelectStackForPush()
+{
+    size_t worker_slot_value = (size_t)m_worker_slot.GetSlotValue();
+
+    unsigned stack_index = worker_slot_value != 0
+        ? (unsigned)(worker_slot_value - 1) % tstack_count
+        : (unsigned)dxAtomicsProvider::template AddValueToTarget<sizeof(atomicord_t)>((volatile void *)&m_push_cursor, 1) % tstack_count;
+    return stack_index;
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+dxThreadedJobInfo *dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::ReleaseAJobAndPickNextPendingOne(
+    dxThreadedJobInfo *job_to_release, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, bool &out_last_job_flag, 
+    unsigned worker_index)
+{
+    if (job_to_release != NULL)
+    {
+        ReleaseAJob(job_to_release, job_result, wait_signal_proc_ptr, worker_index);
+    }
+
+    dxThreadedJobInfo *picked_job = PickNextPendingJob(out_last_job_flag, worker_index);
+    return picked_job;
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+dxThreadedJobInfo *dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::PickNextPendingJob(
+    bool &out_last_job_flag, unsigned worker_index)
+{
+    dxThreadedJobInfo *picked_job = NULL;
+    bool last_job_flag = true;
+
+    if (dxAtomicsProvider::QueryTargetValue(&m_ready_count) != 0)
+    {
+        // Own stack first, then steal from the following ones
+        for (unsigned stack_offset = 0; stack_offset != tstack_count; ++stack_offset)
+        {
+            unsigned stack_index = (worker_index + stack_offset) % tstack_count;
+
+            if (m_job_stacks[stack_index].m_head != (atomicptr_t)NULL)
+            {
+                picked_job = PopReadyJob(stack_index);
+
+                if (picked_job != NULL)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (picked_job != NULL)
+    {
+        // It is OK to assign in unsafe manner - dependencies count should not be changed
+        // after the job has become ready for execution
+        picked_job->m_dependencies_count = 1;
+        // Assign NULL to m_prev_job_next_ptr as an indicator that instance has been dequeued
+        picked_job->m_prev_job_next_ptr = NULL;
+
+        atomicord_t ready_count_left = (atomicord_t)dxAtomicsProvider::template AddValueToTarget<sizeof(atomicord_t)>((volatile void *)&m_ready_count, -1) - 1;
+        last_job_flag = ready_count_left == 0;
+
+        dxAtomicsProvider::DecrementTargetNoRet(&m_queued_count);
+    }
+
+    out_last_job_flag = last_job_flag;
+    return picked_job;
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+void dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::ReleaseAJob(
+    dxThreadedJobInfo *job_instance, bool job_result, dWaitSignallingFunction *wait_signal_proc_ptr, unsigned worker_index)
+{
+    dxThreadedJobInfo *current_job = job_instance;
+
+    if (!job_result)
+    {
+        // Accumulate call fault (be careful to not reset it!!!)
+        current_job->m_call_fault = 1;
+    }
+
+    bool job_dequeued = true;
+    dIASSERT(current_job->m_prev_job_next_ptr == NULL);
+
+    while (true)
+    {
+        dIASSERT(current_job->m_dependencies_count != 0);
+
+        ddependencycount_t new_dependencies_count = this->SmartAddJobDependenciesCount(current_job, -1);
+
+        if (new_dependencies_count != 0)
+        {
+            break;
+        }
+
+        if (!job_dequeued)
+        {
+            // The last dependency is gone - the job is ready to run. 
+            // Keep it with the releasing worker as it is likely to pick it next.
+            PushReadyJob(current_job, worker_index % tstack_count);
+            break;
+        }
+
+        int call_fault = current_job->m_call_fault;
+
+        // The fault must be stored before the wait is signaled as the accumulator 
+        // is likely to be on the waiter's stack which is gone after it wakes up
+        if (current_job->m_fault_accumulator_ptr)
+        {
+            *current_job->m_fault_accumulator_ptr = call_fault;
+        }
+
+        void *job_call_wait = current_job->m_call_wait;
+
+        if (job_call_wait != NULL)
+        {
+            wait_signal_proc_ptr(job_call_wait);
+        }
+
+        dxThreadedJobInfo *dependent_job = current_job->m_dependent_job;
+        this->ReleaseJobInfoIntoPool(current_job);
+
+        if (dependent_job == NULL)
+        {
+            break;
+        }
+
+        if (call_fault)
+        {
+            // Accumulate call fault (be careful to not reset it!!!)
+            dependent_job->m_call_fault = 1;
+        }
+
+        current_job = dependent_job;
+        job_dequeued = dependent_job->m_prev_job_next_ptr == NULL;
+    }
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+void dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::QueueJobForProcessing(dxThreadedJobInfo *job_instance)
+{
+    // Any non-NULL value indicates that the instance has not been dequeued yet
+    job_instance->m_prev_job_next_ptr = &job_instance->m_next_job;
+    dxAtomicsProvider::IncrementTargetNoRet(&m_queued_count);
+
+    if (job_instance->m_dependencies_count == 0)
+    {
+        PushReadyJob(job_instance, SelectStackForPush());
+    }
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+void dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::AlterJobProcessingDependencies(dxThreadedJobInfo *job_instance, ddependencychange_t dependencies_count_change, 
+                                                                                                                            bool &out_job_has_become_ready)
+{
+    // Dependencies should not be changed when job has already become ready for execution
+    dIASSERT(job_instance->m_dependencies_count != 0);
+
+    ddependencycount_t new_dependencies_count = this->SmartAddJobDependenciesCount(job_instance, dependencies_count_change);
+    bool job_has_become_ready = new_dependencies_count == 0;
+
+    if (job_has_become_ready)
+    {
+        PushReadyJob(job_instance, SelectStackForPush());
+    }
+
+    out_job_has_become_ready = job_has_become_ready;
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+void dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::PushReadyJob(
+    dxThreadedJobInfo *job_instance, unsigned stack_index)
+{
+    // Count the job before it can be seen so that the count never drops below the number of jobs in the stacks
+    dxAtomicsProvider::IncrementTargetNoRet(&m_ready_count);
+
+    dxJobStack &job_stack = m_job_stacks[stack_index];
+
+    while (true)
+    {
+        dxThreadedJobInfo *next_job = (dxThreadedJobInfo *)job_stack.m_head;
+        job_instance->m_next_job = next_job;
+
+        if (dxAtomicsProvider::CompareExchangeTargetPtr(&job_stack.m_head, (atomicptr_t)next_job, (atomicptr_t)job_instance))
+        {
+            break;
+        }
+    }
+}
+
+template<class tThreadLull, class tThreadMutex, class tAtomicsProvider, class tThreadSlot, unsigned tstack_count>
+dxThreadedJobInfo *dxtemplateJobStacksContainer<tThreadLull, tThreadMutex, tAtomicsProvider, tThreadSlot, tstack_count>::PopReadyJob(
+    unsigned stack_index)
+{
+    dxJobStack &job_stack = m_job_stacks[stack_index];
+
+    // Extraction must be locked so that other thread does not "steal" head job,
+    // run it and then have it reinserted back with a different "next"
+    dxMutexLockHelper pop_access(job_stack.m_pop_lock);
+
+    dxThreadedJobInfo *head_job;
+
+    while (true)
+    {
+        head_job = (dxThreadedJobInfo *)job_stack.m_head;
+
+        if (head_job == NULL
+            || dxAtomicsProvider::CompareExchangeTargetPtr(&job_stack.m_head, (atomicptr_t)head_job, (atomicptr_t)head_job->m_next_job))
+        {
+            break;
+        }
+    }
+
+    return head_job;
+}
+
+
 /************************************************************************/
 /* Implementation of dxtemplateJobListThreadedHandler                   */
 /************************************************************************/
@@ -923,6 +1343,12 @@ void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Prepare
     // Do nothing
 }
 
+template<class tThreadWakeup, class tJobListContainer>
+const dxThreadingWaitPolicy *dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::RetrieveCallWaitPolicy()
+{
+    return !m_call_wait_policy.IsBlockingImmediately() ? &m_call_wait_policy : NULL;
+}
+
 template<class tThreadWakeup, class tJobListContainer>
 unsigned dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::RetrieveActiveThreadsCount()
 {
@@ -930,23 +1356,36 @@ unsigned dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Ret
 }
 
 template<class tThreadWakeup, class tJobListContainer>
-void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/)
+void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+    const dxThreadingWaitPolicy *wait_policy/*=NULL*/)
 {
-    RegisterAsActiveThread();
+    const dxThreadingWaitPolicy thread_wait_policy = wait_policy != NULL ? *wait_policy : dxThreadingWaitPolicy();
+
+    // The threads waiting for call completions follow the policy of the threads serving the implementation.
+    // All the threads of a pool have the same policy and they all register before the implementation is used.
+    if (!thread_wait_policy.IsBlockingImmediately())
+    {
+        m_call_wait_policy = thread_wait_policy;
+    }
+
+    // The count of threads active before is used as an index to spread workers over job stacks
+    unsigned worker_index = RegisterAsActiveThread();
+    m_job_list_ptr->AttachWorkerThread(worker_index);
 
     if (readiness_callback != NULL)
     {
         (*readiness_callback)(callback_context);
     }
 
-    PerformJobProcessingUntilShutdown();
+    PerformJobProcessingUntilShutdown(worker_index, thread_wait_policy);
 
+    m_job_list_ptr->DetachWorkerThread();
     UnregisterAsActiveThread();
 }
 
 
 template<class tThreadWakeup, class tJobListContainer>
-void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::PerformJobProcessingUntilShutdown()
+void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::PerformJobProcessingUntilShutdown(unsigned worker_index, const dxThreadingWaitPolicy &wait_policy)
 {
     while (true)
     {
@@ -956,7 +1395,10 @@ void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Perform
             break;
         }
 
-        PerformJobProcessingSession();
+        // Any wakeup requested after this point might be for a job the session is going to miss
+        atomicord_t wakeup_request_mark = GetWakeupRequestCount();
+
+        PerformJobProcessingSession(worker_index);
 
         // It is expected that new jobs will not be queued any longer after shutdown had been requested
         if (IsShutdownRequested() && m_job_list_ptr->IsJobListReadyForShutdown())
@@ -964,12 +1406,12 @@ void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Perform
             break;
         }
 
-        BlockAsIdleThread();
+        BlockAsIdleThread(wait_policy, wakeup_request_mark);
     }
 }
 
 template<class tThreadWakeup, class tJobListContainer>
-void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::PerformJobProcessingSession()
+void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::PerformJobProcessingSession(unsigned worker_index)
 {
     dxThreadedJobInfo *current_job = NULL;
     bool job_result = false;
@@ -977,7 +1419,7 @@ void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Perform
     while (true)
     {
         bool last_job_flag;
-        current_job = m_job_list_ptr->ReleaseAJobAndPickNextPendingOne(current_job, job_result, &dxCallWait::AbstractSignalTheWait, last_job_flag);
+        current_job = m_job_list_ptr->ReleaseAJobAndPickNextPendingOne(current_job, job_result, &dxCallWait::AbstractSignalTheWait, last_job_flag, worker_index);
 
         if (!current_job)
         {
@@ -995,15 +1437,69 @@ void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::Perform
 
 
 template<class tThreadWakeup, class tJobListContainer>
-void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::BlockAsIdleThread()
+void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::BlockAsIdleThread(const dxThreadingWaitPolicy &wait_policy, atomicord_t wakeup_request_mark)
 {
+    if (!wait_policy.IsBlockingImmediately())
+    {
+        dxAtomicsProvider::IncrementTargetNoRet(&m_spinning_thread_count);
+        bool wakeup_noticed = SpinForWakeupRequest(wait_policy, wakeup_request_mark);
+        dxAtomicsProvider::DecrementTargetNoRet(&m_spinning_thread_count);
+
+        // The requests made while the thread was counted as spinning might have skipped the wakeup signal.
+        // They must be re-checked after the thread has been uncounted.
+        if (wakeup_noticed || GetWakeupRequestCount() != wakeup_request_mark)
+        {
+            return;
+        }
+    }
+
     m_processing_wakeup.WaitWakeup(NULL);
 }
 
+template<class tThreadWakeup, class tJobListContainer>
+bool dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::SpinForWakeupRequest(const dxThreadingWaitPolicy &wait_policy, atomicord_t wakeup_request_mark)
+{
+    bool result = false;
+
+    for (unsigned spin_index = wait_policy.m_spin_count; spin_index != 0; --spin_index)
+    {
+        if (GetWakeupRequestCount() != wakeup_request_mark)
+        {
+            result = true;
+            break;
+        }
+
+        tThreadWakeup::PauseProcessor();
+    }
+
+    if (!result)
+    {
+        for (unsigned yield_index = wait_policy.m_yield_count; yield_index != 0; --yield_index)
+        {
+            if (GetWakeupRequestCount() != wakeup_request_mark)
+            {
+                result = true;
+                break;
+            }
+
+            tThreadWakeup::YieldThread();
+        }
+    }
+
+    return result;
+}
+
 template<class tThreadWakeup, class tJobListContainer>
 void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::ActivateAnIdleThread()
 {
-    m_processing_wakeup.WakeupAThread();
+    dxAtomicsProvider::IncrementTargetNoRet(&m_wakeup_request_count);
+
+    // A spinning thread is going to notice the request on its own. 
+    // If it stops spinning meanwhile it re-checks the request count before blocking.
+    if (dxAtomicsProvider::QueryTargetValue(&m_spinning_thread_count) == 0)
+    {
+        m_processing_wakeup.WakeupAThread();
+    }
 }
 
 
@@ -1011,6 +1507,7 @@ template<class tThreadWakeup, class tJobListContainer>
 void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::ShutdownProcessing()
 {
     m_shutdown_requested = true;
+    dxAtomicsProvider::IncrementTargetNoRet(&m_wakeup_request_count);
     m_processing_wakeup.WakeupAllThreads();
 }
 
@@ -1018,6 +1515,7 @@ template<class tThreadWakeup, class tJobListContainer>
 void dxtemplateJobListThreadedHandler<tThreadWakeup, tJobListContainer>::CleanupForRestart()
 {
     m_shutdown_requested = false;
+    m_call_wait_policy = dxThreadingWaitPolicy();
     m_processing_wakeup.ResetWakeup();
 }
 
@@ -1041,6 +1539,12 @@ void dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::PrepareForW
     PerformJobProcessingUntilExhaustion();
 }
 
+template<class tThreadWakeup, class tJobListContainer>
+const dxThreadingWaitPolicy *dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::RetrieveCallWaitPolicy()
+{
+    return NULL; // The calls have already been completed by the time of waiting
+}
+
 
 template<class tThreadWakeup, class tJobListContainer>
 unsigned dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::RetrieveActiveThreadsCount()
@@ -1049,10 +1553,12 @@ unsigned dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::Retriev
 }
 
 template<class tThreadWakeup, class tJobListContainer>
-void dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/)
+void dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+    const dxThreadingWaitPolicy *wait_policy/*=NULL*/)
 {
     (void)readiness_callback; // unused
     (void)callback_context; // unused
+    (void)wait_policy; // unused
     dIASSERT(false); // This method is not expected to be called for Self-Handler
 }
 
@@ -1072,7 +1578,7 @@ void dxtemplateJobListSelfHandler<tThreadWakeup, tJobListContainer>::PerformJobP
     while (true)
     {
         bool dummy_last_job_flag;
-        current_job = m_job_list_ptr->ReleaseAJobAndPickNextPendingOne(current_job, job_result, &dxCallWait::AbstractSignalTheWait, dummy_last_job_flag);
+        current_job = m_job_list_ptr->ReleaseAJobAndPickNextPendingOne(current_job, job_result, &dxCallWait::AbstractSignalTheWait, dummy_last_job_flag, 0);
 
         if (!current_job)
         {
@@ -1227,7 +1733,7 @@ void dxtemplateThreadingImplementation<tJobListContainer, tJobListHandler>::Wait
 
     m_list_handler.PrepareForWaitingAJobCompletion();
 
-    bool wait_status = ((dxCallWait *)call_wait)->PerformWaiting(timeout_time_ptr);
+    bool wait_status = ((dxCallWait *)call_wait)->PerformWaiting(timeout_time_ptr, m_list_handler.RetrieveCallWaitPolicy());
     dIASSERT(timeout_time_ptr != NULL || wait_status);
 
     if (out_wait_status_ptr)
@@ -1244,9 +1750,10 @@ unsigned dxtemplateThreadingImplementation<tJobListContainer, tJobListHandler>::
 }
 
 template<class tJobListContainer, class tJobListHandler>
-void dxtemplateThreadingImplementation<tJobListContainer, tJobListHandler>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/)
+void dxtemplateThreadingImplementation<tJobListContainer, tJobListHandler>::StickToJobsProcessing(dxThreadReadyToServeCallback *readiness_callback/*=NULL*/, void *callback_context/*=NULL*/, 
+    const dxThreadingWaitPolicy *wait_policy/*=NULL*/)
 {
-    m_list_handler.StickToJobsProcessing(readiness_callback, callback_context);
+    m_list_handler.StickToJobsProcessing(readiness_callback, callback_context, wait_policy);
 }
 
 template<class tJobListContainer, class tJobListHandler>
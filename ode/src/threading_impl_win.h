@@ -79,6 +79,10 @@ public:
 
     bool WaitWakeup(const dThreadedWaitTime *timeout_time_ptr);
 
+public:
+    static void PauseProcessor() { YieldProcessor(); }
+    static void YieldThread() { SwitchToThread(); }
+
 private:
     bool          m_state_is_permanent;
     HANDLE        m_event_handle;  
@@ -241,6 +245,31 @@ private:
 };
 
 
+/************************************************************************/
+/* dxTlsIndexSlot class implementation                                  */
+/************************************************************************/
+
+class dxTlsIndexSlot
+{
+public:
+    dxTlsIndexSlot(): m_tls_index(TLS_OUT_OF_INDEXES) {}
+    ~dxTlsIndexSlot() { DoFinalizeObject(); }
+
+    bool InitializeObject() { return DoInitializeObject(); }
+
+private:
+    bool DoInitializeObject() { dIASSERT(m_tls_index == TLS_OUT_OF_INDEXES); m_tls_index = TlsAlloc(); return m_tls_index != TLS_OUT_OF_INDEXES; }
+    void DoFinalizeObject() { if (m_tls_index != TLS_OUT_OF_INDEXES) { BOOL free_result = TlsFree(m_tls_index); dICHECK(free_result); m_tls_index = TLS_OUT_OF_INDEXES; } }
+
+public:
+    void *GetSlotValue() const { return TlsGetValue(m_tls_index); }
+    void SetSlotValue(void *value) { BOOL set_result = TlsSetValue(m_tls_index, value); dICHECK(set_result); }
+
+private:
+    DWORD                 m_tls_index;
+};
+
+
 #endif // #if dBUILTIN_THREADING_IMPL_ENABLED
 
 
@@ -264,6 +293,17 @@ typedef dxtemplateJobListThreadedHandler<dxEventWakeup, dxMultiThreadedJobListCo
 typedef dxtemplateThreadingImplementation<dxMultiThreadedJobListContainer, dxMultiThreadedJobListHandler> dxMultiThreadedThreading;
 
 
+/************************************************************************/
+/* Work-stealing job list definition                                    */
+/************************************************************************/
+
+#define dWORK_STEALING_JOB_STACK_COUNT 16U
+
+typedef dxtemplateJobStacksContainer<dxtemplateThreadedLull<dxEventWakeup, dxOUAtomicsProvider, false>, dxCriticalSectionMutex, dxOUAtomicsProvider, dxTlsIndexSlot, dWORK_STEALING_JOB_STACK_COUNT> dxWorkStealingJobListContainer;
+typedef dxtemplateJobListThreadedHandler<dxEventWakeup, dxWorkStealingJobListContainer> dxWorkStealingJobListHandler;
+typedef dxtemplateThreadingImplementation<dxWorkStealingJobListContainer, dxWorkStealingJobListHandler> dxWorkStealingThreading;
+
+
 #endif // #if dBUILTIN_THREADING_IMPL_ENABLED
 
 
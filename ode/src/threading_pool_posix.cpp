@@ -44,8 +44,10 @@
 
 #include <new>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <errno.h>
+#include <stdio.h>
 
 #if !defined(EOK)
 #define EOK   0
@@ -200,13 +202,21 @@ void dxEventObject::ResetEvent()
 }
 
 
+struct dxThreadAffinity
+{
+#if HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t   m_cpu_set;
+#endif
+};
+
+
 struct dxThreadPoolThreadInfo
 {
 public:
     dxThreadPoolThreadInfo();
     ~dxThreadPoolThreadInfo();
 
-    bool Initialize(size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool Initialize(size_t stack_size, unsigned int ode_data_allocate_flags, const dxThreadAffinity *affinity/*=NULL*/);
 
 private:
     bool InitializeThreadAttributes(pthread_attr_t *thread_attr, size_t stack_size);
@@ -227,13 +237,14 @@ public:
 
     struct dxServeImplementationParams
     {
-        dxServeImplementationParams(dThreadingImplementationID impl, dxEventObject *ready_wait_event):
-    m_impl(impl), m_ready_wait_event(ready_wait_event)
+        dxServeImplementationParams(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy):
+    m_impl(impl), m_ready_wait_event(ready_wait_event), m_wait_policy(wait_policy)
     {
     }
 
     dThreadingImplementationID m_impl;
     dxEventObject *m_ready_wait_event;
+    const dxThreadingWaitPolicy *m_wait_policy;
     };
 
     void ExecuteThreadCommand(dxTHREADCOMMAND command, void *param, bool wait_response);
@@ -241,11 +252,12 @@ public:
 private:
     static void *ThreadProcedure_Callback(void *thread_param);
     void ThreadProcedure();
+    bool AssignThreadAffinity();
     bool DisableSignalHandlers();
     void ReportInitStatus(bool init_result);
     void RunCommandHandlingLoop();
 
-    void ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event);
+    void ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy);
     static void ProcessThreadServeReadiness_Callback(void *context);
 
 private:
@@ -253,6 +265,8 @@ private:
     bool        m_thread_allocated;
 
     unsigned int m_ode_data_allocate_flags;
+    bool        m_affinity_assigned;
+    dxThreadAffinity m_affinity;
     dxTHREADCOMMAND m_command_code;
     dxEventObject m_command_event;
     dxEventObject m_acknowledgement_event;
@@ -264,6 +278,8 @@ dxThreadPoolThreadInfo::dxThreadPoolThreadInfo():
 m_thread_handle(),
 m_thread_allocated(false),
 m_ode_data_allocate_flags(0),
+m_affinity_assigned(false),
+m_affinity(),
 m_command_code(dxTHREAD_COMMAND_EXIT),
 m_command_event(),
 m_acknowledgement_event(),
@@ -277,7 +293,7 @@ dxThreadPoolThreadInfo::~dxThreadPoolThreadInfo()
 }
 
 
-bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data_allocate_flags, const dxThreadAffinity *affinity/*=NULL*/)
 {
     bool result = false;
 
@@ -308,6 +324,12 @@ bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data
 
         m_ode_data_allocate_flags = ode_data_allocate_flags;
 
+        m_affinity_assigned = affinity != NULL;
+        if (affinity != NULL)
+        {
+            m_affinity = *affinity;
+        }
+
         pthread_attr_t thread_attr;
         if (!InitializeThreadAttributes(&thread_attr, stack_size))
         {
@@ -463,7 +485,9 @@ void *dxThreadPoolThreadInfo::ThreadProcedure_Callback(void *thread_param)
 
 void dxThreadPoolThreadInfo::ThreadProcedure()
 {
-    bool init_result = dAllocateODEDataForThread(m_ode_data_allocate_flags) != 0
+    // The affinity is assigned first for the thread's ODE data to be allocated on its final CPUs
+    bool init_result = AssignThreadAffinity()
+        && dAllocateODEDataForThread(m_ode_data_allocate_flags) != 0
         && DisableSignalHandlers();
 
     ReportInitStatus(init_result);
@@ -476,6 +500,35 @@ void dxThreadPoolThreadInfo::ThreadProcedure()
     }
 }
 
+bool dxThreadPoolThreadInfo::AssignThreadAffinity()
+{
+    bool result = false;
+
+    do
+    {
+        if (m_affinity_assigned)
+        {
+#if HAVE_PTHREAD_SETAFFINITY_NP
+            int set_result = pthread_setaffinity_np(pthread_self(), sizeof(m_affinity.m_cpu_set), &m_affinity.m_cpu_set);
+            if (set_result != EOK)
+            {
+                errno = set_result;
+                break;
+            }
+#else
+            dIASSERT(false); // The affinity is not expected to be requested if it is not supported
+            errno = ENOSYS;
+            break;
+#endif
+        }
+
+        result = true;
+    }
+    while (false);
+
+    return result;
+}
+
 bool dxThreadPoolThreadInfo::DisableSignalHandlers()
 {
     bool result = false;
@@ -537,19 +590,20 @@ void dxThreadPoolThreadInfo::RunCommandHandlingLoop()
                 const dxServeImplementationParams *serve_params = (const dxServeImplementationParams *)m_command_param;
                 dThreadingImplementationID impl = serve_params->m_impl;
                 dxEventObject *ready_wait_event = serve_params->m_ready_wait_event;
+                const dxThreadingWaitPolicy *wait_policy = serve_params->m_wait_policy;
 
                 m_acknowledgement_event.SetEvent();
 
-                ThreadedServeImplementation(impl, ready_wait_event);
+                ThreadedServeImplementation(impl, ready_wait_event, wait_policy);
                 break;
             }
         }
     }
 }
 
-void dxThreadPoolThreadInfo::ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event)
+void dxThreadPoolThreadInfo::ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy)
 {
-    ((dxIThreadingImplementation *)impl)->StickToJobsProcessing(&ProcessThreadServeReadiness_Callback, (void *)ready_wait_event);
+    ((dxIThreadingImplementation *)impl)->StickToJobsProcessing(&ProcessThreadServeReadiness_Callback, (void *)ready_wait_event, wait_policy);
 }
 
 void dxThreadPoolThreadInfo::ProcessThreadServeReadiness_Callback(void *context)
@@ -568,15 +622,21 @@ public:
     dxThreadingThreadPool();
     ~dxThreadingThreadPool();
 
-    bool InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/);
 
 private:
     void FinalizeThreads();
+    void AssignWaitPolicy(const dThreadingThreadPoolParameters *parameters/*=NULL*/);
 
-    bool InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/);
     void FinalizeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count);
 
-    bool InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dxThreadAffinity *affinity/*=NULL*/);
+    static bool PrepareThreadAffinity(dxThreadAffinity *out_affinity, bool &out_affinity_required, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/, size_t thread_index);
     void FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info);
 
 public:
@@ -587,13 +647,15 @@ private:
     dxThreadPoolThreadInfo  *m_thread_infos;
     size_t                  m_thread_count;
     dxEventObject           m_ready_wait_event;
+    dxThreadingWaitPolicy   m_wait_policy;
 };
 
 
 dxThreadingThreadPool::dxThreadingThreadPool():
 m_thread_infos(NULL),
 m_thread_count(0),
-m_ready_wait_event()
+m_ready_wait_event(),
+m_wait_policy()
 {
 }
 
@@ -603,10 +665,13 @@ dxThreadingThreadPool::~dxThreadingThreadPool()
 }
 
 
-bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     dIASSERT(m_thread_infos == NULL);
 
+    AssignWaitPolicy(parameters);
+
     bool result = false;
 
     bool wait_event_allocated = false;
@@ -631,7 +696,7 @@ bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_
 
         thread_infos_allocated = true;
 
-        if (!InitializeIndividualThreadInfos(thread_infos, thread_count, stack_size, ode_data_allocate_flags))
+        if (!InitializeIndividualThreadInfos(thread_infos, thread_count, stack_size, ode_data_allocate_flags, parameters))
         {
             break;
         }
@@ -673,14 +738,57 @@ void dxThreadingThreadPool::FinalizeThreads()
 }
 
 
-bool dxThreadingThreadPool::InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags)
+void dxThreadingThreadPool::AssignWaitPolicy(const dThreadingThreadPoolParameters *parameters/*=NULL*/)
+{
+    unsigned wait_policy = dThreadingThreadPoolWaitPark, spin_count = 0, yield_count = 0;
+
+    if (parameters != NULL)
+    {
+        dAASSERT(parameters->struct_size >= sizeof(*parameters));
+
+        wait_policy = parameters->wait_policy;
+        spin_count = parameters->wait_spin_count != 0 ? parameters->wait_spin_count : dTHREADING_WAIT_DEFAULT_SPIN_COUNT;
+        yield_count = parameters->wait_yield_count != 0 ? parameters->wait_yield_count : dTHREADING_WAIT_DEFAULT_YIELD_COUNT;
+    }
+
+    switch (wait_policy)
+    {
+        case dThreadingThreadPoolWaitSpin:
+        {
+            m_wait_policy = dxThreadingWaitPolicy(spin_count, yield_count);
+            break;
+        }
+
+        case dThreadingThreadPoolWaitYield:
+        {
+            m_wait_policy = dxThreadingWaitPolicy(0, yield_count);
+            break;
+        }
+
+        default:
+        {
+            dAASSERT(wait_policy == dThreadingThreadPoolWaitPark);
+
+            m_wait_policy = dxThreadingWaitPolicy();
+            break;
+        }
+    }
+}
+
+
+bool dxThreadingThreadPool::InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     bool any_fault = false;
 
     dxThreadPoolThreadInfo *const infos_end = thread_infos + thread_count;
     for (dxThreadPoolThreadInfo *current_info = thread_infos; current_info != infos_end; ++current_info)
     {
-        if (!InitializeSingleThreadInfo(current_info, stack_size, ode_data_allocate_flags))
+        dxThreadAffinity thread_affinity;
+        bool affinity_required;
+
+        if (!PrepareThreadAffinity(&thread_affinity, affinity_required, parameters, current_info - thread_infos)
+            || !InitializeSingleThreadInfo(current_info, stack_size, ode_data_allocate_flags, affinity_required ? &thread_affinity : NULL))
         {
             FinalizeIndividualThreadInfos(thread_infos, current_info - thread_infos);
 
@@ -703,13 +811,14 @@ void dxThreadingThreadPool::FinalizeIndividualThreadInfos(dxThreadPoolThreadInfo
 }
 
 
-bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dxThreadAffinity *affinity/*=NULL*/)
 {
     bool result = false;
 
     new(thread_info) dxThreadPoolThreadInfo();
 
-    if (thread_info->Initialize(stack_size, ode_data_allocate_flags))
+    if (thread_info->Initialize(stack_size, ode_data_allocate_flags, affinity))
     {
         result = true;
     }
@@ -721,6 +830,106 @@ bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *t
     return result;
 }
 
+bool dxThreadingThreadPool::PrepareThreadAffinity(dxThreadAffinity *out_affinity, bool &out_affinity_required, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/, size_t thread_index)
+{
+    bool result = false;
+
+    const unsigned affinity_policy = parameters != NULL ? parameters->affinity_policy : (unsigned)dThreadingThreadPoolAffinityNone;
+    out_affinity_required = affinity_policy != dThreadingThreadPoolAffinityNone;
+
+    do
+    {
+        if (affinity_policy == dThreadingThreadPoolAffinityNone)
+        {
+            result = true;
+            break;
+        }
+
+#if HAVE_PTHREAD_SETAFFINITY_NP
+        cpu_set_t *cpu_set = &out_affinity->m_cpu_set;
+        CPU_ZERO(cpu_set);
+
+        if (affinity_policy == dThreadingThreadPoolAffinityCPUList)
+        {
+            dAASSERT(parameters->cpu_list != NULL && parameters->cpu_count != 0);
+
+            if (parameters->cpu_list == NULL || parameters->cpu_count == 0)
+            {
+                errno = EINVAL;
+                break;
+            }
+
+            unsigned thread_cpu = parameters->cpu_list[thread_index % parameters->cpu_count];
+            if (thread_cpu >= CPU_SETSIZE)
+            {
+                errno = EINVAL;
+                break;
+            }
+
+            CPU_SET(thread_cpu, cpu_set);
+        }
+        else if (affinity_policy == dThreadingThreadPoolAffinityNUMANode)
+        {
+            // The node CPUs are listed by the kernel as comma separated ranges, like "0-7,16-23"
+            char cpulist_path[64];
+            sprintf(cpulist_path, "/sys/devices/system/node/node%u/cpulist", parameters->numa_node);
+
+            FILE *cpulist_file = fopen(cpulist_path, "r");
+            if (cpulist_file == NULL)
+            {
+                break;
+            }
+
+            unsigned range_first, range_last;
+            while (fscanf(cpulist_file, "%u", &range_first) == 1)
+            {
+                int separator = fgetc(cpulist_file);
+
+                range_last = range_first;
+                if (separator == '-' && fscanf(cpulist_file, "%u", &range_last) == 1)
+                {
+                    separator = fgetc(cpulist_file);
+                }
+
+                for (unsigned range_cpu = range_first; range_cpu <= range_last && range_cpu < CPU_SETSIZE; ++range_cpu)
+                {
+                    CPU_SET(range_cpu, cpu_set);
+                }
+
+                if (separator != ',')
+                {
+                    break;
+                }
+            }
+
+            fclose(cpulist_file);
+
+            if (CPU_COUNT(cpu_set) == 0)
+            {
+                errno = EINVAL; // The node has no CPUs
+                break;
+            }
+        }
+        else
+        {
+            dAASSERT(false); // Unknown affinity policy
+            errno = EINVAL;
+            break;
+        }
+
+        result = true;
+#else
+        (void)out_affinity; // unused
+        (void)thread_index; // unused
+        errno = ENOSYS;
+#endif
+    }
+    while (false);
+
+    return result;
+}
+
 void dxThreadingThreadPool::FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info)
 {
     if (thread_info != NULL)
@@ -732,7 +941,7 @@ void dxThreadingThreadPool::FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thr
 
 void dxThreadingThreadPool::ServeThreadingImplementation(dThreadingImplementationID impl)
 {
-    dxThreadPoolThreadInfo::dxServeImplementationParams params(impl, &m_ready_wait_event);
+    dxThreadPoolThreadInfo::dxServeImplementationParams params(impl, &m_ready_wait_event, &m_wait_policy);
 
     dxThreadPoolThreadInfo *const infos_end = m_thread_infos + m_thread_count;
     for (dxThreadPoolThreadInfo *current_info = m_thread_infos; current_info != infos_end; ++current_info)
@@ -758,7 +967,7 @@ void dxThreadingThreadPool::WaitIdleState()
 
 
 /*extern */dThreadingThreadPoolID dThreadingAllocateThreadPool(unsigned thread_count, 
-                                                               size_t stack_size, unsigned int ode_data_allocate_flags, void *reserved/*=NULL*/)
+                                                               size_t stack_size, unsigned int ode_data_allocate_flags, const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     dAASSERT(thread_count != 0);
 
@@ -766,7 +975,7 @@ void dxThreadingThreadPool::WaitIdleState()
     dxThreadingThreadPool *thread_pool = new dxThreadingThreadPool();
     if (thread_pool != NULL)
     {
-        if (thread_pool->InitializeThreads(thread_count, stack_size, ode_data_allocate_flags))
+        if (thread_pool->InitializeThreads(thread_count, stack_size, ode_data_allocate_flags, parameters))
         {
             // do nothing
         }
@@ -780,7 +989,7 @@ void dxThreadingThreadPool::WaitIdleState()
     dThreadingThreadPoolID thread_pool = NULL;
     (void)stack_size; // unused
     (void)ode_data_allocate_flags; // unused
-    (void)reserved; // unused
+    (void)parameters; // unused
 #endif // #if dBUILTIN_THREADING_IMPL_ENABLED
 
     return (dThreadingThreadPoolID)thread_pool;
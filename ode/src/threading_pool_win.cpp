@@ -120,13 +120,19 @@ void dxEventObject::ResetEvent()
 
 
 
+struct dxThreadAffinity
+{
+    DWORD_PTR   m_processor_mask;
+};
+
+
 struct dxThreadPoolThreadInfo
 {
 public:
     dxThreadPoolThreadInfo();
     ~dxThreadPoolThreadInfo();
 
-    bool Initialize(size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool Initialize(size_t stack_size, unsigned int ode_data_allocate_flags, const dxThreadAffinity *affinity/*=NULL*/);
 
 private:
     bool WaitInitStatus();
@@ -145,13 +151,14 @@ public:
 
     struct dxServeImplementationParams
     {
-        dxServeImplementationParams(dThreadingImplementationID impl, dxEventObject *ready_wait_event):
-    m_impl(impl), m_ready_wait_event(ready_wait_event)
+        dxServeImplementationParams(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy):
+    m_impl(impl), m_ready_wait_event(ready_wait_event), m_wait_policy(wait_policy)
     {
     }
 
     dThreadingImplementationID m_impl;
     dxEventObject *m_ready_wait_event;
+    const dxThreadingWaitPolicy *m_wait_policy;
     };
 
     void ExecuteThreadCommand(dxTHREADCOMMAND command, void *param, bool wait_response);
@@ -159,16 +166,19 @@ public:
 private:
     static unsigned CALLBACK ThreadProcedure_Callback(void *thread_param);
     void ThreadProcedure();
+    bool AssignThreadAffinity();
     void ReportInitStatus(bool init_result);
     void RunCommandHandlingLoop();
 
-    void ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event);
+    void ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy);
     static void ProcessThreadServeReadiness_Callback(void *context);
 
 private:
     HANDLE      m_thread_handle;
 
     unsigned int m_ode_data_allocate_flags;
+    bool        m_affinity_assigned;
+    dxThreadAffinity m_affinity;
     dxTHREADCOMMAND m_command_code;
     dxEventObject m_command_event;
     dxEventObject m_acknowledgement_event;
@@ -179,6 +189,8 @@ private:
 dxThreadPoolThreadInfo::dxThreadPoolThreadInfo():
 m_thread_handle(NULL),
 m_ode_data_allocate_flags(0),
+m_affinity_assigned(false),
+m_affinity(),
 m_command_code(dxTHREAD_COMMAND_EXIT),
 m_command_event(),
 m_acknowledgement_event(),
@@ -192,7 +204,7 @@ dxThreadPoolThreadInfo::~dxThreadPoolThreadInfo()
 }
 
 
-bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data_allocate_flags, const dxThreadAffinity *affinity/*=NULL*/)
 {
     bool result = false;
 
@@ -224,6 +236,12 @@ bool dxThreadPoolThreadInfo::Initialize(size_t stack_size, unsigned int ode_data
 
         m_ode_data_allocate_flags = ode_data_allocate_flags;
 
+        m_affinity_assigned = affinity != NULL;
+        if (affinity != NULL)
+        {
+            m_affinity = *affinity;
+        }
+
         thread_handle = (HANDLE)_beginthreadex(NULL, (unsigned)stack_size, &ThreadProcedure_Callback, (void *)this, 0, NULL);
         if (thread_handle == NULL) // Not a bug!!! _beginthreadex() returns NULL on failure
         {
@@ -337,7 +355,9 @@ unsigned CALLBACK dxThreadPoolThreadInfo::ThreadProcedure_Callback(void *thread_
 
 void dxThreadPoolThreadInfo::ThreadProcedure()
 {
-    bool init_result = dAllocateODEDataForThread(m_ode_data_allocate_flags) != 0;
+    // The affinity is assigned first for the thread's ODE data to be allocated on its final CPUs
+    bool init_result = AssignThreadAffinity()
+        && dAllocateODEDataForThread(m_ode_data_allocate_flags) != 0;
 
     ReportInitStatus(init_result);
 
@@ -349,6 +369,13 @@ void dxThreadPoolThreadInfo::ThreadProcedure()
     }
 }
 
+bool dxThreadPoolThreadInfo::AssignThreadAffinity()
+{
+    bool result = !m_affinity_assigned 
+        || SetThreadAffinityMask(GetCurrentThread(), m_affinity.m_processor_mask) != 0;
+    return result;
+}
+
 void dxThreadPoolThreadInfo::ReportInitStatus(bool init_result)
 {
     DWORD error_code;
@@ -396,19 +423,20 @@ void dxThreadPoolThreadInfo::RunCommandHandlingLoop()
                 const dxServeImplementationParams *serve_params = (const dxServeImplementationParams *)m_command_param;
                 dThreadingImplementationID impl = serve_params->m_impl;
                 dxEventObject *ready_wait_event = serve_params->m_ready_wait_event;
+                const dxThreadingWaitPolicy *wait_policy = serve_params->m_wait_policy;
 
                 m_acknowledgement_event.SetEvent();
 
-                ThreadedServeImplementation(impl, ready_wait_event);
+                ThreadedServeImplementation(impl, ready_wait_event, wait_policy);
                 break;
             }
         }
     }
 }
 
-void dxThreadPoolThreadInfo::ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event)
+void dxThreadPoolThreadInfo::ThreadedServeImplementation(dThreadingImplementationID impl, dxEventObject *ready_wait_event, const dxThreadingWaitPolicy *wait_policy)
 {
-    ((dxIThreadingImplementation *)impl)->StickToJobsProcessing(&ProcessThreadServeReadiness_Callback, (void *)ready_wait_event);
+    ((dxIThreadingImplementation *)impl)->StickToJobsProcessing(&ProcessThreadServeReadiness_Callback, (void *)ready_wait_event, wait_policy);
 }
 
 void dxThreadPoolThreadInfo::ProcessThreadServeReadiness_Callback(void *context)
@@ -427,15 +455,21 @@ public:
     dxThreadingThreadPool();
     ~dxThreadingThreadPool();
 
-    bool InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/);
 
 private:
     void FinalizeThreads();
+    void AssignWaitPolicy(const dThreadingThreadPoolParameters *parameters/*=NULL*/);
 
-    bool InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/);
     void FinalizeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count);
 
-    bool InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags);
+    bool InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags, 
+        const dxThreadAffinity *affinity/*=NULL*/);
+    static bool PrepareThreadAffinity(dxThreadAffinity *out_affinity, bool &out_affinity_required, 
+        const dThreadingThreadPoolParameters *parameters/*=NULL*/, size_t thread_index);
     void FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info);
 
 public:
@@ -446,13 +480,15 @@ private:
     dxThreadPoolThreadInfo  *m_thread_infos;
     size_t                  m_thread_count;
     dxEventObject           m_ready_wait_event;
+    dxThreadingWaitPolicy   m_wait_policy;
 };
 
 
 dxThreadingThreadPool::dxThreadingThreadPool():
 m_thread_infos(NULL),
 m_thread_count(0),
-m_ready_wait_event()
+m_ready_wait_event(),
+m_wait_policy()
 {
 }
 
@@ -462,10 +498,13 @@ dxThreadingThreadPool::~dxThreadingThreadPool()
 }
 
 
-bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     dIASSERT(m_thread_infos == NULL);
 
+    AssignWaitPolicy(parameters);
+
     bool result = false;
 
     bool wait_event_allocated = false;
@@ -490,7 +529,7 @@ bool dxThreadingThreadPool::InitializeThreads(size_t thread_count, size_t stack_
 
         thread_infos_allocated = true;
 
-        if (!InitializeIndividualThreadInfos(thread_infos, thread_count, stack_size, ode_data_allocate_flags))
+        if (!InitializeIndividualThreadInfos(thread_infos, thread_count, stack_size, ode_data_allocate_flags, parameters))
         {
             break;
         }
@@ -532,14 +571,57 @@ void dxThreadingThreadPool::FinalizeThreads()
 }
 
 
-bool dxThreadingThreadPool::InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags)
+void dxThreadingThreadPool::AssignWaitPolicy(const dThreadingThreadPoolParameters *parameters/*=NULL*/)
+{
+    unsigned wait_policy = dThreadingThreadPoolWaitPark, spin_count = 0, yield_count = 0;
+
+    if (parameters != NULL)
+    {
+        dAASSERT(parameters->struct_size >= sizeof(*parameters));
+
+        wait_policy = parameters->wait_policy;
+        spin_count = parameters->wait_spin_count != 0 ? parameters->wait_spin_count : dTHREADING_WAIT_DEFAULT_SPIN_COUNT;
+        yield_count = parameters->wait_yield_count != 0 ? parameters->wait_yield_count : dTHREADING_WAIT_DEFAULT_YIELD_COUNT;
+    }
+
+    switch (wait_policy)
+    {
+        case dThreadingThreadPoolWaitSpin:
+        {
+            m_wait_policy = dxThreadingWaitPolicy(spin_count, yield_count);
+            break;
+        }
+
+        case dThreadingThreadPoolWaitYield:
+        {
+            m_wait_policy = dxThreadingWaitPolicy(0, yield_count);
+            break;
+        }
+
+        default:
+        {
+            dAASSERT(wait_policy == dThreadingThreadPoolWaitPark);
+
+            m_wait_policy = dxThreadingWaitPolicy();
+            break;
+        }
+    }
+}
+
+
+bool dxThreadingThreadPool::InitializeIndividualThreadInfos(dxThreadPoolThreadInfo *thread_infos, size_t thread_count, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     bool any_fault = false;
 
     dxThreadPoolThreadInfo *const infos_end = thread_infos + thread_count;
     for (dxThreadPoolThreadInfo *current_info = thread_infos; current_info != infos_end; ++current_info)
     {
-        if (!InitializeSingleThreadInfo(current_info, stack_size, ode_data_allocate_flags))
+        dxThreadAffinity thread_affinity;
+        bool affinity_required;
+
+        if (!PrepareThreadAffinity(&thread_affinity, affinity_required, parameters, current_info - thread_infos)
+            || !InitializeSingleThreadInfo(current_info, stack_size, ode_data_allocate_flags, affinity_required ? &thread_affinity : NULL))
         {
             FinalizeIndividualThreadInfos(thread_infos, current_info - thread_infos);
 
@@ -562,13 +644,14 @@ void dxThreadingThreadPool::FinalizeIndividualThreadInfos(dxThreadPoolThreadInfo
 }
 
 
-bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags)
+bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info, size_t stack_size, unsigned int ode_data_allocate_flags, 
+    const dxThreadAffinity *affinity/*=NULL*/)
 {
     bool result = false;
 
     new(thread_info) dxThreadPoolThreadInfo();
 
-    if (thread_info->Initialize(stack_size, ode_data_allocate_flags))
+    if (thread_info->Initialize(stack_size, ode_data_allocate_flags, affinity))
     {
         result = true;
     }
@@ -580,6 +663,73 @@ bool dxThreadingThreadPool::InitializeSingleThreadInfo(dxThreadPoolThreadInfo *t
     return result;
 }
 
+bool dxThreadingThreadPool::PrepareThreadAffinity(dxThreadAffinity *out_affinity, bool &out_affinity_required, 
+    const dThreadingThreadPoolParameters *parameters/*=NULL*/, size_t thread_index)
+{
+    bool result = false;
+
+    const unsigned affinity_policy = parameters != NULL ? parameters->affinity_policy : (unsigned)dThreadingThreadPoolAffinityNone;
+    out_affinity_required = affinity_policy != dThreadingThreadPoolAffinityNone;
+
+    do
+    {
+        if (affinity_policy == dThreadingThreadPoolAffinityNone)
+        {
+            result = true;
+            break;
+        }
+
+        if (affinity_policy == dThreadingThreadPoolAffinityCPUList)
+        {
+            dAASSERT(parameters->cpu_list != NULL && parameters->cpu_count != 0);
+
+            if (parameters->cpu_list == NULL || parameters->cpu_count == 0)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+                break;
+            }
+
+            // Only the processors of the caller's processor group can be addressed
+            unsigned thread_cpu = parameters->cpu_list[thread_index % parameters->cpu_count];
+            if (thread_cpu >= sizeof(DWORD_PTR) * 8)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+                break;
+            }
+
+            out_affinity->m_processor_mask = (DWORD_PTR)1 << thread_cpu;
+        }
+        else if (affinity_policy == dThreadingThreadPoolAffinityNUMANode)
+        {
+            ULONGLONG node_mask;
+            if (parameters->numa_node > 0xFF || !GetNumaNodeProcessorMask((UCHAR)parameters->numa_node, &node_mask))
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+                break;
+            }
+
+            if (node_mask == 0)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER); // The node has no CPUs
+                break;
+            }
+
+            out_affinity->m_processor_mask = (DWORD_PTR)node_mask;
+        }
+        else
+        {
+            dAASSERT(false); // Unknown affinity policy
+            SetLastError(ERROR_INVALID_PARAMETER);
+            break;
+        }
+
+        result = true;
+    }
+    while (false);
+
+    return result;
+}
+
 void dxThreadingThreadPool::FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thread_info)
 {
     if (thread_info != NULL)
@@ -591,7 +741,7 @@ void dxThreadingThreadPool::FinalizeSingleThreadInfo(dxThreadPoolThreadInfo *thr
 
 void dxThreadingThreadPool::ServeThreadingImplementation(dThreadingImplementationID impl)
 {
-    dxThreadPoolThreadInfo::dxServeImplementationParams params(impl, &m_ready_wait_event);
+    dxThreadPoolThreadInfo::dxServeImplementationParams params(impl, &m_ready_wait_event, &m_wait_policy);
 
     dxThreadPoolThreadInfo *const infos_end = m_thread_infos + m_thread_count;
     for (dxThreadPoolThreadInfo *current_info = m_thread_infos; current_info != infos_end; ++current_info)
@@ -617,7 +767,7 @@ void dxThreadingThreadPool::WaitIdleState()
 
 
 /*extern */dThreadingThreadPoolID dThreadingAllocateThreadPool(unsigned thread_count, 
-                                                               size_t stack_size, unsigned int ode_data_allocate_flags, void *reserved/*=NULL*/)
+                                                               size_t stack_size, unsigned int ode_data_allocate_flags, const dThreadingThreadPoolParameters *parameters/*=NULL*/)
 {
     dAASSERT(thread_count != 0);
 
@@ -625,7 +775,7 @@ void dxThreadingThreadPool::WaitIdleState()
     dxThreadingThreadPool *thread_pool = new dxThreadingThreadPool();
     if (thread_pool != NULL)
     {
-        if (thread_pool->InitializeThreads(thread_count, stack_size, ode_data_allocate_flags))
+        if (thread_pool->InitializeThreads(thread_count, stack_size, ode_data_allocate_flags, parameters))
         {
             // do nothing
         }
@@ -421,3 +421,40 @@ void dTimerReport (FILE *fout, int average)
     }
     fprintf (fout,"\n");
 }
+
+//****************************************************************************
+// monotonic clock for internal measurements. unlike the stopwatch above it 
+// does not depend on the wall clock or on an assumed processor frequency.
+
+#if defined(WIN32)
+
+/*extern */double dxGetMonotonicTime()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter (&counter);
+    return double(counter.QuadPart) * dTimerResolution();
+}
+
+#elif HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+
+#include <time.h>
+
+/*extern */double dxGetMonotonicTime()
+{
+    timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) * 1.0e-9;
+}
+
+#else
+
+#include <sys/time.h>
+
+/*extern */double dxGetMonotonicTime()
+{
+    timeval tv;
+    gettimeofday (&tv, 0);
+    return double(tv.tv_sec) + double(tv.tv_usec) * 1.0e-6;
+}
+
+#endif
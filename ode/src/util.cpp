@@ -25,15 +25,32 @@
 #include "objects.h"
 #include "joints/joint.h"
 #include "util.h"
+#include "profile.h"
+#include "collision_kernel.h"
 #include "threadingutils.h"
 
 #include <new>
 
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
+
 
 #define dMIN(A,B)  ((A)>(B) ? (B) : (A))
 #define dMAX(A,B)  ((B)>(A) ? (B) : (A))
 
 
+// Island cost model: islands are given stepper threads in proportion to their estimated stepping time.
+// The time per cost unit is measured online from the islands stepped by a single thread.
+// TODO: Feed per-stage times into the quickstep stage chunk sizes too (see dxQUICKSTEPISLAND_STAGE2B_STEP).
+#define dxISLAND_COST_JOINT_WEIGHT          4U      // Cost units per joint (a body is one unit)
+#define dxISLAND_COST_DEFAULT_UNIT_TIME     1.0e-6  // Time per cost unit assumed until measured, in seconds
+#define dxISLAND_COST_THREAD_GRAIN_TIME     1.0e-4  // Least island stepping time worth an extra thread, in seconds
+#define dxISLAND_COST_UPDATE_WEIGHT         0.25    // Weight of a new measurement in the running average
+
+
 //****************************************************************************
 // Malloc based world stepping memory manager
 
@@ -41,6 +58,85 @@
 /*extern */dxWorldProcessMemoryReserveInfo g_WorldProcessDefaultReserveInfo(dWORLDSTEP_RESERVEFACTOR_DEFAULT, dWORLDSTEP_RESERVESIZE_DEFAULT);
 
 
+//****************************************************************************
+// NUMA placement of world stepping memory
+
+#if defined(__linux__) && defined(SYS_mbind)
+
+#define dxNUMA_MPOL_PREFERRED   1
+#define dxNUMA_NODE_MASK_BITS   1024
+
+/*extern */bool dxIsNUMAMemoryPlacementSupported()
+{
+    return true;
+}
+
+// The blocks are mapped from the system rather than taken from the heap. A memory policy 
+// stays with the pages of a range and would otherwise apply to heap memory reused after the block is freed.
+static 
+void *AllocateMemoryOnNUMANode(size_t nBlockSize, int iNUMANode)
+{
+    void *pBlock = mmap(NULL, nBlockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (pBlock != MAP_FAILED)
+    {
+        // The pages are not touched yet and get allocated on the node as they are first accessed.
+        // The result is ignored as the placement is a hint and the memory remains usable in any case.
+        if ((unsigned)iNUMANode < dxNUMA_NODE_MASK_BITS)
+        {
+            const size_t nMaskWordBits = sizeof(unsigned long) * 8;
+            unsigned long aulNodeMask[dxNUMA_NODE_MASK_BITS / (sizeof(unsigned long) * 8)] = { 0 };
+            aulNodeMask[(unsigned)iNUMANode / nMaskWordBits] = 1UL << ((unsigned)iNUMANode % nMaskWordBits);
+
+            syscall(SYS_mbind, pBlock, nBlockSize, dxNUMA_MPOL_PREFERRED, 
+                aulNodeMask, (unsigned long)(dxNUMA_NODE_MASK_BITS + 1), 0U);
+        }
+    }
+    else
+    {
+        pBlock = NULL;
+    }
+
+    return pBlock;
+}
+
+static 
+void FreeMemoryOnNUMANode(void *pBlock, size_t nBlockSize)
+{
+    munmap(pBlock, nBlockSize);
+}
+
+
+#else // #if !(defined(__linux__) && defined(SYS_mbind))
+
+
+/*extern */bool dxIsNUMAMemoryPlacementSupported()
+{
+    return false;
+}
+
+static inline 
+void *AllocateMemoryOnNUMANode(size_t nBlockSize, int iNUMANode)
+{
+    (void)nBlockSize; // unused
+    (void)iNUMANode; // unused
+    dIASSERT(false); // The node can't be assigned where the placement is not supported
+
+    return NULL;
+}
+
+static inline 
+void FreeMemoryOnNUMANode(void *pBlock, size_t nBlockSize)
+{
+    (void)pBlock; // unused
+    (void)nBlockSize; // unused
+    dIASSERT(false); // The node can't be assigned where the placement is not supported
+}
+
+
+#endif // #if defined(__linux__) && defined(SYS_mbind)
+
+
 //****************************************************************************
 // dxWorldProcessContext
 
@@ -49,6 +145,7 @@ const char *const dxWorldProcessContext::m_aszContextMutexNames[dxPCM__MAX] =
     "Stepper Arena Obtain Lock" , // dxPCM_STEPPER_ARENA_OBTAIN,
     "Joint addLimot Serialize Lock" , // dxPCM_STEPPER_ADDLIMOT_SERIALIZE
     "Stepper StepBody Serialize Lock" , // dxPCM_STEPPER_STEPBODY_SERIALIZE,
+    "Stepper Cost Model Update Lock" , // dxPCM_STEPPER_COSTMODEL_UPDATE,
 };
 
 dxWorldProcessContext::dxWorldProcessContext():
@@ -56,7 +153,8 @@ dxWorldProcessContext::dxWorldProcessContext():
     m_pmaStepperArenas(NULL),
     m_pswObjectsAllocWorld(NULL),
     m_pmgStepperMutexGroup(NULL),
-    m_pcwIslandsSteppingWait(NULL)
+    m_pcwIslandsSteppingWait(NULL),
+    m_dIslandStepUnitTime(dxISLAND_COST_DEFAULT_UNIT_TIME)
 {
     // Do nothing
 }
@@ -338,6 +436,21 @@ void dxWorldProcessContext::UnlockForStepbodySerialization()
 }
 
 
+void dxWorldProcessContext::UpdateIslandStepUnitTime(double dMeasuredTime, size_t nMeasuredUnits)
+{
+    dIASSERT(nMeasuredUnits != 0);
+
+    // Timer resolution may turn very short measurements into zeros. Such samples are not accounted.
+    if (dMeasuredTime > 0.0)
+    {
+        double dSampleUnitTime = dMeasuredTime / (double)nMeasuredUnits;
+
+        dxMutexGroupLockHelper lhLockHelper(m_pswObjectsAllocWorld, m_pmgStepperMutexGroup, dxPCM_STEPPER_COSTMODEL_UPDATE);
+        m_dIslandStepUnitTime += (dSampleUnitTime - m_dIslandStepUnitTime) * dxISLAND_COST_UPDATE_WEIGHT;
+    }
+}
+
+
 //****************************************************************************
 // Threading call contexts
 
@@ -347,12 +460,20 @@ struct dxIslandsProcessingCallContext
 {
     dxIslandsProcessingCallContext(dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, dReal stepSize, dstepper_fn_t stepper):
         m_world(world), m_islandsInfo(islandsInfo), m_stepSize(stepSize), m_stepper(stepper),
-        m_groupReleasee(NULL), m_islandToProcessStorage(0), m_stepperAllowedThreads(0)
+        m_groupReleasee(NULL), m_islandToProcessStorage(0), m_stepperAllowedThreads(0), m_islandStepUnitTime(0.0), 
+        m_stepRandomSeed(0), m_profileSteppingStart(0.0)
     {
     }
 
     void AssignGroupReleasee(dCallReleaseeID groupReleasee) { m_groupReleasee = groupReleasee; }
     void SetStepperAllowedThreads(unsigned allowedThreadsLimit) { m_stepperAllowedThreads = allowedThreadsLimit; }
+    void SetIslandStepUnitTime(double unitTime) { m_islandStepUnitTime = unitTime; }
+    void SetStepRandomSeed(duint32 stepRandomSeed) { m_stepRandomSeed = stepRandomSeed; }
+    void SetProfileSteppingStart(double startTime) { m_profileSteppingStart = startTime; }
+
+    duint32 MakeIslandRandomSeed(size_t islandIndex) const;
+
+    unsigned SelectIslandStepperThreads(size_t islandCostUnits) const;
 
     static int ThreadedProcessGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
     bool ThreadedProcessGroup();
@@ -375,6 +496,9 @@ struct dxIslandsProcessingCallContext
     dCallReleaseeID                 m_groupReleasee;
     size_t                          volatile m_islandToProcessStorage;
     unsigned                        m_stepperAllowedThreads;
+    double                          m_islandStepUnitTime;
+    duint32                         m_stepRandomSeed;
+    double                          m_profileSteppingStart;
 };
 
 
@@ -385,7 +509,9 @@ struct dxSingleIslandCallContext
         dxBody *const *islandBodiesStart, dxJoint *const *islandJointsStart):
         m_islandsProcessingContext(islandsProcessingContext), m_islandIndex(0), 
         m_stepperArena(stepperArena), m_arenaInitialState(arenaInitialState), 
-        m_stepperCallContext(islandsProcessingContext->m_world, islandsProcessingContext->m_stepSize, islandsProcessingContext->m_stepperAllowedThreads, stepperArena, islandBodiesStart, islandJointsStart)
+        m_stepperCallContext(islandsProcessingContext->m_world, islandsProcessingContext->m_stepSize, islandsProcessingContext->m_stepperAllowedThreads, stepperArena, islandBodiesStart, islandJointsStart),
+        m_timedIslandUnits(0), m_measuredIslandUnits(0), m_measuredIslandTime(0.0), 
+        m_profileIslandPending(false), m_profileQueuedStart(0.0), m_profileIslandStart(0.0)
     {
     }
 
@@ -413,11 +539,64 @@ struct dxSingleIslandCallContext
         m_stepperCallContext.AssignStepperCallFinalReleasee(finalReleasee);
     }
 
+    void AssignStepperAllowedThreads(unsigned stepperAllowedThreads)
+    {
+        m_stepperCallContext.AssignStepperAllowedThreads(stepperAllowedThreads);
+    }
+
+    void AssignIslandIndex(unsigned islandIndex)
+    {
+        m_stepperCallContext.AssignIslandIndex(islandIndex);
+    }
+
+    void AssignIslandRandomSeed(duint32 islandRandomSeed)
+    {
+        m_stepperCallContext.AssignIslandRandomSeed(islandRandomSeed);
+    }
+
+    // Islands stepped by a single thread are stepped entirely within the stepper call and can be timed around it
+    void AssignIslandTimedUnits(size_t islandCostUnits)
+    {
+        m_timedIslandUnits = islandCostUnits;
+    }
+
+    void AccountIslandTiming(double stepperTime)
+    {
+        m_measuredIslandUnits += m_timedIslandUnits;
+        m_measuredIslandTime += stepperTime;
+    }
+
+    void StartIslandProfiling(dxStepProfile *profile)
+    {
+        m_profileQueuedStart = profile->GetCurrentTime();
+        m_profileIslandPending = true;
+    }
+
+    void StartIslandStepperProfiling(dxStepProfile *profile)
+    {
+        m_profileIslandStart = profile->GetCurrentTime();
+        profile->RecordEvent(dSTEPPROFILE_EVENT_QUEUED, "Island Queued", m_stepperCallContext.m_islandIndex, m_profileQueuedStart, m_profileIslandStart);
+    }
+
+    void FinishIslandProfiling(dxStepProfile *profile)
+    {
+        if (m_profileIslandPending) {
+            profile->RecordEvent(dSTEPPROFILE_EVENT_ISLAND, "Island", m_stepperCallContext.m_islandIndex, m_profileIslandStart, profile->GetCurrentTime());
+            m_profileIslandPending = false;
+        }
+    }
+
     dxIslandsProcessingCallContext  *m_islandsProcessingContext;
     size_t                          m_islandIndex;
     dxWorldProcessMemArena          *m_stepperArena;
     void                            *m_arenaInitialState;
     dxStepperProcessingCallContext  m_stepperCallContext;
+    size_t                          m_timedIslandUnits;
+    size_t                          m_measuredIslandUnits;
+    double                          m_measuredIslandTime;
+    bool                            m_profileIslandPending;
+    double                          m_profileQueuedStart;
+    double                          m_profileIslandStart;
 };
 
 
@@ -594,8 +773,17 @@ void dxStepBody (dxBody *b, dReal h)
     // end of angular velocity cap
 
 
-    // handle linear velocity
-    for (unsigned int j=0; j<3; j++) b->posr.pos[j] += h * b->lvel[j];
+    dxWorldProcessContext *world_process_context = b->world->UnsafeGetWorldProcessingContext(); 
+
+    // handle linear velocity, stopping at the first static geom in the way
+    // for CCD bodies
+    dReal linear_h = h;
+    if (b->ccd_space) {
+        dVector3 motion;
+        dCopyScaledVector3 (motion,b->lvel,h);
+        linear_h *= dxSweepBody (b,motion);
+    }
+    for (unsigned int j=0; j<3; j++) b->posr.pos[j] += linear_h * b->lvel[j];
 
     if (b->flags & dxBodyFlagFiniteRotation) {
         dVector3 irv;	// infitesimal rotation vector
@@ -660,11 +848,17 @@ void dxStepBody (dxBody *b, dReal h)
     dQtoR (b->q,b->posr.R);
 
     // notify all attached geoms that this body has moved
-    dxWorldProcessContext *world_process_context = b->world->UnsafeGetWorldProcessingContext(); 
-    for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom)) {
-        world_process_context->LockForStepbodySerialization();
-        dGeomMoved (geom);
-        world_process_context->UnlockForStepbodySerialization();
+    if (!b->world->step_deterministic) {
+        for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom)) {
+            world_process_context->LockForStepbodySerialization();
+            dGeomMoved (geom);
+            world_process_context->UnlockForStepbodySerialization();
+        }
+    }
+    else if (b->geom != NULL) {
+        // The order of notifications changes the order of geoms in spaces and hence the order of 
+        // collision pairs. The geoms are notified in the order of bodies after all the islands complete.
+        b->flags |= dxBodyGeomsMovePending;
     }
 
     // notify the user
@@ -692,6 +886,23 @@ void dxStepBody (dxBody *b, dReal h)
 }
 
 
+
+// Notifies the geoms of the bodies moved by the step in deterministic stepping mode
+void dxNotifyStepMovedGeoms (dxWorld *world)
+{
+    if (world->step_deterministic) {
+        for (dxBody *b = world->firstbody; b; b = (dxBody *)b->next) {
+            if (b->flags & dxBodyGeomsMovePending) {
+                b->flags &= ~dxBodyGeomsMovePending;
+
+                for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom)) {
+                    dGeomMoved (geom);
+                }
+            }
+        }
+    }
+}
+
 //****************************************************************************
 // island processing
 
@@ -873,6 +1084,105 @@ static unsigned EstimateIslandProcessingSimultaneousCallsMaximumCount(unsigned a
     return result;
 }
 
+static unsigned EstimateWorldIslandsProcessingCallsAndThreads(dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, 
+    unsigned &outIslandsJobCount, unsigned &outStepperAllowedThreadCount, dmaxcallcountestimate_fn_t maxCallCountEstimator)
+{
+    unsigned activeThreadCount;
+    const unsigned islandsAllowedThreadCount = world->GetThreadingIslandsMaxThreadsCount(&activeThreadCount);
+    dIASSERT(islandsAllowedThreadCount != 0);
+    dIASSERT(activeThreadCount >= islandsAllowedThreadCount);
+
+    unsigned stepperAllowedThreadCount = islandsAllowedThreadCount; // For now, set stepper allowed threads equal to island stepping threads
+
+    // There is no use in starting more island searching jobs than there are islands.
+    // The threads left idle are then free to step islands of other worlds.
+    const size_t islandsCount = islandsInfo.GetIslandsCount();
+    unsigned islandsJobCount = islandsCount < islandsAllowedThreadCount ? dMAX((unsigned)islandsCount, 1U) : islandsAllowedThreadCount;
+
+    outIslandsJobCount = islandsJobCount;
+    outStepperAllowedThreadCount = stepperAllowedThreadCount;
+
+    unsigned simultaneousCallsCount = EstimateIslandProcessingSimultaneousCallsMaximumCount(activeThreadCount, islandsJobCount, stepperAllowedThreadCount, maxCallCountEstimator);
+    return simultaneousCallsCount;
+}
+
+static void StartWorldIslandsProcessing(dxIslandsProcessingCallContext *callContext, int *summaryFault, 
+    unsigned islandsJobCount, unsigned stepperAllowedThreadCount)
+{
+    dxWorld *world = callContext->m_world;
+    dxWorldProcessContext *context = world->UnsafeGetWorldProcessingContext(); 
+    dCallWaitID pcwGroupCallWait = context->GetIslandsSteppingWait();
+
+    dxGatherSweepCandidates(world);
+
+    if (world->step_profile != NULL) {
+        callContext->SetProfileSteppingStart(world->step_profile->GetCurrentTime());
+    }
+
+    dCallReleaseeID groupReleasee;
+    // First post a group call with dependency count set to number of expected threads
+    world->PostThreadedCall(summaryFault, &groupReleasee, islandsJobCount, NULL, pcwGroupCallWait, 
+        &dxIslandsProcessingCallContext::ThreadedProcessGroup_Callback, (void *)callContext, 0, "World Islands Stepping Group");
+
+    callContext->AssignGroupReleasee(groupReleasee);
+    callContext->SetStepperAllowedThreads(stepperAllowedThreadCount);
+    callContext->SetIslandStepUnitTime(context->GetIslandStepUnitTime());
+    // A step consumes a single value of the world's sequence and islands derive their seeds from it 
+    // by index so that the seeds do not depend on the order the islands are stepped in
+    callContext->SetStepRandomSeed((duint32)dxRandSeeded(&world->step_random_seed));
+
+    // Summary fault flag may be omitted as any failures will automatically propagate to dependent releasee (i.e. to groupReleasee)
+    world->PostThreadedCallsGroup(NULL, islandsJobCount, groupReleasee, 
+        &dxIslandsProcessingCallContext::ThreadedProcessJobStart_Callback, (void *)callContext, "World Islands Stepping Start");
+}
+
+// Serial part of the step after all the islands have been processed
+static void CompleteWorldIslandsProcessing(dxIslandsProcessingCallContext *callContext)
+{
+    dxWorld *world = callContext->m_world;
+
+    dxNotifyStepMovedGeoms(world);
+
+    dxStepProfile *profile = world->step_profile;
+    if (profile != NULL) {
+        profile->RecordThreadedPhase("World Islands Stepping", callContext->m_profileSteppingStart, profile->GetCurrentTime());
+        profile->FinishStep();
+    }
+}
+
+static void WaitWorldIslandsProcessing(dxIslandsProcessingCallContext *callContext)
+{
+    dxWorld *world = callContext->m_world;
+    dxWorldProcessContext *context = world->UnsafeGetWorldProcessingContext(); 
+    dCallWaitID pcwGroupCallWait = context->GetIslandsSteppingWait();
+
+    // Wait until group completes (since jobs were the dependencies of the group the group is going to complete only after all the jobs end)
+    world->WaitThreadedCallExclusively(NULL, pcwGroupCallWait, NULL, "World Islands Stepping Wait");
+
+    CompleteWorldIslandsProcessing(callContext);
+}
+
+static bool PollWorldIslandsProcessing(dxIslandsProcessingCallContext *callContext)
+{
+    dxWorld *world = callContext->m_world;
+    dxWorldProcessContext *context = world->UnsafeGetWorldProcessingContext(); 
+    dCallWaitID pcwGroupCallWait = context->GetIslandsSteppingWait();
+
+    const dThreadedWaitTime zeroTimeout = { 0, 0 };
+
+    int waitStatus = 0;
+    world->WaitThreadedCallCollectively(&waitStatus, pcwGroupCallWait, &zeroTimeout, "World Islands Stepping Poll");
+
+    if (waitStatus != 0) {
+        // The wait is consumed on success and must be reset the same way as after an exclusive wait
+        world->ResetThreadedCallWait(pcwGroupCallWait);
+
+        CompleteWorldIslandsProcessing(callContext);
+    }
+
+    return waitStatus != 0;
+}
+
 // this groups all joints and bodies in a world into islands. all objects
 // in an island are reachable by going through connected bodies and joints.
 // each island can be simulated separately.
@@ -891,42 +1201,100 @@ bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsI
     dxIslandsProcessingCallContext callContext(world, islandsInfo, stepSize, stepper);
 
     do {
-        dxStepWorkingMemory *wmem = world->wmem;
-        dIASSERT(wmem != NULL);
-        dxWorldProcessContext *context = wmem->GetWorldProcessingContext(); 
-        dIASSERT(context != NULL);
-        dCallWaitID pcwGroupCallWait = context->GetIslandsSteppingWait();
+        dIASSERT(world->wmem != NULL && world->wmem->GetWorldProcessingContext() != NULL);
 
         int summaryFault = 0;
 
-        unsigned activeThreadCount;
-        const unsigned islandsAllowedThreadCount = world->GetThreadingIslandsMaxThreadsCount(&activeThreadCount);
-        dIASSERT(islandsAllowedThreadCount != 0);
-        dIASSERT(activeThreadCount >= islandsAllowedThreadCount);
+        unsigned islandsJobCount, stepperAllowedThreadCount;
+        unsigned simultaneousCallsCount = EstimateWorldIslandsProcessingCallsAndThreads(world, islandsInfo, islandsJobCount, stepperAllowedThreadCount, maxCallCountEstimator);
+        if (!world->PreallocateResourcesForThreadedCalls(simultaneousCallsCount)) {
+            break;
+        }
 
-        unsigned stepperAllowedThreadCount = islandsAllowedThreadCount; // For now, set stepper allowed threads equal to island stepping threads
+        StartWorldIslandsProcessing(&callContext, &summaryFault, islandsJobCount, stepperAllowedThreadCount);
+        WaitWorldIslandsProcessing(&callContext);
 
-        unsigned simultaneousCallsCount = EstimateIslandProcessingSimultaneousCallsMaximumCount(activeThreadCount, islandsAllowedThreadCount, stepperAllowedThreadCount, maxCallCountEstimator);
-        if (!world->PreallocateResourcesForThreadedCalls(simultaneousCallsCount)) {
+        if (summaryFault != 0) {
             break;
         }
 
-        dCallReleaseeID groupReleasee;
-        // First post a group call with dependency count set to number of expected threads
-        world->PostThreadedCall(&summaryFault, &groupReleasee, islandsAllowedThreadCount, NULL, pcwGroupCallWait, 
-            &dxIslandsProcessingCallContext::ThreadedProcessGroup_Callback, (void *)&callContext, 0, "World Islands Stepping Group");
+        result = true;
+    }
+    while (false);
 
-        callContext.AssignGroupReleasee(groupReleasee);
-        callContext.SetStepperAllowedThreads(stepperAllowedThreadCount);
+    return result;
+}
 
-        // Summary fault flag may be omitted as any failures will automatically propagate to dependent releasee (i.e. to groupReleasee)
-        world->PostThreadedCallsGroup(NULL, islandsAllowedThreadCount, groupReleasee, 
-            &dxIslandsProcessingCallContext::ThreadedProcessJobStart_Callback, (void *)&callContext, "World Islands Stepping Start");
 
-        // Wait until group completes (since jobs were the dependencies of the group the group is going to complete only after all the jobs end)
-        world->WaitThreadedCallExclusively(NULL, pcwGroupCallWait, NULL, "World Islands Stepping Wait");
+struct dxIslandsBatchEntry
+{
+    dxIslandsBatchEntry(dxWorld *world, dReal stepSize, dstepper_fn_t stepper):
+        m_islandsInfo(), m_callContext(world, m_islandsInfo, stepSize, stepper), 
+        m_summaryFault(0), m_islandsJobCount(0), m_stepperAllowedThreadCount(0)
+    {
+    }
 
-        if (summaryFault != 0) {
+    dxWorldProcessIslandsInfo       m_islandsInfo;
+    dxIslandsProcessingCallContext  m_callContext;
+    int                             m_summaryFault;
+    unsigned                        m_islandsJobCount;
+    unsigned                        m_stepperAllowedThreadCount;
+};
+
+// Steps several worlds sharing the same threading implementation at once.
+// The islands of all the worlds are posted before any of them is waited for 
+// so that threads that run out of islands in one world can proceed with the others.
+bool dxProcessIslandsBatch (dxWorld *const *worlds, unsigned worldCount, dReal stepSize, 
+    dmemestimate_fn_t stepperEstimate, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator)
+{
+    bool result = false;
+
+    const size_t entriesSize = worldCount * sizeof(dxIslandsBatchEntry);
+    dxIslandsBatchEntry *entries = (dxIslandsBatchEntry *)dAlloc(entriesSize);
+
+    do {
+        if (entries == NULL) {
+            break;
+        }
+
+        unsigned simultaneousCallsCount = 0;
+
+        unsigned preparedCount = 0;
+        for (; preparedCount != worldCount; ++preparedCount) {
+            dxWorld *world = worlds[preparedCount];
+            dxIslandsBatchEntry *entry = new(entries + preparedCount) dxIslandsBatchEntry(world, stepSize, stepper);
+
+            if (!dxReallocateWorldProcessContext(world, entry->m_islandsInfo, stepSize, stepperEstimate)) {
+                break;
+            }
+
+            simultaneousCallsCount += EstimateWorldIslandsProcessingCallsAndThreads(world, entry->m_islandsInfo, 
+                entry->m_islandsJobCount, entry->m_stepperAllowedThreadCount, maxCallCountEstimator);
+        }
+
+        if (preparedCount != worldCount) {
+            break;
+        }
+
+        // All the worlds post their calls to the same implementation 
+        // and the resources are to be preallocated for all of them together
+        if (!worlds[0]->PreallocateResourcesForThreadedCalls(simultaneousCallsCount)) {
+            break;
+        }
+
+        for (unsigned startIndex = 0; startIndex != worldCount; ++startIndex) {
+            dxIslandsBatchEntry *entry = entries + startIndex;
+            StartWorldIslandsProcessing(&entry->m_callContext, &entry->m_summaryFault, entry->m_islandsJobCount, entry->m_stepperAllowedThreadCount);
+        }
+
+        bool anyFault = false;
+
+        for (unsigned waitIndex = 0; waitIndex != worldCount; ++waitIndex) {
+            WaitWorldIslandsProcessing(&entries[waitIndex].m_callContext);
+            anyFault = anyFault || entries[waitIndex].m_summaryFault != 0;
+        }
+
+        if (anyFault) {
             break;
         }
 
@@ -934,9 +1302,93 @@ bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsI
     }
     while (false);
 
+    if (entries != NULL) {
+        // The entries have trivial destructors and need not be destroyed
+        dFree(entries, entriesSize);
+    }
+
+    return result;
+}
+
+
+struct dxWorldStepRequest:
+    public dBase
+{
+    dxWorldStepRequest(dxWorld *world, dReal stepSize, dstepper_fn_t stepper):
+        m_entry(world, stepSize, stepper), m_completed(false)
+    {
+    }
+
+    dxIslandsBatchEntry     m_entry;
+    bool                    m_completed;
+};
+
+// Builds islands and posts them for stepping without waiting for completion.
+// The request returned must be passed to dxFinishProcessingIslands() later.
+dxWorldStepRequest *dxStartProcessingIslands (dxWorld *world, dReal stepSize, 
+    dmemestimate_fn_t stepperEstimate, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator)
+{
+    dxWorldStepRequest *result = NULL;
+
+    dxWorldStepRequest *request = new dxWorldStepRequest(world, stepSize, stepper);
+
+    do {
+        if (request == NULL) {
+            break;
+        }
+
+        dxIslandsBatchEntry *entry = &request->m_entry;
+
+        if (!dxReallocateWorldProcessContext(world, entry->m_islandsInfo, stepSize, stepperEstimate)) {
+            break;
+        }
+
+        unsigned simultaneousCallsCount = EstimateWorldIslandsProcessingCallsAndThreads(world, entry->m_islandsInfo, 
+            entry->m_islandsJobCount, entry->m_stepperAllowedThreadCount, maxCallCountEstimator);
+        if (!world->PreallocateResourcesForThreadedCalls(simultaneousCallsCount)) {
+            break;
+        }
+
+        StartWorldIslandsProcessing(&entry->m_callContext, &entry->m_summaryFault, entry->m_islandsJobCount, entry->m_stepperAllowedThreadCount);
+
+        result = request;
+    }
+    while (false);
+
+    if (result == NULL) {
+        delete request;
+    }
+
     return result;
 }
 
+bool dxPollProcessingIslands (dxWorldStepRequest *request)
+{
+    if (!request->m_completed) {
+        request->m_completed = PollWorldIslandsProcessing(&request->m_entry.m_callContext);
+    }
+
+    return request->m_completed;
+}
+
+// Waits for the request to complete (if necessary) and releases it
+bool dxFinishProcessingIslands (dxWorldStepRequest *request)
+{
+    if (!request->m_completed) {
+        WaitWorldIslandsProcessing(&request->m_entry.m_callContext);
+    }
+
+    bool result = request->m_entry.m_summaryFault == 0;
+    delete request;
+
+    return result;
+}
+
+dxWorld *dxGetProcessingIslandsWorld (const dxWorldStepRequest *request)
+{
+    return request->m_entry.m_callContext.m_world;
+}
+
 
 int dxIslandsProcessingCallContext::ThreadedProcessGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
 {
@@ -993,6 +1445,11 @@ void dxIslandsProcessingCallContext::ThreadedProcessIslandSearch(dxSingleIslandC
 {
     bool finalizeJob = false;
 
+    dxStepProfile *profile = m_world->step_profile;
+    if (profile != NULL) {
+        stepperCallContext->FinishIslandProfiling(profile);
+    }
+
     const dxWorldProcessIslandsInfo &islandsInfo = m_islandsInfo;
     unsigned int const *islandSizes = islandsInfo.GetIslandSizes();
 
@@ -1020,6 +1477,18 @@ void dxIslandsProcessingCallContext::ThreadedProcessIslandSearch(dxSingleIslandC
                 // Restore saved stepper memory arena position
                 stepperCallContext->RestoreSavedMemArenaStateForStepper();
 
+                size_t islandCostUnits = (size_t)bcount + (size_t)jcount * dxISLAND_COST_JOINT_WEIGHT;
+                unsigned islandThreads = SelectIslandStepperThreads(islandCostUnits);
+                stepperCallContext->AssignStepperAllowedThreads(islandThreads);
+                stepperCallContext->AssignIslandIndex((unsigned)islandToProcess);
+                stepperCallContext->AssignIslandRandomSeed(MakeIslandRandomSeed(islandToProcess));
+
+                stepperCallContext->AssignIslandTimedUnits(islandThreads == 1 ? islandCostUnits : 0);
+
+                if (profile != NULL) {
+                    stepperCallContext->StartIslandProfiling(profile);
+                }
+
                 dCallReleaseeID nextSearchReleasee;
 
                 // Summary fault flag may be omitted as any failures will automatically propagate to dependent releasee (i.e. to m_groupReleasee)
@@ -1043,14 +1512,39 @@ void dxIslandsProcessingCallContext::ThreadedProcessIslandSearch(dxSingleIslandC
     }
 
     if (finalizeJob) {
+        dxWorldProcessContext *context = m_world->UnsafeGetWorldProcessingContext(); 
+
+        if (stepperCallContext->m_measuredIslandUnits != 0) {
+            context->UpdateIslandStepUnitTime(stepperCallContext->m_measuredIslandTime, stepperCallContext->m_measuredIslandUnits);
+        }
+
         dxWorldProcessMemArena *stepperArena = stepperCallContext->m_stepperArena;
         stepperCallContext->dxSingleIslandCallContext::~dxSingleIslandCallContext();
 
-        dxWorldProcessContext *context = m_world->UnsafeGetWorldProcessingContext(); 
         context->ReturnStepperMemArena(stepperArena);
     }
 }
 
+unsigned dxIslandsProcessingCallContext::SelectIslandStepperThreads(size_t islandCostUnits) const
+{
+    const unsigned allowedThreads = m_stepperAllowedThreads;
+    dIASSERT(allowedThreads != 0);
+
+    unsigned result = 1;
+
+    // The multithreaded stepper stages accumulate in an order that depends on thread timing 
+    // and therefore each island is stepped by a single thread in deterministic mode.
+    if (allowedThreads != 1 && !m_world->step_deterministic) {
+        // Give the island as many threads as there are thread grains in its estimated stepping time.
+        // Small islands are stepped by a single thread and do not pay for the parallel processing overhead.
+        double islandTime = (double)islandCostUnits * m_islandStepUnitTime;
+        double islandGrains = islandTime * (1.0 / dxISLAND_COST_THREAD_GRAIN_TIME);
+        result = islandGrains >= (double)allowedThreads ? allowedThreads : dMAX((unsigned)islandGrains, 1U);
+    }
+
+    return result;
+}
+
 int dxIslandsProcessingCallContext::ThreadedProcessIslandStepper_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
 {
     (void)callInstanceIndex; // unused
@@ -1062,7 +1556,27 @@ int dxIslandsProcessingCallContext::ThreadedProcessIslandStepper_Callback(void *
 
 void dxIslandsProcessingCallContext::ThreadedProcessIslandStepper(dxSingleIslandCallContext *stepperCallContext)
 {
-    m_stepper(&stepperCallContext->m_stepperCallContext);
+    dxStepProfile *profile = m_world->step_profile;
+    if (profile != NULL) {
+        stepperCallContext->StartIslandStepperProfiling(profile);
+    }
+
+    if (stepperCallContext->m_timedIslandUnits != 0) {
+        const double stepperStart = dxGetMonotonicTime();
+        m_stepper(&stepperCallContext->m_stepperCallContext);
+        stepperCallContext->AccountIslandTiming(dxGetMonotonicTime() - stepperStart);
+    }
+    else {
+        m_stepper(&stepperCallContext->m_stepperCallContext);
+    }
+}
+
+duint32 dxIslandsProcessingCallContext::MakeIslandRandomSeed(size_t islandIndex) const
+{
+    // Islands are numbered in the order of bodies in the world and the index is stable for a given world state
+    duint32 islandRandomSeed = m_stepRandomSeed ^ ((duint32)islandIndex * (duint32)0x9E3779B9);
+    dxRandSeeded(&islandRandomSeed); // Scramble the neighbor indices apart
+    return islandRandomSeed;
 }
 
 size_t dxIslandsProcessingCallContext::ObtainNextIslandToBeProcessed(size_t islandsCount)
@@ -1099,7 +1613,7 @@ dxWorldProcessMemArena *dxWorldProcessMemArena::ReallocateMemArena (
             size_t memreq_with_reserve = memreq + (arenareq_with_reserve - arenareq);
 
             if (oldarena != NULL) {
-                oldarena->m_pArenaMemMgr->m_fnFree(pOldArenaBuffer, nOldArenaSize);
+                oldarena->FreeArenaBuffer(pOldArenaBuffer, nOldArenaSize);
                 oldarena = NULL;
 
                 // Zero variables to avoid another freeing on exit
@@ -1108,7 +1622,10 @@ dxWorldProcessMemArena *dxWorldProcessMemArena::ReallocateMemArena (
             }
 
             // Allocate new arena
-            void *pNewArenaBuffer = memmgr->m_fnAlloc(arenareq_with_reserve);
+            const int iNUMANode = memmgr->m_iNUMANode;
+            void *pNewArenaBuffer = iNUMANode >= 0 
+                ? AllocateMemoryOnNUMANode(arenareq_with_reserve, iNUMANode) 
+                : memmgr->m_fnAlloc(arenareq_with_reserve);
             if (pNewArenaBuffer == NULL) {
                 break;
             }
@@ -1123,6 +1640,7 @@ dxWorldProcessMemArena *dxWorldProcessMemArena::ReallocateMemArena (
             arena->m_pArenaBegin = pNewArenaBuffer;
             arena->m_pAllocCurrentOrNextArena = NULL;
             arena->m_pArenaMemMgr = memmgr;
+            arena->m_bArenaMapped = iNUMANode >= 0;
         }
 
         allocsuccess = true;
@@ -1132,7 +1650,7 @@ dxWorldProcessMemArena *dxWorldProcessMemArena::ReallocateMemArena (
     if (!allocsuccess) {
         if (pOldArenaBuffer != NULL) {
             dIASSERT(oldarena != NULL);
-            oldarena->m_pArenaMemMgr->m_fnFree(pOldArenaBuffer, nOldArenaSize);
+            oldarena->FreeArenaBuffer(pOldArenaBuffer, nOldArenaSize);
         }
         arena = NULL;
     }
@@ -1146,7 +1664,17 @@ void dxWorldProcessMemArena::FreeMemArena (dxWorldProcessMemArena *arena)
     size_t arenasize = dxWorldProcessMemArena::MakeArenaSize(memsize);
 
     void *pArenaBegin = arena->m_pArenaBegin;
-    arena->m_pArenaMemMgr->m_fnFree(pArenaBegin, arenasize);
+    arena->FreeArenaBuffer(pArenaBegin, arenasize);
+}
+
+void dxWorldProcessMemArena::FreeArenaBuffer(void *pArenaBuffer, size_t nArenaSize) const
+{
+    if (m_bArenaMapped) {
+        FreeMemoryOnNUMANode(pArenaBuffer, nArenaSize);
+    }
+    else {
+        m_pArenaMemMgr->m_fnFree(pArenaBuffer, nArenaSize);
+    }
 }
 
 
@@ -1164,6 +1692,8 @@ bool dxReallocateWorldProcessContext (dxWorld *world, dxWorldProcessIslandsInfo
 {
     bool result = false;
 
+    dxStepProfileScope profileScope(world->step_profile, dSTEPPROFILE_EVENT_WORLD, "World Islands Building");
+
     do
     {
         dxStepWorkingMemory *wmem = AllocateOnDemand(world->wmem);
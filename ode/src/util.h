@@ -63,6 +63,13 @@
 
 void dInternalHandleAutoDisabling (dxWorld *world, dReal stepsize);
 void dxStepBody (dxBody *b, dReal h);
+void dxNotifyStepMovedGeoms (dxWorld *world);
+
+// Returns the time in seconds, from an unspecified origin, of a clock that never goes back
+double dxGetMonotonicTime ();
+
+unsigned long dxRandSeeded (duint32 *state);
+int dxRandIntSeeded (duint32 *state, int n);
 
 
 struct dxWorldProcessMemoryManager:
@@ -72,7 +79,8 @@ struct dxWorldProcessMemoryManager:
     typedef void *(*shrink_block_fn_t)(void *block_pointer, size_t block_current_size, size_t block_smaller_size);
     typedef void (*free_block_fn_t)(void *block_pointer, size_t block_current_size);
 
-    dxWorldProcessMemoryManager(alloc_block_fn_t fnAlloc, shrink_block_fn_t fnShrink, free_block_fn_t fnFree)
+    dxWorldProcessMemoryManager(alloc_block_fn_t fnAlloc, shrink_block_fn_t fnShrink, free_block_fn_t fnFree):
+        m_iNUMANode(-1)
     {
         Assign(fnAlloc, fnShrink, fnFree);
     }
@@ -84,13 +92,18 @@ struct dxWorldProcessMemoryManager:
         m_fnFree = fnFree;
     }
 
+    void AssignNUMANode(int iNUMANode) { m_iNUMANode = iNUMANode; }
+
     alloc_block_fn_t m_fnAlloc;
     shrink_block_fn_t m_fnShrink;
     free_block_fn_t m_fnFree;
+    int m_iNUMANode; // Preferred node for the blocks mapped in place of m_fnAlloc or -1 to leave placement to the system
 };
 
 extern dxWorldProcessMemoryManager g_WorldProcessMallocMemoryManager;
 
+bool dxIsNUMAMemoryPlacementSupported();
+
 struct dxWorldProcessMemoryReserveInfo:
     public dBase
 {
@@ -216,6 +229,7 @@ public:
 
 private:
     static size_t AdjustArenaSizeForReserveRequirements(size_t arenareq, float rsrvfactor, unsigned rsrvminimum);
+    void FreeArenaBuffer(void *pArenaBuffer, size_t nArenaSize) const;
 
 private:
     void *m_pAllocCurrentOrNextArena;
@@ -224,6 +238,7 @@ private:
     void *m_pArenaBegin;
 
     const dxWorldProcessMemoryManager *m_pArenaMemMgr;
+    bool m_bArenaMapped; // The buffer has been mapped for a NUMA node rather than obtained from m_pArenaMemMgr
 };
 
 class dxWorldProcessContext:
@@ -268,12 +283,18 @@ public:
     void LockForStepbodySerialization();
     void UnlockForStepbodySerialization();
 
+public:
+    // Measured time per island cost unit for islands stepped by a single thread
+    double GetIslandStepUnitTime() const { return m_dIslandStepUnitTime; }
+    void UpdateIslandStepUnitTime(double dMeasuredTime, size_t nMeasuredUnits);
+
 private:
     enum dxProcessContextMutex
     {
         dxPCM_STEPPER_ARENA_OBTAIN,
         dxPCM_STEPPER_ADDLIMOT_SERIALIZE,
         dxPCM_STEPPER_STEPBODY_SERIALIZE,
+        dxPCM_STEPPER_COSTMODEL_UPDATE,
 
         dxPCM__MAX
     };
@@ -286,6 +307,7 @@ private:
     dxWorld                 *m_pswObjectsAllocWorld;
     dMutexGroupID           m_pmgStepperMutexGroup;
     dCallWaitID             m_pcwIslandsSteppingWait;
+    double                  m_dIslandStepUnitTime;
 };
 
 struct dxWorldProcessIslandsInfo
@@ -316,7 +338,7 @@ struct dxStepperProcessingCallContext
         dxWorldProcessMemArena *stepperArena, dxBody *const *islandBodiesStart, dxJoint *const *islandJointsStart): 
         m_world(world), m_stepSize(stepSize), m_stepperArena(stepperArena), m_finalReleasee(NULL), 
         m_islandBodiesStart(islandBodiesStart), m_islandJointsStart(islandJointsStart), m_islandBodiesCount(0), m_islandJointsCount(0),
-        m_stepperAllowedThreads(stepperAllowedThreads)
+        m_stepperAllowedThreads(stepperAllowedThreads), m_islandIndex(0), m_islandRandomSeed(0)
     {
     }
 
@@ -329,6 +351,21 @@ struct dxStepperProcessingCallContext
         m_islandJointsCount = islandJointsCount;
     }
 
+    void AssignStepperAllowedThreads(unsigned stepperAllowedThreads)
+    {
+        m_stepperAllowedThreads = stepperAllowedThreads;
+    }
+
+    void AssignIslandIndex(unsigned islandIndex)
+    {
+        m_islandIndex = islandIndex;
+    }
+
+    void AssignIslandRandomSeed(duint32 islandRandomSeed)
+    {
+        m_islandRandomSeed = islandRandomSeed;
+    }
+
     dxBody *const *GetSelectedIslandBodiesEnd() const { return m_islandBodiesStart + m_islandBodiesCount; }
     dxJoint *const *GetSelectedIslandJointsEnd() const { return m_islandJointsStart + m_islandJointsCount; }
 
@@ -346,6 +383,8 @@ struct dxStepperProcessingCallContext
     unsigned                m_islandBodiesCount;
     unsigned                m_islandJointsCount;
     unsigned                m_stepperAllowedThreads;
+    unsigned                m_islandIndex;      // The index of the island among the islands of the step
+    duint32                 m_islandRandomSeed; // The seed for the island's random sequences in deterministic stepping mode
 };
 
 #define BEGIN_STATE_SAVE(memarena, state) void *state = memarena->SaveState();
@@ -364,6 +403,17 @@ typedef size_t (*dmemestimate_fn_t) (dxBody * const *body, unsigned int nb,
 bool dxReallocateWorldProcessContext (dxWorld *world, dxWorldProcessIslandsInfo &islandsinfo, 
                                       dReal stepsize, dmemestimate_fn_t stepperestimate);
 
+struct dxWorldStepRequest;
+
+dxWorldStepRequest *dxStartProcessingIslands (dxWorld *world, dReal stepSize, 
+                                              dmemestimate_fn_t stepperEstimate, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator);
+bool dxPollProcessingIslands (dxWorldStepRequest *request);
+bool dxFinishProcessingIslands (dxWorldStepRequest *request);
+dxWorld *dxGetProcessingIslandsWorld (const dxWorldStepRequest *request);
+
+bool dxProcessIslandsBatch (dxWorld *const *worlds, unsigned worldCount, dReal stepSize, 
+                            dmemestimate_fn_t stepperEstimate, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator);
+
 dxWorldProcessMemArena *dxAllocateTemporaryWorldProcessMemArena(
     size_t memreq, const dxWorldProcessMemoryManager *memmgr/*=NULL*/, const dxWorldProcessMemoryReserveInfo *reserveinfo/*=NULL*/);
 void dxFreeTemporaryWorldProcessMemArena(dxWorldProcessMemArena *arena);
@@ -389,7 +439,7 @@ class dxStepWorkingMemory:
     public dBase
 {
 public:
-    dxStepWorkingMemory(): m_uiRefCount(1), m_ppcProcessingContext(NULL), m_priReserveInfo(NULL), m_pmmMemoryManager(NULL) {}
+    dxStepWorkingMemory(): m_uiRefCount(1), m_ppcProcessingContext(NULL), m_priReserveInfo(NULL), m_pmmMemoryManager(NULL), m_pwAsyncStepWorld(NULL) {}
 
 private:
     friend struct dBase; // To avoid GCC warning regarding private destructor
@@ -460,12 +510,22 @@ public:
     {
         if (m_pmmMemoryManager) { delete m_pmmMemoryManager; m_pmmMemoryManager = NULL; }
     }
+    // The memory can serve only one asynchronous step at a time and no other steps may be run while it does
+    dxWorld *GetAsyncStepWorld() const { return m_pwAsyncStepWorld; }
+    void AssignAsyncStepWorld(dxWorld *pwAsyncStepWorld) { m_pwAsyncStepWorld = pwAsyncStepWorld; }
+
+    void SetMemoryNUMANode(int iNUMANode)
+    {
+        if (!m_pmmMemoryManager) { m_pmmMemoryManager = new dxWorldProcessMemoryManager(g_WorldProcessMallocMemoryManager); }
+        if (m_pmmMemoryManager) { m_pmmMemoryManager->AssignNUMANode(iNUMANode); }
+    }
 
 private:
     unsigned m_uiRefCount;
     dxWorldProcessContext *m_ppcProcessingContext;
     dxWorldProcessMemoryReserveInfo *m_priReserveInfo;
     dxWorldProcessMemoryManager *m_pmmMemoryManager;
+    dxWorld *m_pwAsyncStepWorld; // The world being stepped asynchronously with the memory or NULL
 };
 
 
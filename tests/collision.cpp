@@ -1,5 +1,87 @@
 #include <UnitTest++.h>
 #include <ode/ode.h>
+#include "../ode/src/config.h"
+#include "../ode/src/collision_std.h"
+
+
+// Contact counts and deepest contacts of several geoms with one target
+struct CollisionResults
+{
+    dGeomID target;
+    const dGeomID *geoms;
+    int *contactCounts;
+    dReal *depths;
+};
+
+static void collideWithTarget(const CollisionResults &results, unsigned index)
+{
+    enum { MAX_CONTACTS = 64 };
+    dContactGeom cg[MAX_CONTACTS];
+    int nc = dCollide(results.target, results.geoms[index], MAX_CONTACTS, &cg[0], sizeof cg[0]);
+    dReal depth = 0;
+    for (int i=0; i<nc; ++i) {
+        depth = dMax(depth, cg[i].depth);
+    }
+    results.contactCounts[index] = nc;
+    results.depths[index] = depth;
+}
+
+static int collideWithTarget_Callback(void *call_context, dcallindex_t instance_index, dCallReleaseeID this_releasee)
+{
+    (void)this_releasee; // unused
+    collideWithTarget(*(const CollisionResults *)call_context, (unsigned)instance_index);
+    return 1;
+}
+
+static int collisionDone_Callback(void *call_context, dcallindex_t instance_index, dCallReleaseeID this_releasee)
+{
+    (void)call_context; // unused
+    (void)instance_index; // unused
+    (void)this_releasee; // unused
+    return 1;
+}
+
+// Collides each geom with the target in a call of its own, the calls running in the threads of a pool at once
+static bool collideWithTargetConcurrently(const CollisionResults &results, unsigned geomCount)
+{
+    dThreadingImplementationID threading = dThreadingAllocateMultiThreadedImplementation();
+    dThreadingThreadPoolID pool = threading != NULL ? dThreadingAllocateThreadPool(4, 0, dAllocateFlagBasicData | dAllocateFlagCollisionData, NULL) : NULL;
+    bool result = false;
+
+    if (pool != NULL) {
+        dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+        const dThreadingFunctionsInfo *functions = dThreadingImplementationGetFunctions(threading);
+
+        functions->preallocate_resources_for_calls(threading, geomCount + 1);
+        dCallWaitID collisionWait = functions->alloc_call_wait(threading);
+
+        if (collisionWait != NULL) {
+            int summaryFault = 0;
+            dCallReleaseeID collisionDone;
+            functions->post_call(threading, &summaryFault, &collisionDone, geomCount, NULL, collisionWait, 
+                &collisionDone_Callback, NULL, 0, "Collision Done");
+
+            for (unsigned index = 0; index != geomCount; ++index) {
+                functions->post_call(threading, NULL, NULL, 0, collisionDone, NULL, 
+                    &collideWithTarget_Callback, (void *)&results, index, "Target Collision");
+            }
+
+            functions->wait_call(threading, NULL, collisionWait, NULL, "Collision Wait");
+            functions->free_call_wait(threading, collisionWait);
+            result = summaryFault == 0;
+        }
+
+        dThreadingImplementationShutdownProcessing(threading);
+        dThreadingFreeThreadPool(pool);
+    }
+
+    if (threading != NULL) {
+        dThreadingFreeImplementation(threading);
+    }
+
+    return result;
+}
+
 
 TEST(test_collision_trimesh_sphere_exact)
 {
@@ -96,6 +178,639 @@ TEST(test_collision_trimesh_sphere_exact)
 }
 
 
+#ifdef dTRIMESH_ENABLED
+
+TEST(test_collision_trimesh_tc_cache)
+{
+    /*
+     * Collides a trimesh against many spheres with temporal coherence enabled,
+     * so that the TC cache has to grow while entries returned earlier stay valid.
+     */
+    {
+        const int VertexCount = 4;
+        const int IndexCount = 2*3;
+        float vertices[VertexCount * 3] = {
+            -10,-10,0,
+            10,-10,0,
+            10,10,0,
+            -10,10,0
+        };
+        dTriIndex indices[IndexCount] = {
+            0,1,2,
+            0,2,3
+        };
+
+        dTriMeshDataID data = dGeomTriMeshDataCreate();
+        dGeomTriMeshDataBuildSingle(data,
+                                    vertices,
+                                    3 * sizeof(float),
+                                    VertexCount,
+                                    indices,
+                                    IndexCount,
+                                    3 * sizeof(dTriIndex));
+        dGeomID trimesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomTriMeshEnableTC(trimesh, dSphereClass, 1);
+
+        const int SphereCount = 64;
+        const dReal radius = REAL(0.5);
+        dGeomID spheres[SphereCount];
+        for (int i=0; i<SphereCount; ++i) {
+            spheres[i] = dCreateSphere(0, radius);
+            dGeomSetPosition(spheres[i], -8 + (i % 8) * 2, -8 + (i / 8) * 2, radius * REAL(0.5));
+        }
+
+        dContactGeom cg[4];
+        for (int pass=0; pass<2; ++pass) {
+            for (int i=0; i<SphereCount; ++i) {
+                int nc = dCollide(trimesh, spheres[i], 4, &cg[0], sizeof cg[0]);
+                CHECK(nc >= 1);
+                if (nc >= 1) {
+                    CHECK_CLOSE(radius * REAL(0.5), cg[0].depth, 1e-2);
+                }
+            }
+        }
+
+        dGeomTriMeshClearTCCache(trimesh);
+        int nc = dCollide(trimesh, spheres[0], 4, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+
+        for (int i=0; i<SphereCount; ++i) {
+            dGeomDestroy(spheres[i]);
+        }
+        dGeomDestroy(trimesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // dTRIMESH_ENABLED
+
+
+#ifdef dTRIMESH_ENABLED
+
+static dTriMeshDataID trimesh_test_square(float vertices[4 * 3], dTriIndex indices[2 * 3])
+{
+    const float square[4 * 3] = {
+        -1,-1,0,
+        1,-1,0,
+        1,1,0,
+        -1,1,0
+    };
+    const dTriIndex triangles[2 * 3] = {
+        0,1,2,
+        0,2,3
+    };
+    for (int i=0; i<4 * 3; ++i) vertices[i] = square[i];
+    for (int i=0; i<2 * 3; ++i) indices[i] = triangles[i];
+
+    dTriMeshDataID data = dGeomTriMeshDataCreate();
+    dGeomTriMeshDataBuildSingle(data,
+                                vertices,
+                                3 * sizeof(float),
+                                4,
+                                indices,
+                                2 * 3,
+                                3 * sizeof(dTriIndex));
+    return data;
+}
+
+// Collides the box with both meshes and returns the deepest contact, or -1 if the meshes disagree
+static dReal trimesh_test_box_depth(dGeomID tcMesh, dGeomID plainMesh, dGeomID box)
+{
+    enum { MAX_CONTACTS = 16 };
+    dContactGeom cg[MAX_CONTACTS];
+    int tcCount = dCollide(tcMesh, box, MAX_CONTACTS, &cg[0], sizeof cg[0]);
+    dReal tcDepth = 0;
+    for (int i=0; i<tcCount; ++i) {
+        tcDepth = dMax(tcDepth, cg[i].depth);
+    }
+    int plainCount = dCollide(plainMesh, box, MAX_CONTACTS, &cg[0], sizeof cg[0]);
+    dReal plainDepth = 0;
+    for (int i=0; i<plainCount; ++i) {
+        plainDepth = dMax(plainDepth, cg[i].depth);
+    }
+    return tcCount == plainCount && tcDepth == plainDepth ? tcDepth : -1;
+}
+
+TEST(test_collision_trimesh_box_tc)
+{
+    /*
+     * Box temporal coherence is off by default. When enabled, the triangles
+     * found for the box are reused while it stays near its last query, and
+     * are found again once the box leaves or the mesh moves. The contacts
+     * must always be those of a mesh without TC.
+     */
+    {
+        float vertices[4 * 3];
+        dTriIndex indices[2 * 3];
+        dTriMeshDataID data = trimesh_test_square(vertices, indices);
+        dGeomID tcMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomID plainMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        CHECK_EQUAL(0, dGeomTriMeshIsTCEnabled(tcMesh, dBoxClass));
+        dGeomTriMeshEnableTC(tcMesh, dBoxClass, 1);
+        CHECK_EQUAL(1, dGeomTriMeshIsTCEnabled(tcMesh, dBoxClass));
+
+        dGeomID box = dCreateBox(0, 1, 1, 1);
+        dGeomSetPosition(box, 0, 0, REAL(0.4));
+
+        // Nothing is found while the mesh is away
+        dGeomSetPosition(tcMesh, 10, 0, 0);
+        dGeomSetPosition(plainMesh, 10, 0, 0);
+        CHECK_EQUAL(0, trimesh_test_box_depth(tcMesh, plainMesh, box));
+
+        // The mesh moves under the box, which stays where it was queried
+        dGeomSetPosition(tcMesh, 0, 0, 0);
+        dGeomSetPosition(plainMesh, 0, 0, 0);
+        CHECK_CLOSE(REAL(0.1), trimesh_test_box_depth(tcMesh, plainMesh, box), 1e-4);
+
+        // A small motion within the enlarged query box
+        dGeomSetPosition(box, REAL(0.02), 0, REAL(0.39));
+        CHECK_CLOSE(REAL(0.11), trimesh_test_box_depth(tcMesh, plainMesh, box), 1e-4);
+
+        // A motion out of the enlarged query box, over the mesh's edge
+        dGeomSetPosition(box, REAL(1.2), 0, REAL(0.3));
+        CHECK_CLOSE(REAL(0.2), trimesh_test_box_depth(tcMesh, plainMesh, box), 1e-4);
+
+        // The mesh is lifted under the box
+        dGeomSetPosition(tcMesh, 0, 0, REAL(0.05));
+        dGeomSetPosition(plainMesh, 0, 0, REAL(0.05));
+        CHECK_CLOSE(REAL(0.25), trimesh_test_box_depth(tcMesh, plainMesh, box), 1e-4);
+
+        // The box leaves the mesh
+        dGeomSetPosition(box, REAL(1.6), 0, REAL(0.3));
+        CHECK_EQUAL(0, trimesh_test_box_depth(tcMesh, plainMesh, box));
+
+        dGeomDestroy(box);
+        dGeomDestroy(plainMesh);
+        dGeomDestroy(tcMesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+TEST(test_collision_trimesh_small_motion)
+{
+    /*
+     * A mesh moved by much less than its size must collide at its new
+     * position, and colliding again without moving it must not change the
+     * contacts.
+     */
+    {
+        float vertices[4 * 3];
+        dTriIndex indices[2 * 3];
+        dTriMeshDataID data = trimesh_test_square(vertices, indices);
+        dGeomID trimesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomID box = dCreateBox(0, 1, 1, 1);
+        dGeomSetPosition(box, 0, 0, REAL(0.4));
+
+        dContactGeom cg[8];
+        int nc = dCollide(trimesh, box, 8, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        const dReal depth = nc >= 1 ? cg[0].depth : 0;
+        CHECK_CLOSE(REAL(0.1), depth, 1e-4);
+
+        dGeomSetPosition(trimesh, 0, 0, 0);
+        nc = dCollide(trimesh, box, 8, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        if (nc >= 1) {
+            CHECK_EQUAL(depth, cg[0].depth);
+        }
+
+        dGeomSetPosition(trimesh, 0, 0, REAL(4e-6));
+        nc = dCollide(trimesh, box, 8, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        if (nc >= 1) {
+            CHECK_CLOSE(REAL(4e-6), cg[0].depth - depth, 1e-6);
+        }
+
+        dGeomDestroy(box);
+        dGeomDestroy(trimesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // dTRIMESH_ENABLED
+
+
+// Trimesh collisions are only reentrant when the colliders do not share the global caches
+#if defined(dTRIMESH_ENABLED) && (defined(dTRIMESH_GIMPACT) || dTLS_ENABLED)
+
+enum { TERRAIN_GRID = 16 };
+
+static dReal trimesh_test_terrain_height(dReal x, dReal y)
+{
+    return REAL(0.25) * dSin(x) * dCos(y);
+}
+
+static dTriMeshDataID trimesh_test_terrain(float vertices[(TERRAIN_GRID + 1) * (TERRAIN_GRID + 1) * 3], 
+    dTriIndex indices[TERRAIN_GRID * TERRAIN_GRID * 6])
+{
+    for (int j=0; j<=TERRAIN_GRID; ++j) {
+        for (int i=0; i<=TERRAIN_GRID; ++i) {
+            float *v = vertices + (j * (TERRAIN_GRID + 1) + i) * 3;
+            v[0] = (float)(i - TERRAIN_GRID / 2);
+            v[1] = (float)(j - TERRAIN_GRID / 2);
+            v[2] = (float)trimesh_test_terrain_height(v[0], v[1]);
+        }
+    }
+    for (int j=0; j<TERRAIN_GRID; ++j) {
+        for (int i=0; i<TERRAIN_GRID; ++i) {
+            const dTriIndex v0 = (dTriIndex)(j * (TERRAIN_GRID + 1) + i);
+            const dTriIndex v1 = v0 + 1, v2 = v0 + (TERRAIN_GRID + 1), v3 = v2 + 1;
+            dTriIndex *tri = indices + (j * TERRAIN_GRID + i) * 6;
+            tri[0] = v0; tri[1] = v1; tri[2] = v3;
+            tri[3] = v0; tri[4] = v3; tri[5] = v2;
+        }
+    }
+
+    dTriMeshDataID data = dGeomTriMeshDataCreate();
+    dGeomTriMeshDataBuildSingle(data,
+                                vertices,
+                                3 * sizeof(float),
+                                (TERRAIN_GRID + 1) * (TERRAIN_GRID + 1),
+                                indices,
+                                TERRAIN_GRID * TERRAIN_GRID * 6,
+                                3 * sizeof(dTriIndex));
+    return data;
+}
+
+TEST(test_collision_trimesh_tc_concurrent)
+{
+    /*
+     * Boxes and spheres collide with a trimesh terrain with temporal
+     * coherence enabled from the threads of a pool at once, so that the
+     * TC caches are populated concurrently. Every geom must get the
+     * contacts it gets serially from a trimesh without TC.
+     */
+    {
+        const unsigned GeomCount = 128;
+        float vertices[(TERRAIN_GRID + 1) * (TERRAIN_GRID + 1) * 3];
+        dTriIndex indices[TERRAIN_GRID * TERRAIN_GRID * 6];
+        dTriMeshDataID data = trimesh_test_terrain(vertices, indices);
+        dGeomID plainMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomID tcMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomTriMeshEnableTC(tcMesh, dSphereClass, 1);
+        dGeomTriMeshEnableTC(tcMesh, dBoxClass, 1);
+
+        dGeomID geoms[GeomCount];
+        for (unsigned i=0; i<GeomCount; ++i) {
+            const dReal x = (dReal)(i % 12) - REAL(5.7), y = (dReal)(i / 12) - REAL(5.3);
+            geoms[i] = (i & 1) ? dCreateSphere(0, REAL(0.35)) : dCreateBox(0, REAL(0.6), REAL(0.6), REAL(0.6));
+            dGeomSetPosition(geoms[i], x, y, trimesh_test_terrain_height(x, y) + REAL(0.2));
+        }
+
+        int expectedCounts[GeomCount], contactCounts[GeomCount];
+        dReal expectedDepths[GeomCount], depths[GeomCount];
+        const CollisionResults expected = { plainMesh, geoms, expectedCounts, expectedDepths };
+        for (unsigned i=0; i<GeomCount; ++i) {
+            collideWithTarget(expected, i);
+            CHECK(expectedCounts[i] >= 1);
+        }
+
+        // The meshes' AABBs are computed before the threads read them
+        dReal aabb[6];
+        dGeomGetAABB(tcMesh, aabb);
+
+        const CollisionResults results = { tcMesh, geoms, contactCounts, depths };
+        for (int pass=0; pass<3; ++pass) {
+            if (pass == 2) {
+                dGeomTriMeshClearTCCache(tcMesh);
+            }
+
+            CHECK(collideWithTargetConcurrently(results, GeomCount));
+            for (unsigned i=0; i<GeomCount; ++i) {
+                CHECK_EQUAL(expectedCounts[i], contactCounts[i]);
+                CHECK_CLOSE(expectedDepths[i], depths[i], 1e-5);
+            }
+        }
+
+        for (unsigned i=0; i<GeomCount; ++i) {
+            dGeomDestroy(geoms[i]);
+        }
+        dGeomDestroy(tcMesh);
+        dGeomDestroy(plainMesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+TEST(test_collision_trimesh_concurrent)
+{
+    /*
+     * Geoms of every class with a trimesh collider collide with a trimesh
+     * terrain from the threads of a pool at once. With GIMPACT the
+     * queries share the mesh's pinned work data. Every geom must get the
+     * contacts it gets serially.
+     */
+    {
+        const unsigned GeomCount = 128;
+        float vertices[(TERRAIN_GRID + 1) * (TERRAIN_GRID + 1) * 3];
+        dTriIndex indices[TERRAIN_GRID * TERRAIN_GRID * 6];
+        dTriMeshDataID data = trimesh_test_terrain(vertices, indices);
+        dGeomID trimesh = dCreateTriMesh(0, data, 0, 0, 0);
+
+        dGeomID geoms[GeomCount];
+        for (unsigned i=0; i<GeomCount; ++i) {
+            const dReal x = (dReal)(i % 12) - REAL(5.7), y = (dReal)(i / 12) - REAL(5.3);
+            switch (i % 4) {
+                case 0: geoms[i] = dCreateSphere(0, REAL(0.35)); break;
+                case 1: geoms[i] = dCreateBox(0, REAL(0.6), REAL(0.6), REAL(0.6)); break;
+                case 2: geoms[i] = dCreateCapsule(0, REAL(0.25), REAL(0.5)); break;
+                default: geoms[i] = dCreateCylinder(0, REAL(0.3), REAL(0.6)); break;
+            }
+            dGeomSetPosition(geoms[i], x, y, trimesh_test_terrain_height(x, y) + REAL(0.2));
+        }
+
+        int expectedCounts[GeomCount], contactCounts[GeomCount];
+        dReal expectedDepths[GeomCount], depths[GeomCount];
+        const CollisionResults expected = { trimesh, geoms, expectedCounts, expectedDepths };
+        for (unsigned i=0; i<GeomCount; ++i) {
+            collideWithTarget(expected, i);
+            CHECK(expectedCounts[i] >= 1);
+        }
+
+        const CollisionResults results = { trimesh, geoms, contactCounts, depths };
+        for (int pass=0; pass<3; ++pass) {
+            CHECK(collideWithTargetConcurrently(results, GeomCount));
+            for (unsigned i=0; i<GeomCount; ++i) {
+                CHECK_EQUAL(expectedCounts[i], contactCounts[i]);
+                CHECK_CLOSE(expectedDepths[i], depths[i], 1e-5);
+            }
+        }
+
+        for (unsigned i=0; i<GeomCount; ++i) {
+            dGeomDestroy(geoms[i]);
+        }
+        dGeomDestroy(trimesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // defined(dTRIMESH_ENABLED) && (defined(dTRIMESH_GIMPACT) || dTLS_ENABLED)
+
+
+
+#ifdef dTRIMESH_OPCODE
+
+static dTriMeshDataID trimesh_trimesh_test_cube(float vertices[8 * 3], dTriIndex indices[12 * 3])
+{
+    for (int i=0; i<8; ++i) {
+        vertices[i * 3 + 0] = (i & 1) ? 1.0f : -1.0f;
+        vertices[i * 3 + 1] = (i & 2) ? 1.0f : -1.0f;
+        vertices[i * 3 + 2] = (i & 4) ? 1.0f : -1.0f;
+    }
+    // two counter-clockwise triangles per face, seen from outside
+    const dTriIndex faces[6][4] = {
+        { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, // -z, +z
+        { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, // -y, +y
+        { 0, 4, 6, 2 }, { 1, 3, 7, 5 }  // -x, +x
+    };
+    for (int f=0; f<6; ++f) {
+        dTriIndex *tri = indices + f * 6;
+        tri[0] = faces[f][0]; tri[1] = faces[f][1]; tri[2] = faces[f][2];
+        tri[3] = faces[f][0]; tri[4] = faces[f][2]; tri[5] = faces[f][3];
+    }
+
+    dTriMeshDataID data = dGeomTriMeshDataCreate();
+    dGeomTriMeshDataBuildSingle(data,
+                                vertices,
+                                3 * sizeof(float),
+                                8,
+                                indices,
+                                12 * 3,
+                                3 * sizeof(dTriIndex));
+    return data;
+}
+
+TEST(test_collision_trimesh_trimesh)
+{
+    /*
+     * Collides two trimesh cubes through the tree-vs-tree pair search.
+     * Overlapping cubes must produce face contacts of the overlap depth,
+     * and a rotated cube whose AABB overlaps without touching must not
+     * produce any (the face plane early-outs reject all of its pairs).
+     */
+    {
+        float vertices[8 * 3];
+        dTriIndex indices[12 * 3];
+        dTriMeshDataID data = trimesh_trimesh_test_cube(vertices, indices);
+        dGeomID mesh1 = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomID mesh2 = dCreateTriMesh(0, data, 0, 0, 0);
+
+        const dReal overlap = REAL(0.1);
+        dGeomSetPosition(mesh2, REAL(0.3), REAL(0.2), 2 - overlap);
+
+        const int MaxContacts = 16;
+        dContactGeom cg[MaxContacts];
+        int nc = dCollide(mesh1, mesh2, MaxContacts, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        int faceContacts = 0;
+        for (int i=0; i<nc; ++i) {
+            // All contacts lie in the overlap region of the cubes
+            CHECK(cg[i].pos[0] >= REAL(-0.7) - REAL(1e-4) && cg[i].pos[0] <= 1 + REAL(1e-4));
+            CHECK(cg[i].pos[1] >= REAL(-0.8) - REAL(1e-4) && cg[i].pos[1] <= 1 + REAL(1e-4));
+            CHECK(cg[i].pos[2] >= 1 - overlap - REAL(1e-4) && cg[i].pos[2] <= 1 + REAL(1e-4));
+            if (dFabs(cg[i].normal[2]) > REAL(0.9999)) {
+                CHECK_CLOSE(overlap, cg[i].depth, 1e-4);
+                ++faceContacts;
+            }
+        }
+        CHECK(faceContacts >= 3);
+
+        // Colliding again must reproduce the same contacts
+        dContactGeom cg2[MaxContacts];
+        int nc2 = dCollide(mesh1, mesh2, MaxContacts, &cg2[0], sizeof cg2[0]);
+        CHECK_EQUAL(nc, nc2);
+        for (int i=0; i<nc && i<nc2; ++i) {
+            CHECK_ARRAY_EQUAL(cg[i].pos, cg2[i].pos, 3);
+            CHECK_ARRAY_EQUAL(cg[i].normal, cg2[i].normal, 3);
+            CHECK_EQUAL(cg[i].depth, cg2[i].depth);
+        }
+
+        // The second cube is rotated by 45 degrees around Z and placed
+        // diagonally: the AABBs overlap while the cubes are apart.
+        dMatrix3 rot;
+        dRFromAxisAndAngle(rot, 0, 0, 1, M_PI / 4);
+        dGeomSetRotation(mesh2, rot);
+        dGeomSetPosition(mesh2, REAL(2.3), REAL(2.3), 0);
+        dReal aabb1[6], aabb2[6];
+        dGeomGetAABB(mesh1, aabb1);
+        dGeomGetAABB(mesh2, aabb2);
+        CHECK(aabb2[0] < aabb1[1] && aabb2[2] < aabb1[3]);
+        nc = dCollide(mesh1, mesh2, MaxContacts, &cg[0], sizeof cg[0]);
+        CHECK_EQUAL(0, nc);
+
+        dGeomDestroy(mesh2);
+        dGeomDestroy(mesh1);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // dTRIMESH_OPCODE
+
+
+#ifdef dTRIMESH_OPCODE
+
+TEST(test_collision_trimesh_compact)
+{
+    /*
+     * Compacts a trimesh data and makes sure the application arrays
+     * are no longer referenced while collisions still work.
+     * Compaction is only available with OPCODE.
+     */
+    {
+        const int VertexCount = 4;
+        const int IndexCount = 2*3;
+        float vertices[VertexCount * 3] = {
+            -10,-10,0,
+            10,-10,0,
+            10,10,0,
+            -10,10,0
+        };
+        dTriIndex indices[IndexCount] = {
+            0,1,2,
+            0,2,3
+        };
+        dReal normals[IndexCount] = {
+            0,0,1,
+            0,0,1
+        };
+
+        dTriMeshDataID data = dGeomTriMeshDataCreate();
+        dGeomTriMeshDataBuildSingle1(data,
+                                     vertices,
+                                     3 * sizeof(float),
+                                     VertexCount,
+                                     indices,
+                                     IndexCount,
+                                     3 * sizeof(dTriIndex),
+                                     normals);
+        dGeomTriMeshDataPreprocess2(data, (1U << dTRIDATAPREPROCESS_BUILD_FACE_ANGLES), NULL);
+        dGeomID trimesh = dCreateTriMesh(0, data, 0, 0, 0);
+
+        CHECK_EQUAL(1, dGeomTriMeshDataCompact(data));
+        // A repeated call has nothing to compact
+        CHECK_EQUAL(0, dGeomTriMeshDataCompact(data));
+
+        // The face normals have been copied as well
+        const dReal *compactNormals = (const dReal *)dGeomTriMeshDataGet2(data, dTRIMESHDATA_FACE_NORMALS, NULL);
+        CHECK(compactNormals != NULL && compactNormals != normals);
+        if (compactNormals != NULL) {
+            CHECK_ARRAY_EQUAL(normals, compactNormals, IndexCount);
+        }
+
+        // Scramble the source arrays -- they must not be accessed any more
+        for (int i=0; i<VertexCount * 3; ++i) vertices[i] = 1000.0f;
+        for (int i=0; i<IndexCount; ++i) indices[i] = 0;
+        for (int i=0; i<IndexCount; ++i) normals[i] = 0;
+
+        dVector3 v0, v1, v2;
+        dGeomTriMeshGetTriangle(trimesh, 1, &v0, &v1, &v2);
+        CHECK_CLOSE(-10, v0[0], 1e-3);
+        CHECK_CLOSE(10, v1[1], 1e-3);
+        CHECK_CLOSE(10, v2[1], 1e-3);
+        CHECK_CLOSE(0, v2[2], 1e-6);
+
+        const dReal radius = REAL(0.5);
+        dGeomID sphere = dCreateSphere(0, radius);
+        dGeomSetPosition(sphere, 3, -4, radius * REAL(0.5));
+
+        dContactGeom cg[4];
+        int nc = dCollide(trimesh, sphere, 4, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        if (nc >= 1) {
+            CHECK_CLOSE(radius * REAL(0.5), cg[0].depth, 1e-2);
+        }
+
+        dGeomDestroy(sphere);
+        dGeomDestroy(trimesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // dTRIMESH_OPCODE
+
+
+
+#ifdef dTRIMESH_ENABLED
+
+TEST(test_collision_trimesh_scale)
+{
+    /*
+     * Shares a single trimesh data between a unit geom and a scaled one
+     * and checks that the scale is taken into account by colliders.
+     */
+    {
+        const int VertexCount = 4;
+        const int IndexCount = 2*3;
+        float vertices[VertexCount * 3] = {
+            -1,-1,0,
+            1,-1,0,
+            1,1,0,
+            -1,1,0
+        };
+        dTriIndex indices[IndexCount] = {
+            0,1,2,
+            0,2,3
+        };
+
+        dTriMeshDataID data = dGeomTriMeshDataCreate();
+        dGeomTriMeshDataBuildSingle(data,
+                                    vertices,
+                                    3 * sizeof(float),
+                                    VertexCount,
+                                    indices,
+                                    IndexCount,
+                                    3 * sizeof(dTriIndex));
+        dGeomID unitMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomID scaledMesh = dCreateTriMesh(0, data, 0, 0, 0);
+        dGeomTriMeshSetScale(scaledMesh, 10, 5, 1);
+
+        dVector3 scale;
+        dGeomTriMeshGetScale(scaledMesh, scale);
+        CHECK_EQUAL(10, scale[0]);
+        CHECK_EQUAL(5, scale[1]);
+        CHECK_EQUAL(1, scale[2]);
+
+        dReal aabb[6];
+        dGeomGetAABB(scaledMesh, aabb);
+        CHECK_CLOSE(-10, aabb[0], 1e-4);
+        CHECK_CLOSE(10, aabb[1], 1e-4);
+        CHECK_CLOSE(-5, aabb[2], 1e-4);
+        CHECK_CLOSE(5, aabb[3], 1e-4);
+
+        const dReal radius = REAL(0.5);
+        dGeomID sphere = dCreateSphere(0, radius);
+        dGeomSetPosition(sphere, 8, -3, radius * REAL(0.5));
+
+        dContactGeom cg[4];
+        int nc = dCollide(unitMesh, sphere, 4, &cg[0], sizeof cg[0]);
+        CHECK_EQUAL(0, nc);
+        nc = dCollide(scaledMesh, sphere, 4, &cg[0], sizeof cg[0]);
+        CHECK(nc >= 1);
+        if (nc >= 1) {
+            CHECK_CLOSE(radius * REAL(0.5), cg[0].depth, 1e-2);
+        }
+
+        dGeomID ray = dCreateRay(0, 20);
+        dGeomRaySet(ray, -7, 4, 10, 0, 0, -1);
+        nc = dCollide(unitMesh, ray, 1, &cg[0], sizeof cg[0]);
+        CHECK_EQUAL(0, nc);
+        nc = dCollide(scaledMesh, ray, 1, &cg[0], sizeof cg[0]);
+        CHECK_EQUAL(1, nc);
+        if (nc == 1) {
+            CHECK_CLOSE(10, cg[0].depth, 1e-4);
+            CHECK_CLOSE(0, cg[0].pos[2], 1e-4);
+        }
+
+        dGeomDestroy(ray);
+        dGeomDestroy(sphere);
+        dGeomDestroy(scaledMesh);
+        dGeomDestroy(unitMesh);
+        dGeomTriMeshDataDestroy(data);
+    }
+}
+
+#endif // dTRIMESH_ENABLED
+
+
 
 TEST(test_collision_heightfield_ray_fail)
 {
@@ -125,3 +840,877 @@ TEST(test_collision_heightfield_ray_fail)
     }
 }
 
+
+
+static dReal heightfield_bounds_test_height(void *data, int x, int z)
+{
+    return ((const float *)data)[x + z * 33];
+}
+
+TEST(test_collision_heightfield_bounds_culling)
+{
+    /*
+     * Zones culled or trimmed with the height bounds pyramid must give
+     * the same contacts as callback data, which is never culled.
+     */
+    float heights[33 * 33];
+    for (int z = 0; z < 33; ++z)
+        for (int x = 0; x < 33; ++x)
+            heights[x + z * 33] = (x >= 20 && x <= 23 && z >= 8 && z <= 12) ? 5.0f
+                : 0.25f * dSin(REAL(0.7) * x) * dCos(REAL(0.4) * z);
+
+    dHeightfieldDataID culledData = dGeomHeightfieldDataCreate();
+    dGeomHeightfieldDataBuildSingle(culledData, heights, 0, 32, 32, 33, 33, 1, 0, 1, 0);
+    dHeightfieldDataID refData = dGeomHeightfieldDataCreate();
+    dGeomHeightfieldDataBuildCallback(refData, heights, &heightfield_bounds_test_height,
+                                      32, 32, 33, 33, 1, 0, 1, 0);
+    dGeomHeightfieldDataSetBounds(refData, -1, 6);
+
+    dGeomID culled = dCreateHeightfield(0, culledData, 1);
+    dGeomID ref = dCreateHeightfield(0, refData, 1);
+
+    dGeomID box = dCreateBox(0, 7, 1, 6);
+    dMatrix3 R;
+    dRFromAxisAndAngle(R, 0, 1, 0, REAL(0.3));
+    dGeomSetRotation(box, R);
+
+    const dReal positions[][3] = {
+        { 0, REAL(0.6), 0 },      // above the waves
+        { -8, REAL(0.3), -4 },    // touching the waves
+        { 4, REAL(0.7), -5 },     // near the plateau, border tiles low
+        { 5, REAL(4.8), -6 },     // resting on the plateau
+        { 4, 10, 4 }              // above everything
+    };
+
+    for (unsigned i = 0; i < sizeof(positions) / sizeof(positions[0]); ++i) {
+        dGeomSetPosition(box, positions[i][0], positions[i][1], positions[i][2]);
+
+        dContactGeom culledContacts[10], refContacts[10];
+        int nCulled = dCollide(box, culled, 10, culledContacts, sizeof(dContactGeom));
+        int nRef = dCollide(box, ref, 10, refContacts, sizeof(dContactGeom));
+
+        CHECK_EQUAL(nRef, nCulled);
+        for (int c = 0; c < nCulled && c < nRef; ++c) {
+            CHECK_CLOSE(refContacts[c].depth, culledContacts[c].depth, 1e-6);
+            CHECK_CLOSE(refContacts[c].pos[1], culledContacts[c].pos[1], 1e-6);
+        }
+    }
+
+    // Raise a second plateau in the referenced samples: setting new bounds
+    // must not leave stale pyramid bounds which would cull its contacts
+    for (int z = 24; z <= 27; ++z)
+        for (int x = 4; x <= 7; ++x)
+            heights[x + z * 33] = 8.0f;
+    dGeomHeightfieldDataSetBounds(culledData, -1, 9);
+    dGeomHeightfieldDataSetBounds(refData, -1, 9);
+
+    dGeomSetPosition(box, -10, REAL(7.8), 9);
+    {
+        dContactGeom culledContacts[10], refContacts[10];
+        int nCulled = dCollide(box, culled, 10, culledContacts, sizeof(dContactGeom));
+        int nRef = dCollide(box, ref, 10, refContacts, sizeof(dContactGeom));
+
+        CHECK(nRef > 0);
+        CHECK_EQUAL(nRef, nCulled);
+        for (int c = 0; c < nCulled && c < nRef; ++c) {
+            CHECK_CLOSE(refContacts[c].depth, culledContacts[c].depth, 1e-6);
+            CHECK_CLOSE(refContacts[c].pos[1], culledContacts[c].pos[1], 1e-6);
+        }
+    }
+
+    dGeomDestroy(box);
+    dGeomDestroy(culled);
+    dGeomDestroy(ref);
+    dGeomHeightfieldDataDestroy(culledData);
+    dGeomHeightfieldDataDestroy(refData);
+}
+
+
+struct heightfield_tiles_test_provider
+{
+    float tiles[4][9 * 9];
+    int loaded[4];
+    bool available[4];
+};
+
+static const float *heightfield_tiles_test_get(void *data, int tile_x, int tile_z)
+{
+    heightfield_tiles_test_provider *provider = (heightfield_tiles_test_provider *)data;
+    const int tile = tile_x + tile_z * 2;
+    if (!provider->available[tile])
+        return 0;
+    ++provider->loaded[tile];
+    return provider->tiles[tile];
+}
+
+static void heightfield_tiles_test_release(void *data, int tile_x, int tile_z, const float *)
+{
+    heightfield_tiles_test_provider *provider = (heightfield_tiles_test_provider *)data;
+    --provider->loaded[tile_x + tile_z * 2];
+}
+
+TEST(test_collision_heightfield_tiled)
+{
+    /*
+     * 2x2 tiles of 8x8 cells must collide as the same heightfield
+     * in a single array, and only touch tiles that are needed.
+     */
+    float heights[17 * 17];
+    for (int z = 0; z < 17; ++z)
+        for (int x = 0; x < 17; ++x)
+            heights[x + z * 17] = 0.3f * dSin(REAL(0.9) * x + REAL(0.5) * z);
+
+    heightfield_tiles_test_provider provider;
+    for (int tile = 0; tile < 4; ++tile) {
+        for (int z = 0; z < 9; ++z)
+            for (int x = 0; x < 9; ++x)
+                provider.tiles[tile][x + z * 9] = heights[(tile % 2) * 8 + x + ((tile / 2) * 8 + z) * 17];
+        provider.loaded[tile] = 0;
+        provider.available[tile] = true;
+    }
+
+    dHeightfieldDataID refData = dGeomHeightfieldDataCreate();
+    dGeomHeightfieldDataBuildSingle(refData, heights, 0, 16, 16, 17, 17, 1, 0, 1, 0);
+    dHeightfieldDataID tiledData = dGeomHeightfieldDataCreate();
+    dGeomHeightfieldDataBuildTiled(tiledData, &provider, &heightfield_tiles_test_get,
+                                   &heightfield_tiles_test_release, 8, 16, 16, 17, 17, 1, 0, 1, 0);
+    dGeomHeightfieldDataSetBounds(tiledData, -1, 1);
+
+    dGeomID ref = dCreateHeightfield(0, refData, 1);
+    dGeomID tiled = dCreateHeightfield(0, tiledData, 1);
+    dGeomID sphere = dCreateSphere(0, 1);
+
+    // sphere over the first tile only
+    dGeomSetPosition(sphere, -4, REAL(0.6), -4);
+    dContactGeom refContacts[10], tiledContacts[10];
+    int nRef = dCollide(sphere, ref, 10, refContacts, sizeof(dContactGeom));
+    int nTiled = dCollide(sphere, tiled, 10, tiledContacts, sizeof(dContactGeom));
+    CHECK(nRef > 0);
+    CHECK_EQUAL(nRef, nTiled);
+    for (int c = 0; c < nRef && c < nTiled; ++c)
+        CHECK_CLOSE(refContacts[c].depth, tiledContacts[c].depth, 1e-6);
+    CHECK_EQUAL(1, provider.loaded[0]);
+    CHECK_EQUAL(0, provider.loaded[1] + provider.loaded[2] + provider.loaded[3]);
+
+    // sphere across all four tiles
+    dGeomSetPosition(sphere, 0, REAL(0.6), 0);
+    nRef = dCollide(sphere, ref, 10, refContacts, sizeof(dContactGeom));
+    nTiled = dCollide(sphere, tiled, 10, tiledContacts, sizeof(dContactGeom));
+    CHECK(nRef > 0);
+    CHECK_EQUAL(nRef, nTiled);
+    for (int c = 0; c < nRef && c < nTiled; ++c)
+        CHECK_CLOSE(refContacts[c].depth, tiledContacts[c].depth, 1e-6);
+
+    // box across the borders of a zone split by an unavailable tile:
+    // samples and points on shared borders are collided by one tile only
+    dGeomHeightfieldDataEvictTile(tiledData, 1, 1);
+    provider.available[3] = false;
+    dGeomID box = dCreateBox(0, 3, 1, 3);
+    dGeomSetPosition(box, 0, REAL(0.45), 0);
+    dContactGeom boxContacts[64];
+    int nBox = dCollide(box, tiled, 64, boxContacts, sizeof(dContactGeom));
+    CHECK(nBox > 0);
+    for (int c = 0; c < nBox; ++c) {
+        for (int d = c + 1; d < nBox; ++d) {
+            bool duplicate = dFabs(boxContacts[c].pos[0] - boxContacts[d].pos[0]) < 1e-6
+                && dFabs(boxContacts[c].pos[1] - boxContacts[d].pos[1]) < 1e-6
+                && dFabs(boxContacts[c].pos[2] - boxContacts[d].pos[2]) < 1e-6;
+            CHECK(!duplicate);
+        }
+    }
+    dGeomDestroy(box);
+    provider.available[3] = true;
+
+    // evicted and unavailable tiles are not collided
+    dGeomHeightfieldDataEvictTile(tiledData, 0, 0);
+    CHECK_EQUAL(0, provider.loaded[0]);
+    provider.available[0] = false;
+    dGeomSetPosition(sphere, -4, REAL(0.6), -4);
+    CHECK_EQUAL(0, dCollide(sphere, tiled, 10, tiledContacts, sizeof(dContactGeom)));
+
+    dGeomDestroy(sphere);
+    dGeomDestroy(ref);
+    dGeomDestroy(tiled);
+    dGeomHeightfieldDataDestroy(refData);
+    dGeomHeightfieldDataDestroy(tiledData);
+    for (int tile = 0; tile < 4; ++tile)
+        CHECK_EQUAL(0, provider.loaded[tile]);
+}
+
+
+static int heightfield_block_test_calls;
+
+static dReal heightfield_block_test_sample(int x, int z)
+{
+    return REAL(0.3) * dSin(REAL(0.9) * x + REAL(0.5) * z);
+}
+
+static dReal heightfield_block_test_height(void *, int x, int z)
+{
+    return heightfield_block_test_sample(x, z);
+}
+
+static void heightfield_block_test_block(void *, int x, int z, int num_x, int num_z, dReal *heights)
+{
+    ++heightfield_block_test_calls;
+    for (int j = 0; j < num_z; ++j)
+        for (int i = 0; i < num_x; ++i)
+            heights[i + j * num_x] = heightfield_block_test_sample(x + i, z + j);
+}
+
+TEST(test_collision_heightfield_callback_block)
+{
+    /*
+     * Block callback data must collide as the per-sample callback data
+     * while requesting the zone under the geom at once.
+     */
+    for (int wrap = 0; wrap < 2; ++wrap) {
+        dHeightfieldDataID refData = dGeomHeightfieldDataCreate();
+        dGeomHeightfieldDataBuildCallback(refData, 0, &heightfield_block_test_height,
+                                          16, 16, 17, 17, 2, 0, 1, wrap);
+        dGeomHeightfieldDataSetBounds(refData, -1, 1);
+        dHeightfieldDataID blockData = dGeomHeightfieldDataCreate();
+        dGeomHeightfieldDataBuildCallbackBlock(blockData, 0, &heightfield_block_test_block,
+                                               16, 16, 17, 17, 2, 0, 1, wrap);
+        dGeomHeightfieldDataSetBounds(blockData, -1, 1);
+
+        dGeomID ref = dCreateHeightfield(0, refData, 1);
+        dGeomID block = dCreateHeightfield(0, blockData, 1);
+        dGeomID capsule = dCreateCapsule(0, REAL(0.5), 3);
+        dMatrix3 R;
+        dRFromAxisAndAngle(R, 1, 1, 0, REAL(1.2));
+        dGeomSetRotation(capsule, R);
+        dGeomSetPosition(capsule, REAL(1.5), REAL(0.4), REAL(-2.5));
+
+        dContactGeom refContacts[10], blockContacts[10];
+        heightfield_block_test_calls = 0;
+        int nRef = dCollide(capsule, ref, 10, refContacts, sizeof(dContactGeom));
+        int nBlock = dCollide(capsule, block, 10, blockContacts, sizeof(dContactGeom));
+        CHECK(nRef > 0);
+        CHECK_EQUAL(nRef, nBlock);
+        CHECK_EQUAL(1, heightfield_block_test_calls);
+        for (int c = 0; c < nRef && c < nBlock; ++c) {
+            CHECK_CLOSE(refContacts[c].depth, blockContacts[c].depth, 1e-6);
+            CHECK_CLOSE(refContacts[c].pos[1], blockContacts[c].pos[1], 1e-6);
+        }
+
+        dGeomDestroy(capsule);
+        dGeomDestroy(ref);
+        dGeomDestroy(block);
+        dGeomHeightfieldDataDestroy(refData);
+        dGeomHeightfieldDataDestroy(blockData);
+    }
+}
+
+
+TEST(test_collision_heightfield_ray_dda)
+{
+    /*
+     * Rays march the cells in order and report the closest hits first.
+     */
+    float ramp[9 * 9];
+    for (int z = 0; z < 9; ++z)
+        for (int x = 0; x < 9; ++x)
+            ramp[x + z * 9] = 0.5f * x;
+
+    dHeightfieldDataID data = dGeomHeightfieldDataCreate();
+    dGeomHeightfieldDataBuildSingle(data, ramp, 0, 8, 8, 9, 9, 1, 0, 1, 0);
+    dGeomID height = dCreateHeightfield(0, data, 1);
+    dGeomID ray = dCreateRay(0, 20);
+    dContactGeom contacts[4];
+
+    // vertical ray, surface at y = 0.5 * (x + 4)
+    dGeomRaySet(ray, REAL(-1.7), 10, REAL(0.3), 0, -1, 0);
+    CHECK_EQUAL(1, dCollide(ray, height, 4, contacts, sizeof(dContactGeom)));
+    CHECK_CLOSE(10 - REAL(1.15), contacts[0].depth, 1e-6);
+    CHECK_CLOSE(REAL(1.15), contacts[0].pos[1], 1e-6);
+    CHECK(contacts[0].normal[1] > 0);
+
+    // horizontal ray climbing the ramp from below, crossing several cells
+    dGeomRaySet(ray, REAL(-3.5), 1, REAL(-1.2), 1, 0, 0);
+    CHECK_EQUAL(1, dCollide(ray, height, 4, contacts, sizeof(dContactGeom)));
+    CHECK_CLOSE(REAL(1.5), contacts[0].depth, 1e-6);
+
+    // ray leaving the heightfield without hitting
+    dGeomRaySet(ray, 0, 10, 0, 1, REAL(0.1), 0);
+    CHECK_EQUAL(0, dCollide(ray, height, 4, contacts, sizeof(dContactGeom)));
+
+    dGeomDestroy(ray);
+    dGeomDestroy(height);
+    dGeomHeightfieldDataDestroy(data);
+}
+
+
+TEST(test_collision_convex_warm_start)
+{
+    /*
+     * A convex collided repeatedly against the same geoms (with cached
+     * separating axes when libccd colliders are used) must give the same
+     * results as a fresh convex.
+     */
+    static dReal planes[] = { 1,0,0,REAL(0.5), -1,0,0,REAL(0.5), 0,1,0,REAL(0.5),
+                              0,-1,0,REAL(0.5), 0,0,1,REAL(0.5), 0,0,-1,REAL(0.5) };
+    static dReal points[] = { REAL(0.5),REAL(0.5),REAL(0.5), -REAL(0.5),REAL(0.5),REAL(0.5),
+                              REAL(0.5),-REAL(0.5),REAL(0.5), -REAL(0.5),-REAL(0.5),REAL(0.5),
+                              REAL(0.5),REAL(0.5),-REAL(0.5), -REAL(0.5),REAL(0.5),-REAL(0.5),
+                              REAL(0.5),-REAL(0.5),-REAL(0.5), -REAL(0.5),-REAL(0.5),-REAL(0.5) };
+    static unsigned polygons[] = { 4,0,2,6,4, 4,1,5,7,3, 4,0,4,5,1, 4,2,3,7,6, 4,0,1,3,2, 4,4,6,7,5 };
+
+    dGeomID warm = dCreateConvex(0, planes, 6, points, 8, polygons);
+    dGeomID others[2] = { dCreateBox(0, 1, 1, 1), dCreateSphere(0, REAL(0.5)) };
+
+    for (int o = 0; o < 2; ++o) {
+        for (int i = 0; i < 200; ++i) {
+            const dReal t = REAL(0.05) * i;
+            dMatrix3 R;
+            dRFromEulerAngles(R, t, REAL(0.5) * t, REAL(0.3));
+            dGeomSetRotation(warm, R);
+            dGeomSetPosition(others[o], REAL(1.3) * dCos(REAL(0.7) * t), REAL(0.9) * dSin(t), REAL(0.2));
+
+            dGeomID cold = dCreateConvex(0, planes, 6, points, 8, polygons);
+            dGeomSetRotation(cold, R);
+
+            dContactGeom warmContacts[4], coldContacts[4];
+            int nWarm = dCollide(warm, others[o], 4, warmContacts, sizeof(dContactGeom));
+            int nCold = dCollide(cold, others[o], 4, coldContacts, sizeof(dContactGeom));
+            CHECK_EQUAL(nCold, nWarm);
+            if (nWarm != 0 && nCold != 0)
+                CHECK_CLOSE(coldContacts[0].depth, warmContacts[0].depth, 1e-6);
+
+            dGeomDestroy(cold);
+        }
+        dGeomDestroy(others[o]);
+    }
+
+    dGeomDestroy(warm);
+}
+
+
+// dCollide goes through libccd for convex pairs under dLIBCCD_CONVEX_CONVEX
+static int collideConvexSAT(dGeomID o1, dGeomID o2, int maxc, dContactGeom *contacts)
+{
+    // bring the final positions up to date, as dCollide does
+    dGeomGetPosition(o1);
+    dGeomGetPosition(o2);
+    return dCollideConvexConvex(o1, o2, maxc, contacts, sizeof(dContactGeom));
+}
+
+TEST(test_collision_convex_convex_sat)
+{
+    /*
+     * Convex pairs: a reduced face-face manifold keeps at most 4 contacts,
+     * chosen before truncating to the requested count, crossing edges give
+     * their penetration depth, and separated pairs stay separated when
+     * collided again.
+     */
+    static dReal planes[] = { 1,0,0,REAL(0.5), -1,0,0,REAL(0.5), 0,1,0,REAL(0.5),
+                              0,-1,0,REAL(0.5), 0,0,1,REAL(0.5), 0,0,-1,REAL(0.5) };
+    static dReal points[] = { REAL(0.5),REAL(0.5),REAL(0.5), -REAL(0.5),REAL(0.5),REAL(0.5),
+                              REAL(0.5),-REAL(0.5),REAL(0.5), -REAL(0.5),-REAL(0.5),REAL(0.5),
+                              REAL(0.5),REAL(0.5),-REAL(0.5), -REAL(0.5),REAL(0.5),-REAL(0.5),
+                              REAL(0.5),-REAL(0.5),-REAL(0.5), -REAL(0.5),-REAL(0.5),-REAL(0.5) };
+    static unsigned polygons[] = { 4,0,2,6,4, 4,1,5,7,3, 4,0,4,5,1, 4,2,3,7,6, 4,0,1,3,2, 4,4,6,7,5 };
+
+    dGeomID lower = dCreateConvex(0, planes, 6, points, 8, polygons);
+    dGeomID upper = dCreateConvex(0, planes, 6, points, 8, polygons);
+    dContactGeom contacts[16];
+    dMatrix3 R;
+
+    // twisted cube resting on another one: the clipped face is an octagon
+    dRFromEulerAngles(R, REAL(0.01), 0, M_PI/4.0);
+    dGeomSetRotation(upper, R);
+    dGeomSetPosition(upper, 0, 0, REAL(0.95));
+    int n = collideConvexSAT(upper, lower, 16, contacts);
+    CHECK(n > 4);
+    dReal deepest = 0;
+    for (int i = 0; i < n; ++i) {
+        CHECK_CLOSE(REAL(0.05), contacts[i].depth, 1e-2);
+        CHECK_CLOSE(REAL(1.0), dFabs(contacts[i].normal[2]), 1e-3);
+        deepest = dMax(deepest, contacts[i].depth);
+    }
+    n = collideConvexSAT(upper, lower, 16 | CONTACTS_REDUCED, contacts);
+    CHECK(n >= 1 && n <= 4);
+    CHECK_CLOSE(deepest, contacts[0].depth, 1e-6);
+    n = collideConvexSAT(upper, lower, 1 | CONTACTS_REDUCED, contacts);
+    CHECK_EQUAL(1, n);
+    CHECK_CLOSE(deepest, contacts[0].depth, 1e-6);
+
+    // crossing edges
+    dRFromAxisAndAngle(R, 1, 0, 0, M_PI/4.0);
+    dGeomSetRotation(lower, R);
+    dRFromAxisAndAngle(R, 0, 1, 0, M_PI/4.0);
+    dGeomSetRotation(upper, R);
+    dGeomSetPosition(upper, 0, 0, dSqrt(2) - REAL(0.05));
+    n = collideConvexSAT(upper, lower, 16, contacts);
+    CHECK_EQUAL(1, n);
+    if (n == 1)
+        CHECK_CLOSE(REAL(0.05), contacts[0].depth, 1e-3);
+
+    dGeomSetPosition(upper, 0, 0, dSqrt(2) + REAL(0.05));
+    CHECK_EQUAL(0, collideConvexSAT(upper, lower, 16, contacts));
+    CHECK_EQUAL(0, collideConvexSAT(upper, lower, 16, contacts));
+    dGeomSetPosition(upper, 0, 0, dSqrt(2) - REAL(0.05));
+    CHECK_EQUAL(1, collideConvexSAT(upper, lower, 16, contacts));
+
+    dGeomDestroy(upper);
+    dGeomDestroy(lower);
+}
+
+
+TEST(test_collision_convex_from_points)
+{
+    /*
+     * The hull of cube corners, face centres and inner points is the cube:
+     * inner points are dropped and coplanar triangles merged. Flat clouds
+     * are refused.
+     */
+    dReal points[(8+6+20)*3];
+    int n = 0;
+    for (int i = 0; i < 8; ++i) {
+        points[n++] = (i & 1) ? REAL(0.5) : -REAL(0.5);
+        points[n++] = (i & 2) ? REAL(0.5) : -REAL(0.5);
+        points[n++] = (i & 4) ? REAL(0.5) : -REAL(0.5);
+    }
+    for (int i = 0; i < 6; ++i) {
+        points[n++] = (i / 2 == 0) ? ((i & 1) ? REAL(0.5) : -REAL(0.5)) : 0;
+        points[n++] = (i / 2 == 1) ? ((i & 1) ? REAL(0.5) : -REAL(0.5)) : 0;
+        points[n++] = (i / 2 == 2) ? ((i & 1) ? REAL(0.5) : -REAL(0.5)) : 0;
+    }
+    for (int i = 0; i < 20; ++i) {
+        points[n++] = REAL(0.4) * dSin(REAL(1.7) * i);
+        points[n++] = REAL(0.4) * dCos(REAL(2.3) * i);
+        points[n++] = REAL(0.02) * (i - 10);
+    }
+
+    dGeomID hull = dCreateConvexFromPoints(0, points, n / 3, 0);
+    CHECK(hull != 0);
+    dReal aabb[6];
+    dGeomGetAABB(hull, aabb);
+    for (int k = 0; k < 6; ++k)
+        CHECK_CLOSE((k & 1) ? REAL(0.5) : -REAL(0.5), aabb[k], 1e-6);
+
+    // a sphere sinks into the top face
+    dGeomID sphere = dCreateSphere(0, REAL(0.25));
+    dGeomSetPosition(sphere, REAL(0.2), REAL(0.1), REAL(0.7));
+    dContactGeom contact;
+    CHECK_EQUAL(1, dCollide(sphere, hull, 1, &contact, sizeof(dContactGeom)));
+    CHECK_CLOSE(REAL(0.05), contact.depth, 1e-3);
+    CHECK_CLOSE(REAL(1.0), dFabs(contact.normal[2]), 1e-3);
+
+    // simplified down to a tetrahedron of the cube corners
+    CHECK_EQUAL(1, dGeomConvexFromPoints(hull, points, n / 3, 4));
+    dGeomGetAABB(hull, aabb);
+    for (int k = 0; k < 6; ++k)
+        CHECK(dFabs(aabb[k]) <= REAL(0.5) + REAL(1e-6));
+
+    const dReal flat[] = { 0,0,0, 1,0,0, 0,1,0, 1,1,0, REAL(0.5),REAL(0.5),0 };
+    CHECK(dCreateConvexFromPoints(0, flat, 5, 0) == 0);
+    CHECK_EQUAL(0, dGeomConvexFromPoints(hull, flat, 5, 0));
+
+    dGeomDestroy(sphere);
+    dGeomDestroy(hull);
+}
+
+TEST(test_collision_convex_from_noisy_grid)
+{
+    /*
+     * Rotated grids over the faces of a cube, with noise in the last
+     * bits: the points near the edges are within rounding of several
+     * faces and may see them as a horizon that touches itself. Such
+     * points are retried or left out, the hull is always built and
+     * spans the cloud.
+     */
+    dRandSetSeed(3);
+    for (int attempt = 0; attempt < 40; ++attempt) {
+        const int side = 3 + attempt % 5;
+        dReal points[6*7*7*3];
+        int n = 0;
+        dMatrix3 R;
+        dRFromEulerAngles(R, dRandReal() * 6, dRandReal() * 6, dRandReal() * 6);
+        const dReal noise = (attempt & 1) ? REAL(1e-10) : REAL(1e-13);
+        for (int f = 0; f < 6; ++f)
+            for (int i = 0; i < side; ++i)
+                for (int j = 0; j < side; ++j) {
+                    dVector3 p, q;
+                    p[f / 2] = (f & 1) ? REAL(1.0) : -REAL(1.0);
+                    p[(f / 2 + 1) % 3] = -1 + (dReal)(2 * i) / (side - 1);
+                    p[(f / 2 + 2) % 3] = -1 + (dReal)(2 * j) / (side - 1);
+                    dMultiply0_331(q, R, p);
+                    for (int k = 0; k < 3; ++k)
+                        points[n++] = q[k] + noise * (dRandReal() - REAL(0.5));
+                }
+
+        dReal bounds[6] = { dInfinity, -dInfinity, dInfinity, -dInfinity, dInfinity, -dInfinity };
+        for (int i = 0; i < n; ++i) {
+            bounds[(i % 3) * 2] = dMin(bounds[(i % 3) * 2], points[i]);
+            bounds[(i % 3) * 2 + 1] = dMax(bounds[(i % 3) * 2 + 1], points[i]);
+        }
+
+        dGeomID hull = dCreateConvexFromPoints(0, points, n / 3, 0);
+        CHECK(hull != 0);
+        if (hull == 0) continue;
+        dReal aabb[6];
+        dGeomGetAABB(hull, aabb);
+        for (int k = 0; k < 6; ++k)
+            CHECK_CLOSE(bounds[k], aabb[k], 1e-5);
+        dGeomDestroy(hull);
+    }
+}
+
+TEST(test_collision_convex_hill_climbing)
+{
+    /*
+     * On a hull with more than HILL_CLIMBING_MIN_POINTS points, the
+     * support found by hill climbing from any start point must be as
+     * far along the direction as the one of a linear scan.
+     */
+    const int count = 64;
+    dReal points[count*3];
+    for (int i = 0; i < count; ++i) {
+        // spiral over a sphere, every point is on the hull
+        const dReal y = 1 - (2 * i + 1) / (dReal)count;
+        const dReal r = dSqrt(1 - y * y);
+        points[i*3+0] = r * dCos(REAL(2.39996) * i);
+        points[i*3+1] = y;
+        points[i*3+2] = r * dSin(REAL(2.39996) * i);
+    }
+
+    dGeomID hull = dCreateConvexFromPoints(0, points, count, 0);
+    CHECK(hull != 0);
+    dxConvex *cvx = (dxConvex *)hull;
+    CHECK(cvx->pointcount > dxConvex::HILL_CLIMBING_MIN_POINTS);
+    CHECK(cvx->adjacencyStart != NULL);
+
+    for (int i = 0; i < 200; ++i) {
+        dVector3 dir;
+        dir[0] = dSin(REAL(1.3) * i + REAL(0.2));
+        dir[1] = dCos(REAL(0.7) * i);
+        dir[2] = dSin(REAL(2.1) * i) * dCos(REAL(0.3) * i);
+
+        dReal scanMax = dCalcVectorDot3(cvx->points, dir);
+        for (unsigned int p = 1; p < cvx->pointcount; ++p)
+            scanMax = dMax(scanMax, dCalcVectorDot3(cvx->points + p * 3, dir));
+
+        unsigned int hint = (unsigned int)(i * 7) % cvx->pointcount;
+        const unsigned int climbed = cvx->SupportIndexLocal(dir, hint);
+        CHECK(climbed < cvx->pointcount);
+        CHECK_CLOSE(scanMax, dCalcVectorDot3(cvx->points + climbed * 3, dir), 1e-9);
+        CHECK_EQUAL(climbed, hint);
+    }
+
+    dGeomDestroy(hull);
+}
+
+TEST(test_collision_convex_concurrent)
+{
+    /*
+     * A hull large enough for hill climbing collides with geoms around it
+     * from the threads of a pool at once, so that its support hints and
+     * separating axis cache are used by many pairs together. The geoms
+     * move between touching and apart, and every geom must get the
+     * contacts it gets serially.
+     */
+    const int count = 64;
+    dReal points[count*3], smallPoints[count*3];
+    for (int i = 0; i < count; ++i) {
+        const dReal y = 1 - (2 * i + 1) / (dReal)count;
+        const dReal r = dSqrt(1 - y * y);
+        points[i*3+0] = r * dCos(REAL(2.39996) * i);
+        points[i*3+1] = y;
+        points[i*3+2] = r * dSin(REAL(2.39996) * i);
+        for (int k = 0; k < 3; ++k)
+            smallPoints[i*3+k] = points[i*3+k] * REAL(0.25);
+    }
+    dGeomID hull = dCreateConvexFromPoints(0, points, count, 0);
+    CHECK(hull != 0);
+
+    const unsigned GeomCount = 96;
+    dGeomID geoms[GeomCount];
+    for (unsigned i = 0; i < GeomCount; ++i) {
+        geoms[i] = (i & 1) ? dCreateSphere(0, REAL(0.25)) : dCreateConvexFromPoints(0, smallPoints, count, 0);
+    }
+
+    int expectedCounts[GeomCount], contactCounts[GeomCount];
+    dReal expectedDepths[GeomCount], depths[GeomCount];
+    const CollisionResults expected = { hull, geoms, expectedCounts, expectedDepths };
+    const CollisionResults results = { hull, geoms, contactCounts, depths };
+    for (int pass = 0; pass < 6; ++pass) {
+        const dReal distance = (pass & 1) ? REAL(1.1) : REAL(1.4);
+        for (unsigned i = 0; i < GeomCount; ++i) {
+            const dReal angle = REAL(2.39996) * i, y = 1 - (2 * i + 1) / (dReal)GeomCount;
+            const dReal r = dSqrt(1 - y * y);
+            dGeomSetPosition(geoms[i], distance * r * dCos(angle), distance * y, distance * r * dSin(angle));
+            collideWithTarget(expected, i);
+            CHECK_EQUAL(pass & 1, expectedCounts[i] >= 1);
+        }
+
+        CHECK(collideWithTargetConcurrently(results, GeomCount));
+        for (unsigned i = 0; i < GeomCount; ++i) {
+            CHECK_EQUAL(expectedCounts[i], contactCounts[i]);
+            CHECK_CLOSE(expectedDepths[i], depths[i], 1e-6);
+        }
+    }
+
+    for (unsigned i = 0; i < GeomCount; ++i)
+        dGeomDestroy(geoms[i]);
+    dGeomDestroy(hull);
+}
+
+TEST(test_collision_contact_reduction)
+{
+    /*
+     * Two unit boxes crossed at 45 degrees touch over an octagon. Reduction
+     * keeps the deepest corner and three more, either on request or for the
+     * geoms of a space in reduction mode.
+     */
+    dSpaceID space = dSimpleSpaceCreate(0);
+    dGeomID base = dCreateBox(0, 1, 1, 1);
+    dGeomID top = dCreateBox(space, 1, 1, 1);
+    dMatrix3 R;
+    dRFromEulerAngles(R, REAL(0.01), 0, M_PI/4.0);
+    dGeomSetRotation(top, R);
+    dGeomSetPosition(top, 0, 0, REAL(0.95));
+
+    dContactGeom contacts[16];
+    const int full = dCollide(base, top, 16, contacts, sizeof(dContactGeom));
+    CHECK(full > 4);
+    dReal deepest = 0;
+    for (int i = 0; i < full; ++i)
+        deepest = dMax(deepest, contacts[i].depth);
+
+    int n = dCollide(base, top, 16 | CONTACTS_REDUCED, contacts, sizeof(dContactGeom));
+    CHECK_EQUAL(4, n);
+    CHECK_CLOSE(deepest, contacts[0].depth, 1e-6);
+    for (int i = 1; i < n; ++i) {
+        CHECK(contacts[i].depth <= deepest);
+        CHECK_CLOSE(contacts[0].normal[2], contacts[i].normal[2], 1e-6);
+    }
+
+    CHECK_EQUAL(0, dSpaceGetContactReduction(space));
+    dSpaceSetContactReduction(space, 1);
+    CHECK_EQUAL(1, dSpaceGetContactReduction(space));
+    CHECK_EQUAL(4, dCollide(base, top, 16, contacts, sizeof(dContactGeom)));
+    dSpaceSetContactReduction(space, 0);
+    CHECK_EQUAL(full, dCollide(base, top, 16, contacts, sizeof(dContactGeom)));
+
+    dGeomDestroy(top);
+    dGeomDestroy(base);
+    dSpaceDestroy(space);
+}
+
+TEST(test_collision_body_ccd)
+{
+    /*
+     * A ball crossing 3 m per step passes a thin wall between two steps,
+     * unless its CCD sphere stops it at the wall. The wall may be in a
+     * nested space, and is swept against if either side's collide bits
+     * match the other's category bits.
+     */
+    dWorldID world = dWorldCreate();
+    dSpaceID space = dHashSpaceCreate(0);
+    dGeomID wall = dCreateBox(space, REAL(0.05), 4, 4);
+    dGeomSetPosition(wall, 2, 0, 0);
+
+    dBodyID ball = dBodyCreate(world);
+    dGeomID sphere = dCreateSphere(space, REAL(0.1));
+    dGeomSetBody(sphere, ball);
+    dBodySetLinearVel(ball, 300, 0, 0);
+
+    dWorldQuickStep(world, REAL(0.01));
+    CHECK_CLOSE(REAL(3.0), dBodyGetPosition(ball)[0], 1e-6);
+
+    dBodySetPosition(ball, 0, 0, 0);
+    dBodySetCCD(ball, space, REAL(0.1));
+    CHECK(dBodyGetCCDSpace(ball) == space);
+    CHECK_CLOSE(REAL(0.1), dBodyGetCCDRadius(ball), 1e-6);
+    dWorldQuickStep(world, REAL(0.01));
+    CHECK_CLOSE(REAL(2.0 - 0.025 - 0.1), dBodyGetPosition(ball)[0], 1e-3);
+
+    // slow steps are left to discrete collision
+    dBodySetPosition(ball, 0, 0, 0);
+    dBodySetLinearVel(ball, 5, 0, 0);
+    dWorldQuickStep(world, REAL(0.01));
+    CHECK_CLOSE(REAL(0.05), dBodyGetPosition(ball)[0], 1e-6);
+
+    // a wall in a nested space, found from its side of the category
+    // test only, among many geoms sorted before and after it
+    dGeomSetPosition(wall, 50, 0, 0);
+    dSpaceID inner = dSimpleSpaceCreate(space);
+    dGeomID walls[20];
+    for (int i = 0; i < 20; ++i) {
+        walls[i] = dCreateBox(inner, REAL(0.05), 4, 4);
+        dGeomSetPosition(walls[i], (dReal)(i - 10) * 4 + REAL(0.5), 10, 0);
+    }
+    dGeomSetPosition(walls[11], 2, 0, 0);
+    dGeomSetCategoryBits(walls[11], 2);
+    dGeomSetCollideBits(walls[11], 1);
+    dGeomSetCategoryBits(sphere, 1);
+    dGeomSetCollideBits(sphere, 0);
+    dBodySetPosition(ball, 0, 0, 0);
+    dBodySetLinearVel(ball, 300, 0, 0);
+    dWorldQuickStep(world, REAL(0.01));
+    CHECK_CLOSE(REAL(2.0 - 0.025 - 0.1), dBodyGetPosition(ball)[0], 1e-3);
+
+    // and passed when neither side collides with the other
+    dGeomSetCollideBits(walls[11], 0);
+    dBodySetPosition(ball, 0, 0, 0);
+    dWorldQuickStep(world, REAL(0.01));
+    CHECK_CLOSE(REAL(3.0), dBodyGetPosition(ball)[0], 1e-6);
+
+    for (int i = 0; i < 20; ++i)
+        dGeomDestroy(walls[i]);
+    dSpaceDestroy(inner);
+
+    dBodySetCCD(ball, 0, 0);
+    CHECK(dBodyGetCCDSpace(ball) == 0);
+
+    dGeomDestroy(sphere);
+    dBodyDestroy(ball);
+    dGeomDestroy(wall);
+    dSpaceDestroy(space);
+    dWorldDestroy(world);
+}
+
+TEST(test_collision_body_ccd_thread_pool)
+{
+    /*
+     * Balls of separate islands sweep against a row of walls from the
+     * threads of a pool, while the static geoms gathered for the step
+     * are in use. The steps are both waited for and polled. Many static
+     * geoms sorted before the walls keep the candidates large.
+     */
+    enum { BALL_COUNT = 256, WALL_COUNT = 64, FILLER_COUNT = 500, ROUND_COUNT = 8 };
+
+    dWorldID world = dWorldCreate();
+    dSpaceID space = dHashSpaceCreate(0);
+
+    dGeomID walls[WALL_COUNT];
+    for (int i = 0; i < WALL_COUNT; ++i) {
+        walls[i] = dCreateBox(space, REAL(0.05), 2, 4);
+        dGeomSetPosition(walls[i], 2, (dReal)(i - WALL_COUNT / 2) * 2 + 1, 0);
+    }
+
+    dGeomID fillers[FILLER_COUNT];
+    for (int i = 0; i < FILLER_COUNT; ++i) {
+        fillers[i] = dCreateSphere(space, REAL(0.1));
+        dGeomSetPosition(fillers[i], (dReal)-i, 1000, 0);
+    }
+
+    dBodyID balls[BALL_COUNT];
+    dGeomID spheres[BALL_COUNT];
+    for (int i = 0; i < BALL_COUNT; ++i) {
+        balls[i] = dBodyCreate(world);
+        spheres[i] = dCreateSphere(space, REAL(0.1));
+        dGeomSetBody(spheres[i], balls[i]);
+        dBodySetCCD(balls[i], space, REAL(0.1));
+    }
+
+    dThreadingImplementationID threading = dThreadingAllocateMultiThreadedImplementation();
+    dThreadingThreadPoolID pool = threading != NULL ? dThreadingAllocateThreadPool(4, 0, dAllocateFlagBasicData | dAllocateFlagCollisionData, NULL) : NULL;
+    if (pool != NULL) {
+        dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+        dWorldSetStepThreadingImplementation(world, dThreadingImplementationGetFunctions(threading), threading);
+    }
+
+    for (int round = 0; round < ROUND_COUNT; ++round) {
+        for (int i = 0; i < BALL_COUNT; ++i) {
+            dBodySetPosition(balls[i], 0, (dReal)(i - BALL_COUNT / 2) * REAL(0.4), 0);
+            dBodySetLinearVel(balls[i], 300, 0, 0);
+        }
+
+        if (round & 1) {
+            dWorldStepRequestID request = dWorldQuickStepAsync(world, REAL(0.01));
+            CHECK(request != NULL);
+            while (!dWorldStepRequestPoll(request)) {}
+            CHECK_EQUAL(1, dWorldStepRequestWait(request));
+        }
+        else {
+            CHECK_EQUAL(1, dWorldQuickStep(world, REAL(0.01)));
+        }
+
+        for (int i = 0; i < BALL_COUNT; ++i)
+            CHECK_CLOSE(REAL(2.0 - 0.025 - 0.1), dBodyGetPosition(balls[i])[0], 1e-3);
+    }
+
+    dWorldSetStepThreadingImplementation(world, NULL, NULL);
+    if (pool != NULL) {
+        dThreadingImplementationShutdownProcessing(threading);
+        dThreadingFreeThreadPool(pool);
+    }
+    if (threading != NULL)
+        dThreadingFreeImplementation(threading);
+
+    for (int i = 0; i < BALL_COUNT; ++i) {
+        dGeomDestroy(spheres[i]);
+        dBodyDestroy(balls[i]);
+    }
+    for (int i = 0; i < FILLER_COUNT; ++i)
+        dGeomDestroy(fillers[i]);
+    for (int i = 0; i < WALL_COUNT; ++i)
+        dGeomDestroy(walls[i]);
+    dSpaceDestroy(space);
+    dWorldDestroy(world);
+}
+
+#ifdef dTRIMESH_ENABLED
+
+TEST(test_collision_body_ccd_trimesh)
+{
+    /*
+     * With manual thread data cleanup, a ball sweeps against a trimesh
+     * wall kept in a nested space. The colliders find their caches by the
+     * spaces' TLS kind, and the sweep proxy must use the wall's.
+     */
+    dCloseODE();
+    dInitODE2(dInitFlagManualThreadCleanup);
+    dAllocateODEDataForThread(dAllocateMaskAll);
+
+    const int VertexCount = 4;
+    const int IndexCount = 2*3;
+    float vertices[VertexCount * 3] = {
+        2,-2,-2,
+        2,2,-2,
+        2,2,2,
+        2,-2,2
+    };
+    // facing the ball
+    dTriIndex indices[IndexCount] = {
+        0,2,1,
+        0,3,2
+    };
+
+    dTriMeshDataID data = dGeomTriMeshDataCreate();
+    dGeomTriMeshDataBuildSingle(data, vertices, 3 * sizeof(float), VertexCount,
+                                indices, IndexCount, 3 * sizeof(dTriIndex));
+
+    dWorldID world = dWorldCreate();
+    dSpaceID space = dHashSpaceCreate(0);
+    dSpaceSetManualCleanup(space, 1);
+    dSpaceID inner = dSimpleSpaceCreate(space);
+    dSpaceSetManualCleanup(inner, 1);
+    dGeomID wall = dCreateTriMesh(inner, data, 0, 0, 0);
+
+    dBodyID ball = dBodyCreate(world);
+    dGeomID sphere = dCreateSphere(space, REAL(0.1));
+    dGeomSetBody(sphere, ball);
+    dBodySetCCD(ball, space, REAL(0.1));
+
+    dBodySetLinearVel(ball, 300, 0, 0);
+    CHECK_EQUAL(1, dWorldQuickStep(world, REAL(0.01)));
+    CHECK_CLOSE(REAL(2.0 - 0.1), dBodyGetPosition(ball)[0], 1e-2);
+
+    dBodySetCCD(ball, 0, 0);
+    dGeomDestroy(sphere);
+    dBodyDestroy(ball);
+    dGeomDestroy(wall);
+    dSpaceDestroy(inner);
+    dSpaceDestroy(space);
+    dWorldDestroy(world);
+    dGeomTriMeshDataDestroy(data);
+
+    dCleanupODEAllDataForThread();
+    dCloseODE();
+    dInitODE();
+}
+
+#endif // dTRIMESH_ENABLED
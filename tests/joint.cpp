@@ -25,9 +25,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 // This file create unit test for some of the functions found in:
 // ode/src/joint.cpp
+// ode/src/ode.cpp (concurrent joint groups)
 //
 //
 ////////////////////////////////////////////////////////////////////////////////
+#include <string.h>
 #include <UnitTest++.h>
 #include <ode/ode.h>
 #include "../ode/src/config.h"
@@ -3052,3 +3054,191 @@ SUITE(JointPiston)
 
 
 } // End of SUITE(JointPiston)
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Testing the concurrent joint groups
+//
+SUITE(JointGroupConcurrent)
+{
+    enum
+    {
+        SEGMENT_COUNT = 4,
+        SEGMENT_JOINT_COUNT = 100,
+    };
+
+    // The contact depth records the position the joint is expected to be linked at
+    static void createSegmentContacts(dJointGroupID group, unsigned segment, dBodyID b1, dBodyID b2)
+    {
+        for (unsigned i = 0; i != SEGMENT_JOINT_COUNT; ++i) {
+            dContact contact;
+            memset(&contact, 0, sizeof(contact));
+            contact.geom.depth = (dReal)(segment * SEGMENT_JOINT_COUNT + i);
+
+            dJointCreateContactConcurrent(group, segment, &contact, b1, b2);
+        }
+    }
+
+    struct SegmentFillingContext
+    {
+        dJointGroupID group;
+        dBodyID b1, b2;
+    };
+
+    static int fillSegment_Callback(void *call_context, dcallindex_t instance_index, dCallReleaseeID this_releasee)
+    {
+        (void)this_releasee; // unused
+        SegmentFillingContext *context = (SegmentFillingContext *)call_context;
+        createSegmentContacts(context->group, (unsigned)instance_index, context->b1, context->b2);
+        return 1;
+    }
+
+    static int fillingDone_Callback(void *call_context, dcallindex_t instance_index, dCallReleaseeID this_releasee)
+    {
+        (void)call_context; // unused
+        (void)instance_index; // unused
+        (void)this_releasee; // unused
+        return 1;
+    }
+
+    // Checks that the joints of the body are in the order of segments and of creation within them
+    static bool areJointsLinkedInOrder(dBodyID body, unsigned expectedCount)
+    {
+        bool result = (unsigned)dBodyGetNumJoints(body) == expectedCount;
+
+        // The body lists the joints attached last first
+        for (unsigned i = 0; result && i != expectedCount; ++i) {
+            dxJointContact *joint = (dxJointContact *)dBodyGetJoint(body, (int)(expectedCount - 1 - i));
+            result = joint->type() == dJointTypeContact && joint->contact.geom.depth == (dReal)i;
+        }
+
+        return result;
+    }
+
+    TEST(test_JointGroupConcurrent_SegmentsFilledByThreads)
+    {
+        dWorldID world = dWorldCreate();
+        dBodyID b1 = dBodyCreate(world), b2 = dBodyCreate(world);
+        dJointGroupID group = dJointGroupCreateConcurrent(world, SEGMENT_COUNT);
+        CHECK(group != NULL);
+
+        dThreadingImplementationID threading = dThreadingAllocateMultiThreadedImplementation();
+        dThreadingThreadPoolID pool = dThreadingAllocateThreadPool(SEGMENT_COUNT, 0, dAllocateFlagBasicData, NULL);
+        CHECK(threading != NULL && pool != NULL);
+
+        if (group != NULL && threading != NULL && pool != NULL) {
+            dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+            const dThreadingFunctionsInfo *functions = dThreadingImplementationGetFunctions(threading);
+
+            SegmentFillingContext context = { group, b1, b2 };
+            int summaryFault = 0;
+
+            // Every segment is filled by a call of its own, the calls running in the pool threads at once
+            functions->preallocate_resources_for_calls(threading, SEGMENT_COUNT + 1);
+            dCallWaitID fillingWait = functions->alloc_call_wait(threading);
+            CHECK(fillingWait != NULL);
+
+            dCallReleaseeID fillingDone;
+            functions->post_call(threading, &summaryFault, &fillingDone, SEGMENT_COUNT, NULL, fillingWait, 
+                &fillingDone_Callback, NULL, 0, "Filling Done");
+
+            for (unsigned segment = 0; segment != SEGMENT_COUNT; ++segment) {
+                functions->post_call(threading, NULL, NULL, 0, fillingDone, NULL, 
+                    &fillSegment_Callback, &context, segment, "Segment Filling");
+            }
+
+            functions->wait_call(threading, NULL, fillingWait, NULL, "Filling Wait");
+            functions->free_call_wait(threading, fillingWait);
+            CHECK_EQUAL(0, summaryFault);
+
+            // The joints are not attached before they are linked
+            CHECK_EQUAL(0, dBodyGetNumJoints(b1));
+
+            dJointGroupLinkJoints(group);
+            CHECK(areJointsLinkedInOrder(b1, SEGMENT_COUNT * SEGMENT_JOINT_COUNT));
+            CHECK(areJointsLinkedInOrder(b2, SEGMENT_COUNT * SEGMENT_JOINT_COUNT));
+
+            dThreadingImplementationShutdownProcessing(threading);
+        }
+
+        if (pool != NULL) {
+            dThreadingFreeThreadPool(pool);
+        }
+
+        if (threading != NULL) {
+            dThreadingFreeImplementation(threading);
+        }
+
+        if (group != NULL) {
+            dJointGroupDestroy(group);
+        }
+        CHECK_EQUAL(0, dBodyGetNumJoints(b1));
+
+        dWorldDestroy(world);
+    }
+
+    TEST(test_JointGroupConcurrent_LinkedByStep)
+    {
+        dWorldID world = dWorldCreate();
+        dBodyID b1 = dBodyCreate(world), b2 = dBodyCreate(world);
+        dJointGroupID group = dJointGroupCreateConcurrent(world, SEGMENT_COUNT);
+
+        // Segments filled out of order are still linked in the order of segments
+        for (unsigned segment = SEGMENT_COUNT; segment-- != 0; ) {
+            createSegmentContacts(group, segment, b1, b2);
+        }
+
+        CHECK_EQUAL(0, dBodyGetNumJoints(b1));
+        CHECK_EQUAL(1, dWorldQuickStep(world, REAL(0.01)));
+        CHECK(areJointsLinkedInOrder(b1, SEGMENT_COUNT * SEGMENT_JOINT_COUNT));
+
+        // Linking again has no effect until more joints are created
+        dJointGroupLinkJoints(group);
+        CHECK_EQUAL(SEGMENT_COUNT * SEGMENT_JOINT_COUNT, dBodyGetNumJoints(b1));
+
+        dJointGroupDestroy(group);
+        dWorldDestroy(world);
+    }
+
+    TEST(test_JointGroupConcurrent_EmptyWithUnlinkedJoints)
+    {
+        dWorldID world = dWorldCreate();
+        dBodyID b1 = dBodyCreate(world), b2 = dBodyCreate(world);
+        dJointGroupID group = dJointGroupCreateConcurrent(world, SEGMENT_COUNT);
+
+        createSegmentContacts(group, 0, b1, b2);
+        createSegmentContacts(group, SEGMENT_COUNT - 1, b1, NULL);
+
+        // The unlinked joints are destroyed together with the linked ones
+        dJointGroupEmpty(group);
+        CHECK_EQUAL(0, dBodyGetNumJoints(b1));
+        CHECK_EQUAL(0, dBodyGetNumJoints(b2));
+
+        // The group remains usable
+        createSegmentContacts(group, 0, b1, b2);
+        dJointGroupLinkJoints(group);
+        CHECK(areJointsLinkedInOrder(b1, SEGMENT_JOINT_COUNT));
+
+        dJointGroupEmpty(group);
+        CHECK_EQUAL(0, dBodyGetNumJoints(b1));
+
+        dJointGroupDestroy(group);
+        dWorldDestroy(world);
+    }
+
+    TEST(test_JointGroupConcurrent_WorldDestroyWithUnlinkedJoints)
+    {
+        dWorldID world = dWorldCreate();
+        dBodyID b1 = dBodyCreate(world), b2 = dBodyCreate(world);
+        dJointGroupID group = dJointGroupCreateConcurrent(world, SEGMENT_COUNT);
+
+        createSegmentContacts(group, 1, b1, b2);
+
+        // The joints outlive the world in the group as any other grouped joints do
+        dWorldDestroy(world);
+
+        dJointGroupEmpty(group);
+        dJointGroupDestroy(group);
+    }
+} // End of SUITE(JointGroupConcurrent)
@@ -0,0 +1,1014 @@
+/*************************************************************************
+  *                                                                       *
+  * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+  * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+  *                                                                       *
+  * This library is free software; you can redistribute it and/or         *
+  * modify it under the terms of EITHER:                                  *
+  *   (1) The GNU Lesser General Public License as published by the Free  *
+  *       Software Foundation; either version 2.1 of the License, or (at  *
+  *       your option) any later version. The text of the GNU Lesser      *
+  *       General Public License is included with this library in the     *
+  *       file LICENSE.TXT.                                               *
+  *   (2) The BSD-style license that is included with this library in     *
+  *       the file LICENSE-BSD.TXT.                                       *
+  *                                                                       *
+  * This library is distributed in the hope that it will be useful,       *
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+  * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+  *                                                                       *
+  *************************************************************************/
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+//        1         2         3         4         5         6         7
+
+////////////////////////////////////////////////////////////////////////////////
+// This file create unit test for deterministic world stepping, thread pool 
+// parameters and step profiling found in:
+// ode/src/util.cpp
+// ode/src/quickstep.cpp
+// ode/src/profile.cpp
+// ode/src/frame.cpp
+// ode/src/threading_pool_posix.cpp
+//
+////////////////////////////////////////////////////////////////////////////////
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <UnitTest++.h>
+#include <ode/ode.h>
+#include "../ode/src/config.h"
+
+
+namespace
+{
+    enum
+    {
+        PILE_COUNT = 3,
+        PILE_BODY_COUNT = 6,
+        BODY_COUNT = PILE_COUNT * PILE_BODY_COUNT,
+        STEP_COUNT = 100,
+        POOL_MAX_THREADS = 4,
+    };
+
+    struct BodyState
+    {
+        dReal pos[3];
+        dQuaternion q;
+    };
+
+    struct PilesSimulation
+    {
+        dWorldID world;
+        dSpaceID space;
+        dJointGroupID contacts;
+        dJointGroupID links;
+        dBodyID bodies[BODY_COUNT];
+        dThreadingImplementationID threading;
+        dThreadingThreadPoolID pool;
+
+        // Zero thread count selects the default self-threaded implementation
+        PilesSimulation(unsigned threadCount, bool workStealing = false, bool singleIsland = false, 
+            const dThreadingThreadPoolParameters *poolParameters = NULL):
+            threading(NULL), pool(NULL)
+        {
+            world = dWorldCreate();
+            dWorldSetGravity(world, 0, 0, -9.81);
+            dWorldSetStepDeterministic(world, 1);
+            dWorldSetStepRandomSeed(world, 12345);
+
+            space = dHashSpaceCreate(0);
+            contacts = dJointGroupCreate(0);
+            links = dJointGroupCreate(0);
+            dCreatePlane(space, 0, 0, 1, 0);
+
+            // Separate piles make separate islands to be stepped in parallel
+            for (int i = 0; i != BODY_COUNT; ++i) {
+                int pile = i / PILE_BODY_COUNT, level = i % PILE_BODY_COUNT;
+
+                dMass mass;
+                dMassSetBox(&mass, 1, 1, 1, 1);
+
+                dBodyID body = dBodyCreate(world);
+                dBodySetMass(body, &mass);
+                dBodySetPosition(body, pile * 4 + REAL(0.1) * level, REAL(0.05) * level, REAL(0.55) + REAL(1.05) * level);
+                bodies[i] = body;
+
+                dGeomID geom = (i & 1) ? dCreateBox(space, 1, 1, 1) : dCreateSphere(space, REAL(0.5));
+                dGeomSetBody(geom, body);
+            }
+
+            // Linking the piles level by level joins them into one large island
+            if (singleIsland) {
+                for (int i = PILE_BODY_COUNT; i != BODY_COUNT; ++i) {
+                    dJointID link = dJointCreateBall(world, links);
+                    dJointAttach(link, bodies[i - PILE_BODY_COUNT], bodies[i]);
+                    const dReal *anchor = dBodyGetPosition(bodies[i]);
+                    dJointSetBallAnchor(link, anchor[0] - 2, anchor[1], anchor[2]);
+                }
+            }
+
+            if (threadCount != 0) {
+                threading = workStealing ? dThreadingAllocateWorkStealingImplementation() : dThreadingAllocateMultiThreadedImplementation();
+                pool = threading != NULL ? dThreadingAllocateThreadPool(threadCount, 0, dAllocateFlagBasicData, poolParameters) : NULL;
+
+                if (pool != NULL) {
+                    dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+                    dWorldSetStepThreadingImplementation(world, dThreadingImplementationGetFunctions(threading), threading);
+                }
+            }
+        }
+
+        ~PilesSimulation()
+        {
+            dWorldSetStepThreadingImplementation(world, NULL, NULL);
+
+            if (pool != NULL) {
+                dThreadingImplementationShutdownProcessing(threading);
+                dThreadingFreeThreadPool(pool);
+            }
+
+            if (threading != NULL) {
+                dThreadingFreeImplementation(threading);
+            }
+
+            dJointGroupDestroy(links);
+            dJointGroupDestroy(contacts);
+            dSpaceDestroy(space);
+            dWorldDestroy(world);
+        }
+
+        static void nearCallback(void *data, dGeomID o1, dGeomID o2)
+        {
+            PilesSimulation *simulation = (PilesSimulation *)data;
+
+            dContact contact[4];
+            int n = dCollide(o1, o2, 4, &contact[0].geom, sizeof(dContact));
+
+            for (int i = 0; i != n; ++i) {
+                contact[i].surface.mode = dContactBounce;
+                contact[i].surface.mu = 1;
+                contact[i].surface.bounce = REAL(0.2);
+                contact[i].surface.bounce_vel = REAL(0.1);
+
+                dJointID c = dJointCreateContact(simulation->world, simulation->contacts, contact + i);
+                dJointAttach(c, dGeomGetBody(o1), dGeomGetBody(o2));
+            }
+        }
+
+        void run(bool quickStep, BodyState states[BODY_COUNT])
+        {
+            for (int step = 0; step != STEP_COUNT; ++step) {
+                dSpaceCollide(space, this, &nearCallback);
+
+                if (quickStep) {
+                    dWorldQuickStep(world, REAL(0.01));
+                }
+                else {
+                    dWorldStep(world, REAL(0.01));
+                }
+
+                dJointGroupEmpty(contacts);
+            }
+
+            getStates(states);
+        }
+
+        void getStates(BodyState states[BODY_COUNT]) const
+        {
+            for (int i = 0; i != BODY_COUNT; ++i) {
+                memcpy(states[i].pos, dBodyGetPosition(bodies[i]), sizeof(states[i].pos));
+                dBodyCopyQuaternion(bodies[i], states[i].q);
+            }
+        }
+    };
+}
+
+
+/*
+ * Tests for stepping results not depending on threads
+ */
+
+SUITE(WorldStepDeterminism)
+{
+    static bool resultsDependOnThreadCount(bool quickStep, bool workStealing = false, bool singleIsland = false)
+    {
+        bool result = false;
+
+        BodyState reference[BODY_COUNT];
+        {
+            PilesSimulation simulation(0, false, singleIsland);
+            simulation.run(quickStep, reference);
+        }
+
+        for (unsigned threadCount = 1; threadCount <= POOL_MAX_THREADS; threadCount *= 2) {
+            // The global random sequence must not affect the results either
+            dRandSetSeed(dRandGetSeed() + threadCount);
+
+            BodyState states[BODY_COUNT];
+            PilesSimulation simulation(threadCount, workStealing, singleIsland);
+            simulation.run(quickStep, states);
+
+            // Bitwise comparison is intended
+            result = result || memcmp(reference, states, sizeof(states)) != 0;
+        }
+
+        return result;
+    }
+
+    TEST(test_WorldStep_ThreadCountIndependence)
+    {
+        CHECK(!resultsDependOnThreadCount(false));
+    }
+
+    TEST(test_WorldQuickStep_ThreadCountIndependence)
+    {
+        CHECK(!resultsDependOnThreadCount(true));
+    }
+
+    TEST(test_LargeIsland_ThreadCountIndependence)
+    {
+        // A large island could be given several stepper threads by the cost model
+        CHECK(!resultsDependOnThreadCount(false, false, true));
+        CHECK(!resultsDependOnThreadCount(true, false, true));
+    }
+
+    TEST(test_WorkStealing_ThreadCountIndependence)
+    {
+        // Jobs scheduled by workers are pushed onto their own stacks and stolen by idle ones
+        CHECK(!resultsDependOnThreadCount(true, true));
+        CHECK(!resultsDependOnThreadCount(false, true));
+    }
+
+    TEST(test_StepRandomSeed)
+    {
+        BodyState first[BODY_COUNT], second[BODY_COUNT];
+
+        PilesSimulation simulation(0);
+        CHECK_EQUAL(1, dWorldGetStepDeterministic(simulation.world));
+        CHECK_EQUAL(12345UL, dWorldGetStepRandomSeed(simulation.world));
+
+        simulation.run(true, first);
+        CHECK(dWorldGetStepRandomSeed(simulation.world) != 12345UL);
+
+        {
+            PilesSimulation repeated(0);
+            repeated.run(true, second);
+            CHECK(memcmp(first, second, sizeof(second)) == 0);
+            CHECK_EQUAL(dWorldGetStepRandomSeed(simulation.world), dWorldGetStepRandomSeed(repeated.world));
+        }
+    }
+}
+
+
+/*
+ * Tests for stepping several worlds in a batch
+ */
+
+SUITE(WorldStepBatch)
+{
+    enum
+    {
+        BATCH_WORLD_COUNT = 3,
+    };
+
+    // The worlds differ in the bodies' starting heights so that a mix-up of the worlds would show
+    static bool batchResultsDifferFromSequential(bool quickStep, unsigned threadCount)
+    {
+        bool result = false;
+
+        BodyState reference[BATCH_WORLD_COUNT][BODY_COUNT];
+        for (unsigned w = 0; w != BATCH_WORLD_COUNT; ++w) {
+            PilesSimulation simulation(0);
+            dBodySetPosition(simulation.bodies[0], 0, 0, REAL(0.55) + REAL(0.1) * w);
+            simulation.run(quickStep, reference[w]);
+        }
+
+        // The batch worlds must share the threading implementation of the first one
+        PilesSimulation first(threadCount), second(0), third(0);
+        PilesSimulation *simulations[BATCH_WORLD_COUNT] = { &first, &second, &third };
+        dWorldID worlds[BATCH_WORLD_COUNT];
+
+        for (unsigned w = 0; w != BATCH_WORLD_COUNT; ++w) {
+            if (first.threading != NULL) {
+                dWorldSetStepThreadingImplementation(simulations[w]->world, dThreadingImplementationGetFunctions(first.threading), first.threading);
+            }
+            dBodySetPosition(simulations[w]->bodies[0], 0, 0, REAL(0.55) + REAL(0.1) * w);
+            worlds[w] = simulations[w]->world;
+        }
+
+        for (int step = 0; step != STEP_COUNT; ++step) {
+            for (unsigned w = 0; w != BATCH_WORLD_COUNT; ++w) {
+                dSpaceCollide(simulations[w]->space, simulations[w], &PilesSimulation::nearCallback);
+            }
+
+            int stepped = quickStep 
+                ? dWorldQuickStepBatch(worlds, BATCH_WORLD_COUNT, REAL(0.01)) 
+                : dWorldStepBatch(worlds, BATCH_WORLD_COUNT, REAL(0.01));
+            result = result || !stepped;
+
+            for (unsigned w = 0; w != BATCH_WORLD_COUNT; ++w) {
+                dJointGroupEmpty(simulations[w]->contacts);
+            }
+        }
+
+        for (unsigned w = 0; w != BATCH_WORLD_COUNT; ++w) {
+            BodyState states[BODY_COUNT];
+            simulations[w]->getStates(states);
+            result = result || memcmp(reference[w], states, sizeof(states)) != 0;
+
+            // The other worlds are detached before the first one releases its implementation
+            dWorldSetStepThreadingImplementation(simulations[w]->world, NULL, NULL);
+        }
+
+        return result;
+    }
+
+    TEST(test_WorldStepBatch_MatchesSequentialSteps)
+    {
+        CHECK(!batchResultsDifferFromSequential(false, 0));
+        CHECK(!batchResultsDifferFromSequential(false, POOL_MAX_THREADS));
+    }
+
+    TEST(test_WorldQuickStepBatch_MatchesSequentialSteps)
+    {
+        CHECK(!batchResultsDifferFromSequential(true, 0));
+        CHECK(!batchResultsDifferFromSequential(true, POOL_MAX_THREADS));
+    }
+}
+
+
+/*
+ * Tests for asynchronous stepping
+ */
+
+SUITE(WorldStepAsync)
+{
+    // Steps the world asynchronously polling for completion. The other world, if any, is 
+    // stepped synchronously while the asynchronous steps are in flight.
+    static bool runAsync(PilesSimulation &simulation, bool quickStep, BodyState states[BODY_COUNT], PilesSimulation *other)
+    {
+        bool result = true;
+
+        for (int step = 0; step != STEP_COUNT; ++step) {
+            dSpaceCollide(simulation.space, &simulation, &PilesSimulation::nearCallback);
+
+            dWorldStepRequestID request = quickStep 
+                ? dWorldQuickStepAsync(simulation.world, REAL(0.01)) 
+                : dWorldStepAsync(simulation.world, REAL(0.01));
+            if (request == NULL) {
+                result = false;
+                break;
+            }
+
+            result = result && dWorldStepRequestGetWorld(request) == simulation.world;
+
+            if (other != NULL) {
+                dSpaceCollide(other->space, other, &PilesSimulation::nearCallback);
+                result = result && dWorldQuickStep(other->world, REAL(0.01));
+                dJointGroupEmpty(other->contacts);
+            }
+
+            // With the self-threaded implementation the polling thread carries the step out
+            while (!dWorldStepRequestPoll(request)) {
+            }
+
+            result = result && dWorldStepRequestWait(request);
+            dJointGroupEmpty(simulation.contacts);
+        }
+
+        simulation.getStates(states);
+        return result;
+    }
+
+    TEST(test_WorldStepAsync_PollAndWait)
+    {
+        for (unsigned threadCount = 0; threadCount <= POOL_MAX_THREADS; threadCount += POOL_MAX_THREADS) {
+            for (int quickStep = 0; quickStep != 2; ++quickStep) {
+                BodyState reference[BODY_COUNT], states[BODY_COUNT];
+                {
+                    PilesSimulation simulation(0);
+                    simulation.run(quickStep != 0, reference);
+                }
+
+                PilesSimulation simulation(threadCount);
+                CHECK(runAsync(simulation, quickStep != 0, states, NULL));
+                CHECK(memcmp(reference, states, sizeof(states)) == 0);
+            }
+        }
+    }
+
+    TEST(test_WorldStepAsync_OtherWorldStepping)
+    {
+        BodyState reference[BODY_COUNT], states[BODY_COUNT], otherStates[BODY_COUNT];
+        {
+            PilesSimulation simulation(0);
+            simulation.run(true, reference);
+        }
+
+        // A world with working memory of its own can be stepped while the step is in flight
+        PilesSimulation simulation(POOL_MAX_THREADS), other(0);
+        CHECK(runAsync(simulation, true, states, &other));
+        CHECK(memcmp(reference, states, sizeof(states)) == 0);
+
+        other.getStates(otherStates);
+        CHECK(memcmp(reference, otherStates, sizeof(otherStates)) == 0);
+    }
+
+    TEST(test_WorldStepAsync_SharedWorkingMemory)
+    {
+        BodyState reference[BODY_COUNT], states[BODY_COUNT], sharingStates[BODY_COUNT];
+        {
+            PilesSimulation simulation(0);
+            simulation.run(true, reference);
+        }
+
+        // The worlds sharing memory are stepped one after another only
+        PilesSimulation simulation(0), sharing(0);
+        CHECK_EQUAL(1, dWorldUseSharedWorkingMemory(sharing.world, simulation.world));
+        CHECK(runAsync(simulation, true, states, NULL));
+        sharing.run(true, sharingStates);
+
+        CHECK(memcmp(reference, states, sizeof(states)) == 0);
+        CHECK(memcmp(reference, sharingStates, sizeof(sharingStates)) == 0);
+    }
+}
+
+
+/*
+ * Tests for frame stepping
+ */
+
+SUITE(WorldStepFrame)
+{
+    enum
+    {
+        TERRAIN_SAMPLES = 16,
+        TERRAIN_BODY_COUNT = 64,
+        TERRAIN_STEP_COUNT = 50,
+    };
+
+    // Bodies dropped onto a heightfield make many pairs with the same heightfield geom.
+    // The terrain may be built as a trimesh of the same heights instead.
+    struct TerrainSimulation
+    {
+        dWorldID world;
+        dSpaceID space;
+        dJointGroupID contacts;
+        dHeightfieldDataID terrainData;
+        dTriMeshDataID meshData;
+        dBodyID bodies[TERRAIN_BODY_COUNT];
+        dThreadingImplementationID threading;
+        dThreadingThreadPoolID pool;
+        double heights[TERRAIN_SAMPLES * TERRAIN_SAMPLES];
+        float meshVertices[TERRAIN_SAMPLES * TERRAIN_SAMPLES * 3];
+        dTriIndex meshIndices[(TERRAIN_SAMPLES - 1) * (TERRAIN_SAMPLES - 1) * 6];
+
+        TerrainSimulation(unsigned threadCount, bool meshTerrain = false):
+            terrainData(NULL), meshData(NULL), threading(NULL), pool(NULL)
+        {
+            world = dWorldCreate();
+            dWorldSetGravity(world, 0, -9.81, 0);
+            dWorldSetStepDeterministic(world, 1);
+
+            space = dHashSpaceCreate(0);
+            contacts = dJointGroupCreate(0);
+
+            for (int i = 0; i != TERRAIN_SAMPLES * TERRAIN_SAMPLES; ++i) {
+                heights[i] = 0.25 * ((i * 7) % 5);
+            }
+
+            if (meshTerrain) {
+                buildMeshTerrain();
+            }
+            else {
+                terrainData = dGeomHeightfieldDataCreate();
+                dGeomHeightfieldDataBuildDouble(terrainData, heights, 0, 8, 8, TERRAIN_SAMPLES, TERRAIN_SAMPLES, 1, 0, 0, 0);
+                dCreateHeightfield(space, terrainData, 1);
+            }
+
+            for (int i = 0; i != TERRAIN_BODY_COUNT; ++i) {
+                dMass mass;
+                dMassSetSphere(&mass, 1, REAL(0.3));
+
+                dBodyID body = dBodyCreate(world);
+                dBodySetMass(body, &mass);
+                dBodySetPosition(body, REAL(-3.5) + (i % 8), REAL(1.5) + REAL(0.01) * i, REAL(-3.5) + (i / 8));
+                bodies[i] = body;
+
+                dGeomID geom = (i & 1) ? dCreateBox(space, REAL(0.6), REAL(0.6), REAL(0.6)) : dCreateSphere(space, REAL(0.3));
+                dGeomSetBody(geom, body);
+            }
+
+            if (threadCount != 0) {
+                threading = dThreadingAllocateMultiThreadedImplementation();
+                pool = threading != NULL ? dThreadingAllocateThreadPool(threadCount, 0, dAllocateMaskAll, NULL) : NULL;
+
+                if (pool != NULL) {
+                    dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+                    dWorldSetStepThreadingImplementation(world, dThreadingImplementationGetFunctions(threading), threading);
+                }
+            }
+        }
+
+        ~TerrainSimulation()
+        {
+            dWorldSetStepThreadingImplementation(world, NULL, NULL);
+
+            if (pool != NULL) {
+                dThreadingImplementationShutdownProcessing(threading);
+                dThreadingFreeThreadPool(pool);
+            }
+
+            if (threading != NULL) {
+                dThreadingFreeImplementation(threading);
+            }
+
+            dJointGroupDestroy(contacts);
+            dSpaceDestroy(space);
+
+            if (terrainData != NULL) {
+                dGeomHeightfieldDataDestroy(terrainData);
+            }
+
+#ifdef dTRIMESH_ENABLED
+            if (meshData != NULL) {
+                dGeomTriMeshDataDestroy(meshData);
+            }
+#endif
+
+            dWorldDestroy(world);
+        }
+
+        // The heightfield samples become the mesh vertices, with the triangles facing up
+        void buildMeshTerrain()
+        {
+#ifdef dTRIMESH_ENABLED
+            const float sampleDistance = 8.0f / (TERRAIN_SAMPLES - 1);
+
+            for (int i = 0; i != TERRAIN_SAMPLES * TERRAIN_SAMPLES; ++i) {
+                float *vertex = meshVertices + i * 3;
+                vertex[0] = -4.0f + sampleDistance * (i % TERRAIN_SAMPLES);
+                vertex[1] = (float)heights[i];
+                vertex[2] = -4.0f + sampleDistance * (i / TERRAIN_SAMPLES);
+            }
+
+            dTriIndex *index = meshIndices;
+            for (int z = 0; z != TERRAIN_SAMPLES - 1; ++z) {
+                for (int x = 0; x != TERRAIN_SAMPLES - 1; ++x) {
+                    dTriIndex corner = (dTriIndex)(z * TERRAIN_SAMPLES + x);
+                    index[0] = corner; index[1] = corner + TERRAIN_SAMPLES; index[2] = corner + 1;
+                    index[3] = corner + 1; index[4] = corner + TERRAIN_SAMPLES; index[5] = corner + TERRAIN_SAMPLES + 1;
+                    index += 6;
+                }
+            }
+
+            meshData = dGeomTriMeshDataCreate();
+            dGeomTriMeshDataBuildSingle(meshData, meshVertices, 3 * sizeof(float), TERRAIN_SAMPLES * TERRAIN_SAMPLES, 
+                meshIndices, (int)(index - meshIndices), 3 * sizeof(dTriIndex));
+            dCreateTriMesh(space, meshData, NULL, NULL, NULL);
+#endif
+        }
+
+        bool run(BodyState states[TERRAIN_BODY_COUNT])
+        {
+            bool result = true;
+
+            dWorldFrameParameters parameters;
+            memset(&parameters, 0, sizeof(parameters));
+            parameters.struct_size = sizeof(parameters);
+            parameters.max_contacts = 8;
+            parameters.surface.mode = dContactBounce;
+            parameters.surface.mu = 1;
+            parameters.surface.bounce = REAL(0.2);
+            parameters.surface.bounce_vel = REAL(0.1);
+            parameters.contact_group = contacts;
+
+            for (int step = 0; step != TERRAIN_STEP_COUNT; ++step) {
+                result = result && dWorldQuickStepFrame(world, space, &parameters, REAL(0.01));
+                dJointGroupEmpty(contacts);
+            }
+
+            for (int i = 0; i != TERRAIN_BODY_COUNT; ++i) {
+                memcpy(states[i].pos, dBodyGetPosition(bodies[i]), sizeof(states[i].pos));
+                dBodyCopyQuaternion(bodies[i], states[i].q);
+            }
+
+            return result;
+        }
+    };
+
+    TEST(test_WorldStepFrame_HeightfieldPairs)
+    {
+        BodyState reference[TERRAIN_BODY_COUNT];
+        {
+            TerrainSimulation simulation(0);
+            CHECK(simulation.run(reference));
+        }
+
+        // The bodies must have landed on the terrain rather than falling through
+        bool landed = true;
+        for (int i = 0; i != TERRAIN_BODY_COUNT; ++i) {
+            landed = landed && reference[i].pos[1] > REAL(-0.5);
+        }
+        CHECK(landed);
+
+        for (int attempt = 0; attempt != 4; ++attempt) {
+            BodyState states[TERRAIN_BODY_COUNT];
+            TerrainSimulation simulation(POOL_MAX_THREADS);
+            CHECK(simulation.pool != NULL);
+            CHECK(simulation.run(states));
+            CHECK(memcmp(reference, states, sizeof(states)) == 0);
+        }
+    }
+
+#ifdef dTRIMESH_ENABLED
+    TEST(test_WorldStepFrame_TrimeshPairs)
+    {
+        // Many pairs with the same trimesh are collided while the threads collide other pairs
+        BodyState reference[TERRAIN_BODY_COUNT];
+        {
+            TerrainSimulation simulation(0, true);
+            CHECK(simulation.run(reference));
+        }
+
+        bool landed = true;
+        for (int i = 0; i != TERRAIN_BODY_COUNT; ++i) {
+            landed = landed && reference[i].pos[1] > REAL(-0.5);
+        }
+        CHECK(landed);
+
+        for (int attempt = 0; attempt != 8; ++attempt) {
+            BodyState states[TERRAIN_BODY_COUNT];
+            TerrainSimulation simulation(POOL_MAX_THREADS, true);
+            CHECK(simulation.pool != NULL);
+            CHECK(simulation.run(states));
+            CHECK(memcmp(reference, states, sizeof(states)) == 0);
+        }
+    }
+#endif // dTRIMESH_ENABLED
+}
+
+
+/*
+ * Tests for island stepper thread selection
+ */
+
+SUITE(IslandStepperThreads)
+{
+    enum
+    {
+        CHAIN_BODY_COUNT = 2000,
+        LONE_BODY_COUNT = 8,
+        THREADS_STEP_COUNT = 5,
+        THREADS_EVENT_CAPACITY = 1000000,
+    };
+
+    // Counts the threads that have recorded stage events for the island
+    static unsigned countIslandStageThreads(const dWorldStepProfileEvent *events, unsigned eventCount, unsigned stepIndex, unsigned islandIndex)
+    {
+        bool threadSeen[POOL_MAX_THREADS + 1] = { false };
+        unsigned result = 0;
+
+        for (unsigned i = 0; i != eventCount; ++i) {
+            const dWorldStepProfileEvent &event = events[i];
+
+            if (event.kind == dSTEPPROFILE_EVENT_STAGE && event.step_index == stepIndex && event.island_index == islandIndex 
+                && event.thread_index <= POOL_MAX_THREADS && !threadSeen[event.thread_index]) {
+                threadSeen[event.thread_index] = true;
+                result += 1;
+            }
+        }
+
+        return result;
+    }
+
+    TEST(test_IslandStepperThreads_ByIslandCost)
+    {
+        dWorldID world = dWorldCreate();
+        dWorldSetGravity(world, 0, 0, -9.81);
+        dJointGroupID links = dJointGroupCreate(0);
+
+        dMass mass;
+        dMassSetSphere(&mass, 1, REAL(0.1));
+
+        // Each lone body makes an island of its own and the chain makes one more
+        for (int i = 0; i != LONE_BODY_COUNT; ++i) {
+            dBodyID body = dBodyCreate(world);
+            dBodySetMass(body, &mass);
+            dBodySetPosition(body, -1 - i, 0, 0);
+        }
+
+        dBodyID previous = NULL;
+        for (int i = 0; i != CHAIN_BODY_COUNT; ++i) {
+            dBodyID body = dBodyCreate(world);
+            dBodySetMass(body, &mass);
+            dBodySetPosition(body, REAL(0.2) * i, 0, 0);
+
+            if (previous != NULL) {
+                dJointID link = dJointCreateBall(world, links);
+                dJointAttach(link, previous, body);
+                dJointSetBallAnchor(link, REAL(0.2) * i - REAL(0.1), 0, 0);
+            }
+            previous = body;
+        }
+
+        dThreadingImplementationID threading = dThreadingAllocateMultiThreadedImplementation();
+        dThreadingThreadPoolID pool = dThreadingAllocateThreadPool(POOL_MAX_THREADS, 0, dAllocateFlagBasicData, NULL);
+        CHECK(threading != NULL && pool != NULL);
+
+        if (threading != NULL && pool != NULL) {
+            dThreadingThreadPoolServeMultiThreadedImplementation(pool, threading);
+            dWorldSetStepThreadingImplementation(world, dThreadingImplementationGetFunctions(threading), threading);
+            dWorldSetStepProfiling(world, THREADS_EVENT_CAPACITY);
+
+            for (int step = 0; step != THREADS_STEP_COUNT; ++step) {
+                dWorldQuickStep(world, REAL(0.01));
+            }
+
+            unsigned eventCount = dWorldGetStepProfileEvents(world, NULL, 0);
+            dWorldStepProfileEvent *events = new dWorldStepProfileEvent[eventCount];
+            dWorldGetStepProfileEvents(world, events, eventCount);
+
+            // The lone bodies are too cheap for more than a thread, while the chain 
+            // takes milliseconds to step and is given several threads
+            const unsigned lastStep = THREADS_STEP_COUNT - 1;
+            unsigned singleThreadedIslands = 0, multiThreadedIslands = 0;
+
+            for (unsigned islandIndex = 0; islandIndex != LONE_BODY_COUNT + 1; ++islandIndex) {
+                unsigned islandThreads = countIslandStageThreads(events, eventCount, lastStep, islandIndex);
+                singleThreadedIslands += islandThreads == 1;
+                multiThreadedIslands += islandThreads > 1;
+            }
+
+            CHECK_EQUAL((unsigned)LONE_BODY_COUNT, singleThreadedIslands);
+            CHECK_EQUAL(1U, multiThreadedIslands);
+
+            delete[] events;
+
+            dWorldSetStepThreadingImplementation(world, NULL, NULL);
+            dThreadingImplementationShutdownProcessing(threading);
+        }
+
+        if (pool != NULL) {
+            dThreadingFreeThreadPool(pool);
+        }
+
+        if (threading != NULL) {
+            dThreadingFreeImplementation(threading);
+        }
+
+        dJointGroupDestroy(links);
+        dWorldDestroy(world);
+    }
+}
+
+
+/*
+ * Tests for thread pool parameters
+ */
+
+SUITE(ThreadPoolParameters)
+{
+    static bool resultsDependOnWaitPolicy(bool quickStep)
+    {
+        bool result = false;
+
+        BodyState reference[BODY_COUNT];
+        {
+            PilesSimulation simulation(0);
+            simulation.run(quickStep, reference);
+        }
+
+        const unsigned waitPolicies[] = { dThreadingThreadPoolWaitPark, dThreadingThreadPoolWaitYield, dThreadingThreadPoolWaitSpin };
+
+        for (unsigned i = 0; i != sizeof(waitPolicies) / sizeof(waitPolicies[0]); ++i) {
+            dThreadingThreadPoolParameters parameters;
+            memset(&parameters, 0, sizeof(parameters));
+            parameters.struct_size = sizeof(parameters);
+            parameters.wait_policy = waitPolicies[i];
+
+            BodyState states[BODY_COUNT];
+            PilesSimulation simulation(POOL_MAX_THREADS, false, false, &parameters);
+            simulation.run(quickStep, states);
+
+            result = result || simulation.pool == NULL || memcmp(reference, states, sizeof(states)) != 0;
+        }
+
+        return result;
+    }
+
+    TEST(test_ThreadPoolWaitPolicies)
+    {
+        CHECK(!resultsDependOnWaitPolicy(false));
+        CHECK(!resultsDependOnWaitPolicy(true));
+    }
+
+    TEST(test_ThreadPoolWaitCounts)
+    {
+        // Short spinning and yielding makes threads block between most of the steps
+        dThreadingThreadPoolParameters parameters;
+        memset(&parameters, 0, sizeof(parameters));
+        parameters.struct_size = sizeof(parameters);
+        parameters.wait_policy = dThreadingThreadPoolWaitSpin;
+        parameters.wait_spin_count = 1;
+        parameters.wait_yield_count = 1;
+
+        BodyState reference[BODY_COUNT], states[BODY_COUNT];
+        {
+            PilesSimulation simulation(0);
+            simulation.run(true, reference);
+        }
+
+        PilesSimulation simulation(2, false, false, &parameters);
+        CHECK(simulation.pool != NULL);
+        simulation.run(true, states);
+        CHECK(memcmp(reference, states, sizeof(states)) == 0);
+    }
+
+    TEST(test_ThreadPoolAffinityAndNUMAMemory)
+    {
+        BodyState reference[BODY_COUNT], states[BODY_COUNT];
+        {
+            PilesSimulation simulation(0);
+            simulation.run(true, reference);
+        }
+
+        // All the threads share the first CPU
+        const unsigned cpuList[] = { 0 };
+
+        dThreadingThreadPoolParameters parameters;
+        memset(&parameters, 0, sizeof(parameters));
+        parameters.struct_size = sizeof(parameters);
+        parameters.affinity_policy = dThreadingThreadPoolAffinityCPUList;
+        parameters.cpu_list = cpuList;
+        parameters.cpu_count = 1;
+
+        PilesSimulation simulation(2, false, false, &parameters);
+#if defined(__linux__)
+        CHECK(simulation.pool != NULL);
+        CHECK_EQUAL(1, dWorldSetStepMemoryNUMANode(simulation.world, 0));
+#endif
+
+        simulation.run(true, states);
+        CHECK(memcmp(reference, states, sizeof(states)) == 0);
+
+        // The memory mapped for the node is released and the default manager is used again
+        CHECK_EQUAL(1, dWorldSetStepMemoryNUMANode(simulation.world, -1));
+        simulation.run(true, states);
+        dWorldCleanupWorkingMemory(simulation.world);
+    }
+}
+
+
+/*
+ * Tests for step profiling
+ */
+
+SUITE(WorldStepProfiling)
+{
+    enum
+    {
+        PROFILE_EVENT_CAPACITY = 100000,
+    };
+
+    static unsigned countEvents(const dWorldStepProfileEvent *events, unsigned eventCount, int kind)
+    {
+        unsigned result = 0;
+
+        for (unsigned i = 0; i != eventCount; ++i) {
+            result += events[i].kind == kind;
+        }
+
+        return result;
+    }
+
+    TEST(test_StepProfileEnabling)
+    {
+        PilesSimulation simulation(0);
+        CHECK_EQUAL(0U, dWorldGetStepProfiling(simulation.world));
+        CHECK_EQUAL(0U, dWorldGetStepProfileEvents(simulation.world, NULL, 0));
+
+        CHECK_EQUAL(1, dWorldSetStepProfiling(simulation.world, 4));
+        CHECK_EQUAL(4U, dWorldGetStepProfiling(simulation.world));
+
+        BodyState states[BODY_COUNT];
+        simulation.run(true, states);
+
+        // The events not fitting into the buffer are counted as dropped
+        CHECK_EQUAL(4U, dWorldGetStepProfileEvents(simulation.world, NULL, 0));
+        CHECK(dWorldGetStepProfileDroppedEventCount(simulation.world) != 0);
+
+        dWorldResetStepProfile(simulation.world);
+        CHECK_EQUAL(0U, dWorldGetStepProfileEvents(simulation.world, NULL, 0));
+        CHECK_EQUAL(0U, dWorldGetStepProfileDroppedEventCount(simulation.world));
+
+        CHECK_EQUAL(1, dWorldSetStepProfiling(simulation.world, 0));
+        CHECK_EQUAL(0U, dWorldGetStepProfiling(simulation.world));
+    }
+
+    TEST(test_StepProfileEvents)
+    {
+        PilesSimulation simulation(2);
+        dWorldSetStepProfiling(simulation.world, PROFILE_EVENT_CAPACITY);
+
+        BodyState states[BODY_COUNT];
+        simulation.run(true, states);
+
+        unsigned eventCount = dWorldGetStepProfileEvents(simulation.world, NULL, 0);
+        CHECK(eventCount != 0);
+        CHECK_EQUAL(0U, dWorldGetStepProfileDroppedEventCount(simulation.world));
+
+        dWorldStepProfileEvent *events = new dWorldStepProfileEvent[eventCount];
+        CHECK_EQUAL(eventCount, dWorldGetStepProfileEvents(simulation.world, events, eventCount));
+
+        // Each step steps the piles as separate islands
+        CHECK_EQUAL((unsigned)(STEP_COUNT - 1), events[eventCount - 1].step_index);
+        CHECK(countEvents(events, eventCount, dSTEPPROFILE_EVENT_ISLAND) >= (unsigned)(STEP_COUNT * PILE_COUNT));
+        CHECK(countEvents(events, eventCount, dSTEPPROFILE_EVENT_QUEUED) >= (unsigned)(STEP_COUNT * PILE_COUNT));
+        CHECK(countEvents(events, eventCount, dSTEPPROFILE_EVENT_STAGE) != 0);
+
+        bool eventsValid = true;
+        for (unsigned i = 0; i != eventCount; ++i) {
+            const dWorldStepProfileEvent &event = events[i];
+            eventsValid = eventsValid && event.name != NULL && event.duration >= 0 && event.self_time <= event.duration
+                && (i == 0 || events[i - 1].start_time <= event.start_time)
+                && (event.kind == dSTEPPROFILE_EVENT_WORLD) == (event.island_index == dSTEPPROFILE_NO_ISLAND);
+        }
+        CHECK(eventsValid);
+
+        delete[] events;
+
+        dWorldStepProfileThreadStats stats[POOL_MAX_THREADS + 1];
+        unsigned threadCount = dWorldGetStepProfileThreadStats(simulation.world, stats, POOL_MAX_THREADS + 1);
+        CHECK(threadCount >= 2 && threadCount <= 3);
+
+        unsigned stageCount = 0;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            CHECK(stats[t].busy_time >= 0 && stats[t].idle_time >= 0);
+            stageCount += stats[t].stage_count;
+        }
+        CHECK(stageCount != 0);
+
+        FILE *trace = tmpfile();
+        if (trace != NULL) {
+            CHECK_EQUAL(1, dWorldWriteStepProfileTrace(simulation.world, trace));
+            CHECK(ftell(trace) > 0);
+            fclose(trace);
+        }
+    }
+
+    // Checks that each value of the key is a number of microseconds with a point and three decimals
+    static bool traceNumbersValid(const char *trace, const char *key)
+    {
+        unsigned valueCount = 0;
+        for (const char *value = strstr(trace, key); value != NULL; value = strstr(value, key)) {
+            value += strlen(key);
+            const char *digit = value;
+            for (; *digit >= '0' && *digit <= '9'; ++digit) {}
+            if (digit == value || digit[0] != '.' || digit[1] < '0' || digit[1] > '9' || digit[2] < '0' || digit[2] > '9' 
+                || digit[3] < '0' || digit[3] > '9' || (digit[4] != ',' && digit[4] != '}')) {
+                return false;
+            }
+            ++valueCount;
+        }
+        return valueCount != 0;
+    }
+
+    TEST(test_StepProfileTraceLocale)
+    {
+        PilesSimulation simulation(2);
+        dWorldSetStepProfiling(simulation.world, PROFILE_EVENT_CAPACITY);
+
+        BodyState states[BODY_COUNT];
+        simulation.run(true, states);
+
+        // Write the trace with a comma as the decimal separator if such a locale is installed
+        const char *const commaLocales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "German", NULL };
+        for (const char *const *locale = commaLocales; *locale != NULL && setlocale(LC_NUMERIC, *locale) == NULL; ++locale) {}
+
+        FILE *trace = tmpfile();
+        if (trace != NULL) {
+            int writeResult = dWorldWriteStepProfileTrace(simulation.world, trace);
+            setlocale(LC_NUMERIC, "C");
+            CHECK_EQUAL(1, writeResult);
+
+            long traceSize = ftell(trace);
+            CHECK(traceSize > 0);
+
+            char *text = new char[traceSize + 1];
+            rewind(trace);
+            size_t readSize = fread(text, 1, (size_t)traceSize, trace);
+            text[readSize] = '\0';
+            fclose(trace);
+
+            CHECK_EQUAL((size_t)traceSize, readSize);
+            CHECK(traceNumbersValid(text, "\"ts\":"));
+            CHECK(traceNumbersValid(text, "\"dur\":"));
+
+            delete[] text;
+        }
+
+        setlocale(LC_NUMERIC, "C");
+    }
+}